@@ -0,0 +1,560 @@
+#include "BlockCompressor.h"
+#include "Core/JobSystem.h"
+#include <cmath>
+#include <cstring>
+
+namespace Assets
+{
+	namespace
+	{
+		constexpr uint BLOCK_ROWS_PER_JOB = 4;
+		constexpr uint POWER_ITERATIONS = 8;
+		constexpr uint BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		struct Block
+		{
+			float pixels[16][4];
+		};
+
+		inline float Clamp(float v, float low, float high)
+		{
+			return v < low ? low : (v > high ? high : v);
+		}
+
+		template<uint Channels>
+		float SquaredDistance(const float* a, const float* b)
+		{
+			float sum = 0.0f;
+			for (uint c = 0; c < Channels; c++)
+				sum += (a[c] - b[c]) * (a[c] - b[c]);
+			return sum;
+		}
+
+		/// <summary>
+		/// Finds the two extremes of the pixels projected on their principal axis (first Channels channels only).
+		/// </summary>
+		template<uint Channels>
+		void FindEndpoints(const float(*pixels)[4], const bool* mask, float* e0, float* e1)
+		{
+			float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			uint count = 0;
+			for (uint i = 0; i < 16; i++)
+			{
+				if (mask && !mask[i])
+					continue;
+				for (uint c = 0; c < Channels; c++)
+					mean[c] += pixels[i][c];
+				count++;
+			}
+			if (count == 0)
+			{
+				for (uint c = 0; c < Channels; c++)
+					e0[c] = e1[c] = 0.0f;
+				return;
+			}
+			for (uint c = 0; c < Channels; c++)
+				mean[c] /= count;
+
+			float covariance[4][4] = {};
+			for (uint i = 0; i < 16; i++)
+			{
+				if (mask && !mask[i])
+					continue;
+				for (uint r = 0; r < Channels; r++)
+					for (uint c = 0; c < Channels; c++)
+						covariance[r][c] += (pixels[i][r] - mean[r]) * (pixels[i][c] - mean[c]);
+			}
+
+			// Power iteration converges to the eigenvector with the largest eigenvalue
+			float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			for (uint iteration = 0; iteration < POWER_ITERATIONS; iteration++)
+			{
+				float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				float largest = 0.0f;
+				for (uint r = 0; r < Channels; r++)
+				{
+					for (uint c = 0; c < Channels; c++)
+						next[r] += covariance[r][c] * axis[c];
+					largest = fabsf(next[r]) > largest ? fabsf(next[r]) : largest;
+				}
+				if (largest < 1e-6f)
+					break;
+				for (uint c = 0; c < Channels; c++)
+					axis[c] = next[c] / largest;
+			}
+
+			float minT = 0.0f, maxT = 0.0f;
+			for (uint i = 0; i < 16; i++)
+			{
+				if (mask && !mask[i])
+					continue;
+				float t = 0.0f;
+				for (uint c = 0; c < Channels; c++)
+					t += (pixels[i][c] - mean[c]) * axis[c];
+				minT = t < minT ? t : minT;
+				maxT = t > maxT ? t : maxT;
+			}
+
+			float axisLengthSquared = 0.0f;
+			for (uint c = 0; c < Channels; c++)
+				axisLengthSquared += axis[c] * axis[c];
+			if (axisLengthSquared < 1e-12f)
+				axisLengthSquared = 1.0f;
+
+			for (uint c = 0; c < Channels; c++)
+			{
+				e0[c] = Clamp(mean[c] + axis[c] * minT / axisLengthSquared, 0.0f, 255.0f);
+				e1[c] = Clamp(mean[c] + axis[c] * maxT / axisLengthSquared, 0.0f, 255.0f);
+			}
+		}
+
+		/// <summary>
+		/// Least squares endpoints for fixed interpolation factors. Returns false if the system is singular
+		/// (all pixels mapped to the same factor).
+		/// </summary>
+		template<uint Channels>
+		bool RefineEndpoints(const float(*pixels)[4], const bool* mask, const float* factors, float* e0, float* e1)
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[4] = {}, bx[4] = {};
+			for (uint i = 0; i < 16; i++)
+			{
+				if (mask && !mask[i])
+					continue;
+				const float b = factors[i];
+				const float a = 1.0f - b;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint c = 0; c < Channels; c++)
+				{
+					ax[c] += a * pixels[i][c];
+					bx[c] += b * pixels[i][c];
+				}
+			}
+			const float determinant = aa * bb - ab * ab;
+			if (fabsf(determinant) < 1e-6f)
+				return false;
+			const float inverse = 1.0f / determinant;
+			for (uint c = 0; c < Channels; c++)
+			{
+				e0[c] = Clamp((ax[c] * bb - bx[c] * ab) * inverse, 0.0f, 255.0f);
+				e1[c] = Clamp((bx[c] * aa - ax[c] * ab) * inverse, 0.0f, 255.0f);
+			}
+			return true;
+		}
+
+		// ------------------------------------------------------------------ BC1
+
+		inline ushort To565(const float* rgb)
+		{
+			const uint r = static_cast<uint>(rgb[0] * 31.0f / 255.0f + 0.5f);
+			const uint g = static_cast<uint>(rgb[1] * 63.0f / 255.0f + 0.5f);
+			const uint b = static_cast<uint>(rgb[2] * 31.0f / 255.0f + 0.5f);
+			return static_cast<ushort>((r << 11) | (g << 5) | b);
+		}
+
+		inline void From565(ushort color, float* rgb)
+		{
+			const uint r = (color >> 11) & 31;
+			const uint g = (color >> 5) & 63;
+			const uint b = color & 31;
+			rgb[0] = float((r << 3) | (r >> 2));
+			rgb[1] = float((g << 2) | (g >> 4));
+			rgb[2] = float((b << 3) | (b >> 2));
+		}
+
+		struct ColorBlockResult
+		{
+			ushort color0, color1;
+			uint indices;
+			float error;
+		};
+
+		// Picks the indices of every pixel for the given 565 endpoints.
+		ColorBlockResult FitColorIndices(const Block& block, const bool* transparent, bool threeColorMode, ushort c0, ushort c1)
+		{
+			float palette[4][4] = {};
+			From565(c0, palette[0]);
+			From565(c1, palette[1]);
+			for (uint c = 0; c < 3; c++)
+			{
+				if (threeColorMode)
+				{
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2.0f;
+				}
+				else
+				{
+					palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+					palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+				}
+			}
+			const uint usable = threeColorMode ? 3 : 4;
+
+			ColorBlockResult result = { c0, c1, 0, 0.0f };
+			for (uint i = 0; i < 16; i++)
+			{
+				uint best = 0;
+				if (transparent && transparent[i])
+				{
+					best = 3;
+				}
+				else
+				{
+					float bestError = SquaredDistance<3>(block.pixels[i], palette[0]);
+					for (uint p = 1; p < usable; p++)
+					{
+						const float error = SquaredDistance<3>(block.pixels[i], palette[p]);
+						if (error < bestError)
+						{
+							bestError = error;
+							best = p;
+						}
+					}
+					result.error += bestError;
+				}
+				result.indices |= best << (2 * i);
+			}
+			return result;
+		}
+
+		// Orders the endpoints as the mode requires and fits the indices.
+		ColorBlockResult FitColorEndpoints(const Block& block, const bool* transparent, bool threeColorMode, const float* e0, const float* e1)
+		{
+			ushort c0 = To565(e0);
+			ushort c1 = To565(e1);
+			// Four color mode needs color0 > color1, three color mode (punch-through alpha) color0 <= color1
+			if ((!threeColorMode && c0 < c1) || (threeColorMode && c0 > c1))
+			{
+				const ushort swap = c0;
+				c0 = c1;
+				c1 = swap;
+			}
+			return FitColorIndices(block, transparent, threeColorMode, c0, c1);
+		}
+
+		void CompressColorBlock(const Block& block, bool allowPunchThrough, uchar* output)
+		{
+			bool transparent[16];
+			bool opaque[16];
+			bool hasTransparent = false;
+			for (uint i = 0; i < 16; i++)
+			{
+				transparent[i] = allowPunchThrough && block.pixels[i][3] < 128.0f;
+				opaque[i] = !transparent[i];
+				hasTransparent |= transparent[i];
+			}
+
+			float e0[3], e1[3];
+			FindEndpoints<3>(block.pixels, opaque, e0, e1);
+			ColorBlockResult best = FitColorEndpoints(block, hasTransparent ? transparent : nullptr, hasTransparent, e0, e1);
+
+			// One least squares pass on the chosen indices usually removes most of the endpoint rounding error
+			if (!hasTransparent && best.color0 != best.color1)
+			{
+				const float factorOfIndex[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+				float factors[16];
+				for (uint i = 0; i < 16; i++)
+					factors[i] = factorOfIndex[(best.indices >> (2 * i)) & 3];
+				float r0[3], r1[3];
+				From565(best.color0, r0);
+				From565(best.color1, r1);
+				if (RefineEndpoints<3>(block.pixels, nullptr, factors, r0, r1))
+				{
+					const ColorBlockResult refined = FitColorEndpoints(block, nullptr, false, r0, r1);
+					if (refined.error < best.error)
+						best = refined;
+				}
+			}
+
+			output[0] = static_cast<uchar>(best.color0 & 0xFF);
+			output[1] = static_cast<uchar>(best.color0 >> 8);
+			output[2] = static_cast<uchar>(best.color1 & 0xFF);
+			output[3] = static_cast<uchar>(best.color1 >> 8);
+			for (uint i = 0; i < 4; i++)
+				output[4 + i] = static_cast<uchar>(best.indices >> (8 * i));
+		}
+
+		// ------------------------------------------------------------------ BC4 (single channel, used by BC3 and BC5)
+
+		void CompressChannelBlock(const Block& block, uint channel, uchar* output)
+		{
+			float low = 255.0f, high = 0.0f;
+			for (uint i = 0; i < 16; i++)
+			{
+				low = block.pixels[i][channel] < low ? block.pixels[i][channel] : low;
+				high = block.pixels[i][channel] > high ? block.pixels[i][channel] : high;
+			}
+			const uint a0 = static_cast<uint>(high + 0.5f);
+			const uint a1 = static_cast<uint>(low + 0.5f);
+			output[0] = static_cast<uchar>(a0);
+			output[1] = static_cast<uchar>(a1);
+
+			// a0 > a1 selects the 8 value mode: a0, a1 and 6 interpolated values
+			float palette[8];
+			palette[0] = float(a0);
+			palette[1] = float(a1);
+			for (uint i = 2; i < 8; i++)
+				palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7.0f;
+
+			uint64 indices = 0;
+			if (a0 != a1)
+			{
+				for (uint i = 0; i < 16; i++)
+				{
+					uint best = 0;
+					float bestError = fabsf(block.pixels[i][channel] - palette[0]);
+					for (uint p = 1; p < 8; p++)
+					{
+						const float error = fabsf(block.pixels[i][channel] - palette[p]);
+						if (error < bestError)
+						{
+							bestError = error;
+							best = p;
+						}
+					}
+					indices |= static_cast<uint64>(best) << (3 * i);
+				}
+			}
+			for (uint i = 0; i < 6; i++)
+				output[2 + i] = static_cast<uchar>(indices >> (8 * i));
+		}
+
+		// ------------------------------------------------------------------ BC7 (mode 6: one subset, RGBA, 4 bit indices)
+
+		struct BitWriter
+		{
+			uint64 low = 0;
+			uint64 high = 0;
+			uint position = 0;
+
+			void Write(uint64 value, uint bits)
+			{
+				if (position < 64)
+				{
+					low |= value << position;
+					if (position + bits > 64)
+						high |= value >> (64 - position);
+				}
+				else
+				{
+					high |= value << (position - 64);
+				}
+				position += bits;
+			}
+		};
+
+		// Quantizes an endpoint to 7 bits per channel plus a shared p-bit, picking the p-bit with the lowest error.
+		void QuantizeBC7Endpoint(const float* endpoint, uint* quantized, uint& pBit)
+		{
+			float bestError = 1e30f;
+			for (uint p = 0; p < 2; p++)
+			{
+				uint candidate[4];
+				float error = 0.0f;
+				for (uint c = 0; c < 4; c++)
+				{
+					const float q = Clamp(floorf((endpoint[c] - p) / 2.0f + 0.5f), 0.0f, 127.0f);
+					candidate[c] = static_cast<uint>(q);
+					const float reconstructed = float((candidate[c] << 1) | p);
+					error += (reconstructed - endpoint[c]) * (reconstructed - endpoint[c]);
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					pBit = p;
+					for (uint c = 0; c < 4; c++)
+						quantized[c] = candidate[c];
+				}
+			}
+		}
+
+		struct BC7Fit
+		{
+			uint endpoints[2][4];
+			uint pBits[2];
+			uint indices[16];
+			float error;
+		};
+
+		BC7Fit FitBC7(const Block& block, const float* e0, const float* e1)
+		{
+			BC7Fit fit;
+			QuantizeBC7Endpoint(e0, fit.endpoints[0], fit.pBits[0]);
+			QuantizeBC7Endpoint(e1, fit.endpoints[1], fit.pBits[1]);
+
+			float palette[16][4];
+			for (uint c = 0; c < 4; c++)
+			{
+				const uint v0 = (fit.endpoints[0][c] << 1) | fit.pBits[0];
+				const uint v1 = (fit.endpoints[1][c] << 1) | fit.pBits[1];
+				for (uint w = 0; w < 16; w++)
+					palette[w][c] = float(((64 - BC7_WEIGHTS4[w]) * v0 + BC7_WEIGHTS4[w] * v1 + 32) >> 6);
+			}
+
+			fit.error = 0.0f;
+			for (uint i = 0; i < 16; i++)
+			{
+				uint best = 0;
+				float bestError = SquaredDistance<4>(block.pixels[i], palette[0]);
+				for (uint p = 1; p < 16; p++)
+				{
+					const float error = SquaredDistance<4>(block.pixels[i], palette[p]);
+					if (error < bestError)
+					{
+						bestError = error;
+						best = p;
+					}
+				}
+				fit.indices[i] = best;
+				fit.error += bestError;
+			}
+			return fit;
+		}
+
+		void CompressBC7Block(const Block& block, uchar* output)
+		{
+			float e0[4], e1[4];
+			FindEndpoints<4>(block.pixels, nullptr, e0, e1);
+			BC7Fit best = FitBC7(block, e0, e1);
+
+			float factors[16];
+			for (uint i = 0; i < 16; i++)
+				factors[i] = BC7_WEIGHTS4[best.indices[i]] / 64.0f;
+			if (RefineEndpoints<4>(block.pixels, nullptr, factors, e0, e1))
+			{
+				const BC7Fit refined = FitBC7(block, e0, e1);
+				if (refined.error < best.error)
+					best = refined;
+			}
+
+			// The anchor (first) index is stored with an implicit 0 MSB, flip the endpoints if it is set
+			if (best.indices[0] >= 8)
+			{
+				for (uint c = 0; c < 4; c++)
+				{
+					const uint swap = best.endpoints[0][c];
+					best.endpoints[0][c] = best.endpoints[1][c];
+					best.endpoints[1][c] = swap;
+				}
+				const uint swap = best.pBits[0];
+				best.pBits[0] = best.pBits[1];
+				best.pBits[1] = swap;
+				for (uint i = 0; i < 16; i++)
+					best.indices[i] = 15 - best.indices[i];
+			}
+
+			BitWriter writer;
+			writer.Write(1 << 6, 7); // Mode 6
+			for (uint c = 0; c < 4; c++)
+			{
+				writer.Write(best.endpoints[0][c], 7);
+				writer.Write(best.endpoints[1][c], 7);
+			}
+			writer.Write(best.pBits[0], 1);
+			writer.Write(best.pBits[1], 1);
+			writer.Write(best.indices[0], 3);
+			for (uint i = 1; i < 16; i++)
+				writer.Write(best.indices[i], 4);
+
+			for (uint i = 0; i < 8; i++)
+			{
+				output[i] = static_cast<uchar>(writer.low >> (8 * i));
+				output[8 + i] = static_cast<uchar>(writer.high >> (8 * i));
+			}
+		}
+
+		// ------------------------------------------------------------------
+
+		Block LoadBlock(const uchar* pixels)
+		{
+			Block block;
+			for (uint i = 0; i < 16; i++)
+				for (uint c = 0; c < 4; c++)
+					block.pixels[i][c] = pixels[i * 4 + c];
+			return block;
+		}
+
+		// Copies a 4x4 block out of the image, clamping reads to the edges.
+		void FetchBlock(const uchar* rgba, uint width, uint height, uint blockX, uint blockY, uchar* block)
+		{
+			for (uint y = 0; y < 4; y++)
+			{
+				const uint sy = blockY * 4 + y < height ? blockY * 4 + y : height - 1;
+				for (uint x = 0; x < 4; x++)
+				{
+					const uint sx = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+					memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+				}
+			}
+		}
+	}
+
+	void BlockCompressor::CompressBlock(const uchar* pixels, TextureFormat format, uchar* output)
+	{
+		const Block block = LoadBlock(pixels);
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			CompressColorBlock(block, true, output);
+			break;
+		case TextureFormat::BC3:
+			CompressChannelBlock(block, 3, output);
+			CompressColorBlock(block, false, output + 8);
+			break;
+		case TextureFormat::BC5:
+			CompressChannelBlock(block, 0, output);
+			CompressChannelBlock(block, 1, output + 8);
+			break;
+		case TextureFormat::BC7:
+			CompressBC7Block(block, output);
+			break;
+		default:
+			memcpy(output, pixels, 64);
+			break;
+		}
+	}
+
+	MipLevel BlockCompressor::CompressLevel(const uchar* rgba, uint width, uint height, TextureFormat format)
+	{
+		MipLevel level;
+		level.width = width;
+		level.height = height;
+		if (!IsBlockCompressed(format))
+		{
+			level.data.assign(rgba, rgba + GetLevelSize(format, width, height));
+			return level;
+		}
+
+		level.data.resize(GetLevelSize(format, width, height));
+		const uint blocksX = (width + 3) / 4;
+		const uint blocksY = (height + 3) / 4;
+		const uint blockSize = GetBlockSize(format);
+
+		Core::JobSystem::ParallelFor(blocksY, BLOCK_ROWS_PER_JOB, [&](uint begin, uint end)
+		{
+			uchar pixels[64];
+			for (uint by = begin; by < end; by++)
+			{
+				uchar* output = level.data.data() + static_cast<size_t>(by) * blocksX * blockSize;
+				for (uint bx = 0; bx < blocksX; bx++)
+				{
+					FetchBlock(rgba, width, height, bx, by, pixels);
+					CompressBlock(pixels, format, output + bx * blockSize);
+				}
+			}
+		});
+		return level;
+	}
+
+	TextureData BlockCompressor::Compress(const std::vector<MipLevel>& rgbaChain, TextureFormat format, bool sRGB)
+	{
+		TextureData texture;
+		texture.format = format;
+		texture.sRGB = sRGB;
+		texture.mips.reserve(rgbaChain.size());
+		for (const MipLevel& level : rgbaChain)
+			texture.mips.push_back(CompressLevel(level.data.data(), level.width, level.height, format));
+		return texture;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "TextureData.h"
+
+namespace Assets
+{
+	/*
+	* CPU block compression (BCn) of RGBA8 images.
+	* Images whose size is not a multiple of 4 are padded by clamping to the edge.
+	*/
+	namespace BlockCompressor
+	{
+		/// <summary>
+		/// Compresses a single 4x4 RGBA8 block.
+		/// </summary>
+		/// <param name="block">16 pixels, 4 bytes each, row by row.</param>
+		/// <param name="format">Any block compressed format.</param>
+		/// <param name="output">GetBlockSize(format) bytes.</param>
+		void CompressBlock(const uchar* block, TextureFormat format, uchar* output);
+
+		/// <summary>
+		/// Compresses an RGBA8 image. Rows of blocks are spread across the job system.
+		/// </summary>
+		/// <param name="rgba">Pixels, 4 bytes each, rows tightly packed.</param>
+		/// <param name="format">Target format. RGBA8 returns a copy of the input.</param>
+		/// <returns>The compressed level.</returns>
+		MipLevel CompressLevel(const uchar* rgba, uint width, uint height, TextureFormat format);
+
+		// Compresses every level of an RGBA8 chain (see GenerateMipChain).
+		TextureData Compress(const std::vector<MipLevel>& rgbaChain, TextureFormat format, bool sRGB);
+	}
+}
@@ -0,0 +1,231 @@
+#include "MeshContainer.h"
+#include "Core/JobSystem.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace Assets
+{
+	namespace
+	{
+		const uint POSITION_STRIDE = 4 * sizeof(ushort);
+		const uint NORMAL_STRIDE = 2 * sizeof(short);
+		const uint TEXCOORD_STRIDE = 2 * sizeof(ushort);
+		const uint VERTEX_GRAIN = 1 << 14;
+
+		inline uint64 AlignUp(uint64 value, uint64 alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		inline uint SectionIndex(MeshSection section)
+		{
+			return static_cast<uint>(section);
+		}
+	}
+
+	MeshContainer::MeshContainer(const char* path)
+	{
+		Open(path);
+	}
+
+	bool MeshContainer::Write(const char* path, const MeshData& mesh, bool shortIndices)
+	{
+		const uint vertexCount = mesh.GetVertexCount();
+		const uint indexCount = static_cast<uint>(mesh.indices.size());
+		if (mesh.HasTexcoords() && mesh.texcoords.size() != vertexCount)
+		{
+			std::cout << "ERROR::MESH_CONTAINER::TEXCOORD_COUNT_MISMATCH: " << path << std::endl;
+			return false;
+		}
+
+		Math::AABB bounds;
+		for (uint i = 0; i < vertexCount; i++)
+			bounds.Expand(mesh.GetPosition(i));
+		const Math::PositionQuantization quantization(bounds);
+
+		ContainerHeader header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.vertexCount = vertexCount;
+		header.indexCount = indexCount;
+		header.indexSize = shortIndices && vertexCount <= 0x10000 ? sizeof(ushort) : sizeof(uint);
+		header.sectionAlignment = SECTION_ALIGNMENT;
+		for (uint axis = 0; axis < 3; axis++)
+		{
+			header.boundsMin[axis] = bounds.min[axis];
+			header.boundsMax[axis] = bounds.max[axis];
+		}
+
+		const uint strides[] = { POSITION_STRIDE, NORMAL_STRIDE, TEXCOORD_STRIDE, header.indexSize };
+		const uint64 counts[] = { vertexCount, vertexCount, mesh.HasTexcoords() ? vertexCount : 0u, indexCount };
+		ContainerSection sections[SectionIndex(MeshSection::Count)] = {};
+		uint64 offset = sizeof(ContainerHeader) + sizeof(sections);
+		for (uint i = 0; i < SectionIndex(MeshSection::Count); i++)
+		{
+			offset = AlignUp(offset, SECTION_ALIGNMENT);
+			sections[i].stride = strides[i];
+			sections[i].offset = offset;
+			sections[i].size = counts[i] * strides[i];
+			offset += sections[i].size;
+		}
+
+		// The whole file is built in memory and written at once, the padding already zeroed
+		std::vector<uchar> bytes(static_cast<size_t>(offset), 0);
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		std::memcpy(bytes.data() + sizeof(header), sections, sizeof(sections));
+
+		ushort* positions = reinterpret_cast<ushort*>(bytes.data() + sections[SectionIndex(MeshSection::Positions)].offset);
+		short* normals = reinterpret_cast<short*>(bytes.data() + sections[SectionIndex(MeshSection::Normals)].offset);
+		ushort* texcoords = reinterpret_cast<ushort*>(bytes.data() + sections[SectionIndex(MeshSection::Texcoords)].offset);
+		Core::JobSystem::ParallelFor(vertexCount, VERTEX_GRAIN, [&](uint begin, uint end)
+		{
+			for (uint i = begin; i < end; i++)
+			{
+				quantization.Quantize(mesh.GetPosition(i), positions + i * 4);
+				Math::EncodeOctahedralSnorm16(mesh.GetNormal(i), normals + i * 2);
+				if (mesh.HasTexcoords())
+					Math::EncodeHalf2(mesh.texcoords[i], texcoords + i * 2);
+			}
+		});
+
+		uchar* indices = bytes.data() + sections[SectionIndex(MeshSection::Indices)].offset;
+		if (header.indexSize == sizeof(uint))
+			std::memcpy(indices, mesh.indices.data(), mesh.indices.size() * sizeof(uint));
+		else
+		{
+			ushort* shortIndices = reinterpret_cast<ushort*>(indices);
+			for (uint i = 0; i < indexCount; i++)
+				shortIndices[i] = static_cast<ushort>(mesh.indices[i]);
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			std::cout << "ERROR::MESH_CONTAINER::CANNOT_OPEN_FOR_WRITING: " << path << std::endl;
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		if (!file)
+		{
+			std::cout << "ERROR::MESH_CONTAINER::WRITE_FAILED: " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool MeshContainer::Open(const char* path)
+	{
+		Close();
+		if (!m_file.Open(path))
+			return false;
+
+		const uchar* bytes = m_file.GetData();
+		const size_t fileSize = m_file.GetSize();
+		const size_t tableSize = sizeof(ContainerHeader) + sizeof(ContainerSection) * SectionIndex(MeshSection::Count);
+		const ContainerHeader* header = reinterpret_cast<const ContainerHeader*>(bytes);
+		if (fileSize < tableSize || header->magic != MAGIC || header->version != VERSION
+			|| (header->indexSize != sizeof(ushort) && header->indexSize != sizeof(uint))
+			|| header->sectionAlignment != SECTION_ALIGNMENT)
+		{
+			std::cout << "ERROR::MESH_CONTAINER::INVALID_HEADER: " << path << std::endl;
+			m_file.Close();
+			return false;
+		}
+
+		// Validate the table once so the views never reach outside the mapping. Sections must be in
+		// order, so the span from the first to the last is the GPU buffer.
+		const ContainerSection* sections = reinterpret_cast<const ContainerSection*>(bytes + sizeof(ContainerHeader));
+		const uint strides[] = { POSITION_STRIDE, NORMAL_STRIDE, TEXCOORD_STRIDE, header->indexSize };
+		uint64 previousEnd = tableSize;
+		for (uint i = 0; i < SectionIndex(MeshSection::Count); i++)
+		{
+			const uint64 count = i == SectionIndex(MeshSection::Indices) ? header->indexCount : header->vertexCount;
+			const bool sizeValid = sections[i].size == count * strides[i]
+				|| (i == SectionIndex(MeshSection::Texcoords) && sections[i].size == 0);
+			if (sections[i].stride != strides[i] || !sizeValid || sections[i].offset % SECTION_ALIGNMENT != 0
+				|| sections[i].offset < previousEnd || sections[i].offset > fileSize || sections[i].size > fileSize - sections[i].offset)
+			{
+				std::cout << "ERROR::MESH_CONTAINER::CORRUPTED_SECTION " << i << ": " << path << std::endl;
+				m_file.Close();
+				return false;
+			}
+			previousEnd = sections[i].offset + sections[i].size;
+		}
+
+		m_header = header;
+		m_sections = sections;
+		m_sectionDataSize = static_cast<size_t>(previousEnd - sections[0].offset);
+		return true;
+	}
+
+	void MeshContainer::Close()
+	{
+		m_file.Close();
+		m_header = nullptr;
+		m_sections = nullptr;
+		m_sectionDataSize = 0;
+	}
+
+	Math::AABB MeshContainer::GetBounds() const
+	{
+		return Math::AABB(Math::Vector3D(m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]),
+			Math::Vector3D(m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]));
+	}
+
+	MeshSectionView MeshContainer::GetSection(MeshSection section) const
+	{
+		const ContainerSection& entry = m_sections[SectionIndex(section)];
+		return { m_file.GetData() + entry.offset, static_cast<size_t>(entry.size), entry.stride };
+	}
+
+	void MeshContainer::Decode(MeshData& result, VertexLayout layout) const
+	{
+		const uint vertexCount = GetVertexCount();
+		result = MeshData();
+		result.layout = layout;
+		if (layout == VertexLayout::Interleaved)
+			result.vertices.resize(vertexCount);
+		else
+		{
+			result.positions.resize(vertexCount);
+			result.normals.resize(vertexCount);
+		}
+		if (HasTexcoords())
+			result.texcoords.resize(vertexCount);
+
+		const Math::PositionQuantization quantization = GetPositionQuantization();
+		const ushort* positions = reinterpret_cast<const ushort*>(GetSection(MeshSection::Positions).data);
+		const short* normals = reinterpret_cast<const short*>(GetSection(MeshSection::Normals).data);
+		const ushort* texcoords = reinterpret_cast<const ushort*>(GetSection(MeshSection::Texcoords).data);
+		Core::JobSystem::ParallelFor(vertexCount, VERTEX_GRAIN, [&](uint begin, uint end)
+		{
+			for (uint i = begin; i < end; i++)
+			{
+				const Math::Vector3D position = quantization.Dequantize(positions + i * 4);
+				const Math::Vector3D normal = Math::DecodeOctahedralSnorm16(normals + i * 2);
+				if (layout == VertexLayout::Interleaved)
+					result.vertices[i] = { position, normal };
+				else
+				{
+					result.positions[i] = position;
+					result.normals[i] = normal;
+				}
+				if (!result.texcoords.empty())
+					result.texcoords[i] = Math::DecodeHalf2(texcoords + i * 2);
+			}
+		});
+
+		const MeshSectionView indices = GetSection(MeshSection::Indices);
+		result.indices.resize(GetIndexCount());
+		if (GetIndexSize() == sizeof(uint))
+			std::memcpy(result.indices.data(), indices.data, indices.size);
+		else
+		{
+			const ushort* shortIndices = reinterpret_cast<const ushort*>(indices.data);
+			for (uint i = 0; i < GetIndexCount(); i++)
+				result.indices[i] = shortIndices[i];
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "MeshData.h"
+#include "Core/MappedFile.h"
+#include "Math/Quantization.h"
+#include <cstddef>
+
+namespace Assets
+{
+	enum class MeshSection : uint
+	{
+		Positions = 0,	// ushort[4]: x, y, z relative to the bounds (see Math::PositionQuantization), padding
+		Normals,		// short[2]: octahedral snorm16
+		Texcoords,		// ushort[2]: half floats. Empty if the mesh has none.
+		Indices,		// ushort or uint per index, see GetIndexSize
+		Count
+	};
+
+	// View into the mapped file, valid while the container stays open. Empty sections have size 0.
+	struct MeshSectionView
+	{
+		const uchar* data = nullptr;
+		size_t size = 0;
+		uint stride = 0;
+	};
+
+	/*
+	* Engine mesh container (.emesh): a mesh stored as it is uploaded, with quantized attributes.
+	* 8 + 4 + 4 bytes per vertex instead of 32 for float positions, normals and texcoords.
+	*
+	* Layout:
+	*   ContainerHeader
+	*   ContainerSection[MeshSection::Count]
+	*   section data, every section starting at a multiple of SECTION_ALIGNMENT
+	*
+	* The sections follow each other in the file, so they can go to the GPU as one buffer in
+	* one upload straight from the mapping (see MeshBuffer). Decode brings them back to floats
+	* for CPU side use.
+	*/
+	class MeshContainer
+	{
+	public:
+		static constexpr uint MAGIC = 0x48534D45; // "EMSH"
+		static constexpr uint VERSION = 1;
+		static constexpr uint SECTION_ALIGNMENT = 256;
+
+		struct ContainerHeader
+		{
+			uint magic;
+			uint version;
+			uint vertexCount;
+			uint indexCount;
+			uint indexSize; // 2 or 4 bytes
+			uint sectionAlignment;
+			float boundsMin[3];
+			float boundsMax[3];
+		};
+
+		struct ContainerSection
+		{
+			uint stride;
+			uint reserved;
+			uint64 offset; // From the start of the file
+			uint64 size;
+		};
+
+		MeshContainer() = default;
+		explicit MeshContainer(const char* path);
+
+		/// <summary>
+		/// Quantizes the mesh and writes it as a container.
+		/// </summary>
+		/// <param name="shortIndices">Store 16-bit indices when the vertex count allows it. RenderQueue and
+		/// InstanceBatcher draw 32-bit indices, so meshes meant for them must be written with false.</param>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		static bool Write(const char* path, const MeshData& mesh, bool shortIndices = true);
+
+		/// <summary>
+		/// Maps a container and validates its header and section table.
+		/// </summary>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		bool Open(const char* path);
+		void Close();
+
+		inline bool IsOpen() const { return m_header != nullptr; }
+		inline uint GetVertexCount() const { return m_header->vertexCount; }
+		inline uint GetIndexCount() const { return m_header->indexCount; }
+		inline uint GetIndexSize() const { return m_header->indexSize; }
+		inline bool HasTexcoords() const { return m_sections[static_cast<uint>(MeshSection::Texcoords)].size > 0; }
+
+		Math::AABB GetBounds() const;
+		// What the vertex shader applies to the position attribute
+		inline Math::PositionQuantization GetPositionQuantization() const { return Math::PositionQuantization(GetBounds()); }
+
+		MeshSectionView GetSection(MeshSection section) const;
+
+		// The file bytes from the first section to the end of the last, what MeshBuffer uploads
+		inline const uchar* GetSectionData() const { return m_file.GetData() + m_sections[0].offset; }
+		inline size_t GetSectionDataSize() const { return m_sectionDataSize; }
+
+		// Dequantizes the mesh back to floats
+		void Decode(MeshData& result, VertexLayout layout = VertexLayout::Interleaved) const;
+
+	private:
+		Core::MappedFile m_file;
+		const ContainerHeader* m_header = nullptr;
+		const ContainerSection* m_sections = nullptr;
+		size_t m_sectionDataSize = 0;
+	};
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Math/Vector2D.h"
+#include "Math/Vector3D.h"
+#include "Misc/Typedefs.h"
+#include <vector>
+
+namespace Assets
+{
+	// How MeshData stores its vertices
+	enum class VertexLayout : uint
+	{
+		Interleaved = 0,	// One MeshVertex per vertex
+		SoA = 1				// One array per attribute
+	};
+
+	struct MeshVertex
+	{
+		Math::Vector3D position;
+		Math::Vector3D normal;
+	};
+
+	// Indexed triangle list ready to be uploaded, three indices per triangle.
+	struct MeshData
+	{
+		VertexLayout layout = VertexLayout::Interleaved;
+		std::vector<MeshVertex> vertices;		// Interleaved
+		std::vector<Math::Vector3D> positions;	// SoA
+		std::vector<Math::Vector3D> normals;	// SoA
+		std::vector<Math::Vector2D> texcoords;	// Either layout; empty if the mesh has none
+		std::vector<uint> indices;
+
+		inline uint GetVertexCount() const
+		{
+			return static_cast<uint>(layout == VertexLayout::Interleaved ? vertices.size() : positions.size());
+		}
+		inline uint GetTriangleCount() const { return static_cast<uint>(indices.size() / 3); }
+		inline bool HasTexcoords() const { return !texcoords.empty(); }
+
+		inline const Math::Vector3D& GetPosition(uint vertex) const
+		{
+			return layout == VertexLayout::Interleaved ? vertices[vertex].position : positions[vertex];
+		}
+		inline const Math::Vector3D& GetNormal(uint vertex) const
+		{
+			return layout == VertexLayout::Interleaved ? vertices[vertex].normal : normals[vertex];
+		}
+	};
+}
@@ -0,0 +1,1043 @@
+#include "MeshImporter.h"
+#include "MeshContainer.h"
+#include "MeshOptimizer.h"
+#include "Core/JobSystem.h"
+#include "Core/MappedFile.h"
+#include "Core/Profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace Assets
+{
+	namespace
+	{
+		// Ranges smaller than this are not worth a job
+		const size_t MIN_RANGE_SIZE = 1 << 20;
+
+		// Splits text into ranges starting right after a line break. Returns the range bounds.
+		std::vector<size_t> SplitLines(const char* text, size_t size)
+		{
+			const size_t threadCount = Core::JobSystem::GetThreadCount();
+			const size_t rangeCount = std::max<size_t>(1, std::min<size_t>(threadCount * 4, size / MIN_RANGE_SIZE));
+
+			std::vector<size_t> bounds(1, 0);
+			for (size_t i = 1; i < rangeCount; i++)
+			{
+				const size_t start = std::max(size * i / rangeCount, bounds.back());
+				const void* newline = std::memchr(text + start, '\n', size - start);
+				const size_t bound = newline ? static_cast<const char*>(newline) - text + 1 : size;
+				if (bound > bounds.back() && bound < size)
+					bounds.push_back(bound);
+			}
+			bounds.push_back(size);
+			return bounds;
+		}
+
+		inline const char* SkipSpaces(const char* p, const char* end)
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+				p++;
+			return p;
+		}
+
+		inline const char* SkipLine(const char* p, const char* end)
+		{
+			const void* newline = std::memchr(p, '\n', end - p);
+			return newline ? static_cast<const char*>(newline) + 1 : end;
+		}
+
+		// Return the end of the number, or null if there is none
+		template<typename T>
+		inline const char* ParseNumber(const char* p, const char* end, T& value)
+		{
+			p = SkipSpaces(p, end);
+			// from_chars takes no explicit plus sign
+			if (p < end && *p == '+')
+				p++;
+			const std::from_chars_result result = std::from_chars(p, end, value);
+			return result.ec == std::errc() ? result.ptr : nullptr;
+		}
+
+		inline bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t';
+		}
+
+		size_t GetLineNumber(const char* text, const char* position)
+		{
+			return static_cast<size_t>(std::count(text, position, '\n')) + 1;
+		}
+
+		// Open addressing map from (position, normal) pairs to vertex indices. Key and index share
+		// a slot, so a probe touches one cache line.
+		class VertexMap
+		{
+		public:
+			explicit VertexMap(size_t expectedCount)
+			{
+				uint bits = 10;
+				while ((size_t(1) << bits) < expectedCount * 2)
+					bits++;
+				Allocate(bits);
+			}
+
+			// Returns the index stored for key, storing index if the key is new
+			inline uint FindOrInsert(uint64 key, uint index, bool& inserted)
+			{
+				if ((m_count + 1) * 2 > m_slots.size())
+					Grow();
+				for (size_t slot = Hash(key);; slot = (slot + 1) & m_mask)
+				{
+					Slot& entry = m_slots[slot];
+					if (entry.key == key)
+					{
+						inserted = false;
+						return entry.index;
+					}
+					if (entry.key == EMPTY)
+					{
+						entry.key = key;
+						entry.index = index;
+						m_count++;
+						inserted = true;
+						return index;
+					}
+				}
+			}
+
+		private:
+			// Positions are below 2^31, so no real key looks like this
+			static constexpr uint64 EMPTY = ~uint64(0);
+
+			struct Slot
+			{
+				uint64 key;
+				uint index;
+			};
+
+			inline size_t Hash(uint64 key) const
+			{
+				return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> m_shift);
+			}
+
+			void Allocate(uint bits)
+			{
+				m_slots.assign(size_t(1) << bits, Slot{ EMPTY, 0 });
+				m_mask = (size_t(1) << bits) - 1;
+				m_shift = 64 - bits;
+				m_count = 0;
+			}
+
+			void Grow()
+			{
+				std::vector<Slot> slots;
+				slots.swap(m_slots);
+				Allocate(64 - m_shift + 1);
+				for (const Slot& entry : slots)
+				{
+					if (entry.key == EMPTY)
+						continue;
+					size_t slot = Hash(entry.key);
+					while (m_slots[slot].key != EMPTY)
+						slot = (slot + 1) & m_mask;
+					m_slots[slot] = entry;
+					m_count++;
+				}
+			}
+
+			std::vector<Slot> m_slots;
+			size_t m_mask = 0;
+			uint m_shift = 0;
+			size_t m_count = 0;
+		};
+
+		inline uint64 MakeVertexKey(uint position, uint normal)
+		{
+			return (static_cast<uint64>(position) << 32) | normal;
+		}
+
+		void GenerateNormals(const std::vector<Math::Vector3D>& positions, const std::vector<uint>& indices, std::vector<Math::Vector3D>& normals)
+		{
+			normals.assign(positions.size(), Math::Vector3D(0.0f));
+			// Unnormalized cross products weight each face by its area
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				const Math::Vector3D& a = positions[indices[i]];
+				const Math::Vector3D normal = Math::Vector3D::CrossProduct(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+				normals[indices[i]] = normals[indices[i]] + normal;
+				normals[indices[i + 1]] = normals[indices[i + 1]] + normal;
+				normals[indices[i + 2]] = normals[indices[i + 2]] + normal;
+			}
+			Core::JobSystem::ParallelFor(static_cast<uint>(normals.size()), 1 << 16, [&normals](uint begin, uint end)
+			{
+				for (uint i = begin; i < end; i++)
+				{
+					const float length = normals[i].Magnitude();
+					if (length > 0.0f)
+						normals[i] = normals[i] * (1.0f / length);
+				}
+			});
+		}
+
+		// Moves the attributes into the result in the requested layout, optimizing it if asked
+		void StoreVertices(const MeshImportSettings& settings, std::vector<Math::Vector3D>& positions, std::vector<Math::Vector3D>& normals,
+			std::vector<Math::Vector2D>& texcoords, std::vector<uint>& indices, MeshData& result)
+		{
+			if (normals.empty() && settings.generateNormals)
+				GenerateNormals(positions, indices, normals);
+			if (normals.size() != positions.size())
+				normals.assign(positions.size(), Math::Vector3D(0.0f));
+
+			result = MeshData();
+			result.layout = settings.layout;
+			result.indices.swap(indices);
+			result.texcoords.swap(texcoords);
+			if (settings.layout == VertexLayout::SoA)
+			{
+				result.positions.swap(positions);
+				result.normals.swap(normals);
+			}
+			else
+			{
+				result.vertices.resize(positions.size());
+				Core::JobSystem::ParallelFor(static_cast<uint>(positions.size()), 1 << 16, [&](uint begin, uint end)
+				{
+					for (uint i = begin; i < end; i++)
+					{
+						result.vertices[i].position = positions[i];
+						result.vertices[i].normal = normals[i];
+					}
+				});
+			}
+
+			if (settings.optimize)
+				MeshOptimizer::Optimize(result);
+		}
+
+		/*
+		* OBJ
+		*/
+
+		// Corner indices as parsed: absolute (zero based), NO_INDEX, or relative to the range's first
+		// element for negative OBJ indices, which count back from the elements parsed so far
+		const int NO_INDEX = -1;
+		const long long RELATIVE_BIAS = 1 << 29;
+
+		inline bool EncodeIndex(long long objIndex, size_t parsedCount, int& encoded)
+		{
+			if (objIndex > 0 && objIndex <= 0x7FFFFFFF)
+			{
+				encoded = static_cast<int>(objIndex - 1);
+				return true;
+			}
+			const long long relative = static_cast<long long>(parsedCount) + objIndex;
+			if (objIndex < 0 && relative >= -RELATIVE_BIAS && relative < 0x7FFFFFFF - 2 * RELATIVE_BIAS)
+			{
+				encoded = static_cast<int>(-2 - (relative + RELATIVE_BIAS));
+				return true;
+			}
+			return false;
+		}
+
+		// Global index of a corner, or -1 if out of range
+		inline long long DecodeIndex(int encoded, size_t rangeFirst, size_t total)
+		{
+			const long long index = encoded >= 0 ? encoded : static_cast<long long>(rangeFirst) + (-2 - static_cast<long long>(encoded) - RELATIVE_BIAS);
+			return index >= 0 && index < static_cast<long long>(total) ? index : -1;
+		}
+
+		struct ObjRange
+		{
+			std::vector<Math::Vector3D> positions;
+			std::vector<Math::Vector3D> normals;
+			// Three corners per triangle
+			std::vector<int> cornerPositions;
+			std::vector<int> cornerNormals;
+			const char* error = nullptr;
+
+			// Index of the first position / normal / corner in the whole file
+			size_t firstPosition = 0;
+			size_t firstNormal = 0;
+			size_t firstCorner = 0;
+
+			// Deduplication: the range's distinct vertices in order, each corner's index among them,
+			// and their index in the whole mesh
+			std::vector<uint64> vertexKeys;
+			std::vector<uint> localIndices;
+			std::vector<uint> globalIndices;
+		};
+
+		void ParseObjRange(const char* begin, const char* end, ObjRange& range)
+		{
+			const char* p = begin;
+			while (p < end)
+			{
+				const char* line = p;
+				p = SkipSpaces(p, end);
+				if (p + 1 < end && p[0] == 'v' && IsSpace(p[1]))
+				{
+					Math::Vector3D position;
+					if (!(p = ParseNumber(p + 2, end, position.x)) || !(p = ParseNumber(p, end, position.y)) || !(p = ParseNumber(p, end, position.z)))
+					{
+						range.error = line;
+						return;
+					}
+					range.positions.push_back(position);
+				}
+				else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+				{
+					Math::Vector3D normal;
+					if (!(p = ParseNumber(p + 3, end, normal.x)) || !(p = ParseNumber(p, end, normal.y)) || !(p = ParseNumber(p, end, normal.z)))
+					{
+						range.error = line;
+						return;
+					}
+					range.normals.push_back(normal);
+				}
+				else if (p + 1 < end && p[0] == 'f' && IsSpace(p[1]))
+				{
+					// v, v/vt, v//vn or v/vt/vn per corner, fanned into triangles around the first corner
+					p += 2;
+					uint corners = 0;
+					int firstPosition = 0, firstNormal = 0, previousPosition = 0, previousNormal = 0;
+					for (;;)
+					{
+						p = SkipSpaces(p, end);
+						if (p >= end || *p == '\n' || *p == '#')
+							break;
+
+						long long position = 0, texcoord = 0, normal = 0;
+						if (!(p = ParseNumber(p, end, position)))
+						{
+							range.error = line;
+							return;
+						}
+						if (p < end && *p == '/')
+						{
+							p++;
+							if (p < end && *p != '/' && !(p = ParseNumber(p, end, texcoord)))
+							{
+								range.error = line;
+								return;
+							}
+							if (p < end && *p == '/' && !(p = ParseNumber(p + 1, end, normal)))
+							{
+								range.error = line;
+								return;
+							}
+						}
+
+						int cornerPosition, cornerNormal = NO_INDEX;
+						if (!EncodeIndex(position, range.positions.size(), cornerPosition)
+							|| (normal != 0 && !EncodeIndex(normal, range.normals.size(), cornerNormal)))
+						{
+							range.error = line;
+							return;
+						}
+
+						if (corners == 0)
+						{
+							firstPosition = cornerPosition;
+							firstNormal = cornerNormal;
+						}
+						else if (corners >= 2)
+						{
+							const int trianglePositions[3] = { firstPosition, previousPosition, cornerPosition };
+							const int triangleNormals[3] = { firstNormal, previousNormal, cornerNormal };
+							range.cornerPositions.insert(range.cornerPositions.end(), trianglePositions, trianglePositions + 3);
+							range.cornerNormals.insert(range.cornerNormals.end(), triangleNormals, triangleNormals + 3);
+						}
+						previousPosition = cornerPosition;
+						previousNormal = cornerNormal;
+						corners++;
+					}
+					if (corners < 3)
+					{
+						range.error = line;
+						return;
+					}
+				}
+				// Anything else (comments, vt, groups, materials, smoothing) is skipped
+				p = SkipLine(p, end);
+			}
+		}
+
+		// Turns the parsed indices into global ones. False if one is out of range.
+		bool ResolveObjRange(ObjRange& range, size_t positionCount, size_t normalCount)
+		{
+			for (size_t i = 0; i < range.cornerPositions.size(); i++)
+			{
+				const long long position = DecodeIndex(range.cornerPositions[i], range.firstPosition, positionCount);
+				const long long normal = range.cornerNormals[i] == NO_INDEX ? NO_INDEX : DecodeIndex(range.cornerNormals[i], range.firstNormal, normalCount);
+				if (position < 0 || (range.cornerNormals[i] != NO_INDEX && normal < 0))
+					return false;
+				range.cornerPositions[i] = static_cast<int>(position);
+				range.cornerNormals[i] = static_cast<int>(normal);
+			}
+			return true;
+		}
+
+		void DeduplicateObjRange(ObjRange& range)
+		{
+			const size_t cornerCount = range.cornerPositions.size();
+			VertexMap map(cornerCount / 4);
+			range.localIndices.resize(cornerCount);
+			for (size_t i = 0; i < cornerCount; i++)
+			{
+				const uint64 key = MakeVertexKey(static_cast<uint>(range.cornerPositions[i]), static_cast<uint>(range.cornerNormals[i]));
+				bool inserted;
+				range.localIndices[i] = map.FindOrInsert(key, static_cast<uint>(range.vertexKeys.size()), inserted);
+				if (inserted)
+					range.vertexKeys.push_back(key);
+			}
+		}
+
+		/*
+		* PLY
+		*/
+
+		enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+		PlyType ParsePlyType(const std::string& name)
+		{
+			if (name == "char" || name == "int8") return PlyType::Int8;
+			if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+			if (name == "short" || name == "int16") return PlyType::Int16;
+			if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+			if (name == "int" || name == "int32") return PlyType::Int32;
+			if (name == "uint" || name == "uint32") return PlyType::UInt32;
+			if (name == "float" || name == "float32") return PlyType::Float32;
+			if (name == "double" || name == "float64") return PlyType::Float64;
+			return PlyType::Invalid;
+		}
+
+		inline size_t GetPlyTypeSize(PlyType type)
+		{
+			switch (type)
+			{
+			case PlyType::Int8: case PlyType::UInt8: return 1;
+			case PlyType::Int16: case PlyType::UInt16: return 2;
+			case PlyType::Float64: return 8;
+			default: return 4;
+			}
+		}
+
+		template<typename T>
+		inline T ReadRaw(const uchar* p, bool swap)
+		{
+			uchar bytes[sizeof(T)];
+			std::memcpy(bytes, p, sizeof(T));
+			if (swap)
+				std::reverse(bytes, bytes + sizeof(T));
+			T value;
+			std::memcpy(&value, bytes, sizeof(T));
+			return value;
+		}
+
+		inline double ReadPlyScalar(const uchar* p, PlyType type, bool swap)
+		{
+			switch (type)
+			{
+			case PlyType::Int8: return static_cast<signed char>(*p);
+			case PlyType::UInt8: return *p;
+			case PlyType::Int16: return ReadRaw<short>(p, swap);
+			case PlyType::UInt16: return ReadRaw<ushort>(p, swap);
+			case PlyType::Int32: return ReadRaw<int>(p, swap);
+			case PlyType::UInt32: return ReadRaw<uint>(p, swap);
+			case PlyType::Float32: return ReadRaw<float>(p, swap);
+			default: return ReadRaw<double>(p, swap);
+			}
+		}
+
+		struct PlyProperty
+		{
+			std::string name;
+			PlyType type = PlyType::Invalid;
+			bool isList = false;
+			PlyType countType = PlyType::Invalid;
+		};
+
+		struct PlyElement
+		{
+			std::string name;
+			size_t count = 0;
+			std::vector<PlyProperty> properties;
+
+			// Size of one instance, 0 if it has list properties
+			size_t GetStride() const
+			{
+				size_t stride = 0;
+				for (const PlyProperty& property : properties)
+				{
+					if (property.isList)
+						return 0;
+					stride += GetPlyTypeSize(property.type);
+				}
+				return stride;
+			}
+
+			int FindProperty(const char* propertyName) const
+			{
+				for (size_t i = 0; i < properties.size(); i++)
+					if (properties[i].name == propertyName)
+						return static_cast<int>(i);
+				return -1;
+			}
+		};
+
+		enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+		struct PlyHeader
+		{
+			PlyFormat format = PlyFormat::Ascii;
+			std::vector<PlyElement> elements;
+			size_t bodyOffset = 0;
+		};
+
+		// Returns an error message, or null on success
+		const char* ParsePlyHeader(const uchar* data, size_t size, PlyHeader& header)
+		{
+			const char* text = reinterpret_cast<const char*>(data);
+			const char* end = text + size;
+			const char* p = text;
+			bool first = true, formatFound = false;
+			while (p < end)
+			{
+				const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+				if (!lineEnd)
+					return "header is not terminated";
+				std::istringstream line(std::string(p, lineEnd));
+				p = lineEnd + 1;
+
+				std::string keyword;
+				line >> keyword;
+				if (first)
+				{
+					if (keyword != "ply")
+						return "not a PLY file";
+					first = false;
+				}
+				else if (keyword == "format")
+				{
+					std::string format;
+					line >> format;
+					if (format == "ascii") header.format = PlyFormat::Ascii;
+					else if (format == "binary_little_endian") header.format = PlyFormat::BinaryLittleEndian;
+					else if (format == "binary_big_endian") header.format = PlyFormat::BinaryBigEndian;
+					else return "unknown format";
+					formatFound = true;
+				}
+				else if (keyword == "element")
+				{
+					PlyElement element;
+					line >> element.name >> element.count;
+					if (!line)
+						return "bad element";
+					header.elements.push_back(element);
+				}
+				else if (keyword == "property")
+				{
+					if (header.elements.empty())
+						return "property outside of an element";
+					PlyProperty property;
+					std::string type;
+					line >> type;
+					if (type == "list")
+					{
+						std::string countType, valueType;
+						line >> countType >> valueType;
+						property.isList = true;
+						property.countType = ParsePlyType(countType);
+						property.type = ParsePlyType(valueType);
+						if (property.countType == PlyType::Invalid)
+							return "unknown property type";
+					}
+					else
+						property.type = ParsePlyType(type);
+					line >> property.name;
+					if (property.type == PlyType::Invalid)
+						return "unknown property type";
+					header.elements.back().properties.push_back(property);
+				}
+				else if (keyword == "end_header")
+				{
+					header.bodyOffset = static_cast<size_t>(p - text);
+					return formatFound ? nullptr : "no format";
+				}
+				// comment and obj_info lines are skipped
+			}
+			return "header is not terminated";
+		}
+
+		// Property indices of the attributes we read, -1 when absent
+		struct PlyVertexProperties
+		{
+			// Position, normal then texcoord components
+			static constexpr uint COUNT = 8;
+
+			int position[3];
+			int normal[3];
+			int texcoord[2];
+
+			inline int Get(uint attribute) const
+			{
+				return attribute < 3 ? position[attribute] : attribute < 6 ? normal[attribute - 3] : texcoord[attribute - 6];
+			}
+		};
+
+		int FindFaceIndicesProperty(const PlyElement& faces)
+		{
+			const int index = faces.FindProperty("vertex_indices");
+			return index >= 0 ? index : faces.FindProperty("vertex_index");
+		}
+
+		// Fans a polygon into triangles. False if an index is out of range.
+		inline bool AddPolygon(const uint* polygon, uint count, uint vertexCount, std::vector<uint>& indices)
+		{
+			for (uint i = 0; i < count; i++)
+				if (polygon[i] >= vertexCount)
+					return false;
+			for (uint i = 2; i < count; i++)
+			{
+				indices.push_back(polygon[0]);
+				indices.push_back(polygon[i - 1]);
+				indices.push_back(polygon[i]);
+			}
+			return true;
+		}
+
+		const char* ReadPlyBinary(const uchar* data, size_t size, const PlyHeader& header, const PlyVertexProperties& attributes,
+			std::vector<Math::Vector3D>& positions, std::vector<Math::Vector3D>& normals, std::vector<Math::Vector2D>& texcoords, std::vector<uint>& indices)
+		{
+			const bool swap = header.format == PlyFormat::BinaryBigEndian;
+			const uchar* p = data + header.bodyOffset;
+			const uchar* end = data + size;
+
+			for (const PlyElement& element : header.elements)
+			{
+				if (element.name == "vertex")
+				{
+					const size_t stride = element.GetStride();
+					if (stride == 0)
+						return "list properties in vertices are not supported";
+					if (static_cast<size_t>(end - p) / stride < element.count)
+						return "file is truncated";
+
+					size_t offsets[PlyVertexProperties::COUNT] = {};
+					PlyType types[PlyVertexProperties::COUNT] = {};
+					size_t offset = 0;
+					for (size_t i = 0; i < element.properties.size(); i++)
+					{
+						for (uint attribute = 0; attribute < PlyVertexProperties::COUNT; attribute++)
+						{
+							if (attributes.Get(attribute) == static_cast<int>(i))
+							{
+								offsets[attribute] = offset;
+								types[attribute] = element.properties[i].type;
+							}
+						}
+						offset += GetPlyTypeSize(element.properties[i].type);
+					}
+
+					const bool hasNormals = attributes.normal[0] >= 0;
+					const bool hasTexcoords = attributes.texcoord[0] >= 0;
+					const uchar* vertices = p;
+					Core::JobSystem::ParallelFor(static_cast<uint>(element.count), 1 << 16, [&](uint begin, uint end)
+					{
+						for (uint i = begin; i < end; i++)
+						{
+							const uchar* vertex = vertices + static_cast<size_t>(i) * stride;
+							for (uint axis = 0; axis < 3; axis++)
+								positions[i][axis] = static_cast<float>(ReadPlyScalar(vertex + offsets[axis], types[axis], swap));
+							if (hasNormals)
+								for (uint axis = 0; axis < 3; axis++)
+									normals[i][axis] = static_cast<float>(ReadPlyScalar(vertex + offsets[3 + axis], types[3 + axis], swap));
+							if (hasTexcoords)
+								for (uint axis = 0; axis < 2; axis++)
+									texcoords[i][axis] = static_cast<float>(ReadPlyScalar(vertex + offsets[6 + axis], types[6 + axis], swap));
+						}
+					});
+					p += element.count * stride;
+				}
+				else if (element.name == "face")
+				{
+					// Faces vary in size: one pass over them
+					const int indicesProperty = FindFaceIndicesProperty(element);
+					const uint vertexCount = static_cast<uint>(positions.size());
+					std::vector<uint> polygon;
+					indices.reserve(element.count * 3);
+					for (size_t face = 0; face < element.count; face++)
+					{
+						for (size_t i = 0; i < element.properties.size(); i++)
+						{
+							const PlyProperty& property = element.properties[i];
+							if (!property.isList)
+							{
+								if (static_cast<size_t>(end - p) < GetPlyTypeSize(property.type))
+									return "file is truncated";
+								p += GetPlyTypeSize(property.type);
+								continue;
+							}
+							const size_t countSize = GetPlyTypeSize(property.countType);
+							if (static_cast<size_t>(end - p) < countSize)
+								return "file is truncated";
+							const uint count = static_cast<uint>(ReadPlyScalar(p, property.countType, swap));
+							p += countSize;
+							const size_t valueSize = GetPlyTypeSize(property.type);
+							if (static_cast<size_t>(end - p) / valueSize < count)
+								return "file is truncated";
+							if (static_cast<int>(i) == indicesProperty)
+							{
+								polygon.resize(count);
+								for (uint corner = 0; corner < count; corner++)
+									polygon[corner] = static_cast<uint>(ReadPlyScalar(p + corner * valueSize, property.type, swap));
+								if (!AddPolygon(polygon.data(), count, vertexCount, indices))
+									return "face index out of range";
+							}
+							p += count * valueSize;
+						}
+					}
+				}
+				else
+				{
+					// Unused elements (edges, materials) are skipped, which needs a fixed size
+					const size_t stride = element.GetStride();
+					if (stride == 0 && element.count > 0)
+						return "list properties in unused elements are not supported";
+					if (static_cast<size_t>(end - p) / std::max<size_t>(stride, 1) < element.count)
+						return "file is truncated";
+					p += element.count * stride;
+				}
+			}
+			return nullptr;
+		}
+
+		const char* ReadPlyAscii(const uchar* data, size_t size, const PlyHeader& header, const PlyVertexProperties& attributes,
+			std::vector<Math::Vector3D>& positions, std::vector<Math::Vector3D>& normals, std::vector<Math::Vector2D>& texcoords, std::vector<uint>& indices)
+		{
+			const char* body = reinterpret_cast<const char*>(data) + header.bodyOffset;
+			const size_t bodySize = size - header.bodyOffset;
+			const std::vector<size_t> bounds = SplitLines(body, bodySize);
+			const uint rangeCount = static_cast<uint>(bounds.size() - 1);
+
+			// Every element instance is a line: number the lines of each range first
+			std::vector<size_t> firstLines(rangeCount + 1, 0);
+			Core::JobSystem::ParallelFor(rangeCount, 1, [&](uint begin, uint end)
+			{
+				for (uint range = begin; range < end; range++)
+					firstLines[range + 1] = static_cast<size_t>(std::count(body + bounds[range], body + bounds[range + 1], '\n'));
+			});
+			for (uint range = 0; range < rangeCount; range++)
+				firstLines[range + 1] += firstLines[range];
+
+			std::vector<size_t> elementFirstLines(header.elements.size() + 1, 0);
+			for (size_t i = 0; i < header.elements.size(); i++)
+				elementFirstLines[i + 1] = elementFirstLines[i] + header.elements[i].count;
+
+			// The last line may lack its line break
+			const size_t lineCount = firstLines[rangeCount] + (bodySize > 0 && body[bodySize - 1] != '\n' ? 1 : 0);
+			if (lineCount < elementFirstLines.back())
+				return "file is truncated";
+
+			const uint vertexCount = static_cast<uint>(positions.size());
+			const bool hasNormals = attributes.normal[0] >= 0;
+			const bool hasTexcoords = attributes.texcoord[0] >= 0;
+			std::vector<std::vector<uint>> rangeIndices(rangeCount);
+			std::vector<const char*> errors(rangeCount, nullptr);
+			Core::JobSystem::ParallelFor(rangeCount, 1, [&](uint begin, uint end)
+			{
+				std::vector<double> values;
+				std::vector<uint> polygon;
+				for (uint range = begin; range < end && !errors[range]; range++)
+				{
+					const char* p = body + bounds[range];
+					const char* rangeEnd = body + bounds[range + 1];
+					size_t element = 0;
+					for (size_t line = firstLines[range]; p < rangeEnd; line++)
+					{
+						while (element < header.elements.size() && line >= elementFirstLines[element + 1])
+							element++;
+						if (element == header.elements.size())
+							break;
+						const PlyElement& type = header.elements[element];
+						const size_t instance = line - elementFirstLines[element];
+
+						if (type.name == "vertex" || type.name == "face")
+						{
+							const int indicesProperty = type.name == "face" ? FindFaceIndicesProperty(type) : -1;
+							values.clear();
+							for (size_t i = 0; i < type.properties.size() && p; i++)
+							{
+								double value = 0.0;
+								if (!type.properties[i].isList)
+								{
+									p = ParseNumber(p, rangeEnd, value);
+									values.push_back(value);
+									continue;
+								}
+								uint count = 0;
+								if (!(p = ParseNumber(p, rangeEnd, count)))
+									break;
+								polygon.resize(count);
+								for (uint corner = 0; corner < count && p; corner++)
+									p = ParseNumber(p, rangeEnd, polygon[corner]);
+								if (p && static_cast<int>(i) == indicesProperty && !AddPolygon(polygon.data(), count, vertexCount, rangeIndices[range]))
+									p = nullptr;
+								values.push_back(0.0);
+							}
+							if (!p)
+							{
+								errors[range] = "bad value";
+								break;
+							}
+							if (type.name == "vertex")
+							{
+								for (uint axis = 0; axis < 3; axis++)
+									positions[instance][axis] = static_cast<float>(values[attributes.position[axis]]);
+								if (hasNormals)
+									for (uint axis = 0; axis < 3; axis++)
+										normals[instance][axis] = static_cast<float>(values[attributes.normal[axis]]);
+								if (hasTexcoords)
+									for (uint axis = 0; axis < 2; axis++)
+										texcoords[instance][axis] = static_cast<float>(values[attributes.texcoord[axis]]);
+							}
+						}
+						p = SkipLine(p, rangeEnd);
+					}
+				}
+			});
+
+			for (const char* error : errors)
+				if (error)
+					return error;
+
+			size_t indexCount = 0;
+			for (const std::vector<uint>& range : rangeIndices)
+				indexCount += range.size();
+			indices.reserve(indexCount);
+			for (const std::vector<uint>& range : rangeIndices)
+				indices.insert(indices.end(), range.begin(), range.end());
+			return nullptr;
+		}
+
+		bool HasExtension(const char* path, const char* extension)
+		{
+			const size_t pathLength = std::strlen(path), extensionLength = std::strlen(extension);
+			if (pathLength < extensionLength)
+				return false;
+			for (size_t i = 0; i < extensionLength; i++)
+				if (std::tolower(static_cast<uchar>(path[pathLength - extensionLength + i])) != extension[i])
+					return false;
+			return true;
+		}
+	}
+
+	bool MeshImporter::Import(const char* path, const MeshImportSettings& settings, MeshData& result)
+	{
+		static Core::Profiler::Counter& timeCounter = Core::Profiler::GetCounter("Assets/MeshImporter/ImportMicroseconds");
+		static Core::Profiler::Counter& bytesCounter = Core::Profiler::GetCounter("Assets/MeshImporter/ImportedBytes");
+		Core::ScopedTimer timer(timeCounter);
+
+		const bool isObj = HasExtension(path, ".obj");
+		if (!isObj && !HasExtension(path, ".ply"))
+		{
+			std::cout << "ERROR::MESH::UNKNOWN_EXTENSION: " << path << std::endl;
+			return false;
+		}
+
+		Core::MappedFile file;
+		if (!file.Open(path))
+			return false;
+		Core::Profiler::Add(bytesCounter, static_cast<long long>(file.GetSize()));
+
+		return isObj ? ImportObj(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), settings, result, path)
+			: ImportPly(file.GetData(), file.GetSize(), settings, result, path);
+	}
+
+	bool MeshImporter::ImportObj(const char* text, size_t size, const MeshImportSettings& settings, MeshData& result, const char* name)
+	{
+		const std::vector<size_t> bounds = SplitLines(text, size);
+		const uint rangeCount = static_cast<uint>(bounds.size() - 1);
+		std::vector<ObjRange> ranges(rangeCount);
+		Core::JobSystem::ParallelFor(rangeCount, 1, [&](uint begin, uint end)
+		{
+			for (uint i = begin; i < end; i++)
+				ParseObjRange(text + bounds[i], text + bounds[i + 1], ranges[i]);
+		});
+
+		size_t positionCount = 0, normalCount = 0, cornerCount = 0;
+		for (ObjRange& range : ranges)
+		{
+			if (range.error)
+			{
+				std::cout << "ERROR::MESH::OBJ_PARSE_ERROR: " << name << " line " << GetLineNumber(text, range.error) << std::endl;
+				return false;
+			}
+			range.firstPosition = positionCount;
+			range.firstNormal = normalCount;
+			range.firstCorner = cornerCount;
+			positionCount += range.positions.size();
+			normalCount += range.normals.size();
+			cornerCount += range.cornerPositions.size();
+		}
+		if (positionCount >= 0x7FFFFFFF || cornerCount >= 0xFFFFFFFF)
+		{
+			std::cout << "ERROR::MESH::TOO_LARGE: " << name << std::endl;
+			return false;
+		}
+
+		std::vector<Math::Vector3D> filePositions(positionCount), fileNormals(normalCount);
+		std::vector<char> resolved(rangeCount);
+		Core::JobSystem::ParallelFor(rangeCount, 1, [&](uint begin, uint end)
+		{
+			for (uint i = begin; i < end; i++)
+			{
+				ObjRange& range = ranges[i];
+				std::copy(range.positions.begin(), range.positions.end(), filePositions.begin() + range.firstPosition);
+				std::copy(range.normals.begin(), range.normals.end(), fileNormals.begin() + range.firstNormal);
+				resolved[i] = ResolveObjRange(range, positionCount, normalCount);
+				// Only corners referencing normals need deduplication: positions are unique already
+				if (resolved[i] && normalCount > 0)
+					DeduplicateObjRange(range);
+			}
+		});
+		for (uint i = 0; i < rangeCount; i++)
+		{
+			if (!resolved[i])
+			{
+				std::cout << "ERROR::MESH::OBJ_INDEX_OUT_OF_RANGE: " << name << std::endl;
+				return false;
+			}
+		}
+
+		std::vector<uint> indices(cornerCount);
+		if (normalCount == 0)
+		{
+			Core::JobSystem::ParallelFor(rangeCount, 1, [&](uint begin, uint end)
+			{
+				for (uint i = begin; i < end; i++)
+					std::copy(ranges[i].cornerPositions.begin(), ranges[i].cornerPositions.end(), indices.begin() + ranges[i].firstCorner);
+			});
+			std::vector<Math::Vector3D> normals;
+			std::vector<Math::Vector2D> texcoords;
+			StoreVertices(settings, filePositions, normals, texcoords, indices, result);
+			return true;
+		}
+
+		// Merge the ranges' distinct vertices in file order: serial, but only touches each range's
+		// distinct vertices, not every corner
+		size_t rangeVertexCount = 0;
+		for (const ObjRange& range : ranges)
+			rangeVertexCount += range.vertexKeys.size();
+		VertexMap map(rangeVertexCount);
+		std::vector<uint64> vertexKeys;
+		vertexKeys.reserve(rangeVertexCount);
+		for (ObjRange& range : ranges)
+		{
+			range.globalIndices.resize(range.vertexKeys.size());
+			for (size_t i = 0; i < range.vertexKeys.size(); i++)
+			{
+				bool inserted;
+				range.globalIndices[i] = map.FindOrInsert(range.vertexKeys[i], static_cast<uint>(vertexKeys.size()), inserted);
+				if (inserted)
+					vertexKeys.push_back(range.vertexKeys[i]);
+			}
+		}
+
+		std::vector<Math::Vector3D> positions(vertexKeys.size()), normals(vertexKeys.size());
+		Core::JobSystem::ParallelFor(rangeCount, 1, [&](uint begin, uint end)
+		{
+			for (uint i = begin; i < end; i++)
+			{
+				const ObjRange& range = ranges[i];
+				for (size_t corner = 0; corner < range.localIndices.size(); corner++)
+					indices[range.firstCorner + corner] = range.globalIndices[range.localIndices[corner]];
+			}
+		});
+		Core::JobSystem::ParallelFor(static_cast<uint>(vertexKeys.size()), 1 << 16, [&](uint begin, uint end)
+		{
+			for (uint i = begin; i < end; i++)
+			{
+				const uint normal = static_cast<uint>(vertexKeys[i]);
+				positions[i] = filePositions[vertexKeys[i] >> 32];
+				normals[i] = normal == static_cast<uint>(NO_INDEX) ? Math::Vector3D(0.0f) : fileNormals[normal];
+			}
+		});
+		std::vector<Math::Vector2D> texcoords;
+		StoreVertices(settings, positions, normals, texcoords, indices, result);
+		return true;
+	}
+
+	bool MeshImporter::ImportPly(const uchar* data, size_t size, const MeshImportSettings& settings, MeshData& result, const char* name)
+	{
+		PlyHeader header;
+		if (const char* error = ParsePlyHeader(data, size, header))
+		{
+			std::cout << "ERROR::MESH::PLY_BAD_HEADER: " << name << " (" << error << ")" << std::endl;
+			return false;
+		}
+
+		const PlyElement* vertices = nullptr;
+		for (const PlyElement& element : header.elements)
+			if (element.name == "vertex")
+				vertices = &element;
+		PlyVertexProperties attributes;
+		const char* positionNames[3] = { "x", "y", "z" };
+		const char* normalNames[3] = { "nx", "ny", "nz" };
+		for (uint axis = 0; axis < 3; axis++)
+		{
+			attributes.position[axis] = vertices ? vertices->FindProperty(positionNames[axis]) : -1;
+			attributes.normal[axis] = vertices ? vertices->FindProperty(normalNames[axis]) : -1;
+		}
+		if (!vertices || attributes.position[0] < 0 || attributes.position[1] < 0 || attributes.position[2] < 0 || vertices->count >= 0x7FFFFFFF)
+		{
+			std::cout << "ERROR::MESH::PLY_NO_POSITIONS: " << name << std::endl;
+			return false;
+		}
+		// Normals are all or nothing
+		if (attributes.normal[0] < 0 || attributes.normal[1] < 0 || attributes.normal[2] < 0)
+			attributes.normal[0] = attributes.normal[1] = attributes.normal[2] = -1;
+
+		// Texture coordinates go by several names
+		const char* texcoordNames[][2] = { { "u", "v" }, { "s", "t" }, { "texture_u", "texture_v" }, { "texture_s", "texture_t" } };
+		attributes.texcoord[0] = attributes.texcoord[1] = -1;
+		for (const auto& names : texcoordNames)
+		{
+			if (vertices->FindProperty(names[0]) >= 0 && vertices->FindProperty(names[1]) >= 0)
+			{
+				attributes.texcoord[0] = vertices->FindProperty(names[0]);
+				attributes.texcoord[1] = vertices->FindProperty(names[1]);
+				break;
+			}
+		}
+
+		std::vector<Math::Vector3D> positions(vertices->count);
+		std::vector<Math::Vector3D> normals(attributes.normal[0] >= 0 ? vertices->count : 0);
+		std::vector<Math::Vector2D> texcoords(attributes.texcoord[0] >= 0 ? vertices->count : 0);
+		std::vector<uint> indices;
+		const char* error = header.format == PlyFormat::Ascii
+			? ReadPlyAscii(data, size, header, attributes, positions, normals, texcoords, indices)
+			: ReadPlyBinary(data, size, header, attributes, positions, normals, texcoords, indices);
+		if (error)
+		{
+			std::cout << "ERROR::MESH::PLY_PARSE_ERROR: " << name << " (" << error << ")" << std::endl;
+			return false;
+		}
+
+		StoreVertices(settings, positions, normals, texcoords, indices, result);
+		return true;
+	}
+
+	bool MeshImporter::Convert(const char* meshPath, const char* containerPath, const MeshImportSettings& settings, bool shortIndices)
+	{
+		MeshData mesh;
+		if (!Import(meshPath, settings, mesh))
+			return false;
+		return MeshContainer::Write(containerPath, mesh, shortIndices);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "MeshData.h"
+#include <cstddef>
+
+namespace Assets
+{
+	struct MeshImportSettings
+	{
+		VertexLayout layout = VertexLayout::Interleaved;
+		// Area weighted vertex normals for files without any
+		bool generateNormals = true;
+		// Runs MeshOptimizer::Optimize with default settings on the result; worth it for meshes that get converted
+		bool optimize = false;
+	};
+
+	/*
+	* Geometry loading for large meshes (scans, photogrammetry). The file is memory mapped and
+	* split on line boundaries into ranges parsed in parallel on the job system, numbers going
+	* through std::from_chars. Polygons are triangulated as fans.
+	*/
+	namespace MeshImporter
+	{
+		/// <summary>
+		/// Loads a Wavefront .obj or a .ply (ascii, binary little or big endian), chosen by extension.
+		/// OBJ corners with different position / normal pairs become separate vertices, identical pairs are
+		/// shared. OBJ texture coordinates, groups and materials are ignored; PLY texture coordinates
+		/// (u/v, s/t) are read.
+		/// </summary>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		bool Import(const char* path, const MeshImportSettings& settings, MeshData& result);
+
+		// Parses OBJ text already in memory. name only appears in error messages.
+		bool ImportObj(const char* text, size_t size, const MeshImportSettings& settings, MeshData& result, const char* name = "<memory>");
+
+		// Parses a PLY file already in memory. name only appears in error messages.
+		bool ImportPly(const uchar* data, size_t size, const MeshImportSettings& settings, MeshData& result, const char* name = "<memory>");
+
+		/// <summary>
+		/// Offline converter: imports a mesh and writes it as a mesh container (.emesh).
+		/// </summary>
+		/// <param name="shortIndices">See MeshContainer::Write.</param>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		bool Convert(const char* meshPath, const char* containerPath, const MeshImportSettings& settings = MeshImportSettings(), bool shortIndices = true);
+	}
+}
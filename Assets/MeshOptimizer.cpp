@@ -0,0 +1,456 @@
+#include "MeshOptimizer.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace Assets
+{
+	namespace
+	{
+		/*
+		* FIFO cache emulation shared by the analysis and the passes: a vertex is in the cache if
+		* fewer than cacheSize misses happened since it was last loaded.
+		*/
+		class VertexCache
+		{
+		public:
+			VertexCache(uint vertexCount, uint cacheSize) : m_loadTime(vertexCount, 0), m_time(cacheSize + 1), m_cacheSize(cacheSize) {}
+
+			inline bool Contains(uint vertex) const { return m_time - m_loadTime[vertex] <= m_cacheSize; }
+
+			// True on a miss
+			inline bool Access(uint vertex)
+			{
+				if (Contains(vertex))
+					return false;
+				m_loadTime[vertex] = m_time++;
+				return true;
+			}
+
+			// Age of the vertex in misses, more than cacheSize if it is out
+			inline uint GetAge(uint vertex) const { return m_time - m_loadTime[vertex]; }
+
+			// Empties the cache without touching every vertex
+			inline void Flush() { m_time += m_cacheSize + 1; }
+
+		private:
+			std::vector<uint> m_loadTime;
+			uint m_time;
+			uint m_cacheSize;
+		};
+
+		// Triangles using each vertex, as offsets into one array
+		struct Adjacency
+		{
+			std::vector<uint> offsets;
+			std::vector<uint> triangles;
+
+			Adjacency(const uint* indices, size_t indexCount, uint vertexCount) : offsets(vertexCount + 1, 0), triangles(indexCount)
+			{
+				for (size_t i = 0; i < indexCount; i++)
+					offsets[indices[i] + 1]++;
+				for (uint v = 0; v < vertexCount; v++)
+					offsets[v + 1] += offsets[v];
+				std::vector<uint> cursor(offsets.begin(), offsets.end() - 1);
+				for (size_t i = 0; i < indexCount; i++)
+					triangles[cursor[indices[i]]++] = static_cast<uint>(i / 3);
+			}
+		};
+
+		// A vertex as bytes, for exact comparison
+		struct VertexKey
+		{
+			float values[8];
+
+			inline bool operator==(const VertexKey& other) const { return std::memcmp(values, other.values, sizeof(values)) == 0; }
+
+			inline uint64 Hash() const
+			{
+				uint words[8];
+				std::memcpy(words, values, sizeof(words));
+				uint64 hash = 0xCBF29CE484222325ull;
+				for (uint word : words)
+					hash = (hash ^ word) * 0x100000001B3ull;
+				return hash ^ (hash >> 29);
+			}
+		};
+
+		VertexKey MakeVertexKey(const MeshData& mesh, uint vertex)
+		{
+			const Math::Vector3D& position = mesh.GetPosition(vertex);
+			const Math::Vector3D& normal = mesh.GetNormal(vertex);
+			const Math::Vector2D texcoord = mesh.HasTexcoords() ? mesh.texcoords[vertex] : Math::Vector2D(0.0f, 0.0f);
+			return { { position.x, position.y, position.z, normal.x, normal.y, normal.z, texcoord.x, texcoord.y } };
+		}
+
+		const uint NO_VERTEX = 0xFFFFFFFF;
+
+		// Moves vertex i to remap[i], dropping NO_VERTEX ones. The indices are left to the caller.
+		void MoveVertices(MeshData& mesh, const std::vector<uint>& remap, uint newVertexCount)
+		{
+			const uint vertexCount = mesh.GetVertexCount();
+			if (mesh.layout == VertexLayout::Interleaved)
+			{
+				std::vector<MeshVertex> vertices(newVertexCount);
+				for (uint i = 0; i < vertexCount; i++)
+					if (remap[i] != NO_VERTEX)
+						vertices[remap[i]] = mesh.vertices[i];
+				mesh.vertices.swap(vertices);
+			}
+			else
+			{
+				std::vector<Math::Vector3D> positions(newVertexCount), normals(newVertexCount);
+				for (uint i = 0; i < vertexCount; i++)
+				{
+					if (remap[i] != NO_VERTEX)
+					{
+						positions[remap[i]] = mesh.positions[i];
+						normals[remap[i]] = mesh.normals[i];
+					}
+				}
+				mesh.positions.swap(positions);
+				mesh.normals.swap(normals);
+			}
+			if (mesh.HasTexcoords())
+			{
+				std::vector<Math::Vector2D> texcoords(newVertexCount);
+				for (uint i = 0; i < vertexCount; i++)
+					if (remap[i] != NO_VERTEX)
+						texcoords[remap[i]] = mesh.texcoords[i];
+				mesh.texcoords.swap(texcoords);
+			}
+		}
+
+		// Tipsify's next fanning vertex: the oldest candidate still cached once its remaining triangles are
+		// emitted, else any candidate with triangles left, else the latest dead end, else the next in index order
+		uint GetNextVertex(const std::vector<uint>& candidates, const VertexCache& cache, const std::vector<uint>& liveTriangles,
+			std::vector<uint>& deadEnds, uint& cursor, uint cacheSize)
+		{
+			uint best = NO_VERTEX;
+			uint bestPriority = 0;
+			for (uint vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0)
+					continue;
+				// Emitting the vertex's remaining triangles adds up to 2 misses per triangle: if it would still
+				// be cached by then, the older the better (it is about to be evicted otherwise)
+				uint priority = 0;
+				if (cache.GetAge(vertex) + 2 * liveTriangles[vertex] <= cacheSize)
+					priority = cache.GetAge(vertex);
+				if (best == NO_VERTEX || priority > bestPriority)
+				{
+					best = vertex;
+					bestPriority = priority;
+				}
+			}
+			if (best != NO_VERTEX)
+				return best;
+
+			while (!deadEnds.empty())
+			{
+				const uint vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[vertex] > 0)
+					return vertex;
+			}
+			for (; cursor < liveTriangles.size(); cursor++)
+				if (liveTriangles[cursor] > 0)
+					return cursor;
+			return NO_VERTEX;
+		}
+
+		// Triangles in [begin, end) of the index buffer
+		struct Cluster
+		{
+			uint begin;
+			uint end;
+			float sortKey;
+		};
+	}
+
+	VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint* indices, size_t indexCount, uint vertexCount, uint cacheSize)
+	{
+		VertexCacheStats stats;
+		VertexCache cache(vertexCount, cacheSize);
+		std::vector<bool> used(vertexCount, false);
+		uint usedVertices = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			stats.transformedVertices += cache.Access(indices[i]) ? 1 : 0;
+			if (!used[indices[i]])
+			{
+				used[indices[i]] = true;
+				usedVertices++;
+			}
+		}
+		const size_t triangleCount = indexCount / 3;
+		stats.acmr = triangleCount > 0 ? static_cast<float>(stats.transformedVertices) / triangleCount : 0.0f;
+		stats.atvr = usedVertices > 0 ? static_cast<float>(stats.transformedVertices) / usedVertices : 0.0f;
+		return stats;
+	}
+
+	uint MeshOptimizer::RemoveDuplicateVertices(MeshData& mesh, uint* degenerateTriangles)
+	{
+		const uint vertexCount = mesh.GetVertexCount();
+		uint bits = 4;
+		while ((1u << bits) < vertexCount * 2u && bits < 31)
+			bits++;
+		const uint64 mask = (uint64(1) << bits) - 1;
+
+		// Open addressing over vertex indices; the first of identical vertices keeps its place
+		std::vector<uint> slots(size_t(1) << bits, NO_VERTEX);
+		std::vector<uint> remap(vertexCount);
+		uint uniqueCount = 0;
+		for (uint vertex = 0; vertex < vertexCount; vertex++)
+		{
+			const VertexKey key = MakeVertexKey(mesh, vertex);
+			uint64 slot = key.Hash() & mask;
+			while (slots[slot] != NO_VERTEX && !(MakeVertexKey(mesh, slots[slot]) == key))
+				slot = (slot + 1) & mask;
+			if (slots[slot] == NO_VERTEX)
+			{
+				slots[slot] = vertex;
+				remap[vertex] = uniqueCount++;
+			}
+			else
+				remap[vertex] = remap[slots[slot]];
+		}
+
+		if (uniqueCount < vertexCount)
+		{
+			// Keep the first of each set of identical vertices, in their original order
+			std::vector<uint> keep(vertexCount, NO_VERTEX);
+			uint next = 0;
+			for (uint vertex = 0; vertex < vertexCount; vertex++)
+				if (remap[vertex] == next)
+					keep[vertex] = next++;
+			MoveVertices(mesh, keep, uniqueCount);
+			for (uint& index : mesh.indices)
+				index = remap[index];
+		}
+
+		uint degenerate = 0;
+		size_t written = 0;
+		std::vector<uint>& indices = mesh.indices;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const uint a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			if (a == b || b == c || c == a)
+			{
+				degenerate++;
+				continue;
+			}
+			indices[written++] = a;
+			indices[written++] = b;
+			indices[written++] = c;
+		}
+		indices.resize(written);
+		if (degenerateTriangles)
+			*degenerateTriangles = degenerate;
+		return vertexCount - uniqueCount;
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(uint* indices, size_t indexCount, uint vertexCount, uint cacheSize)
+	{
+		const uint triangleCount = static_cast<uint>(indexCount / 3);
+		if (triangleCount == 0)
+			return;
+
+		const Adjacency adjacency(indices, indexCount, vertexCount);
+		std::vector<uint> liveTriangles(vertexCount);
+		for (uint v = 0; v < vertexCount; v++)
+			liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint> output;
+		output.reserve(indexCount);
+		std::vector<uint> deadEnds;
+		std::vector<uint> candidates;
+		VertexCache cache(vertexCount, cacheSize);
+		uint cursor = 0;
+
+		for (uint fanning = GetNextVertex(candidates, cache, liveTriangles, deadEnds, cursor, cacheSize); fanning != NO_VERTEX;)
+		{
+			candidates.clear();
+			for (uint i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++)
+			{
+				const uint triangle = adjacency.triangles[i];
+				if (emitted[triangle])
+					continue;
+				emitted[triangle] = true;
+				for (uint corner = 0; corner < 3; corner++)
+				{
+					const uint vertex = indices[triangle * 3 + corner];
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					cache.Access(vertex);
+				}
+			}
+			fanning = GetNextVertex(candidates, cache, liveTriangles, deadEnds, cursor, cacheSize);
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	uint MeshOptimizer::OptimizeOverdraw(const MeshData& mesh, uint* indices, size_t indexCount, uint cacheSize, float threshold)
+	{
+		const uint triangleCount = static_cast<uint>(indexCount / 3);
+		const uint vertexCount = mesh.GetVertexCount();
+		if (triangleCount == 0)
+			return 0;
+
+		// Hard boundaries: triangles missing on all three vertices, where the cache restarts anyway
+		std::vector<uint> boundaries;
+		{
+			VertexCache cache(vertexCount, cacheSize);
+			for (uint triangle = 0; triangle < triangleCount; triangle++)
+			{
+				uint misses = 0;
+				for (uint corner = 0; corner < 3; corner++)
+					misses += cache.Access(indices[triangle * 3 + corner]) ? 1 : 0;
+				if (misses == 3 || triangle == 0)
+					boundaries.push_back(triangle);
+			}
+			boundaries.push_back(triangleCount);
+		}
+
+		// Soft boundaries: within a hard cluster, cut wherever the part so far has an ACMR within
+		// threshold of the whole cluster's. Each part is simulated from an empty cache, as a cluster
+		// can follow any other after sorting.
+		std::vector<Cluster> clusters;
+		VertexCache cache(vertexCount, cacheSize);
+		for (size_t i = 0; i + 1 < boundaries.size(); i++)
+		{
+			const uint begin = boundaries[i], end = boundaries[i + 1];
+			cache.Flush();
+			uint clusterMisses = 0;
+			for (uint index = begin * 3; index < end * 3; index++)
+				clusterMisses += cache.Access(indices[index]) ? 1 : 0;
+			const float limit = threshold * clusterMisses / (end - begin);
+
+			cache.Flush();
+			uint start = begin, misses = 0;
+			for (uint triangle = begin; triangle < end; triangle++)
+			{
+				for (uint corner = 0; corner < 3; corner++)
+					misses += cache.Access(indices[triangle * 3 + corner]) ? 1 : 0;
+				if (triangle + 1 < end && static_cast<float>(misses) / (triangle + 1 - start) <= limit)
+				{
+					clusters.push_back({ start, triangle + 1, 0.0f });
+					start = triangle + 1;
+					misses = 0;
+					cache.Flush();
+				}
+			}
+			clusters.push_back({ start, end, 0.0f });
+		}
+
+		// Sort key: how far the cluster faces away from the mesh center. Outward facing clusters are
+		// in front of the rest from most views, so drawing them first lets depth testing reject more.
+		std::vector<Math::Vector3D> centroids(clusters.size());
+		std::vector<Math::Vector3D> normals(clusters.size());
+		Math::Vector3D meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (size_t i = 0; i < clusters.size(); i++)
+		{
+			Math::Vector3D centroid(0.0f), normal(0.0f);
+			float area = 0.0f;
+			for (uint triangle = clusters[i].begin; triangle < clusters[i].end; triangle++)
+			{
+				const Math::Vector3D& a = mesh.GetPosition(indices[triangle * 3]);
+				const Math::Vector3D& b = mesh.GetPosition(indices[triangle * 3 + 1]);
+				const Math::Vector3D& c = mesh.GetPosition(indices[triangle * 3 + 2]);
+				const Math::Vector3D cross = Math::Vector3D::CrossProduct(b - a, c - a);
+				const float triangleArea = cross.Magnitude();
+				centroid = centroid + (a + b + c) * (triangleArea / 3.0f);
+				normal = normal + cross;
+				area += triangleArea;
+			}
+			centroids[i] = area > 0.0f ? centroid * (1.0f / area) : mesh.GetPosition(indices[clusters[i].begin * 3]);
+			normals[i] = normal;
+			meshCentroid = meshCentroid + centroid;
+			meshArea += area;
+		}
+		if (meshArea > 0.0f)
+			meshCentroid = meshCentroid * (1.0f / meshArea);
+		for (size_t i = 0; i < clusters.size(); i++)
+		{
+			const float length = normals[i].Magnitude();
+			clusters[i].sortKey = length > 0.0f ? Math::Vector3D::DotProduct(centroids[i] - meshCentroid, normals[i]) / length : 0.0f;
+		}
+		// Stable: equal keys keep the cache order
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<uint> sorted;
+		sorted.reserve(indexCount);
+		for (const Cluster& cluster : clusters)
+			sorted.insert(sorted.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+		std::copy(sorted.begin(), sorted.end(), indices);
+		return static_cast<uint>(clusters.size());
+	}
+
+	uint MeshOptimizer::OptimizeVertexFetch(MeshData& mesh)
+	{
+		const uint vertexCount = mesh.GetVertexCount();
+		std::vector<uint> remap(vertexCount, NO_VERTEX);
+		uint next = 0;
+		for (uint index : mesh.indices)
+			if (remap[index] == NO_VERTEX)
+				remap[index] = next++;
+		MoveVertices(mesh, remap, next);
+		for (uint& index : mesh.indices)
+			index = remap[index];
+		return vertexCount - next;
+	}
+
+	MeshOptimizeReport MeshOptimizer::Optimize(MeshData& mesh, const MeshOptimizeSettings& settings)
+	{
+		static Core::Profiler::Counter& timeCounter = Core::Profiler::GetCounter("Assets/MeshOptimizer/OptimizeMicroseconds");
+		Core::ScopedTimer timer(timeCounter);
+
+		auto analyze = [&mesh, &settings]()
+		{
+			return AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.GetVertexCount(), settings.cacheSize);
+		};
+
+		MeshOptimizeReport report;
+		report.initial = analyze();
+		if (settings.removeDuplicates)
+		{
+			report.duplicateVertices = RemoveDuplicateVertices(mesh, &report.degenerateTriangles);
+			report.afterDuplicates = analyze();
+		}
+		if (settings.optimizeVertexCache)
+		{
+			OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.GetVertexCount(), settings.cacheSize);
+			report.afterVertexCache = analyze();
+			if (settings.optimizeOverdraw)
+			{
+				report.clusters = OptimizeOverdraw(mesh, mesh.indices.data(), mesh.indices.size(), settings.cacheSize, settings.overdrawThreshold);
+				report.afterOverdraw = analyze();
+			}
+		}
+		if (settings.optimizeVertexFetch)
+		{
+			report.unusedVertices = OptimizeVertexFetch(mesh);
+			report.afterVertexFetch = analyze();
+		}
+		return report;
+	}
+
+	void MeshOptimizer::OptimizeBatch(MeshData* meshes, uint count, const MeshOptimizeSettings& settings, MeshOptimizeReport* reports)
+	{
+		Core::JobSystem::ParallelFor(count, 1, [=](uint begin, uint end)
+		{
+			for (uint i = begin; i < end; i++)
+			{
+				const MeshOptimizeReport report = Optimize(meshes[i], settings);
+				if (reports)
+					reports[i] = report;
+			}
+		});
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "MeshData.h"
+#include <cstddef>
+
+namespace Assets
+{
+	// Post-transform vertex cache efficiency of an index buffer, simulated as a FIFO cache
+	struct VertexCacheStats
+	{
+		uint transformedVertices = 0;
+		float acmr = 0.0f;	// Average cache miss ratio: transformed vertices per triangle. 0.5 at best, 3 at worst.
+		float atvr = 0.0f;	// Average transform to vertex ratio: transformed vertices per vertex. 1 at best.
+	};
+
+	struct MeshOptimizeSettings
+	{
+		bool removeDuplicates = true;
+		bool optimizeVertexCache = true;
+		// Needs optimizeVertexCache: orders the clusters it finds
+		bool optimizeOverdraw = true;
+		bool optimizeVertexFetch = true;
+
+		// Entries of the simulated post-transform cache (FIFO). 16 is a safe lower bound on current GPUs.
+		uint cacheSize = 16;
+		// How much the ACMR may grow to give the overdraw pass smaller clusters to reorder
+		float overdrawThreshold = 1.05f;
+	};
+
+	// Cache efficiency before and after each pass that ran; passes that did not run keep zeros
+	struct MeshOptimizeReport
+	{
+		VertexCacheStats initial;
+		VertexCacheStats afterDuplicates;
+		VertexCacheStats afterVertexCache;
+		VertexCacheStats afterOverdraw;
+		VertexCacheStats afterVertexFetch;
+
+		uint duplicateVertices = 0;		// Merged into an identical vertex
+		uint degenerateTriangles = 0;	// Dropped, two corners on the same vertex
+		uint unusedVertices = 0;		// Dropped by the vertex fetch pass
+		uint clusters = 0;				// Reordered by the overdraw pass
+	};
+
+	/*
+	* Reorders meshes for the GPU. All passes are deterministic (same input, same output on any
+	* machine and thread count) and single threaded per mesh: OptimizeBatch spreads meshes over
+	* the job system, which is where an asset pipeline gets its parallelism.
+	*
+	* - Duplicates: bitwise identical vertices are merged and degenerate triangles dropped.
+	* - Vertex cache: Tipsify (Sander, Nehab and Barczak 2007), linear time, orders triangles as
+	*   fans around vertices still in the cache.
+	* - Overdraw: the Tipsify order is cut into clusters where the cache restarts anyway, or where
+	*   cutting costs less than overdrawThreshold in ACMR. Clusters are sorted so outward facing
+	*   ones (likely occluders, from any view) draw first.
+	* - Vertex fetch: vertices are renumbered in order of first use so the vertex fetch streams
+	*   through memory; unused vertices are dropped.
+	*/
+	namespace MeshOptimizer
+	{
+		VertexCacheStats AnalyzeVertexCache(const uint* indices, size_t indexCount, uint vertexCount, uint cacheSize = 16);
+
+		/// <summary>
+		/// Runs the passes enabled in the settings, in the order above.
+		/// </summary>
+		MeshOptimizeReport Optimize(MeshData& mesh, const MeshOptimizeSettings& settings = MeshOptimizeSettings());
+
+		// Optimizes count meshes in parallel. reports may be null, otherwise receives one per mesh.
+		void OptimizeBatch(MeshData* meshes, uint count, const MeshOptimizeSettings& settings = MeshOptimizeSettings(),
+			MeshOptimizeReport* reports = nullptr);
+
+		// The passes on their own. Return what they removed, if anything.
+		uint RemoveDuplicateVertices(MeshData& mesh, uint* degenerateTriangles = nullptr);
+		void OptimizeVertexCache(uint* indices, size_t indexCount, uint vertexCount, uint cacheSize = 16);
+		// Expects indices already through OptimizeVertexCache. Returns the number of clusters.
+		uint OptimizeOverdraw(const MeshData& mesh, uint* indices, size_t indexCount, uint cacheSize = 16, float threshold = 1.05f);
+		uint OptimizeVertexFetch(MeshData& mesh);
+	}
+}
@@ -0,0 +1,345 @@
+#include "MipGenerator.h"
+#include "Core/JobSystem.h"
+#include "Math/Simd.h"
+#include <cmath>
+
+namespace Assets
+{
+	namespace
+	{
+		constexpr uint ROWS_PER_JOB = 16;
+		constexpr uint LINEAR_TO_SRGB_STEPS = 4096;
+
+		// Linear RGBA image, 4 floats per pixel.
+		struct LinearImage
+		{
+			uint width = 0;
+			uint height = 0;
+			std::vector<float> pixels;
+
+			float* Row(uint y) { return pixels.data() + static_cast<size_t>(y) * width * 4; }
+			const float* Row(uint y) const { return pixels.data() + static_cast<size_t>(y) * width * 4; }
+		};
+
+		struct ColorTables
+		{
+			float sRGBToLinear[256];
+			uchar linearToSRGB[LINEAR_TO_SRGB_STEPS];
+
+			ColorTables()
+			{
+				for (uint i = 0; i < 256; i++)
+				{
+					const float c = i / 255.0f;
+					sRGBToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+				}
+				for (uint i = 0; i < LINEAR_TO_SRGB_STEPS; i++)
+				{
+					const float l = i / float(LINEAR_TO_SRGB_STEPS - 1);
+					const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+					linearToSRGB[i] = static_cast<uchar>(c * 255.0f + 0.5f);
+				}
+			}
+		};
+
+		const ColorTables& GetColorTables()
+		{
+			static const ColorTables tables;
+			return tables;
+		}
+
+		inline float Clamp01(float v)
+		{
+			return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+		}
+
+		// Accumulates weight * pixel into sum (4 channels).
+		inline void MultiplyAdd(float* sum, const float* pixel, float weight)
+		{
+#if MATH_SIMD_SSE2
+			_mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), _mm_mul_ps(_mm_loadu_ps(pixel), _mm_set1_ps(weight))));
+#else
+			sum[0] += pixel[0] * weight;
+			sum[1] += pixel[1] * weight;
+			sum[2] += pixel[2] * weight;
+			sum[3] += pixel[3] * weight;
+#endif
+		}
+
+		LinearImage Decode(const uchar* rgba, uint width, uint height, bool sRGB)
+		{
+			const ColorTables& tables = GetColorTables();
+			LinearImage image;
+			image.width = width;
+			image.height = height;
+			image.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+			Core::JobSystem::ParallelFor(height, ROWS_PER_JOB, [&](uint begin, uint end)
+			{
+				for (uint y = begin; y < end; y++)
+				{
+					const uchar* src = rgba + static_cast<size_t>(y) * width * 4;
+					float* dst = image.Row(y);
+					for (uint i = 0; i < width * 4; i += 4)
+					{
+						for (uint c = 0; c < 3; c++)
+							dst[i + c] = sRGB ? tables.sRGBToLinear[src[i + c]] : src[i + c] / 255.0f;
+						dst[i + 3] = src[i + 3] / 255.0f;
+					}
+				}
+			});
+			return image;
+		}
+
+		MipLevel Encode(const LinearImage& image, bool sRGB)
+		{
+			const ColorTables& tables = GetColorTables();
+			MipLevel level;
+			level.width = image.width;
+			level.height = image.height;
+			level.data.resize(static_cast<size_t>(image.width) * image.height * 4);
+
+			Core::JobSystem::ParallelFor(image.height, ROWS_PER_JOB, [&](uint begin, uint end)
+			{
+				for (uint y = begin; y < end; y++)
+				{
+					const float* src = image.Row(y);
+					uchar* dst = level.data.data() + static_cast<size_t>(y) * image.width * 4;
+					for (uint i = 0; i < image.width * 4; i += 4)
+					{
+						for (uint c = 0; c < 3; c++)
+						{
+							const float v = Clamp01(src[i + c]);
+							dst[i + c] = sRGB ? tables.linearToSRGB[static_cast<uint>(v * (LINEAR_TO_SRGB_STEPS - 1) + 0.5f)]
+								: static_cast<uchar>(v * 255.0f + 0.5f);
+						}
+						dst[i + 3] = static_cast<uchar>(Clamp01(src[i + 3]) * 255.0f + 0.5f);
+					}
+				}
+			});
+			return level;
+		}
+
+		/// <summary>
+		/// Source texels a destination texel of a 2:1 box reduction along one axis covers. Even sizes
+		/// average two texels; odd sizes 2n + 1 go down to n (the GL level size) with three texels
+		/// weighted by how much of each the wider footprint covers, so the last texel is not dropped.
+		/// </summary>
+		struct BoxTaps
+		{
+			uint first;
+			uint count;
+			float weights[3];
+		};
+
+		BoxTaps GetBoxTaps(uint srcSize, uint dstSize, uint i)
+		{
+			if (srcSize == 1)
+				return { 0, 1, { 1.0f, 0.0f, 0.0f } };
+			if (srcSize % 2 == 0)
+				return { 2 * i, 2, { 0.5f, 0.5f, 0.0f } };
+			const float scale = 1.0f / srcSize;
+			return { 2 * i, 3, { (dstSize - i) * scale, dstSize * scale, (i + 1) * scale } };
+		}
+
+		LinearImage DownsampleBox(const LinearImage& src)
+		{
+			LinearImage dst;
+			dst.width = src.width > 1 ? src.width / 2 : 1;
+			dst.height = src.height > 1 ? src.height / 2 : 1;
+			dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+
+			// Odd sizes take the weighted path, even ones (and 1 texel axes) the plain 2x2 average
+			const bool oddWidth = src.width > 1 && src.width % 2 != 0;
+			const bool oddHeight = src.height > 1 && src.height % 2 != 0;
+			if (oddWidth || oddHeight)
+			{
+				Core::JobSystem::ParallelFor(dst.height, ROWS_PER_JOB, [&](uint begin, uint end)
+				{
+					for (uint y = begin; y < end; y++)
+					{
+						const BoxTaps rows = GetBoxTaps(src.height, dst.height, y);
+						float* out = dst.Row(y);
+						for (uint x = 0; x < dst.width; x++)
+						{
+							const BoxTaps columns = GetBoxTaps(src.width, dst.width, x);
+							float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+							for (uint j = 0; j < rows.count; j++)
+							{
+								const float* row = src.Row(rows.first + j);
+								for (uint i = 0; i < columns.count; i++)
+									MultiplyAdd(sum, row + (columns.first + i) * 4, rows.weights[j] * columns.weights[i]);
+							}
+							for (uint c = 0; c < 4; c++)
+								out[x * 4 + c] = sum[c];
+						}
+					}
+				});
+				return dst;
+			}
+
+			Core::JobSystem::ParallelFor(dst.height, ROWS_PER_JOB, [&](uint begin, uint end)
+			{
+				for (uint y = begin; y < end; y++)
+				{
+					const float* row0 = src.Row(2 * y < src.height ? 2 * y : src.height - 1);
+					const float* row1 = src.Row(2 * y + 1 < src.height ? 2 * y + 1 : src.height - 1);
+					float* out = dst.Row(y);
+					for (uint x = 0; x < dst.width; x++)
+					{
+						const uint x0 = (2 * x < src.width ? 2 * x : src.width - 1) * 4;
+						const uint x1 = (2 * x + 1 < src.width ? 2 * x + 1 : src.width - 1) * 4;
+#if MATH_SIMD_SSE2
+						const __m128 sum = _mm_add_ps(
+							_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+							_mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+						_mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+						for (uint c = 0; c < 4; c++)
+							out[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+#endif
+					}
+				}
+			});
+			return dst;
+		}
+
+		// Zeroth order modified Bessel function of the first kind (series expansion).
+		float BesselI0(float x)
+		{
+			float sum = 1.0f;
+			float term = 1.0f;
+			const float halfXSquared = x * x * 0.25f;
+			for (uint k = 1; k < 32 && term > sum * 1e-8f; k++)
+			{
+				term *= halfXSquared / float(k * k);
+				sum += term;
+			}
+			return sum;
+		}
+
+		// Weights of a 2:1 decimation kernel. Tap j samples source texel 2 * x + firstTap + j.
+		struct DecimationKernel
+		{
+			std::vector<float> weights;
+			int firstTap = 0;
+		};
+
+		DecimationKernel BuildKaiserKernel(float alpha, uint radius)
+		{
+			const float pi = 3.14159265f;
+			DecimationKernel kernel;
+			kernel.firstTap = 1 - static_cast<int>(radius);
+			const float denominator = BesselI0(alpha);
+			float total = 0.0f;
+			for (int j = kernel.firstTap; j <= static_cast<int>(radius); j++)
+			{
+				// Distance from the source texel center to the destination texel center, in source texels
+				const float distance = j - 0.5f;
+				const float x = distance * 0.5f;
+				const float sinc = sinf(pi * x) / (pi * x);
+				const float t = distance / radius;
+				const float window = BesselI0(alpha * sqrtf(1.0f - t * t)) / denominator;
+				kernel.weights.push_back(sinc * window);
+				total += sinc * window;
+			}
+			for (float& w : kernel.weights)
+				w /= total;
+			return kernel;
+		}
+
+		LinearImage DownsampleKaiser(const LinearImage& src, const DecimationKernel& kernel)
+		{
+			const DecimationKernel identity = { { 1.0f }, 0 };
+			const DecimationKernel& kernelX = src.width > 1 ? kernel : identity;
+			const DecimationKernel& kernelY = src.height > 1 ? kernel : identity;
+
+			// Horizontal pass: src.width x src.height -> dst.width x src.height
+			LinearImage temp;
+			temp.width = src.width > 1 ? src.width / 2 : 1;
+			temp.height = src.height;
+			temp.pixels.resize(static_cast<size_t>(temp.width) * temp.height * 4);
+
+			Core::JobSystem::ParallelFor(temp.height, ROWS_PER_JOB, [&](uint begin, uint end)
+			{
+				const int lastX = static_cast<int>(src.width) - 1;
+				for (uint y = begin; y < end; y++)
+				{
+					const float* in = src.Row(y);
+					float* out = temp.Row(y);
+					for (uint x = 0; x < temp.width; x++)
+					{
+						float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+						const int first = static_cast<int>(2 * x) + kernelX.firstTap;
+						for (size_t j = 0; j < kernelX.weights.size(); j++)
+						{
+							int sx = first + static_cast<int>(j);
+							sx = sx < 0 ? 0 : (sx > lastX ? lastX : sx);
+							MultiplyAdd(sum, in + sx * 4, kernelX.weights[j]);
+						}
+						for (uint c = 0; c < 4; c++)
+							out[x * 4 + c] = sum[c];
+					}
+				}
+			});
+
+			// Vertical pass: dst.width x src.height -> dst.width x dst.height
+			LinearImage dst;
+			dst.width = temp.width;
+			dst.height = src.height > 1 ? src.height / 2 : 1;
+			dst.pixels.assign(static_cast<size_t>(dst.width) * dst.height * 4, 0.0f);
+
+			Core::JobSystem::ParallelFor(dst.height, ROWS_PER_JOB, [&](uint begin, uint end)
+			{
+				const int lastY = static_cast<int>(temp.height) - 1;
+				for (uint y = begin; y < end; y++)
+				{
+					float* out = dst.Row(y);
+					const int first = static_cast<int>(2 * y) + kernelY.firstTap;
+					for (size_t j = 0; j < kernelY.weights.size(); j++)
+					{
+						int sy = first + static_cast<int>(j);
+						sy = sy < 0 ? 0 : (sy > lastY ? lastY : sy);
+						const float* in = temp.Row(sy);
+						for (uint x = 0; x < dst.width; x++)
+							MultiplyAdd(out + x * 4, in + x * 4, kernelY.weights[j]);
+					}
+				}
+			});
+			return dst;
+		}
+	}
+
+	std::vector<MipLevel> GenerateMipChain(const uchar* rgba, uint width, uint height, const MipSettings& settings)
+	{
+		std::vector<MipLevel> chain;
+		if (rgba == nullptr || width == 0 || height == 0)
+			return chain;
+
+		uint levelCount = GetMipCount(width, height);
+		if (settings.maxLevels != 0 && settings.maxLevels < levelCount)
+			levelCount = settings.maxLevels;
+		chain.reserve(levelCount);
+
+		MipLevel base;
+		base.width = width;
+		base.height = height;
+		base.data.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+		chain.push_back(std::move(base));
+
+		if (levelCount == 1)
+			return chain;
+
+		const DecimationKernel kaiser = BuildKaiserKernel(settings.kaiserAlpha, settings.kaiserRadius > 0 ? settings.kaiserRadius : 1);
+
+		// Each level is filtered from the previous one, which stays in linear float to avoid
+		// accumulating quantization error along the chain.
+		LinearImage current = Decode(rgba, width, height, settings.sRGB);
+		for (uint level = 1; level < levelCount; level++)
+		{
+			current = settings.filter == MipFilter::Kaiser ? DownsampleKaiser(current, kaiser) : DownsampleBox(current);
+			chain.push_back(Encode(current, settings.sRGB));
+		}
+		return chain;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "TextureData.h"
+
+namespace Assets
+{
+	enum class MipFilter
+	{
+		Box,	// 2x2 average. Cheapest, slightly blurry.
+		Kaiser	// Kaiser-windowed sinc. Sharper, keeps detail in the lower levels.
+	};
+
+	struct MipSettings
+	{
+		MipFilter filter = MipFilter::Box;
+		// Color channels are stored in sRGB and filtered in linear space. Alpha is always linear.
+		bool sRGB = true;
+		// 0 generates the full chain down to 1x1.
+		uint maxLevels = 0;
+		// Kaiser window shape and half-width in source texels.
+		float kaiserAlpha = 4.0f;
+		uint kaiserRadius = 3;
+	};
+
+	/// <summary>
+	/// Builds a mip chain from an RGBA8 image. Levels are filtered in linear space using SSE
+	/// and rows are processed in parallel on the job system.
+	/// </summary>
+	/// <param name="rgba">Level 0 pixels, 4 bytes per pixel, rows tightly packed.</param>
+	/// <param name="width">Width of level 0.</param>
+	/// <param name="height">Height of level 0.</param>
+	/// <param name="settings">Filter and color space options.</param>
+	/// <returns>RGBA8 levels, the first one being a copy of the input.</returns>
+	std::vector<MipLevel> GenerateMipChain(const uchar* rgba, uint width, uint height, const MipSettings& settings = MipSettings());
+}
@@ -0,0 +1,123 @@
+#include "TextureContainer.h"
+#include <fstream>
+#include <iostream>
+
+namespace Assets
+{
+	namespace
+	{
+		inline uint64 AlignUp(uint64 value, uint64 alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	TextureContainer::TextureContainer(const char* path)
+	{
+		Open(path);
+	}
+
+	bool TextureContainer::Write(const char* path, const TextureData& texture, uint64 sourceKey)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			std::cout << "ERROR::TEXTURE_CONTAINER::CANNOT_OPEN_FOR_WRITING: " << path << std::endl;
+			return false;
+		}
+
+		const uint mipCount = static_cast<uint>(texture.mips.size());
+		ContainerHeader header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.format = static_cast<uint>(texture.format);
+		header.sRGB = texture.sRGB ? 1 : 0;
+		header.width = mipCount > 0 ? texture.mips[0].width : 0;
+		header.height = mipCount > 0 ? texture.mips[0].height : 0;
+		header.mipCount = mipCount;
+		header.mipAlignment = MIP_ALIGNMENT;
+		header.sourceKey = sourceKey;
+
+		std::vector<ContainerMipEntry> entries(mipCount);
+		uint64 offset = AlignUp(sizeof(ContainerHeader) + sizeof(ContainerMipEntry) * mipCount, MIP_ALIGNMENT);
+		for (uint i = 0; i < mipCount; i++)
+		{
+			entries[i] = { texture.mips[i].width, texture.mips[i].height, offset, texture.mips[i].data.size() };
+			offset = AlignUp(offset + entries[i].size, MIP_ALIGNMENT);
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), sizeof(ContainerMipEntry) * mipCount);
+
+		const char padding[MIP_ALIGNMENT] = {};
+		uint64 written = sizeof(ContainerHeader) + sizeof(ContainerMipEntry) * mipCount;
+		for (uint i = 0; i < mipCount; i++)
+		{
+			file.write(padding, static_cast<std::streamsize>(entries[i].offset - written));
+			file.write(reinterpret_cast<const char*>(texture.mips[i].data.data()), static_cast<std::streamsize>(entries[i].size));
+			written = entries[i].offset + entries[i].size;
+		}
+
+		if (!file)
+		{
+			std::cout << "ERROR::TEXTURE_CONTAINER::WRITE_FAILED: " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool TextureContainer::Open(const char* path)
+	{
+		Close();
+		if (!m_file.Open(path))
+			return false;
+
+		const uchar* bytes = m_file.GetData();
+		const size_t fileSize = m_file.GetSize();
+		const ContainerHeader* header = reinterpret_cast<const ContainerHeader*>(bytes);
+		if (fileSize < sizeof(ContainerHeader) || header->magic != MAGIC || header->version != VERSION
+			|| header->format > static_cast<uint>(TextureFormat::BC7) || header->mipAlignment != MIP_ALIGNMENT
+			|| fileSize < sizeof(ContainerHeader) + sizeof(ContainerMipEntry) * static_cast<size_t>(header->mipCount))
+		{
+			std::cout << "ERROR::TEXTURE_CONTAINER::INVALID_HEADER: " << path << std::endl;
+			m_file.Close();
+			return false;
+		}
+
+		// Validate the index once so GetMip never reads outside the mapping
+		const ContainerMipEntry* mips = reinterpret_cast<const ContainerMipEntry*>(bytes + sizeof(ContainerHeader));
+		const TextureFormat format = static_cast<TextureFormat>(header->format);
+		for (uint i = 0; i < header->mipCount; i++)
+		{
+			if (mips[i].offset % MIP_ALIGNMENT != 0 || mips[i].offset > fileSize || mips[i].size > fileSize - mips[i].offset
+				|| mips[i].size != GetLevelSize(format, mips[i].width, mips[i].height))
+			{
+				std::cout << "ERROR::TEXTURE_CONTAINER::CORRUPTED_LEVEL " << i << ": " << path << std::endl;
+				m_file.Close();
+				return false;
+			}
+		}
+
+		m_header = header;
+		m_mips = mips;
+		return true;
+	}
+
+	void TextureContainer::Close()
+	{
+		m_file.Close();
+		m_header = nullptr;
+		m_mips = nullptr;
+	}
+
+	TextureLevelView TextureContainer::GetMip(uint level) const
+	{
+		if (m_header == nullptr || level >= m_header->mipCount)
+		{
+			std::cout << "ERROR::TEXTURE_CONTAINER::INVALID_LEVEL " << level << std::endl;
+			return {};
+		}
+		const ContainerMipEntry& entry = m_mips[level];
+		return { entry.width, entry.height, m_file.GetData() + entry.offset, static_cast<size_t>(entry.size) };
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "TextureData.h"
+#include "Core/MappedFile.h"
+
+namespace Assets
+{
+	/*
+	* Engine texture container (.etex): a processed mip chain stored exactly as it is uploaded.
+	*
+	* Layout:
+	*   ContainerHeader
+	*   ContainerMipEntry[mipCount]
+	*   level data, every level starting at a multiple of MIP_ALIGNMENT
+	*
+	* Opening a container maps the file; the level views point straight into the mapping,
+	* so the bytes go from the page cache to the upload with no intermediate copy.
+	*/
+	class TextureContainer
+	{
+	public:
+		static constexpr uint MAGIC = 0x58455445; // "ETEX"
+		static constexpr uint VERSION = 2;
+		static constexpr uint MIP_ALIGNMENT = 256;
+
+		struct ContainerHeader
+		{
+			uint magic;
+			uint version;
+			uint format;
+			uint sRGB;
+			uint width;
+			uint height;
+			uint mipCount;
+			uint mipAlignment;
+			uint64 sourceKey; // TextureImporter::GetSourceKey of the import, 0 if unknown
+		};
+
+		struct ContainerMipEntry
+		{
+			uint width;
+			uint height;
+			uint64 offset; // From the start of the file
+			uint64 size;
+		};
+
+		TextureContainer() = default;
+		explicit TextureContainer(const char* path);
+
+		/// <summary>
+		/// Writes the texture as a container.
+		/// </summary>
+		/// <param name="sourceKey">Identifies the source and settings the texture was imported with, see TextureImporter::GetSourceKey.</param>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		static bool Write(const char* path, const TextureData& texture, uint64 sourceKey = 0);
+
+		/// <summary>
+		/// Maps a container and validates its header and level index.
+		/// </summary>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		bool Open(const char* path);
+		void Close();
+
+		inline bool IsOpen() const { return m_header != nullptr; }
+		inline TextureFormat GetFormat() const { return static_cast<TextureFormat>(m_header->format); }
+		inline bool IsSRGB() const { return m_header->sRGB != 0; }
+		inline uint GetMipCount() const { return m_header->mipCount; }
+		inline uint64 GetSourceKey() const { return m_header->sourceKey; }
+
+		// View into the mapped file, valid while the container stays open. Empty if the level does not exist.
+		TextureLevelView GetMip(uint level) const;
+
+	private:
+		Core::MappedFile m_file;
+		const ContainerHeader* m_header = nullptr;
+		const ContainerMipEntry* m_mips = nullptr;
+	};
+}
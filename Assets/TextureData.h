@@ -0,0 +1,87 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <cstddef>
+#include <vector>
+
+namespace Assets
+{
+	// Pixel layout of every mip level of a texture.
+	enum class TextureFormat : uint
+	{
+		RGBA8 = 0,	// Uncompressed, 4 bytes per pixel
+		BC1 = 1,	// RGB + 1 bit alpha, 8 bytes per 4x4 block
+		BC3 = 2,	// RGBA, 16 bytes per 4x4 block
+		BC5 = 3,	// Two channels (RG, e.g. normal maps), 16 bytes per 4x4 block
+		BC7 = 4		// High quality RGBA, 16 bytes per 4x4 block
+	};
+
+	struct MipLevel
+	{
+		uint width = 0;
+		uint height = 0;
+		std::vector<uchar> data;
+	};
+
+	// A full mip chain ready to be uploaded, level 0 being the largest.
+	struct TextureData
+	{
+		TextureFormat format = TextureFormat::RGBA8;
+		bool sRGB = true;
+		std::vector<MipLevel> mips;
+	};
+
+	// Non-owning view of one level, e.g. pointing into a memory mapped texture container.
+	struct TextureLevelView
+	{
+		uint width = 0;
+		uint height = 0;
+		const uchar* data = nullptr;
+		size_t size = 0;
+	};
+
+	inline TextureLevelView MakeLevelView(const MipLevel& level)
+	{
+		return { level.width, level.height, level.data.data(), level.data.size() };
+	}
+
+	inline bool IsBlockCompressed(TextureFormat format)
+	{
+		return format != TextureFormat::RGBA8;
+	}
+
+	// Bytes per 4x4 block for compressed formats, bytes per pixel for RGBA8.
+	inline uint GetBlockSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1: return 8;
+		case TextureFormat::BC3:
+		case TextureFormat::BC5:
+		case TextureFormat::BC7: return 16;
+		default: return 4;
+		}
+	}
+
+	// Size in bytes of a single level with the given dimensions.
+	inline size_t GetLevelSize(TextureFormat format, uint width, uint height)
+	{
+		if (!IsBlockCompressed(format))
+			return static_cast<size_t>(width) * height * 4;
+		const size_t blocksX = (width + 3) / 4;
+		const size_t blocksY = (height + 3) / 4;
+		return blocksX * blocksY * GetBlockSize(format);
+	}
+
+	// Number of levels of a full chain down to 1x1.
+	inline uint GetMipCount(uint width, uint height)
+	{
+		uint count = 1;
+		while (width > 1 || height > 1)
+		{
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			count++;
+		}
+		return count;
+	}
+}
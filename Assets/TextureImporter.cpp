@@ -0,0 +1,84 @@
+#include "TextureImporter.h"
+#include "BlockCompressor.h"
+#include "TextureContainer.h"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "Middleware/stb/stb_image.h"
+
+namespace Assets
+{
+	namespace
+	{
+		// FNV-1a over the bytes of value
+		template<typename T>
+		void HashValue(uint64& hash, const T& value)
+		{
+			uchar bytes[sizeof(T)];
+			std::memcpy(bytes, &value, sizeof(T));
+			for (uchar byte : bytes)
+				hash = (hash ^ byte) * 0x100000001B3ull;
+		}
+
+		// Two channel data (normal maps) is not color: never decoded from sRGB before filtering
+		MipSettings GetMipSettings(const TextureImportSettings& settings)
+		{
+			MipSettings mips = settings.mips;
+			if (settings.format == TextureFormat::BC5)
+				mips.sRGB = false;
+			return mips;
+		}
+	}
+
+	bool TextureImporter::Import(const char* imagePath, const TextureImportSettings& settings, TextureData& result)
+	{
+		int width, height, channels;
+		uchar* pixels = stbi_load(imagePath, &width, &height, &channels, 4);
+		if (pixels == nullptr)
+		{
+			std::cout << "ERROR::TEXTURE::FAILED_TO_LOAD: " << imagePath << " (" << stbi_failure_reason() << ")" << std::endl;
+			return false;
+		}
+
+		const MipSettings mips = GetMipSettings(settings);
+		const std::vector<MipLevel> chain = GenerateMipChain(pixels, width, height, mips);
+		stbi_image_free(pixels);
+
+		result = BlockCompressor::Compress(chain, settings.format, mips.sRGB);
+		return true;
+	}
+
+	uint64 TextureImporter::GetSourceKey(const char* imagePath, const TextureImportSettings& settings)
+	{
+		std::error_code error;
+		const uint64 size = std::filesystem::file_size(imagePath, error);
+		if (error)
+			return 0;
+		const long long time = std::filesystem::last_write_time(imagePath, error).time_since_epoch().count();
+		if (error)
+			return 0;
+
+		uint64 hash = 0xCBF29CE484222325ull;
+		HashValue(hash, size);
+		HashValue(hash, time);
+		HashValue(hash, static_cast<uint>(settings.format));
+		const MipSettings mips = GetMipSettings(settings);
+		HashValue(hash, static_cast<uint>(mips.filter));
+		HashValue(hash, mips.sRGB);
+		HashValue(hash, mips.maxLevels);
+		HashValue(hash, mips.kaiserAlpha);
+		HashValue(hash, mips.kaiserRadius);
+		// 0 means no key
+		return hash != 0 ? hash : 1;
+	}
+
+	bool TextureImporter::Convert(const char* imagePath, const char* containerPath, const TextureImportSettings& settings)
+	{
+		TextureData texture;
+		if (!Import(imagePath, settings, texture))
+			return false;
+		return TextureContainer::Write(containerPath, texture, GetSourceKey(imagePath, settings));
+	}
+}
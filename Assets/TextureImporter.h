@@ -0,0 +1,44 @@
+#pragma once
+#include "TextureData.h"
+#include "MipGenerator.h"
+
+namespace Assets
+{
+	struct TextureImportSettings
+	{
+		// BC3 compresses fast enough for load time; BC7 looks better but encodes at a few MPix/s,
+		// so it is meant for offline conversion (GetOfflineSettings). BC5 mips are always filtered as linear data.
+		TextureFormat format = TextureFormat::BC3;
+		MipSettings mips;
+	};
+
+	namespace TextureImporter
+	{
+		/// <summary>
+		/// Decodes any image stb_image reads, builds its mip chain and compresses it.
+		/// </summary>
+		/// <returns>False if the image could not be decoded.</returns>
+		bool Import(const char* imagePath, const TextureImportSettings& settings, TextureData& result);
+
+		/// <summary>
+		/// Identifies what an import would produce: the settings plus the size and modification time
+		/// of the source. A cached container is only valid for the same key.
+		/// </summary>
+		/// <returns>0 if the source does not exist.</returns>
+		uint64 GetSourceKey(const char* imagePath, const TextureImportSettings& settings);
+
+		// Default settings of the offline converter: BC7, the encode time is paid once
+		inline TextureImportSettings GetOfflineSettings()
+		{
+			TextureImportSettings settings;
+			settings.format = TextureFormat::BC7;
+			return settings;
+		}
+
+		/// <summary>
+		/// Offline converter: imports an image and writes it as a texture container (.etex).
+		/// </summary>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		bool Convert(const char* imagePath, const char* containerPath, const TextureImportSettings& settings = GetOfflineSettings());
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <chrono>
+#include <string>
+
+/*
+* Benchmarks and CPU side tests of the engine subsystems, one function per subsystem.
+*
+*   Benchmarks                 lists them
+*   Benchmarks <name> [...]    runs the named ones, "all" runs every one
+*
+* Each returns its number of failed checks and the process exits with the total, so the
+* tests can gate a build. Timings are printed, never checked: build Release x64 to compare them.
+*/
+namespace Benchmarks
+{
+	// Prints what failed and returns 1, so failures add up into the return value
+	int Check(bool condition, const char* what);
+
+	inline double GetMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Reversed-Z and infinite far projections: depth mapping, frustum planes and depth error per distance
+	int RunDepthPrecision();
+
+	// Frame arenas against malloc, single threaded and on the job system, and their frame lifetime
+	int RunFrameAllocator();
+
+	// Vec / Mat templates against the hand written loops they replaced: time and bits
+	int RunMathTemplates();
+
+	// OBJ and PLY import throughput against a typical ifstream loader, and the formats' edge cases
+	int RunMeshImporter();
+
+	// Quantized mesh container: encoding error, round trip, and load time against importing the source
+	int RunMeshContainer();
+
+	// Draw recording into per-thread command lists, serial and on the job system, against direct submission
+	int RunCommandLists();
+
+	// Software occlusion culling: rasterize and test times, the SSE path against the scalar one,
+	// culled boxes really hidden, and the same result on any number of threads
+	int RunOcclusion();
+
+	// Render queue sort and redundant state filtering, checked through a RecordingRenderBackend
+	int RunRenderQueue();
+
+	// Scene graph of 500k nodes with 5% moving per frame: dirty subtree propagation time and correctness
+	int RunSceneGraph();
+
+	// Stream buffer sub-allocation, alignment and fencing, on a simulated device
+	int RunStreamBuffer();
+
+	// Mip generation and BCn compression throughput in MPix/s, checked against a serial and a reference decode
+	int RunTextureCompression();
+
+	// Texture container load against decoding the source on load, and the container's validation
+	int RunTextureContainer();
+
+	// TransformSystem over a million entities, on the job system and on one thread
+	int RunTransformSystem();
+
+	// Wavefront OBJ of a size x size grid of quads with per-vertex normals, 58 MB at 700
+	void WriteGridObj(const std::string& path, int size);
+}
@@ -0,0 +1,146 @@
+#include "Benchmark.h"
+#include "Core/JobSystem.h"
+#include "Graphics/CommandList.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using Command = RecordingRenderBackend::CommandType;
+
+namespace
+{
+	const uint DRAW_COUNT = 100000;
+	const uint UNIFORM_BINDING = 1;
+
+	// Draw i of the frame, with a uniform block whose first float is i
+	DrawPacket MakePacket(uint i, float (&color)[4])
+	{
+		DrawPacket packet;
+		packet.program = 1 + i % 7;
+		packet.vertexArray = 1 + i % 13;
+		packet.textures[0] = 1 + i % 29;
+		packet.indexCount = 36;
+		packet.modelLocation = 0;
+		packet.uniformBlockSize = sizeof(color);
+		packet.uniformBinding = UNIFORM_BINDING;
+		packet.sortKey = RenderSortKey::Opaque(1, packet.program, 0, packet.textures[0], static_cast<float>(i % 1000) + 1.0f);
+		color[0] = static_cast<float>(i);
+		color[1] = color[2] = 0.0f;
+		color[3] = 1.0f;
+		return packet;
+	}
+
+	void RecordRange(CommandList& list, const std::vector<Math::Matrix4D>& models, uint begin, uint end)
+	{
+		for (uint i = begin; i < end; i++)
+		{
+			float color[4];
+			const DrawPacket packet = MakePacket(i, color);
+			list.Record(packet, &models[i], color);
+		}
+	}
+
+	// Every draw must come out once, with its own uniform block
+	int CheckQueue(const RenderQueue& queue)
+	{
+		RecordingRenderBackend backend;
+		queue.Execute(backend);
+
+		std::vector<uint> draws;
+		bool blocksValid = true;
+		for (const RecordingRenderBackend::Command& command : backend.GetCommands())
+		{
+			if (command.type != Command::SetUniformBlock)
+				continue;
+			float head;
+			std::memcpy(&head, &command.arguments[2], sizeof(head));
+			blocksValid &= command.arguments[0] == UNIFORM_BINDING && command.arguments[1] == 4 * sizeof(float);
+			draws.push_back(static_cast<uint>(head));
+		}
+		std::sort(draws.begin(), draws.end());
+		bool everyDrawOnce = draws.size() == DRAW_COUNT;
+		for (uint i = 0; everyDrawOnce && i < DRAW_COUNT; i++)
+			everyDrawOnce = draws[i] == i;
+
+		int failures = 0;
+		failures += Benchmarks::Check(queue.GetPacketCount() == DRAW_COUNT && queue.GetTransformCount() == DRAW_COUNT, "every draw merged");
+		failures += Benchmarks::Check(backend.Count(Command::DrawIndexed) == DRAW_COUNT && backend.Count(Command::SetMatrix) == DRAW_COUNT, "every draw executed");
+		failures += Benchmarks::Check(blocksValid, "uniform blocks keep their binding and size");
+		failures += Benchmarks::Check(everyDrawOnce, "every uniform block executed once");
+		return failures;
+	}
+}
+
+int Benchmarks::RunCommandLists()
+{
+	const int REPEAT_COUNT = 5;
+	const std::vector<Math::Matrix4D> models(DRAW_COUNT, Math::Matrix4D::Identity());
+	RenderQueue queue;
+	int failures = 0;
+
+	// Baseline: one thread submitting straight to the queue
+	for (int repeat = 0; repeat < REPEAT_COUNT; repeat++)
+	{
+		queue.Reset();
+		const auto start = std::chrono::steady_clock::now();
+		for (uint i = 0; i < DRAW_COUNT; i++)
+		{
+			float color[4];
+			DrawPacket packet = MakePacket(i, color);
+			packet.transform = queue.AddTransform(models[i]);
+			packet.uniformBlock = queue.AddUniformBlock(color, sizeof(color));
+			queue.Submit(packet);
+		}
+		const double submitTime = GetMilliseconds(start);
+		std::printf("serial submit:     %7.2f ms (%6.0f draws/ms)\n", submitTime, DRAW_COUNT / submitTime);
+	}
+	failures += CheckQueue(queue);
+
+	// Draws take about 160 bytes each, and one list may get all of them
+	CommandListSet lists(DRAW_COUNT * 256);
+	for (int repeat = 0; repeat < REPEAT_COUNT; repeat++)
+	{
+		lists.Reset();
+		queue.Reset();
+		auto start = std::chrono::steady_clock::now();
+		RecordRange(lists.GetThreadList(), models, 0, DRAW_COUNT);
+		const double recordTime = GetMilliseconds(start);
+		start = std::chrono::steady_clock::now();
+		lists.MergeInto(queue);
+		const double mergeTime = GetMilliseconds(start);
+		std::printf("serial record:     %7.2f ms (%6.0f draws/ms), merge %.2f ms\n", recordTime, DRAW_COUNT / recordTime, mergeTime);
+	}
+	failures += CheckQueue(queue);
+
+	for (int repeat = 0; repeat < REPEAT_COUNT; repeat++)
+	{
+		lists.Reset();
+		queue.Reset();
+		auto start = std::chrono::steady_clock::now();
+		Core::JobSystem::ParallelFor(DRAW_COUNT, 1024, [&lists, &models](uint begin, uint end)
+		{
+			RecordRange(lists.GetThreadList(), models, begin, end);
+		});
+		const double recordTime = GetMilliseconds(start);
+		start = std::chrono::steady_clock::now();
+		lists.MergeInto(queue);
+		const double mergeTime = GetMilliseconds(start);
+		start = std::chrono::steady_clock::now();
+		queue.Sort();
+		const double sortTime = GetMilliseconds(start);
+		std::printf("parallel record:   %7.2f ms (%6.0f draws/ms), merge %.2f ms, sort %.2f ms, %u threads\n",
+			recordTime, DRAW_COUNT / recordTime, mergeTime, sortTime, Core::JobSystem::GetThreadCount());
+	}
+	failures += CheckQueue(queue);
+
+	// A full list drops draws instead of growing
+	CommandList small(1000);
+	const DrawPacket packet;
+	uint recorded = 0;
+	while (recorded < 1000 && small.Record(packet, &models[0]))
+		recorded++;
+	failures += Check(recorded > 0 && recorded < 1000 && small.GetCount() == recorded, "full list drops draws");
+
+	return failures;
+}
@@ -0,0 +1,162 @@
+#include "Benchmark.h"
+#include "Graphics/Camera.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace Math;
+using CameraUtilities::DepthMode;
+
+namespace
+{
+	struct Projection
+	{
+		const char* name;
+		Matrix4D matrix;
+		ClipDepth clipDepth;
+		bool reversedZ;
+		bool infinite;
+	};
+
+	// Normalized device depth of a point straight ahead at distance, after the float perspective divide
+	float GetDeviceDepth(const Matrix4D& projection, float distance)
+	{
+		const Vector4D clip = projection * Vector4D(0.0f, 0.0f, -distance, 1.0f);
+		return clip.z / clip.w;
+	}
+
+	// Inverse of GetDeviceDepth, in double so only the stored depth contributes error
+	double GetDistance(const Matrix4D& projection, double deviceDepth)
+	{
+		return projection.r2c3 / (deviceDepth + projection.r2c2);
+	}
+
+	// Largest relative distance error over [10^decade, 10^(decade + 1)) when depth is stored as
+	// a float (D32F) or, with depthBits, as a normalized integer
+	double GetMaxRelativeError(const Projection& projection, int decade, uint depthBits = 0)
+	{
+		const int SAMPLES = 2000;
+		double maxError = 0.0;
+		for (int i = 0; i < SAMPLES; i++)
+		{
+			const double distance = std::pow(10.0, decade + static_cast<double>(i) / SAMPLES);
+			double depth = GetDeviceDepth(projection.matrix, static_cast<float>(distance));
+			if (projection.clipDepth == ClipDepth::NegativeOneToOne)
+			{
+				// glDepthRange maps [-1, 1] to window depth [0, 1] and the reconstruction maps it back
+				float window = 0.5f * static_cast<float>(depth) + 0.5f;
+				if (depthBits != 0)
+				{
+					const double steps = std::pow(2.0, depthBits) - 1.0;
+					window = static_cast<float>(std::round(window * steps) / steps);
+				}
+				depth = (window - 0.5f) * 2.0f;
+			}
+			maxError = std::max(maxError, std::fabs(GetDistance(projection.matrix, depth) - distance) / distance);
+		}
+		return maxError;
+	}
+
+	int CheckProjection(const Projection& projection, float nearPlane, float farPlane)
+	{
+		int failures = 0;
+		const float low = projection.clipDepth == ClipDepth::ZeroToOne ? 0.0f : -1.0f;
+		const float nearDepth = projection.reversedZ ? 1.0f : low;
+		const float farDepth = projection.reversedZ ? low : 1.0f;
+		failures += Benchmarks::Check(std::fabs(GetDeviceDepth(projection.matrix, nearPlane) - nearDepth) < 1e-4f, "near plane depth");
+		if (!projection.infinite)
+			failures += Benchmarks::Check(std::fabs(GetDeviceDepth(projection.matrix, farPlane) - farDepth) < 1e-3f, "far plane depth");
+
+		const Frustum frustum = Frustum::FromMatrix(projection.matrix, projection.clipDepth, projection.reversedZ);
+		failures += Benchmarks::Check(frustum.Contains(Vector3D(0.0f, 0.0f, -1.0f)), "frustum contains a point ahead");
+		failures += Benchmarks::Check(!frustum.Contains(Vector3D(0.0f, 0.0f, -0.05f)), "frustum excludes a point before near");
+		failures += Benchmarks::Check(!frustum.Contains(Vector3D(0.0f, 0.0f, 1.0f)), "frustum excludes a point behind");
+		failures += Benchmarks::Check(!frustum.Contains(Vector3D(100.0f, 0.0f, -1.0f)), "frustum excludes a point aside");
+		failures += Benchmarks::Check(frustum.Contains(Vector3D(0.0f, 0.0f, -0.9f * farPlane)), "frustum contains a point before far");
+		failures += Benchmarks::Check(frustum.Contains(Vector3D(0.0f, 0.0f, -1.1f * farPlane)) == projection.infinite, "far plane only without infinite far");
+		failures += Benchmarks::Check(frustum.Contains(Vector3D(0.0f, 0.0f, -1e7f)) == projection.infinite, "far plane only without infinite far");
+		return failures;
+	}
+
+	// Rays do not depend on the depth mapping; only the infinite far frustum keeps distant points
+	int CheckCamera()
+	{
+		int failures = 0;
+		Camera camera(Vector3D(3.0f, 4.0f, 5.0f));
+		camera.ProcessMouseMovement(30.0f, -20.0f);
+		camera.SetProjection(1.5f, 0.1f, 500.0f);
+
+		const uint POINT_COUNT = 37;
+		std::vector<float> points;
+		for (uint i = 0; i < POINT_COUNT; i++)
+		{
+			points.push_back(i * 50.0f + 3.0f);
+			points.push_back(i * 27.0f + 1.0f);
+		}
+		std::vector<Ray> reference(POINT_COUNT), rays(POINT_COUNT);
+		camera.ScreenPointsToRays(points.data(), POINT_COUNT, 1920.0f, 1080.0f, reference.data());
+
+		const DepthMode depthModes[] = { DepthMode::Standard, DepthMode::ReversedZ, DepthMode::InfiniteReversedZ };
+		const ClipDepth clipDepths[] = { ClipDepth::NegativeOneToOne, ClipDepth::ZeroToOne };
+		for (DepthMode depthMode : depthModes)
+		{
+			for (ClipDepth clipDepth : clipDepths)
+			{
+				camera.SetDepthMode(depthMode, clipDepth);
+				camera.ScreenPointsToRays(points.data(), POINT_COUNT, 1920.0f, 1080.0f, rays.data());
+				bool same = true;
+				for (uint i = 0; i < POINT_COUNT; i++)
+					same &= (rays[i].direction - reference[i].direction).Magnitude() < 1e-3f && (rays[i].origin - reference[i].origin).Magnitude() < 1e-3f;
+				failures += Benchmarks::Check(same, "rays independent of the depth mode");
+
+				const Frustum frustum = camera.GetFrustum();
+				failures += Benchmarks::Check(frustum.Contains(camera.GetLocation() + camera.GetForwardVector() * 10.0f), "camera frustum contains a point ahead");
+				failures += Benchmarks::Check(frustum.Contains(camera.GetLocation() + camera.GetForwardVector() * 1000.0f) == (depthMode == DepthMode::InfiniteReversedZ),
+					"camera far plane only without infinite far");
+			}
+		}
+		return failures;
+	}
+}
+
+int Benchmarks::RunDepthPrecision()
+{
+	const float NEAR_PLANE = 0.1f, FAR_PLANE = 10000.0f, FOV = DEG2RAD * 60.0f, ASPECT = 1.5f;
+	const Projection projections[] =
+	{
+		{ "standard [-1,1]", Matrix4D::Perspective(FOV, ASPECT, NEAR_PLANE, FAR_PLANE), ClipDepth::NegativeOneToOne, false, false },
+		{ "standard [0,1]", Matrix4D::Perspective(FOV, ASPECT, NEAR_PLANE, FAR_PLANE, ClipDepth::ZeroToOne), ClipDepth::ZeroToOne, false, false },
+		{ "reversed [-1,1]", Matrix4D::PerspectiveReversedZ(FOV, ASPECT, NEAR_PLANE, FAR_PLANE, ClipDepth::NegativeOneToOne), ClipDepth::NegativeOneToOne, true, false },
+		{ "reversed [0,1]", Matrix4D::PerspectiveReversedZ(FOV, ASPECT, NEAR_PLANE, FAR_PLANE), ClipDepth::ZeroToOne, true, false },
+		{ "infinite [-1,1]", Matrix4D::PerspectiveInfiniteReversedZ(FOV, ASPECT, NEAR_PLANE, ClipDepth::NegativeOneToOne), ClipDepth::NegativeOneToOne, true, true },
+		{ "infinite [0,1]", Matrix4D::PerspectiveInfiniteReversedZ(FOV, ASPECT, NEAR_PLANE), ClipDepth::ZeroToOne, true, true },
+	};
+
+	int failures = 0;
+	std::printf("Max relative distance error, near %g, far %g\n%-20s", NEAR_PLANE, FAR_PLANE, "");
+	for (int decade = -1; decade < 4; decade++)
+		std::printf("  [%g, %g)", std::pow(10.0, decade), std::pow(10.0, decade + 1));
+	std::printf("\n");
+
+	for (const Projection& projection : projections)
+	{
+		failures += CheckProjection(projection, NEAR_PLANE, FAR_PLANE);
+		std::printf("%-20s", (std::string(projection.name) + " D32F").c_str());
+		for (int decade = -1; decade < 4; decade++)
+			std::printf("  %9.1e", GetMaxRelativeError(projection, decade));
+		std::printf("\n");
+	}
+
+	// What most applications ship with, for reference
+	std::printf("%-20s", "standard [-1,1] D24");
+	for (int decade = -1; decade < 4; decade++)
+		std::printf("  %9.1e", GetMaxRelativeError(projections[0], decade, 24));
+	std::printf("\n");
+
+	// Reversed-Z with a float buffer must beat the standard mapping far away, where it matters
+	failures += Benchmarks::Check(GetMaxRelativeError(projections[3], 3) * 100.0 < GetMaxRelativeError(projections[0], 3), "reversed-Z precision at distance");
+
+	return failures + CheckCamera();
+}
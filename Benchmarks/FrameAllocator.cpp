@@ -0,0 +1,218 @@
+#include "Benchmark.h"
+#include "Core/JobSystem.h"
+#include "Memory/ArenaAllocator.h"
+#include "Memory/FrameAllocator.h"
+#include "Memory/ScopedStack.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const uint FRAME_COUNT = 20;
+	const uint ALLOCATIONS_PER_FRAME = 200000;
+	const size_t ARENA_SIZE = 64 * 1024 * 1024;
+
+	// Sizes of the temporaries of a frame: mostly small, a few larger
+	std::vector<uint> MakeSizes()
+	{
+		std::mt19937 random(5);
+		std::uniform_int_distribution<uint> small(8, 128);
+		std::uniform_int_distribution<uint> large(256, 4096);
+		std::vector<uint> sizes(ALLOCATIONS_PER_FRAME);
+		for (uint i = 0; i < ALLOCATIONS_PER_FRAME; i++)
+			sizes[i] = i % 16 == 0 ? large(random) : small(random);
+		return sizes;
+	}
+
+	// Every allocation is touched and kept until the end of the frame, as a frame's temporaries are
+	void RunSingleThreaded(const std::vector<uint>& sizes)
+	{
+		std::vector<void*> pointers(sizes.size());
+		uint sum = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint frame = 0; frame < FRAME_COUNT; frame++)
+		{
+			for (size_t i = 0; i < sizes.size(); i++)
+			{
+				pointers[i] = std::malloc(sizes[i]);
+				static_cast<uchar*>(pointers[i])[0] = static_cast<uchar>(i);
+			}
+			for (size_t i = 0; i < sizes.size(); i++)
+			{
+				sum += static_cast<uchar*>(pointers[i])[0];
+				std::free(pointers[i]);
+			}
+		}
+		const double mallocTime = Benchmarks::GetMilliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (uint frame = 0; frame < FRAME_COUNT; frame++)
+		{
+			Memory::FrameAllocator::BeginFrame();
+			for (size_t i = 0; i < sizes.size(); i++)
+			{
+				pointers[i] = Memory::FrameAllocator::Allocate(sizes[i]);
+				static_cast<uchar*>(pointers[i])[0] = static_cast<uchar>(i);
+			}
+			for (size_t i = 0; i < sizes.size(); i++)
+				sum += static_cast<uchar*>(pointers[i])[0];
+		}
+		const double arenaTime = Benchmarks::GetMilliseconds(start);
+
+		const double allocations = static_cast<double>(FRAME_COUNT) * sizes.size();
+		std::printf("1 thread, %u allocations per frame: malloc/free %.1f ns, frame arena %.1f ns per allocation, %.1fx (sum %u)\n",
+			ALLOCATIONS_PER_FRAME, mallocTime * 1e6 / allocations, arenaTime * 1e6 / allocations, mallocTime / arenaTime, sum);
+	}
+
+	// The arenas never lock; malloc has to share its heap between the workers
+	void RunParallel(const std::vector<uint>& sizes)
+	{
+		std::vector<void*> pointers(sizes.size());
+		std::atomic<uint> sum{ 0 };
+		auto touch = [&pointers, &sum](uint begin, uint end)
+		{
+			uint local = 0;
+			for (uint i = begin; i < end; i++)
+				local += static_cast<uchar*>(pointers[i])[0];
+			sum += local;
+		};
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint frame = 0; frame < FRAME_COUNT; frame++)
+		{
+			Core::JobSystem::ParallelFor(static_cast<uint>(sizes.size()), 4096, [&sizes, &pointers](uint begin, uint end)
+			{
+				for (uint i = begin; i < end; i++)
+				{
+					pointers[i] = std::malloc(sizes[i]);
+					static_cast<uchar*>(pointers[i])[0] = static_cast<uchar>(i);
+				}
+			});
+			Core::JobSystem::ParallelFor(static_cast<uint>(sizes.size()), 4096, [&pointers, &touch](uint begin, uint end)
+			{
+				touch(begin, end);
+				for (uint i = begin; i < end; i++)
+					std::free(pointers[i]);
+			});
+		}
+		const double mallocTime = Benchmarks::GetMilliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (uint frame = 0; frame < FRAME_COUNT; frame++)
+		{
+			Memory::FrameAllocator::BeginFrame();
+			Core::JobSystem::ParallelFor(static_cast<uint>(sizes.size()), 4096, [&sizes, &pointers](uint begin, uint end)
+			{
+				for (uint i = begin; i < end; i++)
+				{
+					pointers[i] = Memory::FrameAllocator::Allocate(sizes[i]);
+					static_cast<uchar*>(pointers[i])[0] = static_cast<uchar>(i);
+				}
+			});
+			Core::JobSystem::ParallelFor(static_cast<uint>(sizes.size()), 4096, touch);
+		}
+		const double arenaTime = Benchmarks::GetMilliseconds(start);
+
+		const double allocations = static_cast<double>(FRAME_COUNT) * sizes.size();
+		std::printf("%u threads: malloc/free %.1f ns, frame arenas %.1f ns per allocation, %.1fx (sum %u)\n", Core::JobSystem::GetThreadCount(),
+			mallocTime * 1e6 / allocations, arenaTime * 1e6 / allocations, mallocTime / arenaTime, sum.load());
+	}
+
+	void RunVectors()
+	{
+		const uint VECTOR_COUNT = 20000;
+		uint sum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (uint i = 0; i < VECTOR_COUNT; i++)
+		{
+			std::vector<uint> values;
+			for (uint j = 0; j < 64; j++)
+				values.push_back(i + j);
+			sum += values.back();
+		}
+		const double vectorTime = Benchmarks::GetMilliseconds(start);
+
+		Memory::FrameAllocator::BeginFrame();
+		start = std::chrono::steady_clock::now();
+		for (uint i = 0; i < VECTOR_COUNT; i++)
+		{
+			Memory::FrameVector<uint> values;
+			for (uint j = 0; j < 64; j++)
+				values.push_back(i + j);
+			sum += values.back();
+		}
+		const double frameVectorTime = Benchmarks::GetMilliseconds(start);
+		std::printf("%u vectors of 64 push_backs: std::vector %.2f ms, FrameVector %.2f ms (sum %u)\n", VECTOR_COUNT, vectorTime, frameVectorTime, sum);
+	}
+
+	int CheckArena()
+	{
+		int failures = 0;
+		Memory::LinearArena arena(1024);
+		bool aligned = true;
+		for (size_t alignment = 1; alignment <= 256; alignment *= 2)
+		{
+			arena.Allocate(3);
+			aligned &= reinterpret_cast<size_t>(arena.Allocate(8, alignment)) % alignment == 0;
+		}
+		failures += Benchmarks::Check(aligned, "allocations aligned");
+
+		const size_t allocations = arena.GetStats().allocationCount;
+		failures += Benchmarks::Check(arena.Allocate(2048) == nullptr && arena.GetStats().failedCount == 1 && arena.GetStats().allocationCount == allocations,
+			"overflow returns nullptr and is counted");
+
+		const size_t used = arena.GetUsed();
+		{
+			Memory::ScopedStack stack(arena);
+			stack.AllocateArray<float>(16);
+			failures += Benchmarks::Check(arena.GetUsed() > used, "scoped stack allocates from the arena");
+		}
+		failures += Benchmarks::Check(arena.GetUsed() == used && arena.GetStats().peak > used, "scoped stack rewinds, peak kept");
+		arena.Reset();
+		failures += Benchmarks::Check(arena.GetUsed() == 0 && arena.GetStats().totalAllocated > 0, "reset keeps the totals");
+		return failures;
+	}
+
+	// What a frame hands to the GPU survives the next BeginFrame and is recycled by the one after
+	int CheckDoubleBuffering()
+	{
+		Memory::FrameAllocator::BeginFrame();
+		uint* previous = Memory::FrameAllocator::AllocateArray<uint>(1024);
+		for (uint i = 0; i < 1024; i++)
+			previous[i] = i * 7;
+
+		Memory::FrameAllocator::BeginFrame();
+		uint* current = Memory::FrameAllocator::AllocateArray<uint>(1024);
+		std::memset(current, 0xFF, 1024 * sizeof(uint));
+		bool intact = true;
+		for (uint i = 0; i < 1024; i++)
+			intact &= previous[i] == i * 7;
+
+		Memory::FrameAllocator::BeginFrame();
+		uint* recycled = Memory::FrameAllocator::AllocateArray<uint>(1024);
+
+		int failures = 0;
+		failures += Benchmarks::Check(intact && !Memory::FrameAllocator::GetThreadArena().Owns(current), "previous frame intact after BeginFrame");
+		failures += Benchmarks::Check(recycled == previous, "frame memory recycled two frames later");
+		return failures;
+	}
+}
+
+int Benchmarks::RunFrameAllocator()
+{
+	Memory::FrameAllocator::Initialize(ARENA_SIZE);
+	int failures = 0;
+	failures += CheckArena();
+	failures += CheckDoubleBuffering();
+
+	const std::vector<uint> sizes = MakeSizes();
+	RunSingleThreaded(sizes);
+	RunParallel(sizes);
+	RunVectors();
+	return failures;
+}
@@ -0,0 +1,73 @@
+#include "Benchmark.h"
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	struct Entry
+	{
+		const char* name;
+		int (*run)();
+	};
+
+	const Entry ENTRIES[] =
+	{
+		{ "command-lists", Benchmarks::RunCommandLists },
+		{ "depth-precision", Benchmarks::RunDepthPrecision },
+		{ "frame-allocator", Benchmarks::RunFrameAllocator },
+		{ "math-templates", Benchmarks::RunMathTemplates },
+		{ "mesh-container", Benchmarks::RunMeshContainer },
+		{ "mesh-importer", Benchmarks::RunMeshImporter },
+		{ "occlusion", Benchmarks::RunOcclusion },
+		{ "render-queue", Benchmarks::RunRenderQueue },
+		{ "scene-graph", Benchmarks::RunSceneGraph },
+		{ "stream-buffer", Benchmarks::RunStreamBuffer },
+		{ "texture-compression", Benchmarks::RunTextureCompression },
+		{ "texture-container", Benchmarks::RunTextureContainer },
+		{ "transform-system", Benchmarks::RunTransformSystem },
+	};
+}
+
+namespace Benchmarks
+{
+	int Check(bool condition, const char* what)
+	{
+		if (condition)
+			return 0;
+		std::cout << "FAILED: " << what << std::endl;
+		return 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: Benchmarks <name> [...] | all" << std::endl;
+		for (const Entry& entry : ENTRIES)
+			std::cout << "  " << entry.name << std::endl;
+		return 0;
+	}
+
+	int failures = 0;
+	for (int arg = 1; arg < argc; arg++)
+	{
+		bool found = false;
+		for (const Entry& entry : ENTRIES)
+		{
+			if (std::strcmp(argv[arg], "all") != 0 && std::strcmp(argv[arg], entry.name) != 0)
+				continue;
+			found = true;
+			std::cout << "== " << entry.name << std::endl;
+			const int entryFailures = entry.run();
+			std::cout << (entryFailures == 0 ? "passed" : "FAILED") << std::endl << std::endl;
+			failures += entryFailures;
+		}
+		if (!found)
+		{
+			std::cout << "ERROR::BENCHMARKS::UNKNOWN: " << argv[arg] << std::endl;
+			failures++;
+		}
+	}
+	return failures;
+}
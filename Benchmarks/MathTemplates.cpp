@@ -0,0 +1,250 @@
+#include "Benchmark.h"
+#include "Math/Half.h"
+#include "Math/Matrix4D.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Math;
+
+namespace
+{
+	const uint COUNT = 1 << 20;
+
+	// What Vector3D and Matrix4D were before the templates: plain structs and written out expressions
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	struct Int3
+	{
+		int x, y, z;
+	};
+
+	struct Double4x4
+	{
+		double m[16];
+	};
+
+	template<typename F>
+	double TimeBest(F&& f)
+	{
+		double best = 1e30;
+		for (int repeat = 0; repeat < 5; repeat++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			best = std::min(best, Benchmarks::GetMilliseconds(start));
+		}
+		return best;
+	}
+
+	template<typename A, typename B>
+	bool SameBits(const std::vector<A>& a, const std::vector<B>& b)
+	{
+		static_assert(sizeof(A) == sizeof(B), "same layout");
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(A)) == 0;
+	}
+
+	int Report(const char* name, double templateTime, double handTime, bool same)
+	{
+		std::printf("%-22s template %7.3f ms, hand written %7.3f ms, ratio %.2f\n", name, templateTime, handTime, templateTime / handTime);
+		return Benchmarks::Check(same, name);
+	}
+
+	int RunVectors(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+		std::vector<Vector3D> a(COUNT), b(COUNT), out(COUNT);
+		std::vector<Float3> ha(COUNT), hb(COUNT), hout(COUNT);
+		for (uint i = 0; i < COUNT; i++)
+		{
+			a[i] = Vector3D(uniform(random), uniform(random), uniform(random));
+			b[i] = Vector3D(uniform(random), uniform(random), uniform(random));
+			ha[i] = { a[i].x, a[i].y, a[i].z };
+			hb[i] = { b[i].x, b[i].y, b[i].z };
+		}
+
+		int failures = 0;
+		double templateTime = TimeBest([&] { for (uint i = 0; i < COUNT; i++) out[i] = a[i] + b[i] * 0.5f; });
+		double handTime = TimeBest([&]
+		{
+			for (uint i = 0; i < COUNT; i++)
+				hout[i] = { ha[i].x + hb[i].x * 0.5f, ha[i].y + hb[i].y * 0.5f, ha[i].z + hb[i].z * 0.5f };
+		});
+		failures += Report("float3 a + b * s", templateTime, handTime, SameBits(out, hout));
+
+		templateTime = TimeBest([&] { for (uint i = 0; i < COUNT; i++) out[i] = Cross(a[i], b[i]); });
+		handTime = TimeBest([&]
+		{
+			for (uint i = 0; i < COUNT; i++)
+				hout[i] = { ha[i].y * hb[i].z - hb[i].y * ha[i].z, ha[i].z * hb[i].x - hb[i].z * ha[i].x, ha[i].x * hb[i].y - hb[i].x * ha[i].y };
+		});
+		failures += Report("float3 cross", templateTime, handTime, SameBits(out, hout));
+
+		// Offset so no vector has zero length. The zero check is the one the former Vector3D::Normalized had
+		templateTime = TimeBest([&] { for (uint i = 0; i < COUNT; i++) out[i] = Normalize(a[i] + Vector3D(3.0f)); });
+		handTime = TimeBest([&]
+		{
+			for (uint i = 0; i < COUNT; i++)
+			{
+				const float x = ha[i].x + 3.0f, y = ha[i].y + 3.0f, z = ha[i].z + 3.0f;
+				const float length = std::sqrt(x * x + y * y + z * z);
+				if (length == 0.0f)
+				{
+					std::cout << "Vector has magnitude zero" << std::endl;
+					hout[i] = { 0.0f, 0.0f, 0.0f };
+					continue;
+				}
+				hout[i] = { x / length, y / length, z / length };
+			}
+		});
+		failures += Report("float3 normalize", templateTime, handTime, SameBits(out, hout));
+
+		float templateSum = 0.0f, handSum = 0.0f;
+		templateTime = TimeBest([&]
+		{
+			templateSum = 0.0f;
+			for (uint i = 0; i < COUNT; i++)
+				templateSum += Dot(a[i], b[i]);
+		});
+		handTime = TimeBest([&]
+		{
+			handSum = 0.0f;
+			for (uint i = 0; i < COUNT; i++)
+				handSum += ha[i].x * hb[i].x + ha[i].y * hb[i].y + ha[i].z * hb[i].z;
+		});
+		failures += Report("float3 dot sum", templateTime, handTime, templateSum == handSum);
+
+		// Grid math on integer vectors
+		std::vector<Vector3Int> cells(COUNT), cellsOut(COUNT);
+		std::vector<Int3> handCells(COUNT), handCellsOut(COUNT);
+		for (uint i = 0; i < COUNT; i++)
+		{
+			cells[i] = Vector3Int(static_cast<int>(random() % 1024), static_cast<int>(random() % 1024), static_cast<int>(random() % 1024));
+			handCells[i] = { cells[i].x, cells[i].y, cells[i].z };
+		}
+		templateTime = TimeBest([&] { for (uint i = 0; i < COUNT; i++) cellsOut[i] = cells[i] * 2 + Vector3Int(1, -1, 3); });
+		handTime = TimeBest([&]
+		{
+			for (uint i = 0; i < COUNT; i++)
+				handCellsOut[i] = { handCells[i].x * 2 + 1, handCells[i].y * 2 - 1, handCells[i].z * 2 + 3 };
+		});
+		failures += Report("int3 cell * 2 + offset", templateTime, handTime, SameBits(cellsOut, handCellsOut));
+		return failures;
+	}
+
+	int RunMatrices(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+		Matrix4D matrix = Matrix4D::Rotate(Matrix4D::Translate(Matrix4D::Identity(), Vector3D(1.0f, 2.0f, 3.0f)), 0.7f, Vector3D(0.3f, 1.0f, 0.2f));
+		std::vector<Vector4D> points(COUNT), out(COUNT), handOut(COUNT);
+		for (uint i = 0; i < COUNT; i++)
+			points[i] = Vector4D(uniform(random), uniform(random), uniform(random), 1.0f);
+
+		int failures = 0;
+		double templateTime = TimeBest([&] { for (uint i = 0; i < COUNT; i++) out[i] = matrix * points[i]; });
+		const float* m = &matrix.r0c0;
+		double handTime = TimeBest([&]
+		{
+			for (uint i = 0; i < COUNT; i++)
+			{
+				const Vector4D& p = points[i];
+				handOut[i] = Vector4D(m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3] * p.w, m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7] * p.w,
+					m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11] * p.w, m[12] * p.x + m[13] * p.y + m[14] * p.z + m[15] * p.w);
+			}
+		});
+		failures += Report("float4x4 * float4", templateTime, handTime, SameBits(out, handOut));
+
+		// A chain of products, so every multiply depends on the previous one
+		const uint CHAIN = COUNT / 16;
+		Matrix4D product;
+		templateTime = TimeBest([&]
+		{
+			product = matrix;
+			for (uint i = 0; i < CHAIN; i++)
+				product = product * matrix;
+		});
+		float handProduct[16];
+		handTime = TimeBest([&]
+		{
+			std::memcpy(handProduct, m, sizeof(handProduct));
+			for (uint i = 0; i < CHAIN; i++)
+			{
+				float next[16];
+				for (int row = 0; row < 4; row++)
+				{
+					for (int column = 0; column < 4; column++)
+					{
+						next[row * 4 + column] = handProduct[row * 4] * m[column] + handProduct[row * 4 + 1] * m[4 + column]
+							+ handProduct[row * 4 + 2] * m[8 + column] + handProduct[row * 4 + 3] * m[12 + column];
+					}
+				}
+				std::memcpy(handProduct, next, sizeof(next));
+			}
+		});
+		failures += Report("float4x4 * float4x4", templateTime, handTime, std::memcmp(&product, handProduct, sizeof(handProduct)) == 0);
+
+		// The generic Mat, as used in double precision
+		const Matrix4Double doubleMatrix(matrix);
+		Matrix4Double doubleProduct;
+		templateTime = TimeBest([&]
+		{
+			doubleProduct = doubleMatrix;
+			for (uint i = 0; i < CHAIN; i++)
+				doubleProduct = doubleProduct * doubleMatrix;
+		});
+		Double4x4 handDouble, handDoubleMatrix;
+		for (int i = 0; i < 16; i++)
+			handDoubleMatrix.m[i] = doubleMatrix(i / 4, i % 4);
+		handTime = TimeBest([&]
+		{
+			handDouble = handDoubleMatrix;
+			for (uint i = 0; i < CHAIN; i++)
+			{
+				Double4x4 next;
+				for (int row = 0; row < 4; row++)
+				{
+					for (int column = 0; column < 4; column++)
+					{
+						next.m[row * 4 + column] = handDouble.m[row * 4] * handDoubleMatrix.m[column] + handDouble.m[row * 4 + 1] * handDoubleMatrix.m[4 + column]
+							+ handDouble.m[row * 4 + 2] * handDoubleMatrix.m[8 + column] + handDouble.m[row * 4 + 3] * handDoubleMatrix.m[12 + column];
+					}
+				}
+				handDouble = next;
+			}
+		});
+		failures += Report("double4x4 * double4x4", templateTime, handTime, std::memcmp(&doubleProduct, handDouble.m, sizeof(handDouble.m)) == 0);
+		return failures;
+	}
+
+	// Every finite half survives the round trip through float
+	int CheckHalf()
+	{
+		bool roundTrip = true;
+		for (uint bits = 0; bits < 0x10000; bits++)
+		{
+			if ((bits & 0x7C00) == 0x7C00)
+				continue;
+			Half half;
+			half.bits = static_cast<ushort>(bits);
+			roundTrip &= Half(static_cast<float>(half)).bits == half.bits;
+		}
+		return Benchmarks::Check(roundTrip, "half round trip");
+	}
+}
+
+int Benchmarks::RunMathTemplates()
+{
+	std::mt19937 random(17);
+	int failures = 0;
+	failures += RunVectors(random);
+	failures += RunMatrices(random);
+	failures += CheckHalf();
+	return failures;
+}
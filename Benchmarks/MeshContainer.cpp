@@ -0,0 +1,206 @@
+#include "Benchmark.h"
+#include "Assets/MeshContainer.h"
+#include "Assets/MeshImporter.h"
+#include "Math/Quantization.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace Assets;
+
+namespace
+{
+	// Octahedral normals stay unit length and within their documented angular error, axes included
+	int CheckNormalEncoding(std::mt19937& random)
+	{
+		std::normal_distribution<float> normal;
+		double maxAngle = 0.0;
+		bool unitLength = true;
+		for (int i = 0; i < 1000000; i++)
+		{
+			Math::Vector3D n = Math::Vector3D(normal(random), normal(random), normal(random)).Normalized();
+			if (i < 6)
+			{
+				n = Math::Vector3D(0.0f);
+				n[i / 2] = i % 2 ? -1.0f : 1.0f;
+			}
+			short encoded[2];
+			Math::EncodeOctahedralSnorm16(n, encoded);
+			const Math::Vector3D d = Math::DecodeOctahedralSnorm16(encoded);
+			unitLength &= std::fabs(d.Magnitude() - 1.0f) < 1e-5f;
+			const double cx = static_cast<double>(n.y) * d.z - static_cast<double>(n.z) * d.y;
+			const double cy = static_cast<double>(n.z) * d.x - static_cast<double>(n.x) * d.z;
+			const double cz = static_cast<double>(n.x) * d.y - static_cast<double>(n.y) * d.x;
+			maxAngle = std::max(maxAngle, std::asin(std::min(1.0, std::sqrt(cx * cx + cy * cy + cz * cz))) * 180.0 / 3.14159265358979);
+		}
+		std::printf("octahedral normals: max angular error %.5f degrees\n", maxAngle);
+
+		int failures = 0;
+		failures += Benchmarks::Check(unitLength, "decoded normals unit length");
+		failures += Benchmarks::Check(maxAngle < 0.004, "normal error below 0.004 degrees");
+		return failures;
+	}
+
+	// Half a step of the bounds per axis, plus float rounding
+	int CheckPositionQuantization(std::mt19937& random)
+	{
+		const Math::AABB bounds(Math::Vector3D(-3.0f, 0.0f, 5.0f), Math::Vector3D(2.0f, 0.0f, 105.0f));
+		const Math::PositionQuantization quantization(bounds);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		bool withinBound = true;
+		for (int i = 0; i < 100000; i++)
+		{
+			const Math::Vector3D p(-3.0f + 5.0f * uniform(random), 0.0f, 5.0f + 100.0f * uniform(random));
+			ushort quantized[3];
+			quantization.Quantize(p, quantized);
+			const Math::Vector3D d = quantization.Dequantize(quantized);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				const float extent = bounds.max[axis] - bounds.min[axis];
+				withinBound &= std::fabs(d[axis] - p[axis]) <= extent / 131070.0f * 1.1f;
+			}
+		}
+		return Benchmarks::Check(withinBound, "position error within half a step");
+	}
+
+	int CheckRoundTrip(const MeshData& mesh, const MeshContainer& container)
+	{
+		MeshData decoded;
+		container.Decode(decoded);
+		const Math::Vector3D extent = container.GetBounds().max - container.GetBounds().min;
+		const float positionBound = std::max(extent.x, std::max(extent.y, extent.z)) / 131070.0f * 1.1f * std::sqrt(3.0f);
+		double positionError = 0.0, normalError = 0.0;
+		bool texcoordsValid = decoded.texcoords.size() == mesh.texcoords.size();
+		for (uint i = 0; i < decoded.GetVertexCount(); i++)
+		{
+			positionError = std::max(positionError, static_cast<double>((decoded.GetPosition(i) - mesh.GetPosition(i)).Magnitude()));
+			normalError = std::max(normalError, static_cast<double>((decoded.GetNormal(i) - mesh.GetNormal(i)).Magnitude()));
+			// Halfs keep 11 significant bits
+			for (uint axis = 0; texcoordsValid && axis < 2; axis++)
+			{
+				const float value = axis == 0 ? mesh.texcoords[i].x : mesh.texcoords[i].y;
+				const float decodedValue = axis == 0 ? decoded.texcoords[i].x : decoded.texcoords[i].y;
+				texcoordsValid = std::fabs(decodedValue - value) <= std::max(std::fabs(value), 1.0f) / 2048.0f;
+			}
+		}
+		std::printf("round trip: max position error %.3g, max normal error %.3g\n", positionError, normalError);
+
+		int failures = 0;
+		failures += Benchmarks::Check(decoded.indices == mesh.indices, "indices round trip");
+		failures += Benchmarks::Check(decoded.GetVertexCount() == mesh.GetVertexCount() && positionError <= positionBound, "positions round trip");
+		failures += Benchmarks::Check(normalError < 1e-4, "normals round trip");
+		failures += Benchmarks::Check(texcoordsValid, "texcoords round trip");
+		return failures;
+	}
+
+	// Small meshes get 16-bit indices unless told otherwise, and a damaged file does not open
+	int CheckSmallMesh(const std::string& path)
+	{
+		MeshData mesh;
+		mesh.layout = VertexLayout::SoA;
+		mesh.positions = { Math::Vector3D(0.0f), Math::Vector3D(1.0f, 0.0f, 0.0f), Math::Vector3D(0.0f, 1.0f, 0.0f) };
+		mesh.normals = { Math::Vector3D(0.0f, 0.0f, 1.0f), Math::Vector3D(0.0f, 0.0f, -1.0f), Math::Vector3D(0.0f, 1.0f, 0.0f) };
+		mesh.indices = { 0, 1, 2 };
+
+		int failures = 0;
+		{
+			MeshContainer::Write(path.c_str(), mesh);
+			MeshContainer container(path.c_str());
+			MeshData decoded;
+			if (container.IsOpen())
+				container.Decode(decoded, VertexLayout::SoA);
+			failures += Benchmarks::Check(container.IsOpen() && container.GetIndexSize() == 2 && !container.HasTexcoords(), "16-bit indices for small meshes");
+			failures += Benchmarks::Check(decoded.normals.size() == 3 && decoded.normals[1].z == -1.0f && decoded.positions[2].y == 1.0f, "small mesh round trip");
+		}
+		{
+			MeshContainer::Write(path.c_str(), mesh, false);
+			MeshContainer container(path.c_str());
+			failures += Benchmarks::Check(container.IsOpen() && container.GetIndexSize() == 4, "32-bit indices on request");
+		}
+
+		// A vertex count the sections cannot hold
+		{
+			std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+			const uint vertexCount = 100;
+			file.seekp(offsetof(MeshContainer::ContainerHeader, vertexCount));
+			file.write(reinterpret_cast<const char*>(&vertexCount), sizeof(vertexCount));
+		}
+		MeshContainer corrupted;
+		failures += Benchmarks::Check(!corrupted.Open(path.c_str()), "corrupted container rejected");
+		return failures;
+	}
+}
+
+int Benchmarks::RunMeshContainer()
+{
+	const int GRID_SIZE = 700;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::string objPath = (directory / "benchmark_grid.obj").string();
+	const std::string containerPath = (directory / "benchmark_grid.emesh").string();
+	std::mt19937 random(1);
+	int failures = 0;
+
+	failures += CheckNormalEncoding(random);
+	failures += CheckPositionQuantization(random);
+
+	// Loading from source, as every start did before the container
+	WriteGridObj(objPath, GRID_SIZE);
+	MeshData mesh;
+	auto start = std::chrono::steady_clock::now();
+	const bool imported = MeshImporter::Import(objPath.c_str(), MeshImportSettings(), mesh);
+	const double importTime = GetMilliseconds(start);
+	failures += Check(imported, "OBJ imported");
+	mesh.texcoords.resize(mesh.GetVertexCount());
+	for (uint i = 0; i < mesh.GetVertexCount(); i++)
+		mesh.texcoords[i] = Math::Vector2D(mesh.GetPosition(i).x * 3.0f, mesh.GetPosition(i).y * 3.0f);
+
+	start = std::chrono::steady_clock::now();
+	failures += Check(MeshContainer::Write(containerPath.c_str(), mesh), "container written");
+	const double writeTime = GetMilliseconds(start);
+	const size_t floatBytes = mesh.GetVertexCount() * (sizeof(MeshVertex) + sizeof(Math::Vector2D)) + mesh.indices.size() * sizeof(uint);
+	std::printf("%u vertices, %zu indices: %.1f MB as floats, %.1f MB as a container; OBJ import %.1f ms, container write %.1f ms\n",
+		mesh.GetVertexCount(), mesh.indices.size(), floatBytes / 1e6, std::filesystem::file_size(containerPath) / 1e6, importTime, writeTime);
+
+	for (int repeat = 0; repeat < 3; repeat++)
+	{
+		start = std::chrono::steady_clock::now();
+		MeshContainer container;
+		if (!container.Open(containerPath.c_str()))
+		{
+			failures += Check(false, "container opened");
+			break;
+		}
+		// Touch every page, as the upload would
+		const uchar* data = container.GetSectionData();
+		uint sum = 0;
+		for (size_t i = 0; i < container.GetSectionDataSize(); i += 4096)
+			sum += data[i];
+		const double openTime = GetMilliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		MeshData decoded;
+		container.Decode(decoded);
+		const double decodeTime = GetMilliseconds(start);
+		std::printf("container open and read %.2f ms (page sum %u), decode to floats %.1f ms\n", openTime, sum, decodeTime);
+
+		if (repeat == 0)
+			failures += CheckRoundTrip(mesh, container);
+	}
+
+	// PLY texcoords go into the container like OBJ ones
+	const char* ply = "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\nproperty float z\nproperty float s\nproperty float t\n"
+		"element face 1\nproperty list uchar int vertex_indices\nend_header\n0 0 0 0 0\n1 0 0 1 0\n0 1 0 0 1\n3 0 1 2\n";
+	MeshData plyMesh;
+	const bool importedPly = MeshImporter::ImportPly(reinterpret_cast<const uchar*>(ply), std::strlen(ply), MeshImportSettings(), plyMesh);
+	failures += Check(importedPly && plyMesh.HasTexcoords() && plyMesh.texcoords[1].x == 1.0f && plyMesh.texcoords[2].y == 1.0f, "PLY texcoords imported");
+
+	failures += CheckSmallMesh(containerPath);
+	std::filesystem::remove(objPath);
+	std::filesystem::remove(containerPath);
+	return failures;
+}
@@ -0,0 +1,228 @@
+#include "Benchmark.h"
+#include "Assets/MeshImporter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+using namespace Assets;
+
+void Benchmarks::WriteGridObj(const std::string& path, int size)
+{
+	FILE* file = std::fopen(path.c_str(), "w");
+	std::fprintf(file, "# grid\no grid\n");
+	for (int y = 0; y < size; y++)
+		for (int x = 0; x < size; x++)
+			std::fprintf(file, "v %.6f %.6f %.6f\n", x * 0.01f, y * 0.01f, std::sin(x * 0.1f) * 0.1f);
+	for (int i = 0; i < size * size; i++)
+		std::fprintf(file, "vn %.6f %.6f %.6f\n", 0.0f, 0.0f, 1.0f);
+	for (int y = 0; y + 1 < size; y++)
+	{
+		for (int x = 0; x + 1 < size; x++)
+		{
+			const int a = y * size + x + 1, b = a + 1, c = a + size + 1, d = a + size;
+			std::fprintf(file, "f %d//%d %d//%d %d//%d %d//%d\n", a, a, b, b, c, c, d, d);
+		}
+	}
+	std::fclose(file);
+}
+
+namespace
+{
+	// PLY of a mesh in the given format, with an extra property between position and normal to skip
+	void WriteMeshPly(const std::string& path, const MeshData& mesh, const char* format)
+	{
+		const bool ascii = std::strcmp(format, "ascii") == 0;
+		const bool bigEndian = std::strcmp(format, "binary_big_endian") == 0;
+		FILE* file = std::fopen(path.c_str(), "wb");
+		std::fprintf(file, "ply\nformat %s 1.0\ncomment grid\nelement vertex %u\nproperty float x\nproperty float y\nproperty float z\n"
+			"property uchar red\nproperty float nx\nproperty float ny\nproperty float nz\nelement face %u\nproperty list uchar int vertex_indices\nend_header\n",
+			format, mesh.GetVertexCount(), mesh.GetTriangleCount());
+		auto put = [file, bigEndian](const void* value, uint size)
+		{
+			uchar bytes[4];
+			std::memcpy(bytes, value, size);
+			if (bigEndian)
+				std::reverse(bytes, bytes + size);
+			std::fwrite(bytes, size, 1, file);
+		};
+
+		const uchar red = 7, corners = 3;
+		for (uint i = 0; i < mesh.GetVertexCount(); i++)
+		{
+			const Math::Vector3D& p = mesh.GetPosition(i);
+			const Math::Vector3D& n = mesh.GetNormal(i);
+			if (ascii)
+			{
+				std::fprintf(file, "%g %g %g %u %g %g %g\n", p.x, p.y, p.z, red, n.x, n.y, n.z);
+				continue;
+			}
+			put(&p.x, 4); put(&p.y, 4); put(&p.z, 4);
+			put(&red, 1);
+			put(&n.x, 4); put(&n.y, 4); put(&n.z, 4);
+		}
+		for (uint t = 0; t < mesh.GetTriangleCount(); t++)
+		{
+			const uint* triangle = &mesh.indices[t * 3];
+			if (ascii)
+			{
+				std::fprintf(file, "3 %u %u %u\n", triangle[0], triangle[1], triangle[2]);
+				continue;
+			}
+			put(&corners, 1);
+			for (uint k = 0; k < 3; k++)
+				put(&triangle[k], 4);
+		}
+		std::fclose(file);
+	}
+
+	/// <summary>
+	/// The usual OBJ loader the importer replaces: getline, a stringstream per line and a
+	/// string-keyed map for the vertex dedup. Handles the "v", "vn" and "f v//vn" the grid uses.
+	/// </summary>
+	void LoadObjWithStreams(const std::string& path, MeshData& result)
+	{
+		std::ifstream file(path);
+		std::string line;
+		std::vector<Math::Vector3D> positions, normals;
+		std::unordered_map<std::string, uint> vertices;
+		result = MeshData();
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string keyword;
+			stream >> keyword;
+			if (keyword == "v" || keyword == "vn")
+			{
+				Math::Vector3D v;
+				stream >> v.x >> v.y >> v.z;
+				(keyword == "v" ? positions : normals).push_back(v);
+			}
+			else if (keyword == "f")
+			{
+				std::string corner;
+				std::vector<uint> polygon;
+				while (stream >> corner)
+				{
+					auto it = vertices.find(corner);
+					if (it == vertices.end())
+					{
+						int position = 0, normal = 0;
+						std::sscanf(corner.c_str(), "%d//%d", &position, &normal);
+						it = vertices.emplace(corner, static_cast<uint>(result.vertices.size())).first;
+						result.vertices.push_back({ positions[position - 1], normals[normal - 1] });
+					}
+					polygon.push_back(it->second);
+				}
+				for (size_t i = 2; i < polygon.size(); i++)
+				{
+					result.indices.push_back(polygon[0]);
+					result.indices.push_back(polygon[i - 1]);
+					result.indices.push_back(polygon[i]);
+				}
+			}
+		}
+	}
+
+	bool IsSameMesh(const MeshData& a, const MeshData& b, float tolerance)
+	{
+		if (a.indices != b.indices || a.GetVertexCount() != b.GetVertexCount())
+			return false;
+		for (uint i = 0; i < a.GetVertexCount(); i++)
+		{
+			const Math::Vector3D dp = a.GetPosition(i) - b.GetPosition(i);
+			const Math::Vector3D dn = a.GetNormal(i) - b.GetNormal(i);
+			if (std::fabs(dp.x) > tolerance || std::fabs(dp.y) > tolerance || std::fabs(dp.z) > tolerance
+				|| std::fabs(dn.x) > tolerance || std::fabs(dn.y) > tolerance || std::fabs(dn.z) > tolerance)
+				return false;
+		}
+		return true;
+	}
+
+	double GetFileMegabytes(const std::string& path)
+	{
+		return static_cast<double>(std::filesystem::file_size(path)) / 1e6;
+	}
+
+	// Syntax the grid does not use, and input that must be rejected
+	int CheckEdgeCases()
+	{
+		int failures = 0;
+		MeshImportSettings soa;
+		soa.layout = VertexLayout::SoA;
+		MeshData mesh;
+
+		// Negative (relative) indices, v/vt/vn, CRLF, a trailing comment, no normals to read
+		const char* obj = "v 0 0 0\nv 1 0 0\nv 1 1 0\nvt 0 0\nf -3/1 -2/1 -1/1\r\nv 0 1 0\nf 1 3 4 # quad half\n";
+		const bool imported = MeshImporter::ImportObj(obj, std::strlen(obj), soa, mesh);
+		failures += Benchmarks::Check(imported && mesh.GetVertexCount() == 4 && mesh.GetTriangleCount() == 2, "OBJ relative indices and comments");
+		failures += Benchmarks::Check(imported && mesh.indices == std::vector<uint>{ 0, 1, 2, 0, 2, 3 }, "OBJ vertices shared across faces");
+		failures += Benchmarks::Check(imported && mesh.GetNormal(0).z == 1.0f, "OBJ normals generated");
+
+		const char* badIndex = "v 0 0 0\nf 1 2 3\n";
+		failures += Benchmarks::Check(!MeshImporter::ImportObj(badIndex, std::strlen(badIndex), soa, mesh), "OBJ index out of range rejected");
+		const char* badNumber = "v 0 0 x\n";
+		failures += Benchmarks::Check(!MeshImporter::ImportObj(badNumber, std::strlen(badNumber), soa, mesh), "OBJ bad number rejected");
+
+		const char* header = "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\nproperty float z\n"
+			"element face 1\nproperty list uchar int vertex_indices\nend_header\n";
+		const std::string ply = std::string(header) + "0 0 0\n1 0 0\n0 1 0\n3 0 1 2";
+		failures += Benchmarks::Check(MeshImporter::ImportPly(reinterpret_cast<const uchar*>(ply.data()), ply.size(), soa, mesh),
+			"PLY last line without a newline accepted");
+		const std::string truncated = std::string(header) + "0 0 0\n1 0 0\n";
+		failures += Benchmarks::Check(!MeshImporter::ImportPly(reinterpret_cast<const uchar*>(truncated.data()), truncated.size(), soa, mesh),
+			"truncated PLY rejected");
+		const std::string badFace = std::string(header) + "0 0 0\n1 0 0\n0 1 0\n3 0 1 5\n";
+		failures += Benchmarks::Check(!MeshImporter::ImportPly(reinterpret_cast<const uchar*>(badFace.data()), badFace.size(), soa, mesh),
+			"PLY index out of range rejected");
+		return failures;
+	}
+}
+
+int Benchmarks::RunMeshImporter()
+{
+	const int GRID_SIZE = 700;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::string objPath = (directory / "benchmark_grid.obj").string();
+	const std::string plyPath = (directory / "benchmark_grid.ply").string();
+	int failures = 0;
+
+	WriteGridObj(objPath, GRID_SIZE);
+	const double objMegabytes = GetFileMegabytes(objPath);
+
+	MeshData imported, loaded;
+	auto start = std::chrono::steady_clock::now();
+	const bool importedObj = MeshImporter::Import(objPath.c_str(), MeshImportSettings(), imported);
+	const double importTime = GetMilliseconds(start);
+	start = std::chrono::steady_clock::now();
+	LoadObjWithStreams(objPath, loaded);
+	const double loadTime = GetMilliseconds(start);
+
+	std::printf("OBJ %.1f MB: importer %.1f ms (%.0f MB/s), ifstream loader %.1f ms (%.0f MB/s)\n",
+		objMegabytes, importTime, objMegabytes / importTime * 1000.0, loadTime, objMegabytes / loadTime * 1000.0);
+	failures += Check(importedObj, "OBJ imported");
+	failures += Check(IsSameMesh(imported, loaded, 0.0f), "importer matches the ifstream loader");
+
+	const char* formats[] = { "binary_little_endian", "binary_big_endian", "ascii" };
+	for (const char* format : formats)
+	{
+		WriteMeshPly(plyPath, imported, format);
+		const double plyMegabytes = GetFileMegabytes(plyPath);
+		MeshData mesh;
+		start = std::chrono::steady_clock::now();
+		const bool importedPly = MeshImporter::Import(plyPath.c_str(), MeshImportSettings(), mesh);
+		const double plyTime = GetMilliseconds(start);
+		std::printf("PLY %-20s %.1f MB: %.1f ms (%.0f MB/s)\n", format, plyMegabytes, plyTime, plyMegabytes / plyTime * 1000.0);
+		// The ASCII file holds %g text, so positions only match to its precision
+		failures += Check(importedPly && IsSameMesh(mesh, imported, 1e-4f), "PLY matches the OBJ");
+	}
+
+	std::filesystem::remove(objPath);
+	std::filesystem::remove(plyPath);
+	return failures + CheckEdgeCases();
+}
@@ -0,0 +1,296 @@
+#include "Benchmark.h"
+#include "Core/JobSystem.h"
+#include "Scene/OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Math;
+using Scene::OcclusionCuller;
+
+namespace
+{
+	const uint WIDTH = 256;
+	const uint HEIGHT = 128;
+	const uint PILLAR_COUNT = 48;
+	const uint BOX_COUNT = 20000;
+	// Sample points per side of each box face when checking that a culled box is hidden
+	const uint FACE_SAMPLES = 5;
+	// OcclusionCuller::MIN_W
+	const float MIN_W = 1e-4f;
+
+	const Vector3D CUBE_POSITIONS[8] =
+	{
+		Vector3D(-0.5f, -0.5f, -0.5f), Vector3D(0.5f, -0.5f, -0.5f), Vector3D(0.5f, 0.5f, -0.5f), Vector3D(-0.5f, 0.5f, -0.5f),
+		Vector3D(-0.5f, -0.5f, 0.5f), Vector3D(0.5f, -0.5f, 0.5f), Vector3D(0.5f, 0.5f, 0.5f), Vector3D(-0.5f, 0.5f, 0.5f)
+	};
+	const uint CUBE_INDICES[36] =
+	{
+		0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+		3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5
+	};
+
+	Matrix4D MakeBox(const Vector3D& center, const Vector3D& size)
+	{
+		return Matrix4D::Scale(Matrix4D::Translate(Matrix4D::Identity(), center), size);
+	}
+
+	// A floor, a wall across the view and pillars to the sides, all in front of the camera:
+	// no occluder triangle needs clipping against w
+	std::vector<Matrix4D> MakeOccluders(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> side(10.0f, 40.0f);
+		std::uniform_real_distribution<float> depth(-80.0f, -30.0f);
+		std::vector<Matrix4D> occluders;
+		occluders.push_back(MakeBox(Vector3D(0.0f, -0.5f, -50.5f), Vector3D(200.0f, 1.0f, 100.0f)));
+		occluders.push_back(MakeBox(Vector3D(0.0f, 2.0f, -20.0f), Vector3D(16.0f, 4.0f, 0.5f)));
+		for (uint i = 0; i < PILLAR_COUNT; i++)
+			occluders.push_back(MakeBox(Vector3D(i % 2 == 0 ? side(random) : -side(random), 3.0f, depth(random)), Vector3D(1.0f, 6.0f, 1.0f)));
+		return occluders;
+	}
+
+	std::vector<AABB> MakeBoxes(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> x(-40.0f, 40.0f), y(-4.0f, 8.0f), z(-90.0f, -3.0f), extent(0.1f, 1.0f);
+		std::vector<AABB> boxes(BOX_COUNT);
+		for (AABB& box : boxes)
+		{
+			const Vector3D center(x(random), y(random), z(random));
+			const Vector3D extents(extent(random), extent(random), extent(random));
+			box = AABB(center - extents, center + extents);
+		}
+		return boxes;
+	}
+
+	void Rasterize(OcclusionCuller& culler, uint mesh, const Matrix4D& viewProjection, const std::vector<Matrix4D>& occluders)
+	{
+		culler.BeginFrame(viewProjection);
+		for (const Matrix4D& model : occluders)
+			culler.AddOccluder(mesh, model);
+		culler.Rasterize();
+	}
+
+	std::vector<std::vector<float>> CopyLevels(const OcclusionCuller& culler)
+	{
+		std::vector<std::vector<float>> levels(culler.GetLevelCount());
+		for (uint level = 0; level < culler.GetLevelCount(); level++)
+			levels[level].assign(culler.GetLevel(level), culler.GetLevel(level) + culler.GetLevelWidth(level) * culler.GetLevelHeight(level));
+		return levels;
+	}
+
+	// The scalar path of OcclusionCuller, over the whole screen instead of per tile
+	std::vector<float> RasterizeReference(const Matrix4D& viewProjection, const std::vector<Matrix4D>& occluders)
+	{
+		std::vector<float> depth(WIDTH * HEIGHT, 0.0f);
+		const float lastX = static_cast<float>(WIDTH - 1), lastY = static_cast<float>(HEIGHT - 1);
+		for (const Matrix4D& model : occluders)
+		{
+			const Matrix4D modelViewProjection = viewProjection * model;
+			for (uint i = 0; i < 36; i += 3)
+			{
+				float x[3], y[3], z[3];
+				bool outside[4] = { true, true, true, true };
+				for (int k = 0; k < 3; k++)
+				{
+					const Vector3D& position = CUBE_POSITIONS[CUBE_INDICES[i + k]];
+					const Vector4D clip = modelViewProjection * Vector4D(position.x, position.y, position.z, 1.0f);
+					outside[0] &= clip.x > clip.w;
+					outside[1] &= -clip.x > clip.w;
+					outside[2] &= clip.y > clip.w;
+					outside[3] &= -clip.y > clip.w;
+					const float inverseW = 1.0f / clip.w;
+					x[k] = (clip.x * inverseW * 0.5f + 0.5f) * WIDTH;
+					y[k] = (clip.y * inverseW * 0.5f + 0.5f) * HEIGHT;
+					z[k] = inverseW;
+				}
+				const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+				if (outside[0] || outside[1] || outside[2] || outside[3] || area == 0.0f)
+					continue;
+
+				const float minX = std::min(std::min(x[0], x[1]), x[2]), maxX = std::max(std::max(x[0], x[1]), x[2]);
+				const float minY = std::min(std::min(y[0], y[1]), y[2]), maxY = std::max(std::max(y[0], y[1]), y[2]);
+				if (maxX < 0.0f || maxY < 0.0f || minX > lastX || minY > lastY)
+					continue;
+
+				const float sign = area > 0.0f ? 1.0f : -1.0f;
+				const float inverseArea = 1.0f / fabsf(area);
+				float edgeA[3], edgeB[3];
+				for (int k = 0; k < 3; k++)
+				{
+					edgeA[k] = (y[k] - y[(k + 1) % 3]) * sign;
+					edgeB[k] = (x[(k + 1) % 3] - x[k]) * sign;
+				}
+				const float depthA = (edgeA[0] * z[2] + edgeA[1] * z[0] + edgeA[2] * z[1]) * inverseArea;
+				const float depthB = (edgeB[0] * z[2] + edgeB[1] * z[0] + edgeB[2] * z[1]) * inverseArea;
+				const float maxDepth = std::max(std::max(z[0], z[1]), z[2]);
+
+				const int startX = static_cast<int>(std::floor(std::min(std::max(minX, 0.0f), static_cast<float>(WIDTH))));
+				const int endX = static_cast<int>(std::ceil(std::max(std::min(maxX, static_cast<float>(WIDTH)), 0.0f)));
+				const int startY = static_cast<int>(std::floor(std::min(std::max(minY, 0.0f), static_cast<float>(HEIGHT))));
+				const int endY = static_cast<int>(std::ceil(std::max(std::min(maxY, static_cast<float>(HEIGHT)), 0.0f)));
+				for (int pixelRow = startY; pixelRow < endY; pixelRow++)
+				{
+					const float pixelY = pixelRow + 0.5f;
+					for (int pixelColumn = startX; pixelColumn < endX; pixelColumn++)
+					{
+						const float pixelX = pixelColumn + 0.5f;
+						bool inside = true;
+						for (int k = 0; k < 3; k++)
+							inside &= edgeA[k] * (pixelX - x[k]) + edgeB[k] * (pixelY - y[k]) >= 0.0f;
+						if (inside)
+						{
+							float& texel = depth[pixelRow * WIDTH + pixelColumn];
+							texel = std::max(texel, std::min(z[0] + depthB * (pixelY - y[0]) + depthA * (pixelX - x[0]), maxDepth));
+						}
+					}
+				}
+			}
+		}
+		return depth;
+	}
+
+	// The scalar path of OcclusionCuller::IsVisible, on the culler's pyramid
+	bool IsVisibleReference(const OcclusionCuller& culler, const Matrix4D& viewProjection, const AABB& box)
+	{
+		float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f, nearest = 0.0f;
+		for (int i = 0; i < 8; i++)
+		{
+			const Vector4D corner((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z, 1.0f);
+			const Vector4D clip = viewProjection * corner;
+			if (clip.w < MIN_W)
+				return true;
+			const float inverseW = 1.0f / clip.w;
+			const float x = (clip.x * inverseW * 0.5f + 0.5f) * WIDTH;
+			const float y = (clip.y * inverseW * 0.5f + 0.5f) * HEIGHT;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			nearest = std::max(nearest, inverseW);
+		}
+		if (maxX < 0.0f || maxY < 0.0f || minX >= WIDTH || minY >= HEIGHT)
+			return false;
+
+		const uint x0 = static_cast<uint>(std::max(minX, 0.0f)), x1 = static_cast<uint>(std::min(maxX, static_cast<float>(WIDTH - 1)));
+		const uint y0 = static_cast<uint>(std::max(minY, 0.0f)), y1 = static_cast<uint>(std::min(maxY, static_cast<float>(HEIGHT - 1)));
+		uint level = 0;
+		while (level + 1 < culler.GetLevelCount() && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3))
+			level++;
+		float farthest = 1e30f;
+		for (uint y = y0 >> level; y <= (y1 >> level); y++)
+		{
+			for (uint x = x0 >> level; x <= (x1 >> level); x++)
+				farthest = std::min(farthest, culler.GetLevel(level)[y * culler.GetLevelWidth(level) + x]);
+		}
+		return nearest >= farthest;
+	}
+
+	// Every on-screen sample point of the box's faces lies behind the rasterized occluders
+	bool IsHidden(const float* depth, const Matrix4D& viewProjection, const AABB& box)
+	{
+		const Vector3D size = box.max - box.min;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+			for (int face = 0; face < 2; face++)
+			{
+				for (uint i = 0; i < FACE_SAMPLES * FACE_SAMPLES; i++)
+				{
+					Vector3D point = box.min;
+					(&point.x)[axis] += face * (&size.x)[axis];
+					(&point.x)[u] += (i % FACE_SAMPLES + 0.5f) / FACE_SAMPLES * (&size.x)[u];
+					(&point.x)[v] += (i / FACE_SAMPLES + 0.5f) / FACE_SAMPLES * (&size.x)[v];
+					const Vector4D clip = viewProjection * Vector4D(point.x, point.y, point.z, 1.0f);
+					if (clip.w < MIN_W)
+						return false;
+					const float inverseW = 1.0f / clip.w;
+					const float x = (clip.x * inverseW * 0.5f + 0.5f) * WIDTH;
+					const float y = (clip.y * inverseW * 0.5f + 0.5f) * HEIGHT;
+					if (x < 0.0f || y < 0.0f || x >= WIDTH || y >= HEIGHT)
+						continue;
+					if (depth[static_cast<uint>(y) * WIDTH + static_cast<uint>(x)] < inverseW)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+int Benchmarks::RunOcclusion()
+{
+	std::mt19937 random(19);
+	const std::vector<Matrix4D> occluders = MakeOccluders(random);
+	const std::vector<AABB> boxes = MakeBoxes(random);
+	const Matrix4D viewProjection = Matrix4D::PerspectiveInfiniteReversedZ(1.0f, static_cast<float>(WIDTH) / HEIGHT, 0.1f)
+		* Matrix4D::LookAt(Vector3D(0.0f, 1.7f, 0.0f), Vector3D(0.0f, 1.7f, -1.0f));
+
+	OcclusionCuller culler(WIDTH, HEIGHT);
+	const uint mesh = culler.AddOccluderMesh(CUBE_POSITIONS, 8, CUBE_INDICES, 36);
+	double rasterizeTime = 1e30;
+	for (int repeat = 0; repeat < 20; repeat++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		Rasterize(culler, mesh, viewProjection, occluders);
+		rasterizeTime = std::min(rasterizeTime, GetMilliseconds(start));
+	}
+	std::vector<uint> visible(BOX_COUNT);
+	uint visibleCount = 0;
+	double filterTime = 1e30;
+	for (int repeat = 0; repeat < 10; repeat++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		visibleCount = culler.FilterVisible(boxes.data(), BOX_COUNT, visible.data());
+		filterTime = std::min(filterTime, GetMilliseconds(start));
+	}
+	visible.resize(visibleCount);
+	std::printf("%u occluders rasterized at %ux%u in %.3f ms on %u threads; %u boxes tested in %.3f ms (%.0f ns each), %u culled\n",
+		static_cast<uint>(occluders.size()), WIDTH, HEIGHT, rasterizeTime, Core::JobSystem::GetThreadCount(), BOX_COUNT, filterTime,
+		filterTime * 1e6 / BOX_COUNT, BOX_COUNT - visibleCount);
+
+	int failures = 0;
+	const std::vector<float> reference = RasterizeReference(viewProjection, occluders);
+	failures += Check(std::memcmp(reference.data(), culler.GetLevel(0), reference.size() * sizeof(float)) == 0, "depth buffer matches the scalar path");
+
+	std::vector<uint> referenceVisible;
+	for (uint i = 0; i < BOX_COUNT; i++)
+	{
+		if (IsVisibleReference(culler, viewProjection, boxes[i]))
+			referenceVisible.push_back(i);
+	}
+	failures += Check(visible == referenceVisible, "box tests match the scalar path");
+
+	// Conservative: nothing that shows a single sample point is culled
+	bool hidden = true;
+	for (uint i = 0, next = 0; i < BOX_COUNT; i++)
+	{
+		if (next < visibleCount && visible[next] == i)
+			next++;
+		else
+			hidden &= IsHidden(culler.GetLevel(0), viewProjection, boxes[i]);
+	}
+	failures += Check(hidden, "culled boxes are hidden");
+	failures += Check(!culler.IsVisible(AABB(Vector3D(-1.0f, 1.0f, -26.0f), Vector3D(1.0f, 3.0f, -24.0f))), "box behind the wall culled");
+	failures += Check(!culler.IsVisible(AABB(Vector3D(4.0f, -4.0f, -31.0f), Vector3D(6.0f, -2.0f, -29.0f))), "box under the floor culled");
+	failures += Check(culler.IsVisible(AABB(Vector3D(-1.0f, 1.0f, -11.0f), Vector3D(1.0f, 3.0f, -9.0f))), "box in front of the wall visible");
+	failures += Check(culler.IsVisible(AABB(Vector3D(-1.0f, 6.0f, -26.0f), Vector3D(1.0f, 7.0f, -24.0f))), "box over the wall visible");
+
+	// Tiles and transform jobs land on other threads, the result must not change
+	const std::vector<std::vector<float>> levels = CopyLevels(culler);
+	for (uint workers : { 1u, 3u, 0u })
+	{
+		Core::JobSystem::Shutdown();
+		Core::JobSystem::Initialize(workers);
+		const auto start = std::chrono::steady_clock::now();
+		Rasterize(culler, mesh, viewProjection, occluders);
+		const double time = GetMilliseconds(start);
+		std::vector<uint> workerVisible(BOX_COUNT);
+		workerVisible.resize(culler.FilterVisible(boxes.data(), BOX_COUNT, workerVisible.data()));
+		std::printf("%u threads: rasterized in %.3f ms\n", Core::JobSystem::GetThreadCount(), time);
+		failures += Check(CopyLevels(culler) == levels && workerVisible == visible, "same pyramid and visibility on any number of threads");
+	}
+	return failures;
+}
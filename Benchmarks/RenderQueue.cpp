@@ -0,0 +1,126 @@
+#include "Benchmark.h"
+#include "Graphics/RenderQueue.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using Command = RecordingRenderBackend::CommandType;
+
+namespace
+{
+	// The stats must describe exactly what reached the backend
+	int CheckStats(const RenderQueueStats& stats, const RecordingRenderBackend& backend, uint packetCount)
+	{
+		int failures = 0;
+		failures += Benchmarks::Check(stats.draws == packetCount && backend.Count(Command::DrawIndexed) == packetCount, "one draw per packet");
+		failures += Benchmarks::Check(stats.programChanges == backend.Count(Command::UseProgram), "program changes match the backend");
+		failures += Benchmarks::Check(stats.vertexArrayChanges == backend.Count(Command::BindVertexArray), "vertex array changes match the backend");
+		failures += Benchmarks::Check(stats.textureBinds == backend.Count(Command::BindTexture), "texture binds match the backend");
+		failures += Benchmarks::Check(stats.matrixUploads == backend.Count(Command::SetMatrix), "matrix uploads match the backend");
+		failures += Benchmarks::Check(stats.programChanges + stats.programChangesSkipped == packetCount, "every program change sent or skipped");
+		return failures;
+	}
+
+	void PrintStats(const char* name, const RenderQueueStats& stats)
+	{
+		std::printf("%-9s program %5u (skipped %5u)  vertex array %5u (%5u)  texture %5u (%5u)  matrix %5u (%5u)\n", name,
+			stats.programChanges, stats.programChangesSkipped, stats.vertexArrayChanges, stats.vertexArrayChangesSkipped,
+			stats.textureBinds, stats.textureBindsSkipped, stats.matrixUploads, stats.matrixUploadsSkipped);
+	}
+
+	// Translucent draws go back to front, and equal keys keep their submission order
+	int CheckOrdering()
+	{
+		int failures = 0;
+		RenderQueue queue;
+		for (uint i = 0; i < 5; i++)
+		{
+			DrawPacket packet;
+			packet.sortKey = RenderSortKey::Translucent(2, 1, 1, 1, static_cast<float>(i + 1));
+			packet.indexCount = i;
+			queue.Submit(packet);
+		}
+		queue.Sort();
+		for (uint i = 0; i < 5; i++)
+			failures += Benchmarks::Check(queue.GetSortedPacket(i).indexCount == 4 - i, "translucent back to front");
+
+		queue.Reset();
+		for (uint i = 0; i < 5; i++)
+		{
+			DrawPacket packet;
+			packet.sortKey = 7;
+			packet.indexCount = i;
+			queue.Submit(packet);
+		}
+		queue.Sort();
+		for (uint i = 0; i < 5; i++)
+			failures += Benchmarks::Check(queue.GetSortedPacket(i).indexCount == i, "stable for equal keys");
+		return failures;
+	}
+}
+
+int Benchmarks::RunRenderQueue()
+{
+	const uint PACKET_COUNT = 20000;
+	const int FRAME_COUNT = 3;
+	std::mt19937 random(1);
+	RenderQueue queue;
+	RecordingRenderBackend backend;
+	int failures = 0;
+
+	for (int frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		// A frame of random state, one packet in ten translucent
+		queue.Reset();
+		for (uint i = 0; i < PACKET_COUNT; i++)
+		{
+			DrawPacket packet;
+			packet.program = 1 + random() % 8;
+			packet.vertexArray = 1 + random() % 32;
+			packet.textures[0] = 1 + random() % 64;
+			const uint material = random() % 100;
+			const float viewDepth = 1.0f + (random() % 100000) * 0.01f;
+			packet.sortKey = i % 10 == 0
+				? RenderSortKey::Translucent(2, packet.program, material, packet.textures[0], viewDepth)
+				: RenderSortKey::Opaque(1, packet.program, material, packet.textures[0], viewDepth);
+			packet.indexCount = 36;
+			packet.modelLocation = 3;
+			packet.transform = queue.AddTransform(Math::Matrix4D());
+			queue.Submit(packet);
+		}
+
+		backend.Clear();
+		const RenderQueueStats unsorted = queue.Execute(backend);
+		failures += CheckStats(unsorted, backend, PACKET_COUNT);
+
+		auto start = std::chrono::steady_clock::now();
+		queue.Sort();
+		const double sortTime = GetMilliseconds(start);
+
+		backend.Clear();
+		const RenderQueueStats sorted = queue.Execute(backend);
+		failures += CheckStats(sorted, backend, PACKET_COUNT);
+		failures += Check(sorted.programChanges < unsorted.programChanges && sorted.textureBinds < unsorted.textureBinds, "sorting removes state changes");
+
+		bool ordered = true;
+		for (uint i = 1; i < PACKET_COUNT; i++)
+			ordered &= queue.GetSortedPacket(i - 1).sortKey <= queue.GetSortedPacket(i).sortKey;
+		failures += Check(ordered, "packets sorted by key");
+
+		// The comparison sort the radix sort replaces, on the same keys
+		std::vector<std::pair<uint64, uint>> entries(PACKET_COUNT);
+		for (uint i = 0; i < PACKET_COUNT; i++)
+			entries[i] = { queue.GetSortedPacket(i).sortKey, i };
+		std::shuffle(entries.begin(), entries.end(), random);
+		start = std::chrono::steady_clock::now();
+		std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		const double stableSortTime = GetMilliseconds(start);
+
+		std::printf("frame %d: %u packets, radix sort %.3f ms, std::stable_sort %.3f ms\n", frame, PACKET_COUNT, sortTime, stableSortTime);
+		PrintStats("unsorted", unsorted);
+		PrintStats("sorted", sorted);
+	}
+
+	return failures + CheckOrdering();
+}
@@ -0,0 +1,129 @@
+#include "Benchmark.h"
+#include "Core/JobSystem.h"
+#include "Scene/SceneGraph.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Scene;
+
+namespace
+{
+	const uint NODE_COUNT = 500000;
+	const uint ROOT_COUNT = 64;
+	const uint CHILDREN_PER_NODE = 4;
+	const uint FRAME_COUNT = 20;
+
+	Transform MakeLocal(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+		Transform local;
+		local.position = Math::Vector3D(uniform(random), uniform(random), uniform(random)) * 4.0f;
+		local.rotation = Math::Quaternion::FromAxisAngle(Math::Vector3D(uniform(random), 1.0f, uniform(random)).Normalized(), uniform(random));
+		local.scale = Math::Vector3D(1.0f + uniform(random) * 0.05f);
+		return local;
+	}
+
+	// Nodes are created after their parent, so one pass in creation order sees every parent first
+	int CheckWorlds(const SceneGraph& graph, const std::vector<SceneNode>& nodes, const std::vector<uint>& parents)
+	{
+		std::vector<Math::Matrix4D> expected(nodes.size());
+		bool matches = true;
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const Transform& local = graph.GetLocalTransform(nodes[i]);
+			const Math::Matrix4D localMatrix = Math::MakeTRS(local.position, local.rotation, local.scale);
+			expected[i] = i < ROOT_COUNT ? localMatrix : expected[parents[i]] * localMatrix;
+			matches &= std::memcmp(&expected[i], &graph.GetWorldMatrix(nodes[i]), sizeof(Math::Matrix4D)) == 0;
+		}
+		return Benchmarks::Check(matches, "world matrices match a serial recomputation");
+	}
+}
+
+int Benchmarks::RunSceneGraph()
+{
+	std::mt19937 random(13);
+	SceneGraph graph(NODE_COUNT);
+	std::vector<SceneNode> nodes;
+	std::vector<uint> parents(NODE_COUNT, 0);
+	nodes.reserve(NODE_COUNT);
+
+	// A forest of 4-ary trees, eight levels deep
+	auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < NODE_COUNT; i++)
+	{
+		if (i < ROOT_COUNT)
+			nodes.push_back(graph.CreateNode(MakeLocal(random)));
+		else
+		{
+			parents[i] = (i - ROOT_COUNT) / CHILDREN_PER_NODE;
+			nodes.push_back(graph.CreateNode(MakeLocal(random), nodes[parents[i]]));
+		}
+	}
+	const double createTime = GetMilliseconds(start);
+	start = std::chrono::steady_clock::now();
+	graph.Update();
+	std::printf("%u nodes created in %.1f ms, first update (order rebuild and every node) %.1f ms, %u depths\n",
+		graph.GetNodeCount(), createTime, GetMilliseconds(start), graph.GetDepthCount());
+
+	int failures = 0;
+	failures += CheckWorlds(graph, nodes, parents);
+
+	// 5% of the nodes move every frame; their subtrees follow
+	const uint dirtyCount = NODE_COUNT / 20;
+	std::uniform_int_distribution<uint> pick(0, NODE_COUNT - 1);
+	std::vector<uchar> dirty(NODE_COUNT);
+	double best = 1e30, total = 0.0;
+	bool counted = true;
+	for (uint frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		std::fill(dirty.begin(), dirty.end(), static_cast<uchar>(0));
+		for (uint i = 0; i < dirtyCount; i++)
+		{
+			const uint node = pick(random);
+			dirty[node] = 1;
+			graph.SetLocalTransform(nodes[node], MakeLocal(random));
+		}
+		uint expectedUpdates = 0;
+		for (uint i = 0; i < NODE_COUNT; i++)
+		{
+			dirty[i] |= i >= ROOT_COUNT ? dirty[parents[i]] : 0;
+			expectedUpdates += dirty[i];
+		}
+
+		start = std::chrono::steady_clock::now();
+		graph.Update();
+		const double time = GetMilliseconds(start);
+		best = std::min(best, time);
+		total += time;
+		counted &= graph.GetUpdatedCount() == expectedUpdates;
+		if (frame == 0)
+			std::printf("%u nodes moved, %u recomputed with their subtrees\n", dirtyCount, expectedUpdates);
+	}
+	std::printf("update with 5%% moving: best %.2f ms, average %.2f ms on %u threads\n", best, total / FRAME_COUNT, Core::JobSystem::GetThreadCount());
+	failures += Check(counted, "only changed subtrees recomputed");
+	failures += CheckWorlds(graph, nodes, parents);
+
+	// Everything moving, for comparison
+	for (uint i = 0; i < ROOT_COUNT; i++)
+		graph.SetLocalTransform(nodes[i], graph.GetLocalTransform(nodes[i]));
+	start = std::chrono::steady_clock::now();
+	graph.Update();
+	std::printf("update with every node moving: %.2f ms\n", GetMilliseconds(start));
+	failures += Check(graph.GetUpdatedCount() == NODE_COUNT, "moving the roots recomputes every node");
+
+	graph.Update();
+	failures += Check(graph.GetUpdatedCount() == 0, "nothing recomputed when nothing moved");
+
+	// A subtree moved under another root follows its new parent
+	const uint moved = ROOT_COUNT + 5;
+	failures += Check(graph.SetParent(nodes[moved], nodes[1]), "subtree reparented");
+	parents[moved] = 1;
+	start = std::chrono::steady_clock::now();
+	graph.Update();
+	std::printf("update after reparenting (order rebuild): %.1f ms\n", GetMilliseconds(start));
+	failures += CheckWorlds(graph, nodes, parents);
+	return failures;
+}
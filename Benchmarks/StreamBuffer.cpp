@@ -0,0 +1,112 @@
+#include "Benchmark.h"
+#include "Graphics/StreamBuffer.h"
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const uint UNIFORM_ALIGNMENT = 256;
+	const uint STORAGE_ALIGNMENT = 32;
+	const uint REGION_SIZE = 4096;
+	const uint REGION_COUNT = 3;
+
+	// A GPU two frames behind never makes the CPU wait; a GPU that stops does, once the regions wrap
+	int CheckFencing(SimulatedStreamBufferDevice& device, StreamBuffer& stream)
+	{
+		int failures = 0;
+		bool aligned = true;
+		for (uint frame = 0; frame < 30; frame++)
+		{
+			for (uint i = 0; i < 10; i++)
+			{
+				const StreamBuffer::Allocation allocation = stream.AllocateUniform(100);
+				aligned &= allocation.data != nullptr && allocation.offset % UNIFORM_ALIGNMENT == 0 && allocation.offset / REGION_SIZE == frame % REGION_COUNT;
+				if (allocation.data != nullptr)
+					std::memset(allocation.data, static_cast<int>(frame), 100);
+			}
+			const StreamBuffer::Allocation storage = stream.AllocateStorage(20);
+			aligned &= storage.data != nullptr && storage.offset % STORAGE_ALIGNMENT == 0;
+			stream.EndFrame();
+			if (frame >= 1)
+				device.CompleteGpuWork(1);
+		}
+		failures += Benchmarks::Check(aligned, "allocations aligned and in the frame's region");
+		failures += Benchmarks::Check(device.GetStallCount() == 0, "no stall while the GPU keeps up");
+
+		// The region after the two in flight is free, every one after that waits
+		for (uint frame = 0; frame < 6; frame++)
+		{
+			stream.AllocateUniform(64);
+			stream.EndFrame();
+		}
+		failures += Benchmarks::Check(device.GetStallCount() == 4, "stalls once the regions wrap on a stuck GPU");
+		failures += Benchmarks::Check(device.GetPendingFenceCount() <= REGION_COUNT, "at most one fence per region pending");
+
+		// An empty frame has nothing for the GPU to finish
+		const uint pending = device.GetPendingFenceCount();
+		stream.EndFrame();
+		failures += Benchmarks::Check(device.GetPendingFenceCount() == pending, "empty frame inserts no fence");
+		return failures;
+	}
+
+	int CheckCapacity(StreamBuffer& stream)
+	{
+		int failures = 0;
+		failures += Benchmarks::Check(stream.Allocate(4000).data != nullptr, "allocation within the region");
+		failures += Benchmarks::Check(stream.Allocate(200).data == nullptr, "allocation past the region fails");
+		stream.EndFrame();
+		failures += Benchmarks::Check(stream.Allocate(REGION_SIZE, UNIFORM_ALIGNMENT).data != nullptr, "whole region in the next frame");
+		stream.EndFrame();
+		return failures;
+	}
+
+	// A region size that is not a multiple of the alignments must not shift later regions off alignment
+	int CheckOddRegionSize(SimulatedStreamBufferDevice& device)
+	{
+		StreamBuffer stream(device, 1000, REGION_COUNT);
+		bool aligned = true;
+		for (uint frame = 0; frame < 3 * REGION_COUNT; frame++)
+		{
+			const StreamBuffer::Allocation uniform = stream.AllocateUniform(100);
+			const StreamBuffer::Allocation storage = stream.AllocateStorage(10);
+			aligned &= uniform.data != nullptr && uniform.offset % UNIFORM_ALIGNMENT == 0;
+			aligned &= storage.data != nullptr && storage.offset % STORAGE_ALIGNMENT == 0;
+			stream.EndFrame();
+			device.CompleteGpuWork(1);
+		}
+
+		int failures = 0;
+		failures += Benchmarks::Check(stream.GetRegionSize() == 1024, "region size rounded up to the alignments");
+		failures += Benchmarks::Check(aligned, "allocations aligned in every region");
+		return failures;
+	}
+}
+
+int Benchmarks::RunStreamBuffer()
+{
+	SimulatedStreamBufferDevice device(UNIFORM_ALIGNMENT, STORAGE_ALIGNMENT);
+	int failures = 0;
+	{
+		StreamBuffer stream(device, REGION_SIZE, REGION_COUNT);
+		failures += CheckFencing(device, stream);
+		failures += CheckCapacity(stream);
+	}
+	failures += CheckOddRegionSize(device);
+	failures += Check(device.GetLiveBufferCount() == 0, "buffers destroyed with their stream");
+
+	// Sub-allocation cost: a frame of small uniform blocks
+	const uint BLOCK_COUNT = 100000;
+	StreamBuffer stream(device, BLOCK_COUNT * UNIFORM_ALIGNMENT, REGION_COUNT);
+	for (uint frame = 0; frame < 5; frame++)
+	{
+		const float block[16] = {};
+		const auto start = std::chrono::steady_clock::now();
+		for (uint i = 0; i < BLOCK_COUNT; i++)
+			stream.Write(block, sizeof(block), UNIFORM_ALIGNMENT);
+		const double writeTime = GetMilliseconds(start);
+		stream.EndFrame();
+		device.CompleteGpuWork(1);
+		std::printf("%u uniform block writes: %.2f ms (%.0f writes/ms)\n", BLOCK_COUNT, writeTime, BLOCK_COUNT / writeTime);
+	}
+	return failures;
+}
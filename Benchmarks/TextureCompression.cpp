@@ -0,0 +1,197 @@
+#include "Benchmark.h"
+#include "Assets/BlockCompressor.h"
+#include "Assets/MipGenerator.h"
+#include "Core/JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Assets;
+
+namespace
+{
+	const uint IMAGE_SIZE = 2048;
+
+	// Gradients, a few hard edges and some noise: smooth enough to compress well, busy enough to cost
+	std::vector<uchar> MakeImage(uint size)
+	{
+		std::mt19937 random(7);
+		std::uniform_int_distribution<int> noise(-6, 6);
+		std::vector<uchar> rgba(static_cast<size_t>(size) * size * 4);
+		for (uint y = 0; y < size; y++)
+		{
+			for (uint x = 0; x < size; x++)
+			{
+				uchar* pixel = &rgba[(static_cast<size_t>(y) * size + x) * 4];
+				const bool stripe = (x / 64 + y / 96) % 3 == 0;
+				const int base[4] = { static_cast<int>(x * 255 / size), static_cast<int>(y * 255 / size), stripe ? 200 : 60, stripe ? 255 : static_cast<int>((x + y) * 255 / (2 * size)) };
+				for (int channel = 0; channel < 4; channel++)
+					pixel[channel] = static_cast<uchar>(std::min(255, std::max(0, base[channel] + (channel < 3 ? noise(random) : 0))));
+			}
+		}
+		return rgba;
+	}
+
+	inline void Unpack565(uint color, int* rgb)
+	{
+		rgb[0] = static_cast<int>((color >> 11) & 31) * 255 / 31;
+		rgb[1] = static_cast<int>((color >> 5) & 63) * 255 / 63;
+		rgb[2] = static_cast<int>(color & 31) * 255 / 31;
+	}
+
+	// Reference BC1 decoder: rgb of the 16 pixels of a block, and whether each is transparent
+	void DecodeBC1(const uchar* block, int rgb[16][3], bool transparent[16])
+	{
+		const uint color0 = block[0] | (block[1] << 8);
+		const uint color1 = block[2] | (block[3] << 8);
+		int palette[4][3];
+		Unpack565(color0, palette[0]);
+		Unpack565(color1, palette[1]);
+		for (int channel = 0; channel < 3; channel++)
+		{
+			if (color0 > color1)
+			{
+				palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+				palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+			}
+			else
+			{
+				palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+				palette[3][channel] = 0;
+			}
+		}
+		for (int pixel = 0; pixel < 16; pixel++)
+		{
+			const uint index = (block[4 + pixel / 4] >> ((pixel % 4) * 2)) & 3;
+			std::memcpy(rgb[pixel], palette[index], sizeof(rgb[pixel]));
+			transparent[pixel] = color0 <= color1 && index == 3;
+		}
+	}
+
+	// Root mean square color error of the opaque pixels; alpha below 128 must decode as transparent
+	double GetBC1Error(const uchar* rgba, uint size, const MipLevel& level, bool& alphaMatches)
+	{
+		double squared = 0.0;
+		size_t opaqueCount = 0;
+		alphaMatches = true;
+		const uint blocksX = size / 4;
+		for (uint by = 0; by < size / 4; by++)
+		{
+			for (uint bx = 0; bx < blocksX; bx++)
+			{
+				int rgb[16][3];
+				bool transparent[16];
+				DecodeBC1(&level.data[(static_cast<size_t>(by) * blocksX + bx) * 8], rgb, transparent);
+				for (int pixel = 0; pixel < 16; pixel++)
+				{
+					const uchar* source = &rgba[((static_cast<size_t>(by) * 4 + pixel / 4) * size + bx * 4 + pixel % 4) * 4];
+					alphaMatches &= transparent[pixel] == (source[3] < 128);
+					if (transparent[pixel])
+						continue;
+					opaqueCount++;
+					for (int channel = 0; channel < 3; channel++)
+						squared += (rgb[pixel][channel] - source[channel]) * (rgb[pixel][channel] - source[channel]);
+				}
+			}
+		}
+		return std::sqrt(squared / std::max<double>(1.0, opaqueCount * 3.0));
+	}
+
+	int CheckMipChain(const std::vector<uchar>& rgba)
+	{
+		int failures = 0;
+		for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+		{
+			const char* name = filter == MipFilter::Box ? "box" : "Kaiser";
+			MipSettings settings;
+			settings.filter = filter;
+			std::vector<MipLevel> chain;
+			double best = 1e30;
+			for (int repeat = 0; repeat < 3; repeat++)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				chain = GenerateMipChain(rgba.data(), IMAGE_SIZE, IMAGE_SIZE, settings);
+				best = std::min(best, Benchmarks::GetMilliseconds(start));
+			}
+			std::printf("%s mips of %ux%u: %.1f ms, %.0f MPix/s of source\n", name, IMAGE_SIZE, IMAGE_SIZE, best, IMAGE_SIZE * IMAGE_SIZE / (best * 1e3));
+
+			bool sizes = chain.size() == GetMipCount(IMAGE_SIZE, IMAGE_SIZE);
+			for (size_t level = 0; sizes && level < chain.size(); level++)
+				sizes = chain[level].width == std::max(1u, IMAGE_SIZE >> level) && chain[level].data.size() == GetLevelSize(TextureFormat::RGBA8, chain[level].width, chain[level].height);
+			failures += Benchmarks::Check(sizes, "full chain with halved sizes");
+		}
+
+		// A constant image stays constant down to 1x1, sRGB conversion included
+		std::vector<uchar> flat(64 * 64 * 4);
+		for (size_t i = 0; i < flat.size(); i += 4)
+		{
+			flat[i] = 180;
+			flat[i + 1] = 90;
+			flat[i + 2] = 20;
+			flat[i + 3] = 128;
+		}
+		const std::vector<MipLevel> flatChain = GenerateMipChain(flat.data(), 64, 64);
+		const uchar* last = flatChain.back().data.data();
+		failures += Benchmarks::Check(std::abs(last[0] - 180) <= 1 && std::abs(last[1] - 90) <= 1 && std::abs(last[2] - 20) <= 1 && std::abs(last[3] - 128) <= 1,
+			"constant image keeps its color");
+		return failures;
+	}
+
+	int CheckCompression(const std::vector<uchar>& rgba)
+	{
+		int failures = 0;
+		const TextureFormat formats[] = { TextureFormat::BC1, TextureFormat::BC3, TextureFormat::BC5, TextureFormat::BC7 };
+		const char* names[] = { "BC1", "BC3", "BC5", "BC7" };
+		for (int f = 0; f < 4; f++)
+		{
+			const TextureFormat format = formats[f];
+			const auto start = std::chrono::steady_clock::now();
+			const MipLevel level = BlockCompressor::CompressLevel(rgba.data(), IMAGE_SIZE, IMAGE_SIZE, format);
+			const double time = Benchmarks::GetMilliseconds(start);
+			std::printf("%s %ux%u: %.1f ms, %.1f MPix/s on %u threads\n", names[f], IMAGE_SIZE, IMAGE_SIZE, time, IMAGE_SIZE * IMAGE_SIZE / (time * 1e3),
+				Core::JobSystem::GetThreadCount());
+			failures += Benchmarks::Check(level.data.size() == GetLevelSize(format, IMAGE_SIZE, IMAGE_SIZE), "compressed level size");
+
+			// The parallel rows give the blocks a serial compression gives, sampled over the image
+			bool identical = level.data.size() == GetLevelSize(format, IMAGE_SIZE, IMAGE_SIZE);
+			const uint blocksX = IMAGE_SIZE / 4;
+			for (uint block = 0; identical && block < blocksX * blocksX; block += 997)
+			{
+				uchar pixels[64];
+				for (uint row = 0; row < 4; row++)
+					std::memcpy(&pixels[row * 16], &rgba[((static_cast<size_t>(block / blocksX) * 4 + row) * IMAGE_SIZE + (block % blocksX) * 4) * 4], 16);
+				uchar output[16];
+				BlockCompressor::CompressBlock(pixels, format, output);
+				identical = std::memcmp(output, &level.data[static_cast<size_t>(block) * GetBlockSize(format)], GetBlockSize(format)) == 0;
+			}
+			failures += Benchmarks::Check(identical, "parallel compression matches CompressBlock");
+
+			if (format == TextureFormat::BC1)
+			{
+				bool alphaMatches;
+				const double error = GetBC1Error(rgba.data(), IMAGE_SIZE, level, alphaMatches);
+				std::printf("BC1 color error: %.2f RMS\n", error);
+				failures += Benchmarks::Check(error < 6.0, "BC1 error below 6 RMS");
+				failures += Benchmarks::Check(alphaMatches, "BC1 punch-through alpha");
+			}
+		}
+
+		// Sizes that are not a multiple of 4 are padded to whole blocks
+		const MipLevel odd = BlockCompressor::CompressLevel(rgba.data(), 6, 3, TextureFormat::BC1);
+		failures += Benchmarks::Check(odd.width == 6 && odd.height == 3 && odd.data.size() == 2 * 8, "partial blocks padded");
+		return failures;
+	}
+}
+
+int Benchmarks::RunTextureCompression()
+{
+	const std::vector<uchar> rgba = MakeImage(IMAGE_SIZE);
+	int failures = 0;
+	failures += CheckMipChain(rgba);
+	failures += CheckCompression(rgba);
+	return failures;
+}
@@ -0,0 +1,149 @@
+#include "Benchmark.h"
+#include "Assets/TextureContainer.h"
+#include "Assets/TextureImporter.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace Assets;
+
+namespace
+{
+	const uint IMAGE_SIZE = 2048;
+
+	// Uncompressed 32-bit TGA, top-left origin: stb_image reads it without a third party writer
+	void WriteTga(const std::string& path, uint size)
+	{
+		uchar header[18] = {};
+		header[2] = 2;
+		header[12] = static_cast<uchar>(size & 0xFF);
+		header[13] = static_cast<uchar>(size >> 8);
+		header[14] = static_cast<uchar>(size & 0xFF);
+		header[15] = static_cast<uchar>(size >> 8);
+		header[16] = 32;
+		header[17] = 0x28;	// 8 alpha bits, rows top to bottom
+
+		std::vector<uchar> bgra(static_cast<size_t>(size) * size * 4);
+		for (uint y = 0; y < size; y++)
+		{
+			for (uint x = 0; x < size; x++)
+			{
+				uchar* pixel = &bgra[(static_cast<size_t>(y) * size + x) * 4];
+				pixel[0] = static_cast<uchar>((x ^ y) & 0xFF);
+				pixel[1] = static_cast<uchar>(y * 255 / size);
+				pixel[2] = static_cast<uchar>(x * 255 / size);
+				pixel[3] = 255;
+			}
+		}
+		std::ofstream file(path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(bgra.data()), static_cast<std::streamsize>(bgra.size()));
+	}
+
+	bool SameLevels(const TextureData& texture, const TextureContainer& container)
+	{
+		if (container.GetFormat() != texture.format || container.IsSRGB() != texture.sRGB || container.GetMipCount() != texture.mips.size())
+			return false;
+		for (uint level = 0; level < container.GetMipCount(); level++)
+		{
+			const TextureLevelView view = container.GetMip(level);
+			const MipLevel& mip = texture.mips[level];
+			if (view.width != mip.width || view.height != mip.height || view.size != mip.data.size() || std::memcmp(view.data, mip.data.data(), view.size) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// A truncated file and a level pointing past the end are rejected instead of read
+	int CheckCorruption(const std::string& containerPath, const std::string& corruptPath)
+	{
+		int failures = 0;
+		const uintmax_t size = std::filesystem::file_size(containerPath);
+		std::filesystem::copy_file(containerPath, corruptPath, std::filesystem::copy_options::overwrite_existing);
+		std::filesystem::resize_file(corruptPath, size / 2);
+		TextureContainer truncated;
+		failures += Benchmarks::Check(!truncated.Open(corruptPath.c_str()), "truncated container rejected");
+
+		std::filesystem::copy_file(containerPath, corruptPath, std::filesystem::copy_options::overwrite_existing);
+		{
+			std::fstream file(corruptPath, std::ios::in | std::ios::out | std::ios::binary);
+			const uint64 offset = size + TextureContainer::MIP_ALIGNMENT;
+			file.seekp(sizeof(TextureContainer::ContainerHeader) + offsetof(TextureContainer::ContainerMipEntry, offset));
+			file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+		}
+		TextureContainer outOfBounds;
+		failures += Benchmarks::Check(!outOfBounds.Open(corruptPath.c_str()), "level past the end rejected");
+		return failures;
+	}
+}
+
+int Benchmarks::RunTextureContainer()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::string imagePath = (directory / "benchmark_texture.tga").string();
+	const std::string containerPath = (directory / "benchmark_texture.etex").string();
+	const std::string corruptPath = (directory / "benchmark_texture_corrupt.etex").string();
+	int failures = 0;
+
+	WriteTga(imagePath, IMAGE_SIZE);
+	const TextureImportSettings settings;
+
+	// What every start did before the container: decode, filter the mips and compress them
+	auto start = std::chrono::steady_clock::now();
+	TextureData texture;
+	const bool imported = TextureImporter::Import(imagePath.c_str(), settings, texture);
+	const double importTime = GetMilliseconds(start);
+	failures += Check(imported, "image imported");
+
+	start = std::chrono::steady_clock::now();
+	failures += Check(TextureContainer::Write(containerPath.c_str(), texture, TextureImporter::GetSourceKey(imagePath.c_str(), settings)), "container written");
+	const double writeTime = GetMilliseconds(start);
+	std::printf("%ux%u source: decode on load %.1f ms; container %.1f MB written in %.1f ms\n", IMAGE_SIZE, IMAGE_SIZE, importTime,
+		std::filesystem::file_size(containerPath) / 1e6, writeTime);
+
+	for (int repeat = 0; repeat < 3; repeat++)
+	{
+		start = std::chrono::steady_clock::now();
+		TextureContainer container;
+		if (!container.Open(containerPath.c_str()))
+		{
+			failures += Check(false, "container opened");
+			break;
+		}
+		// Touch every page of every level, as the upload would
+		uint sum = 0;
+		for (uint level = 0; level < container.GetMipCount(); level++)
+		{
+			const TextureLevelView view = container.GetMip(level);
+			for (size_t i = 0; i < view.size; i += 4096)
+				sum += view.data[i];
+		}
+		const double openTime = GetMilliseconds(start);
+		std::printf("container open and read %.2f ms (page sum %u): %.0fx faster than decoding\n", openTime, sum, importTime / openTime);
+
+		if (repeat == 0)
+		{
+			failures += Check(SameLevels(texture, container), "container levels match the import");
+			failures += Check(container.GetSourceKey() == TextureImporter::GetSourceKey(imagePath.c_str(), settings), "source key stored");
+		}
+	}
+
+	// The offline converter pays for BC7 once
+	start = std::chrono::steady_clock::now();
+	const bool converted = TextureImporter::Convert(imagePath.c_str(), containerPath.c_str());
+	const double convertTime = GetMilliseconds(start);
+	TextureContainer offline;
+	failures += Check(converted && offline.Open(containerPath.c_str()) && offline.GetFormat() == TextureFormat::BC7, "offline conversion to BC7");
+	std::printf("offline BC7 conversion %.1f ms\n", convertTime);
+	offline.Close();
+
+	failures += CheckCorruption(containerPath, corruptPath);
+
+	std::filesystem::remove(imagePath);
+	std::filesystem::remove(containerPath);
+	std::filesystem::remove(corruptPath);
+	return failures;
+}
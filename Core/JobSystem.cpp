@@ -0,0 +1,243 @@
+#include "JobSystem.h"
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+	namespace
+	{
+		struct QueuedJob
+		{
+			JobSystem::Job job;
+			JobCounter* counter;
+		};
+
+		struct Pool
+		{
+			std::vector<std::thread> workers;
+			std::deque<QueuedJob> queue;
+			std::mutex mutex;
+			std::condition_variable wakeUp;
+			bool running = false;
+			// Owner of index 0: the thread that initialized the pool
+			std::thread::id initializingThread;
+			// Bit i set: index i + 1 is held by a registered thread
+			std::atomic<uint> registeredThreads{ 0 };
+
+			// Joinable threads left in a static object hang the exit (or terminate it)
+			~Pool();
+		};
+
+		void StopWorkers(Pool& pool)
+		{
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				if (!pool.running)
+					return;
+				pool.running = false;
+			}
+			pool.wakeUp.notify_all();
+			for (std::thread& worker : pool.workers)
+				worker.join();
+			pool.workers.clear();
+		}
+
+		Pool::~Pool()
+		{
+			StopWorkers(*this);
+		}
+
+		Pool& GetPool()
+		{
+			static Pool pool;
+			return pool;
+		}
+
+		thread_local uint t_threadIndex = 0;
+
+		// Hands the registered index back when its thread exits
+		struct RegisteredIndex
+		{
+			uint index = 0;
+
+			~RegisteredIndex()
+			{
+				if (index != 0)
+					GetPool().registeredThreads.fetch_and(~(1u << (index - 1)), std::memory_order_release);
+			}
+		};
+		thread_local RegisteredIndex t_registeredIndex;
+
+		// Pops one job and runs it. Returns false if the queue was empty.
+		bool RunOneJob(Pool& pool)
+		{
+			QueuedJob queued;
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				if (pool.queue.empty())
+					return false;
+				queued = std::move(pool.queue.front());
+				pool.queue.pop_front();
+			}
+			queued.job();
+			queued.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+
+		void WorkerLoop(uint index)
+		{
+			t_threadIndex = index;
+			Pool& pool = GetPool();
+			while (true)
+			{
+				QueuedJob queued;
+				{
+					std::unique_lock<std::mutex> lock(pool.mutex);
+					pool.wakeUp.wait(lock, [&pool] { return !pool.queue.empty() || !pool.running; });
+					if (pool.queue.empty())
+						return; // Not running and nothing left to do
+					queued = std::move(pool.queue.front());
+					pool.queue.pop_front();
+				}
+				queued.job();
+				queued.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+			}
+		}
+	}
+
+	void JobSystem::Initialize(uint workerCount)
+	{
+		Pool& pool = GetPool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		if (pool.running)
+			return;
+
+		if (workerCount == 0)
+		{
+			const uint hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		pool.running = true;
+		pool.initializingThread = std::this_thread::get_id();
+		pool.workers.reserve(workerCount);
+		for (uint i = 0; i < workerCount; i++)
+			pool.workers.emplace_back(WorkerLoop, MAX_REGISTERED_THREADS + 1 + i);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		StopWorkers(GetPool());
+	}
+
+	uint JobSystem::GetThreadCount()
+	{
+		Initialize();
+		return static_cast<uint>(GetPool().workers.size()) + 1;
+	}
+
+	uint JobSystem::GetThreadIndex()
+	{
+		// Index 0 shared by two threads would let them race on the same per-thread data
+		assert(t_threadIndex != 0 || GetPool().initializingThread == std::thread::id() || GetPool().initializingThread == std::this_thread::get_id());
+		return t_threadIndex;
+	}
+
+	uint JobSystem::GetThreadIndexCount()
+	{
+		Initialize();
+		return MAX_REGISTERED_THREADS + 1 + static_cast<uint>(GetPool().workers.size());
+	}
+
+	uint JobSystem::RegisterThread()
+	{
+		Initialize();
+		if (t_threadIndex != 0)
+			return t_threadIndex;
+
+		std::atomic<uint>& registered = GetPool().registeredThreads;
+		uint used = registered.load(std::memory_order_relaxed);
+		while (true)
+		{
+			uint slot = 0;
+			while (slot < MAX_REGISTERED_THREADS && (used & (1u << slot)) != 0)
+				slot++;
+			if (slot == MAX_REGISTERED_THREADS)
+				break;
+			// On failure used is reloaded and the search starts over
+			if (registered.compare_exchange_weak(used, used | (1u << slot), std::memory_order_acquire))
+			{
+				t_threadIndex = slot + 1;
+				t_registeredIndex.index = t_threadIndex;
+				return t_threadIndex;
+			}
+		}
+		std::cout << "ERROR::JOB_SYSTEM::TOO_MANY_REGISTERED_THREADS" << std::endl;
+		return 0;
+	}
+
+	void JobSystem::Execute(JobCounter& counter, Job job)
+	{
+		Initialize();
+		Pool& pool = GetPool();
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			pool.queue.push_back({ std::move(job), &counter });
+		}
+		pool.wakeUp.notify_one();
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		Pool& pool = GetPool();
+		while (counter.pending.load(std::memory_order_acquire) != 0)
+		{
+			if (!RunOneJob(pool))
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::ParallelFor(uint count, uint grainSize, const RangeJob& job)
+	{
+		if (count == 0)
+			return;
+		if (grainSize == 0)
+			grainSize = 1;
+
+		const uint rangeCount = (count + grainSize - 1) / grainSize;
+		if (rangeCount == 1)
+		{
+			job(0, count);
+			return;
+		}
+
+		// Every participant grabs ranges from a shared cursor until the space is exhausted,
+		// so uneven ranges balance themselves without a job per range.
+		std::atomic<uint> nextRange{ 0 };
+		auto drain = [&]()
+		{
+			uint range;
+			while ((range = nextRange.fetch_add(1, std::memory_order_relaxed)) < rangeCount)
+			{
+				const uint begin = range * grainSize;
+				const uint end = begin + grainSize < count ? begin + grainSize : count;
+				job(begin, end);
+			}
+		};
+
+		const uint threadCount = GetThreadCount();
+		const uint helpers = (rangeCount < threadCount ? rangeCount : threadCount) - 1;
+
+		JobCounter counter;
+		for (uint i = 0; i < helpers; i++)
+			Execute(counter, drain);
+		drain();
+		Wait(counter);
+	}
+}
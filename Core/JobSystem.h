@@ -0,0 +1,77 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <atomic>
+#include <functional>
+
+namespace Core
+{
+	// Counts the jobs of a batch that are still pending. Wait() on it to join the batch.
+	struct JobCounter
+	{
+		std::atomic<uint> pending{ 0 };
+	};
+
+	/*
+	* Small fixed-size worker pool shared by the whole engine.
+	* Threads that wait on a counter help executing queued jobs,
+	* so jobs may spawn (and wait on) other jobs without deadlocking.
+	*
+	* The pool lives until Shutdown or, failing that, until static destruction at exit, where it
+	* is shut down automatically. Jobs must not be submitted from destructors of static objects.
+	*/
+	class JobSystem
+	{
+	public:
+		// Threads other than the workers and the initializing thread that may run jobs at the same time
+		static constexpr uint MAX_REGISTERED_THREADS = 4;
+
+		using Job = std::function<void()>;
+		// Receives a half-open range [begin, end) of the iteration space.
+		using RangeJob = std::function<void(uint begin, uint end)>;
+
+		/// <summary>
+		/// Starts the worker threads. Called lazily by the first job submission.
+		/// </summary>
+		/// <param name="workerCount">Number of workers. 0 means one per hardware thread minus the caller.</param>
+		static void Initialize(uint workerCount = 0);
+
+		// Joins all workers. Pending jobs are executed before returning. Runs at exit if not called before.
+		static void Shutdown();
+
+		// Workers plus the calling thread: how many threads a ParallelFor runs on.
+		static uint GetThreadCount();
+
+		/// <summary>
+		/// Index of the current thread: 0 for the thread that initialized the pool,
+		/// 1..MAX_REGISTERED_THREADS for registered threads, the ones above for workers.
+		/// Useful to pick per-thread data without locking; size such data with GetThreadIndexCount.
+		/// </summary>
+		static uint GetThreadIndex();
+
+		// Upper bound (exclusive) of GetThreadIndex
+		static uint GetThreadIndexCount();
+
+		/// <summary>
+		/// Gives the calling thread its own thread index until it exits. Any thread besides the
+		/// initializing one that waits on jobs or runs ParallelFor (e.g. the render thread) must
+		/// register first, or it would share index 0 with the initializing thread.
+		/// </summary>
+		/// <returns>The index, 0 if all MAX_REGISTERED_THREADS are taken.</returns>
+		static uint RegisterThread();
+
+		// Queues a job and increments the counter. The counter is decremented once the job finishes.
+		static void Execute(JobCounter& counter, Job job);
+
+		// Blocks until the counter reaches zero, running queued jobs in the meantime.
+		static void Wait(const JobCounter& counter);
+
+		/// <summary>
+		/// Splits [0, count) into ranges of at most grainSize elements and runs them on all threads,
+		/// including the caller. Returns once every range has been processed.
+		/// </summary>
+		/// <param name="count">Size of the iteration space.</param>
+		/// <param name="grainSize">Maximum number of elements per range.</param>
+		/// <param name="job">Function invoked once per range.</param>
+		static void ParallelFor(uint count, uint grainSize, const RangeJob& job);
+	};
+}
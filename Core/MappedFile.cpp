@@ -0,0 +1,133 @@
+#include "MappedFile.h"
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Core
+{
+	MappedFile::MappedFile(const char* path)
+	{
+		Open(path);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+#ifdef _WIN32
+			std::swap(m_file, other.m_file);
+			std::swap(m_mapping, other.m_mapping);
+#endif
+		}
+		return *this;
+	}
+
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			std::cout << "ERROR::MAPPED_FILE::CANNOT_OPEN: " << path << std::endl;
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			std::cout << "ERROR::MAPPED_FILE::EMPTY_OR_UNREADABLE: " << path << std::endl;
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (view == nullptr)
+		{
+			std::cout << "ERROR::MAPPED_FILE::CANNOT_MAP: " << path << std::endl;
+			if (mapping)
+				CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_file = file;
+		m_mapping = mapping;
+		m_data = static_cast<const uchar*>(view);
+		m_size = static_cast<size_t>(size.QuadPart);
+#else
+		const int descriptor = open(path, O_RDONLY);
+		if (descriptor < 0)
+		{
+			std::cout << "ERROR::MAPPED_FILE::CANNOT_OPEN: " << path << std::endl;
+			return false;
+		}
+
+		struct stat status;
+		if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+		{
+			std::cout << "ERROR::MAPPED_FILE::EMPTY_OR_UNREADABLE: " << path << std::endl;
+			close(descriptor);
+			return false;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+		// The mapping keeps its own reference to the file
+		close(descriptor);
+		if (view == MAP_FAILED)
+		{
+			std::cout << "ERROR::MAPPED_FILE::CANNOT_MAP: " << path << std::endl;
+			return false;
+		}
+		madvise(view, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+		m_data = static_cast<const uchar*>(view);
+		m_size = static_cast<size_t>(status.st_size);
+#endif
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data == nullptr)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		m_file = nullptr;
+		m_mapping = nullptr;
+#else
+		munmap(const_cast<uchar*>(m_data), m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+}
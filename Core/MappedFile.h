@@ -0,0 +1,42 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <cstddef>
+
+namespace Core
+{
+	/*
+	* Read-only memory mapping of a whole file.
+	* The bytes come straight from the OS page cache, nothing is copied on open.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const char* path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		/// <summary>
+		/// Maps the file, unmapping the previous one if any.
+		/// </summary>
+		/// <returns>True on success. Otherwise false and prints the reason.</returns>
+		bool Open(const char* path);
+		void Close();
+
+		inline bool IsOpen() const { return m_data != nullptr; }
+		inline const uchar* GetData() const { return m_data; }
+		inline size_t GetSize() const { return m_size; }
+
+	private:
+		const uchar* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+}
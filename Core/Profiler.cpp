@@ -0,0 +1,59 @@
+#include "Profiler.h"
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Core
+{
+	namespace
+	{
+		struct CounterRegistry
+		{
+			std::mutex mutex;
+			// Counters are heap allocated so references handed out never move
+			std::map<std::string, std::unique_ptr<Profiler::Counter>> counters;
+		};
+
+		CounterRegistry& GetRegistry()
+		{
+			static CounterRegistry registry;
+			return registry;
+		}
+	}
+
+	Profiler::Counter& Profiler::GetCounter(const char* name)
+	{
+		CounterRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		std::unique_ptr<Counter>& counter = registry.counters[name];
+		if (!counter)
+			counter.reset(new Counter(0));
+		return *counter;
+	}
+
+	void Profiler::Max(Counter& counter, long long value)
+	{
+		long long current = counter.load(std::memory_order_relaxed);
+		while (value > current && !counter.compare_exchange_weak(current, value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void Profiler::ForEachCounter(const std::function<void(const char* name, long long value)>& visitor)
+	{
+		CounterRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (const auto& entry : registry.counters)
+			visitor(entry.first.c_str(), entry.second->load(std::memory_order_relaxed));
+	}
+
+	void Profiler::Print()
+	{
+		ForEachCounter([](const char* name, long long value)
+		{
+			std::cout << name << ": " << value << std::endl;
+		});
+	}
+}
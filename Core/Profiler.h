@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+namespace Core
+{
+	/*
+	* Named engine counters (memory usage, state changes, wait times...).
+	* Look a counter up once and keep the reference: it stays valid for the
+	* lifetime of the program and can be updated from any thread.
+	*/
+	class Profiler
+	{
+	public:
+		using Counter = std::atomic<long long>;
+
+		// Returns the counter with that name, creating it (at zero) the first time.
+		static Counter& GetCounter(const char* name);
+
+		static inline void Set(Counter& counter, long long value) { counter.store(value, std::memory_order_relaxed); }
+		static inline void Add(Counter& counter, long long delta) { counter.fetch_add(delta, std::memory_order_relaxed); }
+		// Keeps the largest value ever reported
+		static void Max(Counter& counter, long long value);
+
+		// Visits every counter in name order.
+		static void ForEachCounter(const std::function<void(const char* name, long long value)>& visitor);
+
+		// Prints every counter to the console.
+		static void Print();
+	};
+
+	// Adds the microseconds spent in its scope to a counter.
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(Profiler::Counter& counter) : m_counter(counter), m_start(std::chrono::steady_clock::now()) {}
+		~ScopedTimer()
+		{
+			const auto elapsed = std::chrono::steady_clock::now() - m_start;
+			Profiler::Add(m_counter, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		Profiler::Counter& m_counter;
+		std::chrono::steady_clock::time_point m_start;
+	};
+}
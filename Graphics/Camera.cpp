@@ -1,6 +1,8 @@
 #include "Camera.h"
 #include "Middleware/GLFW/include/GLFW/glfw3.h"
 #include "Math/Matrix4D.h"
+#include "Math/Simd.h"
+#include "Math/Trigonometry.h"
 
 Camera::Camera(Vector3D location, Vector3D up, Vector3D rotation) :
 	front(Vector3D(0.0f, 0.0f, -1.0f))
@@ -15,6 +17,7 @@ Camera::Camera(Vector3D location, Vector3D up, Vector3D rotation) :
 void Camera::ProcessKeyboardInput(GLFWwindow* window, const float& deltaTime)
 {
 	float velocity = m_speed * deltaTime;
+	const Vector3D previousLocation = location;
 
 	// Movement keys
 	// Forwards
@@ -32,12 +35,16 @@ void Camera::ProcessKeyboardInput(GLFWwindow* window, const float& deltaTime)
 	// Right
 	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
 		location += right * velocity;
+
+	if (location.x != previousLocation.x || location.y != previousLocation.y || location.z != previousLocation.z)
+		MarkViewChanged();
 }
 
 void Camera::ProcessMouseMovement(float xOffset, float yOffset, bool constrainPitch)
 {
 	xOffset *= m_mouseSensitivity;
 	yOffset *= m_mouseSensitivity;
+	const Vector3D previousRotation = rotation;
 
 	rotation.y += xOffset;
 	rotation.x += yOffset;
@@ -52,28 +59,182 @@ void Camera::ProcessMouseMovement(float xOffset, float yOffset, bool constrainPi
 	}
 
 	// update Front, Right and Up Vectors using the updated Euler angles
-	UpdateCameraVectors();
+	if (rotation.x != previousRotation.x || rotation.y != previousRotation.y)
+		UpdateCameraVectors();
 }
 
 void Camera::ProcessMouseScroll(float yOffset)
 {
+	const float previousZoom = zoom;
 	zoom -= yOffset;
 	if (zoom < 1.0f)
 		zoom = 1.0f;
 	if (zoom > 45.0f)
 		zoom = 45.0f;
+	if (zoom != previousZoom)
+		MarkProjectionChanged();
+}
+
+
+void Camera::SetLocation(const Vector3D loc)
+{
+	if (loc.x == location.x && loc.y == location.y && loc.z == location.z)
+		return;
+	location = loc;
+	MarkViewChanged();
+}
+
+void Camera::SetProjection(float aspectRatio, float nearPlane, float farPlane)
+{
+	if (aspectRatio == m_aspectRatio && nearPlane == m_nearPlane && farPlane == m_farPlane)
+		return;
+	m_aspectRatio = aspectRatio;
+	m_nearPlane = nearPlane;
+	m_farPlane = farPlane;
+	MarkProjectionChanged();
+}
+
+void Camera::SetDepthMode(CameraUtilities::DepthMode depthMode, Math::ClipDepth clipDepth)
+{
+	if (depthMode == m_depthMode && clipDepth == m_clipDepth)
+		return;
+	m_depthMode = depthMode;
+	m_clipDepth = clipDepth;
+	MarkProjectionChanged();
+}
+
+void Camera::RecomputeMatrices() const
+{
+	if (m_viewDirty)
+	{
+		m_view = Matrix4D::LookAt(location, location + front, up);
+
+		// The view is a rotation then a translation: invert it as R^T and the location
+		m_inverseView = Matrix4D(
+			m_view.r0c0, m_view.r1c0, m_view.r2c0, location.x,
+			m_view.r0c1, m_view.r1c1, m_view.r2c1, location.y,
+			m_view.r0c2, m_view.r1c2, m_view.r2c2, location.z,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	if (m_projectionDirty)
+	{
+		const float fieldOfView = Math::DEG2RAD * zoom;
+		switch (m_depthMode)
+		{
+		case CameraUtilities::DepthMode::ReversedZ:
+			m_projection = Matrix4D::PerspectiveReversedZ(fieldOfView, m_aspectRatio, m_nearPlane, m_farPlane, m_clipDepth);
+			break;
+		case CameraUtilities::DepthMode::InfiniteReversedZ:
+			m_projection = Matrix4D::PerspectiveInfiniteReversedZ(fieldOfView, m_aspectRatio, m_nearPlane, m_clipDepth);
+			break;
+		default:
+			m_projection = Matrix4D::Perspective(fieldOfView, m_aspectRatio, m_nearPlane, m_farPlane, m_clipDepth);
+			break;
+		}
+		m_inverseProjection = m_projection.Inverse();
+	}
+
+	m_viewProjection = m_projection * m_view;
+	m_inverseViewProjection = m_inverseView * m_inverseProjection;
+	m_viewDirty = false;
+	m_projectionDirty = false;
+}
+
+Math::Ray Camera::ScreenPointToRay(float screenX, float screenY, float viewportWidth, float viewportHeight) const
+{
+	const float screenPoint[2] = { screenX, screenY };
+	Math::Ray ray;
+	ScreenPointsToRays(screenPoint, 1, viewportWidth, viewportHeight, &ray);
+	return ray;
+}
+
+void Camera::ScreenPointsToRays(const float* screenPoints, uint count, float viewportWidth, float viewportHeight, Math::Ray* rays) const
+{
+	// Each point is unprojected twice, on the near plane and at a farther NDC depth
+	const Matrix4D& m = GetInverseViewProjectionMatrix();
+	const float scaleX = 2.0f / viewportWidth;
+	const float scaleY = -2.0f / viewportHeight;
+
+	const float lowDepth = m_clipDepth == Math::ClipDepth::ZeroToOne ? 0.0f : -1.0f;
+	const float nearDepth = IsReversedZ() ? 1.0f : lowDepth;
+	float farDepth = IsReversedZ() ? lowDepth : 1.0f;
+	// The far end of an infinite projection unprojects to w = 0, go halfway instead
+	if (m_depthMode == CameraUtilities::DepthMode::InfiniteReversedZ)
+		farDepth = (nearDepth + farDepth) * 0.5f;
+
+	uint i = 0;
+#if MATH_SIMD_SSE2
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 first = _mm_loadu_ps(screenPoints + i * 2);
+		const __m128 second = _mm_loadu_ps(screenPoints + i * 2 + 4);
+		const __m128 ndcX = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)), _mm_set1_ps(scaleX)), one);
+		const __m128 ndcY = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)), _mm_set1_ps(scaleY)), one);
+
+		// Row r of m times (x, y, depth, 1): shared part plus the z column scaled by each depth
+		__m128 nearPoint[4], farPoint[4];
+		const float* row = &m.r0c0;
+		for (int r = 0; r < 4; r++, row += 4)
+		{
+			const __m128 shared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ndcX, _mm_set1_ps(row[0])), _mm_mul_ps(ndcY, _mm_set1_ps(row[1]))), _mm_set1_ps(row[3]));
+			nearPoint[r] = _mm_add_ps(shared, _mm_set1_ps(row[2] * nearDepth));
+			farPoint[r] = _mm_add_ps(shared, _mm_set1_ps(row[2] * farDepth));
+		}
+
+		const __m128 nearW = _mm_div_ps(one, nearPoint[3]);
+		const __m128 farW = _mm_div_ps(one, farPoint[3]);
+		alignas(16) float origin[3][4], direction[3][4];
+		__m128 delta[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			nearPoint[axis] = _mm_mul_ps(nearPoint[axis], nearW);
+			delta[axis] = _mm_sub_ps(_mm_mul_ps(farPoint[axis], farW), nearPoint[axis]);
+			_mm_store_ps(origin[axis], nearPoint[axis]);
+		}
+		const __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(delta[0], delta[0]), _mm_mul_ps(delta[1], delta[1])), _mm_mul_ps(delta[2], delta[2]))));
+		for (int axis = 0; axis < 3; axis++)
+			_mm_store_ps(direction[axis], _mm_mul_ps(delta[axis], inverseLength));
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			rays[i + lane].origin = Vector3D(origin[0][lane], origin[1][lane], origin[2][lane]);
+			rays[i + lane].direction = Vector3D(direction[0][lane], direction[1][lane], direction[2][lane]);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float ndcX = screenPoints[i * 2] * scaleX - 1.0f;
+		const float ndcY = screenPoints[i * 2 + 1] * scaleY + 1.0f;
+		const Math::Vector4D nearPoint = m * Math::Vector4D(ndcX, ndcY, nearDepth, 1.0f);
+		const Math::Vector4D farPoint = m * Math::Vector4D(ndcX, ndcY, farDepth, 1.0f);
+		const Vector3D origin(nearPoint.x / nearPoint.w, nearPoint.y / nearPoint.w, nearPoint.z / nearPoint.w);
+		const Vector3D target(farPoint.x / farPoint.w, farPoint.y / farPoint.w, farPoint.z / farPoint.w);
+		rays[i] = Math::Ray(origin, (target - origin).Normalized());
+	}
+}
+
+Math::Frustum Camera::GetFrustum() const
+{
+	return Math::Frustum::FromMatrix(GetViewProjectionMatrix(), m_clipDepth, IsReversedZ());
 }
 
 
 void Camera::UpdateCameraVectors()
 {
 	// calculate the new Front vector
+	float sinPitch, cosPitch, sinYaw, cosYaw;
+	Math::SinCos(Math::DEG2RAD * rotation.x, sinPitch, cosPitch);
+	Math::SinCos(Math::DEG2RAD * rotation.y, sinYaw, cosYaw);
 	Vector3D Front;
-	Front.x = cos(Math::DEG2RAD * rotation.y) * cos(Math::DEG2RAD * rotation.x);
-	Front.y = sin(Math::DEG2RAD * rotation.x);
-	Front.z = sin(Math::DEG2RAD * rotation.y) * cos(Math::DEG2RAD * rotation.x);
+	Front.x = cosYaw * cosPitch;
+	Front.y = sinPitch;
+	Front.z = sinYaw * cosPitch;
 	this->front = Front.Normalized();
 	// also re-calculate the Right and Up vector
 	this->right = Vector3D::CrossProduct(this->front, worldUp).Normalized(); // normalize the vectors, because their length gets closer to 0 the more you look up or down which results in slower movement.
 	this->up = Vector3D::CrossProduct(right, front).Normalized();
+	MarkViewChanged();
 }
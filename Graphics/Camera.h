@@ -1,6 +1,9 @@
 #pragma once
 #include "Math/Vector3D.h"
 #include "Math/Matrix4D.h"
+#include "Math/Ray.h"
+#include "Math/Frustum.h"
+#include "Misc/Typedefs.h"
 
 using Math::Vector3D;
 using Math::Matrix4D;
@@ -10,6 +13,9 @@ namespace CameraUtilities
 {
 	constexpr float YAW = -90.0f;
 	constexpr float PITCH = 0.0f;
+
+	// Which perspective builder the camera uses, see Matrix4D::PerspectiveReversedZ
+	enum class DepthMode { Standard, ReversedZ, InfiniteReversedZ };
 }
 
 class Camera
@@ -19,19 +25,75 @@ public:
 	Camera(Vector3D location = Vector3D(0.0f), Vector3D up = Vector3D(0.0f, 1.0f, 0.0f),
 		Vector3D rotation = Vector3D(CameraUtilities::PITCH, CameraUtilities::YAW, 0.0f));
 
+	/*
+	* The matrices below are cached and only recomputed after the camera changed.
+	* Not thread safe: query them from one thread, or once before handing them out.
+	*/
+
 	// Returns the view matrix calculated using Euler Angles and the LookAt Matrix
-	inline Matrix4D GetViewMatrix() const
-	{
-		return Matrix4D::LookAt(location, location + front, up);
-	}
+	inline const Matrix4D& GetViewMatrix() const { UpdateMatrices(); return m_view; }
+	inline const Matrix4D& GetProjectionMatrix() const { UpdateMatrices(); return m_projection; }
+	inline const Matrix4D& GetViewProjectionMatrix() const { UpdateMatrices(); return m_viewProjection; }
+	inline const Matrix4D& GetInverseViewMatrix() const { UpdateMatrices(); return m_inverseView; }
+	inline const Matrix4D& GetInverseProjectionMatrix() const { UpdateMatrices(); return m_inverseProjection; }
+	inline const Matrix4D& GetInverseViewProjectionMatrix() const { UpdateMatrices(); return m_inverseViewProjection; }
+
+	/// <summary>
+	/// Incremented whenever location, rotation, zoom or projection change.
+	/// Compare with a stored value to skip uniform uploads or culling on static frames.
+	/// </summary>
+	inline uint64 GetVersion() const { return m_version; }
 
 	inline Vector3D GetLocation() const { return location; }
-	inline void SetLocation(const Vector3D loc) { location = loc; }
+	void SetLocation(const Vector3D loc);
 
 	inline Vector3D GetForwardVector() const { return front; }
 	inline Vector3D GetUpVector() const { return up; }
 	inline Vector3D GetRightVector() const { return right; }
 
+	// Vertical field of view in degrees, changed by ProcessMouseScroll
+	inline float GetZoom() const { return zoom; }
+
+	/// <summary>
+	/// Sets the perspective projection parameters. The field of view is the zoom.
+	/// </summary>
+	/// <param name="aspectRatio">Width / height of the viewport.</param>
+	/// <param name="nearPlane">Distance to the near clipping plane.</param>
+	/// <param name="farPlane">Distance to the far clipping plane.</param>
+	void SetProjection(float aspectRatio, float nearPlane, float farPlane);
+
+	/// <summary>
+	/// Selects the depth mapping of the projection. The renderer has to match it:
+	/// glClipControl for ZeroToOne, and for reversed-Z glDepthFunc(GL_GREATER) with depth cleared to 0.
+	/// InfiniteReversedZ ignores the far plane.
+	/// </summary>
+	void SetDepthMode(CameraUtilities::DepthMode depthMode, Math::ClipDepth clipDepth);
+	inline CameraUtilities::DepthMode GetDepthMode() const { return m_depthMode; }
+	inline Math::ClipDepth GetClipDepth() const { return m_clipDepth; }
+	inline bool IsReversedZ() const { return m_depthMode != CameraUtilities::DepthMode::Standard; }
+
+	/// <summary>
+	/// Builds the world space ray going from the camera through a point of the viewport,
+	/// e.g. the mouse cursor for picking.
+	/// </summary>
+	/// <param name="screenX">Pixels from the left edge.</param>
+	/// <param name="screenY">Pixels from the top edge (GLFW cursor convention).</param>
+	/// <param name="viewportWidth">Width of the viewport in pixels.</param>
+	/// <param name="viewportHeight">Height of the viewport in pixels.</param>
+	/// <returns>A ray starting on the near plane with a unit length direction.</returns>
+	Math::Ray ScreenPointToRay(float screenX, float screenY, float viewportWidth, float viewportHeight) const;
+
+	/// <summary>
+	/// ScreenPointToRay for many points at once (marquee selection, CPU ray casting of the screen).
+	/// Four points are unprojected per iteration with SSE.
+	/// </summary>
+	/// <param name="screenPoints">count (x, y) pairs in pixels, interleaved.</param>
+	/// <param name="rays">Receives count rays.</param>
+	void ScreenPointsToRays(const float* screenPoints, uint count, float viewportWidth, float viewportHeight, Math::Ray* rays) const;
+
+	// View frustum of the current projection
+	Math::Frustum GetFrustum() const;
+
 	// Keyboard input
 	void ProcessKeyboardInput(GLFWwindow* window, const float& deltaTime);
 
@@ -55,6 +117,32 @@ private:
 	float m_mouseSensitivity = 0.1f;
 	float zoom = 45.0f;
 
+	float m_aspectRatio = 16.0f / 9.0f;
+	float m_nearPlane = 0.1f;
+	float m_farPlane = 100.0f;
+	CameraUtilities::DepthMode m_depthMode = CameraUtilities::DepthMode::Standard;
+	Math::ClipDepth m_clipDepth = Math::ClipDepth::NegativeOneToOne;
+
+	uint64 m_version = 0;
+	mutable Matrix4D m_view;
+	mutable Matrix4D m_projection;
+	mutable Matrix4D m_viewProjection;
+	mutable Matrix4D m_inverseView;
+	mutable Matrix4D m_inverseProjection;
+	mutable Matrix4D m_inverseViewProjection;
+	mutable bool m_viewDirty = true;
+	mutable bool m_projectionDirty = true;
+
 	// calculates the front vector from the Camera's (updated) Euler Angles
 	void UpdateCameraVectors();
+
+	inline void MarkViewChanged() { m_viewDirty = true; m_version++; }
+	inline void MarkProjectionChanged() { m_projectionDirty = true; m_version++; }
+
+	inline void UpdateMatrices() const
+	{
+		if (m_viewDirty || m_projectionDirty)
+			RecomputeMatrices();
+	}
+	void RecomputeMatrices() const;
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "CommandList.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include "Memory/ScopedStack.h"
+#include <cstring>
+
+CommandList::CommandList(size_t arenaBytes) : m_arena(arenaBytes)
+{
+}
+
+void CommandList::Reset()
+{
+	m_arena.Reset();
+	m_first = nullptr;
+	m_last = nullptr;
+	m_count = 0;
+	m_transformCount = 0;
+	m_uniformBytes = 0;
+}
+
+bool CommandList::Record(const DrawPacket& packet, const Math::Matrix4D* transform, const void* uniformData)
+{
+	// Allocate everything first so a full arena leaves the list as it was
+	const size_t marker = m_arena.GetMarker();
+	Command* command = m_arena.AllocateArray<Command>(1);
+	Math::Matrix4D* transformCopy = transform ? m_arena.AllocateArray<Math::Matrix4D>(1) : nullptr;
+	void* uniformCopy = uniformData ? m_arena.Allocate(packet.uniformBlockSize) : nullptr;
+	if (!command || (transform && !transformCopy) || (uniformData && !uniformCopy))
+	{
+		m_arena.Rewind(marker);
+		return false;
+	}
+
+	if (transform)
+	{
+		*transformCopy = *transform;
+		m_transformCount++;
+	}
+	if (uniformData)
+	{
+		std::memcpy(uniformCopy, uniformData, packet.uniformBlockSize);
+		m_uniformBytes += packet.uniformBlockSize;
+	}
+
+	command->packet = packet;
+	command->transform = transformCopy;
+	command->uniformData = uniformCopy;
+	command->next = nullptr;
+	if (m_last)
+		m_last->next = command;
+	else
+		m_first = command;
+	m_last = command;
+	m_count++;
+	return true;
+}
+
+void CommandList::CopyTo(const RenderQueue::AppendBlock& block, uint packet, uint transform, uint uniformByte) const
+{
+	for (const Command* command = m_first; command; command = command->next)
+	{
+		DrawPacket& copy = block.packets[packet++];
+		copy = command->packet;
+		if (command->transform)
+		{
+			block.transforms[transform] = *command->transform;
+			copy.transform = block.firstTransform + transform++;
+		}
+		if (command->uniformData)
+		{
+			std::memcpy(block.uniformData + uniformByte, command->uniformData, copy.uniformBlockSize);
+			copy.uniformBlock = block.firstUniformByte + uniformByte;
+			uniformByte += copy.uniformBlockSize;
+		}
+	}
+}
+
+CommandListSet::CommandListSet(size_t arenaBytesPerThread)
+{
+	const uint threadCount = Core::JobSystem::GetThreadIndexCount();
+	m_lists.reserve(threadCount);
+	for (uint i = 0; i < threadCount; i++)
+		m_lists.emplace_back(new CommandList(arenaBytesPerThread));
+}
+
+void CommandListSet::Reset()
+{
+	for (const std::unique_ptr<CommandList>& list : m_lists)
+		list->Reset();
+}
+
+CommandList& CommandListSet::GetThreadList()
+{
+	return *m_lists[Core::JobSystem::GetThreadIndex()];
+}
+
+void CommandListSet::MergeInto(RenderQueue& queue) const
+{
+	static Core::Profiler::Counter& recordedCounter = Core::Profiler::GetCounter("Graphics/CommandLists/RecordedDraws");
+
+	// Each list's place in the merged arrays
+	const uint listCount = GetListCount();
+	Memory::ScopedStack stack;
+	uint* offsets = stack.AllocateArray<uint>(listCount * 3);
+	uint packets = 0, transforms = 0, uniformBytes = 0;
+	for (uint i = 0; i < listCount; i++)
+	{
+		offsets[i * 3 + 0] = packets;
+		offsets[i * 3 + 1] = transforms;
+		offsets[i * 3 + 2] = uniformBytes;
+		packets += m_lists[i]->GetCount();
+		transforms += m_lists[i]->GetTransformCount();
+		uniformBytes += m_lists[i]->GetUniformBytes();
+	}
+
+	const RenderQueue::AppendBlock block = queue.Append(packets, transforms, uniformBytes);
+	Core::JobSystem::ParallelFor(listCount, 1, [this, &block, offsets](uint begin, uint end)
+	{
+		for (uint i = begin; i < end; i++)
+			m_lists[i]->CopyTo(block, offsets[i * 3 + 0], offsets[i * 3 + 1], offsets[i * 3 + 2]);
+	});
+	Core::Profiler::Set(recordedCounter, packets);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "RenderQueue.h"
+#include "Math/Matrix4D.h"
+#include "Memory/AlignedAllocator.h"
+#include "Memory/LinearArena.h"
+#include "Misc/Typedefs.h"
+#include <memory>
+#include <vector>
+
+/*
+* Draws recorded by one thread, with copies of their transforms and uniform blocks,
+* stored back to back in a linear arena: recording never locks or allocates.
+*/
+class alignas(Memory::CACHE_LINE_SIZE) CommandList
+{
+public:
+	explicit CommandList(size_t arenaBytes);
+
+	CommandList(const CommandList&) = delete;
+	CommandList& operator=(const CommandList&) = delete;
+
+	// Forgets the recorded draws, keeping the arena
+	void Reset();
+
+	/// <summary>
+	/// Records a draw. The packet's transform and uniformBlock fields are filled in on merge.
+	/// </summary>
+	/// <param name="transform">Copied if not null.</param>
+	/// <param name="uniformData">packet.uniformBlockSize bytes copied if not null.</param>
+	/// <returns>False if the arena is full: the draw is dropped.</returns>
+	bool Record(const DrawPacket& packet, const Math::Matrix4D* transform = nullptr, const void* uniformData = nullptr);
+
+	inline uint GetCount() const { return m_count; }
+	inline uint GetTransformCount() const { return m_transformCount; }
+	inline uint GetUniformBytes() const { return m_uniformBytes; }
+
+	/// <summary>
+	/// Copies the recorded draws into storage from RenderQueue::Append, at the given offsets
+	/// into the block. Touches nothing else, so lists can be copied in parallel.
+	/// </summary>
+	void CopyTo(const RenderQueue::AppendBlock& block, uint packet, uint transform, uint uniformByte) const;
+
+private:
+	struct Command
+	{
+		DrawPacket packet;
+		const Math::Matrix4D* transform;
+		const void* uniformData;
+		const Command* next;
+	};
+
+	Memory::LinearArena m_arena;
+	const Command* m_first = nullptr;
+	Command* m_last = nullptr;
+	uint m_count = 0;
+	uint m_transformCount = 0;
+	uint m_uniformBytes = 0;
+};
+
+/*
+* One command list per job system thread, so draws can be recorded from jobs (e.g. a
+* ParallelFor over the visible objects) without synchronization, then merged into a
+* RenderQueue to be sorted and executed like serially submitted draws.
+*
+* Usage per frame: Reset, GetThreadList().Record from any job, MergeInto, then Sort the queue.
+* Equal sort keys end up in an order that depends on job scheduling.
+*/
+class CommandListSet
+{
+public:
+	/// <param name="arenaBytesPerThread">Capacity of each thread's list. A draw with a transform takes about 160 bytes.</param>
+	explicit CommandListSet(size_t arenaBytesPerThread = 1024 * 1024);
+
+	void Reset();
+
+	// The calling thread's list (JobSystem::GetThreadIndex)
+	CommandList& GetThreadList();
+
+	inline uint GetListCount() const { return static_cast<uint>(m_lists.size()); }
+	inline CommandList& GetList(uint i) { return *m_lists[i]; }
+
+	/// <summary>
+	/// Appends every list to the queue, copying the lists in parallel on the job system.
+	/// Call once all recording jobs have finished.
+	/// </summary>
+	void MergeInto(RenderQueue& queue) const;
+
+private:
+	std::vector<std::unique_ptr<CommandList>> m_lists;
+};
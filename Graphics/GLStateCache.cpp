@@ -0,0 +1,413 @@
+#include "GLStateCache.h"
+#include "Core/Profiler.h"
+#include "Middleware/GLEW/include/GL/glew.h"
+#include <iostream>
+
+namespace
+{
+	// No GL object or enum has this value
+	const uint UNKNOWN = 0xFFFFFFFF;
+
+	const uint BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER,
+		GL_DRAW_INDIRECT_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER };
+	const uint BUFFER_BINDINGS[] = { GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_BINDING,
+		GL_DRAW_INDIRECT_BUFFER_BINDING, GL_COPY_READ_BUFFER_BINDING, GL_COPY_WRITE_BUFFER_BINDING, GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING };
+	const uint BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+	// The element array binding is part of the vertex array object
+	const uint ELEMENT_ARRAY_SLOT = 1;
+
+	const uint TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_3D };
+	const uint TEXTURE_BINDINGS[] = { GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_2D_ARRAY, GL_TEXTURE_BINDING_CUBE_MAP, GL_TEXTURE_BINDING_3D };
+	const uint TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+	const uint CAPABILITIES[] = { GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST,
+		GL_FRAMEBUFFER_SRGB, GL_MULTISAMPLE, GL_POLYGON_OFFSET_FILL };
+	const uint CAPABILITY_COUNT = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+
+	struct State
+	{
+		uint program;
+		uint vertexArray;
+		uint buffers[BUFFER_TARGET_COUNT];
+		uint activeTexture;
+		uint textures[GLStateCache::MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+		uint samplers[GLStateCache::MAX_TEXTURE_UNITS];
+		uint drawFramebuffer;
+		uint readFramebuffer;
+		uint capabilities[CAPABILITY_COUNT];
+		uint blendSource;
+		uint blendDestination;
+		uint blendEquation;
+		uint depthFunction;
+		uint depthMask;
+		uint cullFace;
+		uint viewport[4];
+	};
+
+	State CreateUnknownState()
+	{
+		State state;
+		state.program = UNKNOWN;
+		state.vertexArray = UNKNOWN;
+		for (uint& buffer : state.buffers)
+			buffer = UNKNOWN;
+		state.activeTexture = UNKNOWN;
+		for (auto& unit : state.textures)
+			for (uint& texture : unit)
+				texture = UNKNOWN;
+		for (uint& sampler : state.samplers)
+			sampler = UNKNOWN;
+		state.drawFramebuffer = UNKNOWN;
+		state.readFramebuffer = UNKNOWN;
+		for (uint& capability : state.capabilities)
+			capability = UNKNOWN;
+		state.blendSource = UNKNOWN;
+		state.blendDestination = UNKNOWN;
+		state.blendEquation = UNKNOWN;
+		state.depthFunction = UNKNOWN;
+		state.depthMask = UNKNOWN;
+		state.cullFace = UNKNOWN;
+		for (uint& component : state.viewport)
+			component = UNKNOWN;
+		return state;
+	}
+
+	State s_state = CreateUnknownState();
+#ifdef _DEBUG
+	bool s_verify = true;
+#else
+	bool s_verify = false;
+#endif
+
+	inline uint QueryInteger(uint parameter)
+	{
+		GLint value = 0;
+		glGetIntegerv(parameter, &value);
+		return static_cast<uint>(value);
+	}
+
+	inline uint QueryTexture(uint unit, uint binding)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		s_state.activeTexture = unit;
+		return QueryInteger(binding);
+	}
+
+	inline uint QuerySampler(uint unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		s_state.activeTexture = unit;
+		return QueryInteger(GL_SAMPLER_BINDING);
+	}
+
+	inline uint QueryEnabled(uint capability)
+	{
+		return glIsEnabled(capability) == GL_TRUE ? 1 : 0;
+	}
+
+	inline uint QueryDepthMask()
+	{
+		GLboolean value = GL_FALSE;
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &value);
+		return value == GL_TRUE ? 1 : 0;
+	}
+
+	void ReportDesync(const char* state, uint cached, uint actual)
+	{
+		std::cout << "ERROR::GLSTATECACHE::DESYNC: " << state << " cached as " << cached << " but the driver has " << actual << std::endl;
+	}
+
+	/// <summary>
+	/// The filter every cached value goes through: updates the cache on a change.
+	/// </summary>
+	/// <param name="query">Reads the current value from the driver, only used when verifying.</param>
+	/// <returns>True if the call must reach the driver.</returns>
+	template<typename Query>
+	bool Changes(uint& cached, uint value, const char* state, Query query)
+	{
+		if (cached != value)
+		{
+			cached = value;
+			return true;
+		}
+		if (s_verify)
+		{
+			const uint actual = query();
+			if (actual != value)
+			{
+				ReportDesync(state, value, actual);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Counts a call and whether it was dropped, passing the decision through
+	inline bool Issue(bool changes)
+	{
+		static Core::Profiler::Counter& callsCounter = Core::Profiler::GetCounter("Graphics/GLState/Calls");
+		static Core::Profiler::Counter& skippedCounter = Core::Profiler::GetCounter("Graphics/GLState/CallsSkipped");
+
+		Core::Profiler::Add(callsCounter, 1);
+		if (!changes)
+			Core::Profiler::Add(skippedCounter, 1);
+		return changes;
+	}
+
+	inline int FindSlot(const uint* targets, uint count, uint target)
+	{
+		for (uint i = 0; i < count; i++)
+			if (targets[i] == target)
+				return static_cast<int>(i);
+		return -1;
+	}
+
+	inline void SetActiveTexture(uint unit)
+	{
+		if (Issue(Changes(s_state.activeTexture, unit, "active texture", [] { return QueryInteger(GL_ACTIVE_TEXTURE) - GL_TEXTURE0; })))
+			glActiveTexture(GL_TEXTURE0 + unit);
+	}
+}
+
+void GLStateCache::UseProgram(uint program)
+{
+	if (Issue(Changes(s_state.program, program, "program", [] { return QueryInteger(GL_CURRENT_PROGRAM); })))
+		glUseProgram(program);
+}
+
+void GLStateCache::BindVertexArray(uint vertexArray)
+{
+	if (Issue(Changes(s_state.vertexArray, vertexArray, "vertex array", [] { return QueryInteger(GL_VERTEX_ARRAY_BINDING); })))
+	{
+		glBindVertexArray(vertexArray);
+		s_state.buffers[ELEMENT_ARRAY_SLOT] = UNKNOWN;
+	}
+}
+
+void GLStateCache::BindBuffer(uint target, uint buffer)
+{
+	const int slot = FindSlot(BUFFER_TARGETS, BUFFER_TARGET_COUNT, target);
+	if (slot < 0)
+	{
+		glBindBuffer(target, buffer);
+		return;
+	}
+	const uint binding = BUFFER_BINDINGS[slot];
+	if (Issue(Changes(s_state.buffers[slot], buffer, "buffer binding", [binding] { return QueryInteger(binding); })))
+		glBindBuffer(target, buffer);
+}
+
+void GLStateCache::BindTexture(uint unit, uint target, uint texture)
+{
+	const int slot = FindSlot(TEXTURE_TARGETS, TEXTURE_TARGET_COUNT, target);
+	if (slot < 0 || unit >= MAX_TEXTURE_UNITS)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		s_state.activeTexture = unit;
+		glBindTexture(target, texture);
+		return;
+	}
+	const uint binding = TEXTURE_BINDINGS[slot];
+	if (Issue(Changes(s_state.textures[unit][slot], texture, "texture binding", [unit, binding] { return QueryTexture(unit, binding); })))
+	{
+		SetActiveTexture(unit);
+		glBindTexture(target, texture);
+	}
+}
+
+void GLStateCache::BindSampler(uint unit, uint sampler)
+{
+	if (unit >= MAX_TEXTURE_UNITS)
+	{
+		glBindSampler(unit, sampler);
+		return;
+	}
+	if (Issue(Changes(s_state.samplers[unit], sampler, "sampler binding", [unit] { return QuerySampler(unit); })))
+		glBindSampler(unit, sampler);
+}
+
+void GLStateCache::BindFramebuffer(uint target, uint framebuffer)
+{
+	if (target == GL_FRAMEBUFFER)
+	{
+		// Check both before updating either: && would leave the read binding stale when the draw one changes
+		const bool drawChanges = Changes(s_state.drawFramebuffer, framebuffer, "draw framebuffer", [] { return QueryInteger(GL_DRAW_FRAMEBUFFER_BINDING); });
+		const bool readChanges = Changes(s_state.readFramebuffer, framebuffer, "read framebuffer", [] { return QueryInteger(GL_READ_FRAMEBUFFER_BINDING); });
+		if (Issue(drawChanges || readChanges))
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+	else if (target == GL_DRAW_FRAMEBUFFER)
+	{
+		if (Issue(Changes(s_state.drawFramebuffer, framebuffer, "draw framebuffer", [] { return QueryInteger(GL_DRAW_FRAMEBUFFER_BINDING); })))
+			glBindFramebuffer(target, framebuffer);
+	}
+	else if (target == GL_READ_FRAMEBUFFER)
+	{
+		if (Issue(Changes(s_state.readFramebuffer, framebuffer, "read framebuffer", [] { return QueryInteger(GL_READ_FRAMEBUFFER_BINDING); })))
+			glBindFramebuffer(target, framebuffer);
+	}
+	else
+		glBindFramebuffer(target, framebuffer);
+}
+
+void GLStateCache::SetEnabled(uint capability, bool enabled)
+{
+	const int slot = FindSlot(CAPABILITIES, CAPABILITY_COUNT, capability);
+	if (slot >= 0 && !Issue(Changes(s_state.capabilities[slot], enabled ? 1 : 0, "capability", [capability] { return QueryEnabled(capability); })))
+		return;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+void GLStateCache::BlendFunc(uint source, uint destination)
+{
+	const bool sourceChanges = Changes(s_state.blendSource, source, "blend source", [] { return QueryInteger(GL_BLEND_SRC_RGB); });
+	const bool destinationChanges = Changes(s_state.blendDestination, destination, "blend destination", [] { return QueryInteger(GL_BLEND_DST_RGB); });
+	if (Issue(sourceChanges || destinationChanges))
+		glBlendFunc(source, destination);
+}
+
+void GLStateCache::BlendEquation(uint mode)
+{
+	if (Issue(Changes(s_state.blendEquation, mode, "blend equation", [] { return QueryInteger(GL_BLEND_EQUATION_RGB); })))
+		glBlendEquation(mode);
+}
+
+void GLStateCache::DepthFunc(uint function)
+{
+	if (Issue(Changes(s_state.depthFunction, function, "depth function", [] { return QueryInteger(GL_DEPTH_FUNC); })))
+		glDepthFunc(function);
+}
+
+void GLStateCache::DepthMask(bool write)
+{
+	if (Issue(Changes(s_state.depthMask, write ? 1 : 0, "depth mask", [] { return QueryDepthMask(); })))
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::CullFace(uint face)
+{
+	if (Issue(Changes(s_state.cullFace, face, "cull face", [] { return QueryInteger(GL_CULL_FACE_MODE); })))
+		glCullFace(face);
+}
+
+void GLStateCache::Viewport(int x, int y, int width, int height)
+{
+	const int viewport[4] = { x, y, width, height };
+	bool changes = false;
+	for (uint i = 0; i < 4; i++)
+	{
+		changes |= Changes(s_state.viewport[i], static_cast<uint>(viewport[i]), "viewport", [i]
+		{
+			GLint actual[4] = {};
+			glGetIntegerv(GL_VIEWPORT, actual);
+			return static_cast<uint>(actual[i]);
+		});
+	}
+	if (Issue(changes))
+		glViewport(x, y, width, height);
+}
+
+void GLStateCache::OnVertexArrayDeleted(uint vertexArray)
+{
+	if (s_state.vertexArray == vertexArray)
+	{
+		s_state.vertexArray = 0;
+		s_state.buffers[ELEMENT_ARRAY_SLOT] = UNKNOWN;
+	}
+}
+
+void GLStateCache::OnBufferDeleted(uint buffer)
+{
+	for (uint& bound : s_state.buffers)
+		if (bound == buffer)
+			bound = 0;
+}
+
+void GLStateCache::OnTextureDeleted(uint texture)
+{
+	for (auto& unit : s_state.textures)
+		for (uint& bound : unit)
+			if (bound == texture)
+				bound = 0;
+}
+
+void GLStateCache::OnSamplerDeleted(uint sampler)
+{
+	for (uint& bound : s_state.samplers)
+		if (bound == sampler)
+			bound = 0;
+}
+
+void GLStateCache::OnFramebufferDeleted(uint framebuffer)
+{
+	if (s_state.drawFramebuffer == framebuffer)
+		s_state.drawFramebuffer = 0;
+	if (s_state.readFramebuffer == framebuffer)
+		s_state.readFramebuffer = 0;
+}
+
+void GLStateCache::Invalidate()
+{
+	s_state = CreateUnknownState();
+}
+
+namespace
+{
+	bool Matches(const char* state, uint cached, uint actual)
+	{
+		if (cached == UNKNOWN || cached == actual)
+			return true;
+		ReportDesync(state, cached, actual);
+		return false;
+	}
+}
+
+bool GLStateCache::Verify()
+{
+	bool matches = true;
+	matches &= Matches("program", s_state.program, QueryInteger(GL_CURRENT_PROGRAM));
+	matches &= Matches("vertex array", s_state.vertexArray, QueryInteger(GL_VERTEX_ARRAY_BINDING));
+	for (uint i = 0; i < BUFFER_TARGET_COUNT; i++)
+		matches &= Matches("buffer binding", s_state.buffers[i], QueryInteger(BUFFER_BINDINGS[i]));
+
+	// Per unit queries go through the active texture: restore it afterwards
+	const uint activeTexture = QueryInteger(GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+	matches &= Matches("active texture", s_state.activeTexture, activeTexture);
+	for (uint unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		for (uint i = 0; i < TEXTURE_TARGET_COUNT; i++)
+			matches &= Matches("texture binding", s_state.textures[unit][i], QueryInteger(TEXTURE_BINDINGS[i]));
+		matches &= Matches("sampler binding", s_state.samplers[unit], QueryInteger(GL_SAMPLER_BINDING));
+	}
+	glActiveTexture(GL_TEXTURE0 + activeTexture);
+
+	matches &= Matches("draw framebuffer", s_state.drawFramebuffer, QueryInteger(GL_DRAW_FRAMEBUFFER_BINDING));
+	matches &= Matches("read framebuffer", s_state.readFramebuffer, QueryInteger(GL_READ_FRAMEBUFFER_BINDING));
+	for (uint i = 0; i < CAPABILITY_COUNT; i++)
+		matches &= Matches("capability", s_state.capabilities[i], QueryEnabled(CAPABILITIES[i]));
+	matches &= Matches("blend source", s_state.blendSource, QueryInteger(GL_BLEND_SRC_RGB));
+	matches &= Matches("blend destination", s_state.blendDestination, QueryInteger(GL_BLEND_DST_RGB));
+	matches &= Matches("blend equation", s_state.blendEquation, QueryInteger(GL_BLEND_EQUATION_RGB));
+	matches &= Matches("depth function", s_state.depthFunction, QueryInteger(GL_DEPTH_FUNC));
+	matches &= Matches("depth mask", s_state.depthMask, QueryDepthMask());
+	matches &= Matches("cull face", s_state.cullFace, QueryInteger(GL_CULL_FACE_MODE));
+	GLint viewport[4] = {};
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	for (uint i = 0; i < 4; i++)
+		matches &= Matches("viewport", s_state.viewport[i], static_cast<uint>(viewport[i]));
+	return matches;
+}
+
+void GLStateCache::SetVerification(bool enabled)
+{
+	s_verify = enabled;
+}
+
+bool GLStateCache::IsVerificationEnabled()
+{
+	return s_verify;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "Misc/Typedefs.h"
+
+/*
+* Shadow copy of the GL context state the engine touches. Each call compares against the
+* cached value and only reaches the driver if the state actually changes, so code can set
+* what it needs before every draw without paying for redundant binds.
+*
+* Everything starts out unknown, so the first call of each kind always goes through
+* whatever state the context was created with. Code calling GL directly for state covered
+* here (third party UI, debug tools) must call Invalidate afterwards. Like GL itself, only
+* to be used from the thread owning the context.
+*
+* With verification on (default in _DEBUG), every filtered call also reads the state back
+* with glGet* and reports a desync instead of trusting the cache; Verify checks everything at once.
+*/
+class GLStateCache
+{
+public:
+	static constexpr uint MAX_TEXTURE_UNITS = 16;
+
+	static void UseProgram(uint program);
+	static void BindVertexArray(uint vertexArray);
+	// Array, element array, uniform, shader storage, indirect, copy and pixel buffers are cached; other targets pass through
+	static void BindBuffer(uint target, uint buffer);
+	// 2D, 2D array, cube map and 3D targets are cached; other targets pass through
+	static void BindTexture(uint unit, uint target, uint texture);
+	static void BindSampler(uint unit, uint sampler);
+	// GL_FRAMEBUFFER binds both draw and read framebuffers
+	static void BindFramebuffer(uint target, uint framebuffer);
+
+	// glEnable / glDisable. Blend, depth, cull, scissor, stencil, sRGB, multisample and polygon offset are cached.
+	static void SetEnabled(uint capability, bool enabled);
+	static void BlendFunc(uint source, uint destination);
+	static void BlendEquation(uint mode);
+	static void DepthFunc(uint function);
+	static void DepthMask(bool write);
+	static void CullFace(uint face);
+	static void Viewport(int x, int y, int width, int height);
+
+	// Deleting objects unbinds them from the context: call after glDelete* so the cache follows
+	static void OnVertexArrayDeleted(uint vertexArray);
+	static void OnBufferDeleted(uint buffer);
+	static void OnTextureDeleted(uint texture);
+	static void OnSamplerDeleted(uint sampler);
+	static void OnFramebufferDeleted(uint framebuffer);
+
+	// Forgets all cached state: the next call of each kind goes to the driver
+	static void Invalidate();
+
+	/// <summary>
+	/// Compares every cached value with the driver's (glGet*), printing each mismatch.
+	/// Slow: meant for debugging and tests.
+	/// </summary>
+	/// <returns>True if the cache matches the context.</returns>
+	static bool Verify();
+
+	// Whether filtered calls check the driver's state before being dropped
+	static void SetVerification(bool enabled);
+	static bool IsVerificationEnabled();
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "Memory/HandlePool.h"
+#include "Camera.h"
+#include "MeshBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+
+// Generational handles to the objects owned by GraphicsResources.
+// Prefer these over raw pointers or GL ids: a destroyed object is detected instead of dangling.
+using ShaderHandle = Memory::Handle<Shader>;
+using TextureHandle = Memory::Handle<Texture>;
+using CameraHandle = Memory::Handle<Camera>;
+using MeshHandle = Memory::Handle<MeshBuffer>;
+
+/*
+* Owner of the engine's graphics objects. Each kind lives in its own dense
+* array, so systems touching all of them (e.g. reloading shaders, updating
+* cameras) iterate contiguous memory.
+*/
+struct GraphicsResources
+{
+	Memory::HandlePool<Shader> shaders;
+	Memory::HandlePool<Texture> textures;
+	Memory::HandlePool<Camera> cameras;
+	Memory::HandlePool<MeshBuffer> meshes;
+};
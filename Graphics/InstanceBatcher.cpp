@@ -0,0 +1,231 @@
+#include "InstanceBatcher.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include <algorithm>
+
+uint InstanceBatcher::AddMesh(const BatchMesh& mesh)
+{
+	m_meshes.push_back(mesh);
+	return static_cast<uint>(m_meshes.size() - 1);
+}
+
+uint InstanceBatcher::AddMaterial(const BatchMaterial& material)
+{
+	m_materials.push_back(material);
+	return static_cast<uint>(m_materials.size() - 1);
+}
+
+void InstanceBatcher::UpdateMeshOrder()
+{
+	m_meshCount = static_cast<uint>(m_meshes.size());
+	m_meshOrder.resize(m_meshCount);
+	for (uint i = 0; i < m_meshCount; i++)
+		m_meshOrder[i] = i;
+	std::stable_sort(m_meshOrder.begin(), m_meshOrder.end(), [this](uint a, uint b)
+	{
+		return m_meshes[a].vertexArray < m_meshes[b].vertexArray;
+	});
+	m_meshRank.resize(m_meshCount);
+	for (uint i = 0; i < m_meshCount; i++)
+		m_meshRank[m_meshOrder[i]] = i;
+}
+
+namespace
+{
+	// Slot of a class key in a power of two table
+	inline size_t HashClass(uint64 key, size_t mask)
+	{
+		return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+	}
+}
+
+void InstanceBatcher::CountRange(RangeClasses& range, const BatchInstance* instances, uint begin, uint end)
+{
+	range.keys.clear();
+	range.counts.clear();
+
+	// Few registered pairs: a plain histogram, clearing it costs no more than the range
+	const uint64 classCount = static_cast<uint64>(m_materials.size()) * m_meshCount;
+	range.isDirect = classCount <= end - begin;
+	if (range.isDirect)
+	{
+		range.direct.assign(static_cast<size_t>(classCount), 0);
+		for (uint i = begin; i < end; i++)
+			range.direct[static_cast<size_t>(GetClass(instances[i]))]++;
+		for (uint64 key = 0; key < classCount; key++)
+		{
+			if (range.direct[static_cast<size_t>(key)] == 0)
+				continue;
+			range.keys.push_back(key);
+			range.counts.push_back(range.direct[static_cast<size_t>(key)]);
+		}
+		return;
+	}
+
+	const size_t INITIAL_TABLE_SIZE = 64;
+	range.table.assign(INITIAL_TABLE_SIZE, ClassSlot{ EMPTY_CLASS, 0 });
+	size_t mask = INITIAL_TABLE_SIZE - 1;
+	for (uint i = begin; i < end; i++)
+	{
+		const uint64 key = GetClass(instances[i]);
+		size_t slot = HashClass(key, mask);
+		while (range.table[slot].key != key && range.table[slot].key != EMPTY_CLASS)
+			slot = (slot + 1) & mask;
+
+		uint local = range.table[slot].local;
+		if (range.table[slot].key == EMPTY_CLASS)
+		{
+			local = static_cast<uint>(range.keys.size());
+			range.keys.push_back(key);
+			range.counts.push_back(0);
+			range.table[slot] = { key, local };
+
+			// Over half full: double the table and reinsert every key
+			if (range.keys.size() * 2 > range.table.size())
+			{
+				mask = range.table.size() * 2 - 1;
+				range.table.assign(mask + 1, ClassSlot{ EMPTY_CLASS, 0 });
+				for (uint existing = 0; existing <= local; existing++)
+				{
+					size_t target = HashClass(range.keys[existing], mask);
+					while (range.table[target].key != EMPTY_CLASS)
+						target = (target + 1) & mask;
+					range.table[target] = { range.keys[existing], existing };
+				}
+			}
+		}
+		range.counts[local]++;
+		m_localClasses[i] = local;
+	}
+}
+
+void InstanceBatcher::Build(const BatchInstance* instances, const Math::Matrix4D* transforms, uint count)
+{
+	static Core::Profiler::Counter& buildCounter = Core::Profiler::GetCounter("Graphics/InstanceBatcher/BuildMicroseconds");
+	static Core::Profiler::Counter& batchesCounter = Core::Profiler::GetCounter("Graphics/InstanceBatcher/Batches");
+	static Core::Profiler::Counter& commandsCounter = Core::Profiler::GetCounter("Graphics/InstanceBatcher/Commands");
+	static Core::Profiler::Counter& instancesCounter = Core::Profiler::GetCounter("Graphics/InstanceBatcher/Instances");
+	Core::ScopedTimer timer(buildCounter);
+
+	if (m_meshCount != m_meshes.size())
+		UpdateMeshOrder();
+
+	m_batches.clear();
+	m_commands.clear();
+	m_instances.resize(count);
+
+	if (count > 0 && m_meshCount > 0 && !m_materials.empty())
+	{
+		// A few ranges per thread balance the load; small ranges would only repeat the same classes
+		const uint MIN_RANGE_SIZE = 4096;
+		const uint threadCount = Core::JobSystem::GetThreadCount();
+		const uint rangeSize = std::max(MIN_RANGE_SIZE, (count + threadCount * 4 - 1) / (threadCount * 4));
+		const uint rangeCount = (count + rangeSize - 1) / rangeSize;
+		if (m_ranges.size() < rangeCount)
+			m_ranges.resize(rangeCount);
+		m_localClasses.resize(count);	// Only written for hashed ranges
+
+		Core::JobSystem::ParallelFor(rangeCount, 1, [this, instances, count, rangeSize](uint begin, uint end)
+		{
+			for (uint range = begin; range < end; range++)
+				CountRange(m_ranges[range], instances, range * rangeSize, std::min(count, (range + 1) * rangeSize));
+		});
+
+		// Only the classes in use are ordered, each range's local classes are then mapped to them
+		m_usedClasses.clear();
+		for (uint range = 0; range < rangeCount; range++)
+			m_usedClasses.insert(m_usedClasses.end(), m_ranges[range].keys.begin(), m_ranges[range].keys.end());
+		std::sort(m_usedClasses.begin(), m_usedClasses.end());
+		m_usedClasses.erase(std::unique(m_usedClasses.begin(), m_usedClasses.end()), m_usedClasses.end());
+		const uint usedCount = static_cast<uint>(m_usedClasses.size());
+
+		m_classSlots.assign(usedCount, 0);
+		for (uint range = 0; range < rangeCount; range++)
+		{
+			RangeClasses& classes = m_ranges[range];
+			classes.slots.resize(classes.keys.size());
+			for (size_t local = 0; local < classes.keys.size(); local++)
+			{
+				// Reuse slots to hold the used class index until the output slots are known
+				const uint used = static_cast<uint>(std::lower_bound(m_usedClasses.begin(), m_usedClasses.end(), classes.keys[local]) - m_usedClasses.begin());
+				classes.slots[local] = used;
+				m_classSlots[used] += classes.counts[local];
+			}
+		}
+
+		// Class by class: turn the counts into first slots and emit the commands
+		uint next = 0;
+		for (uint used = 0; used < usedCount; used++)
+		{
+			const uint first = next;
+			const uint instanceCount = m_classSlots[used];
+			m_classSlots[used] = first;
+			next += instanceCount;
+
+			const uint material = static_cast<uint>(m_usedClasses[used] / m_meshCount);
+			const BatchMesh& mesh = m_meshes[m_meshOrder[m_usedClasses[used] % m_meshCount]];
+			if (m_batches.empty() || m_batches.back().material != material || m_batches.back().vertexArray != mesh.vertexArray)
+				m_batches.push_back({ material, mesh.vertexArray, static_cast<uint>(m_commands.size()), 0, 0 });
+
+			Batch& batch = m_batches.back();
+			batch.commandCount++;
+			batch.instanceCount += instanceCount;
+			m_commands.push_back({ mesh.indexCount, instanceCount, mesh.firstIndex, mesh.baseVertex, first });
+		}
+
+		// Ranges in order, so instances of a class keep their submission order
+		for (uint range = 0; range < rangeCount; range++)
+		{
+			RangeClasses& classes = m_ranges[range];
+			for (size_t local = 0; local < classes.keys.size(); local++)
+			{
+				uint& slot = m_classSlots[classes.slots[local]];
+				classes.slots[local] = slot;
+				if (classes.isDirect)
+					classes.direct[static_cast<size_t>(classes.keys[local])] = slot;
+				slot += classes.counts[local];
+			}
+		}
+
+		Core::JobSystem::ParallelFor(rangeCount, 1, [this, instances, transforms, count, rangeSize](uint begin, uint end)
+		{
+			for (uint range = begin; range < end; range++)
+			{
+				RangeClasses& classes = m_ranges[range];
+				const uint last = std::min(count, (range + 1) * rangeSize);
+				if (classes.isDirect)
+				{
+					for (uint i = range * rangeSize; i < last; i++)
+						m_instances[classes.direct[static_cast<size_t>(GetClass(instances[i]))]++] = InstanceTransform::FromMatrix(transforms[i]);
+				}
+				else
+				{
+					for (uint i = range * rangeSize; i < last; i++)
+						m_instances[classes.slots[m_localClasses[i]]++] = InstanceTransform::FromMatrix(transforms[i]);
+				}
+			}
+		});
+	}
+
+	Core::Profiler::Set(batchesCounter, static_cast<long long>(m_batches.size()));
+	Core::Profiler::Set(commandsCounter, static_cast<long long>(m_commands.size()));
+	Core::Profiler::Set(instancesCounter, count);
+}
+
+void InstanceBatcher::Execute(RenderBackend& backend) const
+{
+	if (m_batches.empty())
+		return;
+
+	backend.SetInstanceData(m_instances.data(), static_cast<uint>(m_instances.size() * sizeof(InstanceTransform)), sizeof(InstanceTransform));
+	for (const Batch& batch : m_batches)
+	{
+		const BatchMaterial& material = m_materials[batch.material];
+		backend.UseProgram(material.program);
+		backend.BindVertexArray(batch.vertexArray);
+		for (uint unit = 0; unit < DrawPacket::MAX_TEXTURES; unit++)
+			if (material.textures[unit] != 0)
+				backend.BindTexture(unit, material.textures[unit]);
+		backend.MultiDrawIndirect(&m_commands[batch.firstCommand], batch.commandCount);
+	}
+}
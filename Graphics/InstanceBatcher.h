@@ -0,0 +1,139 @@
+#pragma once
+#include "RenderBackend.h"
+#include "RenderQueue.h"
+#include "Math/Matrix4D.h"
+#include "Memory/AlignedAllocator.h"
+#include "Misc/Typedefs.h"
+#include <vector>
+
+// A mesh inside a shared vertex pool (see MeshPool): meshes with the same vertex array can share a draw call
+struct BatchMesh
+{
+	uint vertexArray;
+	uint indexCount;
+	uint firstIndex;
+	int baseVertex;
+};
+
+struct BatchMaterial
+{
+	uint program;
+	uint textures[DrawPacket::MAX_TEXTURES];	// 0 leaves the unit as it is
+};
+
+// One object to draw: registered mesh and material ids
+struct BatchInstance
+{
+	uint mesh;
+	uint material;
+};
+
+/*
+* Model matrix as sent to the GPU: the top three rows of the row-major Matrix4D, the last
+* row being always (0, 0, 0, 1). 48 bytes instead of 64. In the vertex shader, as three
+* vec4 attributes on RenderBackend::INSTANCE_BUFFER_BINDING (divisor 1):
+* world = vec3(dot(row0, p), dot(row1, p), dot(row2, p)) with p = vec4(position, 1).
+*/
+struct InstanceTransform
+{
+	float rows[12];
+
+	static inline InstanceTransform FromMatrix(const Math::Matrix4D& matrix)
+	{
+		InstanceTransform transform;
+		std::memcpy(transform.rows, &matrix.r0c0, sizeof(transform.rows));
+		return transform;
+	}
+};
+
+/*
+* Turns many objects into a few draw calls. Objects with the same material and mesh
+* become one indirect command drawing all of them as instances, and the commands of all
+* meshes sharing a material and a vertex pool go out in a single glMultiDrawElementsIndirect.
+* Each object costs a 48-byte transform instead of a uniform upload and a draw call.
+*
+* Build is a parallel counting sort on the job system: every range of instances counts the
+* (material, mesh) pairs it uses (hashed when there are more pairs than instances in the range),
+* the serial part orders only the pairs in use, then every range scatters its transforms
+* straight into place. Its cost does not grow with the number of registered pairs.
+*
+* Usage: AddMesh / AddMaterial once; per frame Build then Execute.
+*/
+class InstanceBatcher
+{
+public:
+	// One multi-draw: shared state and a range of the commands
+	struct Batch
+	{
+		uint material;
+		uint vertexArray;
+		uint firstCommand;
+		uint commandCount;
+		uint instanceCount;
+	};
+
+	uint AddMesh(const BatchMesh& mesh);
+	uint AddMaterial(const BatchMaterial& material);
+
+	/// <summary>
+	/// Groups the instances into batches, on the job system.
+	/// </summary>
+	/// <param name="instances">Valid mesh and material ids.</param>
+	/// <param name="transforms">Model matrix of each instance.</param>
+	void Build(const BatchInstance* instances, const Math::Matrix4D* transforms, uint count);
+
+	// Issues one multi-draw per batch, with the instance data of the whole frame uploaded once
+	void Execute(RenderBackend& backend) const;
+
+	inline const std::vector<Batch>& GetBatches() const { return m_batches; }
+	inline const std::vector<DrawIndirectCommand>& GetCommands() const { return m_commands; }
+	// In command order: command i draws instances baseInstance .. baseInstance + instanceCount - 1
+	inline const Memory::CacheAlignedVector<InstanceTransform>& GetInstances() const { return m_instances; }
+
+private:
+	// Classes a range of instances uses, numbered locally in order of first use
+	struct ClassSlot
+	{
+		uint64 key;		// EMPTY_CLASS for free slots
+		uint local;
+	};
+
+	struct RangeClasses
+	{
+		// Few classes: a histogram indexed by key, then each class's next output slot
+		bool isDirect = false;
+		std::vector<uint> direct;
+		// Otherwise open addressing from key to local class
+		std::vector<ClassSlot> table;
+		// Per local class
+		std::vector<uint64> keys;
+		std::vector<uint> counts;
+		std::vector<uint> slots;		// Next output slot, once Build has placed the classes
+	};
+
+	static constexpr uint64 EMPTY_CLASS = ~uint64(0);
+
+	// Key of a (material, mesh) pair: material major, then meshes grouped by vertex array
+	inline uint64 GetClass(const BatchInstance& instance) const
+	{
+		return static_cast<uint64>(instance.material) * m_meshCount + m_meshRank[instance.mesh];
+	}
+	void UpdateMeshOrder();
+	// Fills the range's classes and the local class of each of its instances
+	void CountRange(RangeClasses& range, const BatchInstance* instances, uint begin, uint end);
+
+	std::vector<BatchMesh> m_meshes;
+	std::vector<BatchMaterial> m_materials;
+	// Mesh ids sorted by vertex array, and the position of each mesh in that order
+	std::vector<uint> m_meshOrder;
+	std::vector<uint> m_meshRank;
+	uint m_meshCount = 0;
+
+	std::vector<RangeClasses> m_ranges;
+	std::vector<uint> m_localClasses;	// Per instance of a hashed range, its class within the range
+	std::vector<uint64> m_usedClasses;	// Sorted, across all ranges
+	std::vector<uint> m_classSlots;		// Per used class, next output slot
+	std::vector<Batch> m_batches;
+	std::vector<DrawIndirectCommand> m_commands;
+	Memory::CacheAlignedVector<InstanceTransform> m_instances;
+};
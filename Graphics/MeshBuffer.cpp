@@ -0,0 +1,105 @@
+#include "MeshBuffer.h"
+#include "GLStateCache.h"
+#include "Assets/MeshContainer.h"
+#include "Middleware/GLEW/include/GL/glew.h"
+#include <iostream>
+
+MeshBuffer::MeshBuffer(const Assets::MeshContainer& container)
+{
+	if (!container.IsOpen())
+	{
+		std::cout << "ERROR::MESH_BUFFER::CONTAINER_NOT_OPEN" << std::endl;
+		return;
+	}
+	if (container.GetSectionDataSize() == 0)
+	{
+		std::cout << "ERROR::MESH_BUFFER::EMPTY_MESH" << std::endl;
+		return;
+	}
+
+	glGenVertexArrays(1, &m_vertexArray);
+	glGenBuffers(1, &m_buffer);
+	GLStateCache::BindVertexArray(m_vertexArray);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	// Straight from the mapping: the only copy is the driver's
+	glBufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(container.GetSectionDataSize()), container.GetSectionData(), 0);
+	// The same buffer holds the indices; the vertex array records the binding
+	GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
+
+	// The buffer starts at the first section
+	auto offsetOf = [&container](Assets::MeshSection section)
+	{
+		return reinterpret_cast<const void*>(static_cast<size_t>(container.GetSection(section).data - container.GetSectionData()));
+	};
+
+	glEnableVertexAttribArray(POSITION_LOCATION);
+	glVertexAttribPointer(POSITION_LOCATION, 3, GL_UNSIGNED_SHORT, GL_FALSE,
+		static_cast<GLsizei>(container.GetSection(Assets::MeshSection::Positions).stride), offsetOf(Assets::MeshSection::Positions));
+	glEnableVertexAttribArray(NORMAL_LOCATION);
+	glVertexAttribPointer(NORMAL_LOCATION, 2, GL_SHORT, GL_TRUE,
+		static_cast<GLsizei>(container.GetSection(Assets::MeshSection::Normals).stride), offsetOf(Assets::MeshSection::Normals));
+	if (container.HasTexcoords())
+	{
+		glEnableVertexAttribArray(TEXCOORD_LOCATION);
+		glVertexAttribPointer(TEXCOORD_LOCATION, 2, GL_HALF_FLOAT, GL_FALSE,
+			static_cast<GLsizei>(container.GetSection(Assets::MeshSection::Texcoords).stride), offsetOf(Assets::MeshSection::Texcoords));
+	}
+	GLStateCache::BindVertexArray(0);
+
+	m_indexCount = container.GetIndexCount();
+	m_indexType = container.GetIndexSize() == sizeof(ushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	m_indexOffset = static_cast<size_t>(container.GetSection(Assets::MeshSection::Indices).data - container.GetSectionData());
+	m_quantization = container.GetPositionQuantization();
+}
+
+MeshBuffer::~MeshBuffer()
+{
+	Release();
+}
+
+MeshBuffer::MeshBuffer(MeshBuffer&& other) noexcept
+	: m_vertexArray(other.m_vertexArray), m_buffer(other.m_buffer), m_indexCount(other.m_indexCount),
+	m_indexType(other.m_indexType), m_indexOffset(other.m_indexOffset), m_quantization(other.m_quantization)
+{
+	other.m_vertexArray = 0;
+	other.m_buffer = 0;
+}
+
+MeshBuffer& MeshBuffer::operator=(MeshBuffer&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		m_vertexArray = other.m_vertexArray;
+		m_buffer = other.m_buffer;
+		m_indexCount = other.m_indexCount;
+		m_indexType = other.m_indexType;
+		m_indexOffset = other.m_indexOffset;
+		m_quantization = other.m_quantization;
+		other.m_vertexArray = 0;
+		other.m_buffer = 0;
+	}
+	return *this;
+}
+
+void MeshBuffer::Draw() const
+{
+	GLStateCache::BindVertexArray(m_vertexArray);
+	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), m_indexType, reinterpret_cast<void*>(m_indexOffset));
+}
+
+void MeshBuffer::Release()
+{
+	if (m_vertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		GLStateCache::OnVertexArrayDeleted(m_vertexArray);
+	}
+	if (m_buffer != 0)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		GLStateCache::OnBufferDeleted(m_buffer);
+	}
+	m_vertexArray = 0;
+	m_buffer = 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Math/Quantization.h"
+#include "Misc/Typedefs.h"
+#include <cstddef>
+
+namespace Assets
+{
+	class MeshContainer;
+}
+
+/*
+* GPU copy of a mesh container: one immutable buffer holding every section, uploaded in a
+* single call straight from the mapped file, and a vertex array describing it.
+*
+* The attributes stay quantized on the GPU; the vertex shader decodes them:
+*
+*   layout(location = 0) in vec3 quantizedPosition;   // 0..65535, not normalized
+*   layout(location = 1) in vec2 octahedralNormal;    // -1..1
+*   layout(location = 2) in vec2 texcoord;            // half floats, read as floats
+*   uniform vec3 positionScale, positionOffset;       // GetPositionQuantization()
+*
+*   vec3 position = quantizedPosition * positionScale + positionOffset;
+*   vec3 normal = vec3(octahedralNormal, 1.0 - abs(octahedralNormal.x) - abs(octahedralNormal.y));
+*   float fold = max(-normal.z, 0.0);
+*   normal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(normal.xy, vec2(0.0)));
+*   normal = normalize(normal);
+*/
+class MeshBuffer
+{
+public:
+	static constexpr uint POSITION_LOCATION = 0;
+	static constexpr uint NORMAL_LOCATION = 1;
+	static constexpr uint TEXCOORD_LOCATION = 2;
+
+	// Uploads the container's sections. The container must be open.
+	explicit MeshBuffer(const Assets::MeshContainer& container);
+	~MeshBuffer();
+
+	MeshBuffer(const MeshBuffer&) = delete;
+	MeshBuffer& operator=(const MeshBuffer&) = delete;
+	MeshBuffer(MeshBuffer&& other) noexcept;
+	MeshBuffer& operator=(MeshBuffer&& other) noexcept;
+
+	// Binds the vertex array and draws every triangle
+	void Draw() const;
+
+	inline uint GetVertexArray() const { return m_vertexArray; }
+	inline uint GetBuffer() const { return m_buffer; }
+	inline uint GetIndexCount() const { return m_indexCount; }
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	inline uint GetIndexType() const { return m_indexType; }
+	inline const Math::PositionQuantization& GetPositionQuantization() const { return m_quantization; }
+
+private:
+	void Release();
+
+	uint m_vertexArray = 0;
+	uint m_buffer = 0;
+	uint m_indexCount = 0;
+	uint m_indexType = 0;
+	size_t m_indexOffset = 0;
+	Math::PositionQuantization m_quantization;
+};
@@ -0,0 +1,137 @@
+#include "MeshPool.h"
+#include "GLStateCache.h"
+#include "Assets/MeshContainer.h"
+#include "Middleware/GLEW/include/GL/glew.h"
+#include <iostream>
+
+namespace
+{
+	const uint POSITION_STRIDE = 4 * sizeof(ushort);
+	const uint NORMAL_STRIDE = 2 * sizeof(short);
+	const uint TEXCOORD_STRIDE = 2 * sizeof(ushort);
+	const uint VERTEX_SIZE = POSITION_STRIDE + NORMAL_STRIDE + TEXCOORD_STRIDE;
+
+	const uint POSITION_BINDING = 0;
+	const uint NORMAL_BINDING = 1;
+	const uint TEXCOORD_BINDING = 2;
+}
+
+MeshPool::MeshPool(uint vertexCapacity, uint indexCapacity)
+	: m_vertexCapacity(vertexCapacity), m_indexCapacity(indexCapacity)
+{
+	const size_t vertexBytes = static_cast<size_t>(vertexCapacity) * VERTEX_SIZE;
+	glGenVertexArrays(1, &m_vertexArray);
+	glGenBuffers(1, &m_buffer);
+	GLStateCache::BindVertexArray(m_vertexArray);
+	GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes + static_cast<size_t>(indexCapacity) * sizeof(uint)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	// The indices follow the vertex regions in the same buffer; firstIndex accounts for them
+	GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
+
+	const GLintptr normalOffset = static_cast<GLintptr>(vertexCapacity) * POSITION_STRIDE;
+	const GLintptr texcoordOffset = normalOffset + static_cast<GLintptr>(vertexCapacity) * NORMAL_STRIDE;
+	glBindVertexBuffer(POSITION_BINDING, m_buffer, 0, POSITION_STRIDE);
+	glBindVertexBuffer(NORMAL_BINDING, m_buffer, normalOffset, NORMAL_STRIDE);
+	glBindVertexBuffer(TEXCOORD_BINDING, m_buffer, texcoordOffset, TEXCOORD_STRIDE);
+
+	glEnableVertexAttribArray(POSITION_LOCATION);
+	glVertexAttribFormat(POSITION_LOCATION, 3, GL_UNSIGNED_SHORT, GL_FALSE, 0);
+	glVertexAttribBinding(POSITION_LOCATION, POSITION_BINDING);
+	glEnableVertexAttribArray(NORMAL_LOCATION);
+	glVertexAttribFormat(NORMAL_LOCATION, 2, GL_SHORT, GL_TRUE, 0);
+	glVertexAttribBinding(NORMAL_LOCATION, NORMAL_BINDING);
+	glEnableVertexAttribArray(TEXCOORD_LOCATION);
+	glVertexAttribFormat(TEXCOORD_LOCATION, 2, GL_HALF_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(TEXCOORD_LOCATION, TEXCOORD_BINDING);
+
+	// The backend attaches the instance buffer to this binding before every multi-draw
+	for (uint row = 0; row < 3; row++)
+	{
+		glEnableVertexAttribArray(INSTANCE_LOCATION + row);
+		glVertexAttribFormat(INSTANCE_LOCATION + row, 4, GL_FLOAT, GL_FALSE, row * 4 * sizeof(float));
+		glVertexAttribBinding(INSTANCE_LOCATION + row, RenderBackend::INSTANCE_BUFFER_BINDING);
+	}
+	glVertexBindingDivisor(RenderBackend::INSTANCE_BUFFER_BINDING, 1);
+	GLStateCache::BindVertexArray(0);
+}
+
+MeshPool::~MeshPool()
+{
+	if (m_vertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		GLStateCache::OnVertexArrayDeleted(m_vertexArray);
+	}
+	if (m_buffer != 0)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		GLStateCache::OnBufferDeleted(m_buffer);
+	}
+}
+
+uint MeshPool::Add(const Assets::MeshContainer& container)
+{
+	if (!container.IsOpen())
+	{
+		std::cout << "ERROR::MESH_POOL::CONTAINER_NOT_OPEN" << std::endl;
+		return INVALID_MESH;
+	}
+	const uint vertexCount = container.GetVertexCount();
+	const uint indexCount = container.GetIndexCount();
+	if (vertexCount > m_vertexCapacity - m_vertexCount || indexCount > m_indexCapacity - m_indexCount)
+	{
+		std::cout << "ERROR::MESH_POOL::FULL" << std::endl;
+		return INVALID_MESH;
+	}
+
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+	const size_t normalRegion = static_cast<size_t>(m_vertexCapacity) * POSITION_STRIDE;
+	const size_t texcoordRegion = normalRegion + static_cast<size_t>(m_vertexCapacity) * NORMAL_STRIDE;
+	const size_t indexRegion = static_cast<size_t>(m_vertexCapacity) * VERTEX_SIZE;
+	auto upload = [](size_t offset, size_t size, const void* data)
+	{
+		glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+	};
+
+	const Assets::MeshSectionView positions = container.GetSection(Assets::MeshSection::Positions);
+	const Assets::MeshSectionView normals = container.GetSection(Assets::MeshSection::Normals);
+	upload(static_cast<size_t>(m_vertexCount) * POSITION_STRIDE, static_cast<size_t>(vertexCount) * POSITION_STRIDE, positions.data);
+	upload(normalRegion + static_cast<size_t>(m_vertexCount) * NORMAL_STRIDE, static_cast<size_t>(vertexCount) * NORMAL_STRIDE, normals.data);
+	if (container.HasTexcoords())
+	{
+		upload(texcoordRegion + static_cast<size_t>(m_vertexCount) * TEXCOORD_STRIDE, static_cast<size_t>(vertexCount) * TEXCOORD_STRIDE,
+			container.GetSection(Assets::MeshSection::Texcoords).data);
+	}
+	else
+	{
+		// A mesh drawn with the others still reads texcoords: keep them defined
+		const std::vector<ushort> zeros(static_cast<size_t>(vertexCount) * 2, 0);
+		upload(texcoordRegion + static_cast<size_t>(m_vertexCount) * TEXCOORD_STRIDE, zeros.size() * sizeof(ushort), zeros.data());
+	}
+
+	// The multi-draw has a single index type; baseVertex offsets the indices, so they are copied as they are
+	const Assets::MeshSectionView indices = container.GetSection(Assets::MeshSection::Indices);
+	const size_t indexOffset = indexRegion + static_cast<size_t>(m_indexCount) * sizeof(uint);
+	if (container.GetIndexSize() == sizeof(uint))
+		upload(indexOffset, static_cast<size_t>(indexCount) * sizeof(uint), indices.data);
+	else
+	{
+		const ushort* shortIndices = reinterpret_cast<const ushort*>(indices.data);
+		const std::vector<uint> wide(shortIndices, shortIndices + indexCount);
+		upload(indexOffset, wide.size() * sizeof(uint), wide.data());
+	}
+
+	Entry entry;
+	entry.batch = { m_vertexArray, indexCount, static_cast<uint>(indexRegion / sizeof(uint)) + m_indexCount, static_cast<int>(m_vertexCount) };
+	entry.quantization = container.GetPositionQuantization();
+	m_meshes.push_back(entry);
+	m_vertexCount += vertexCount;
+	m_indexCount += indexCount;
+	return static_cast<uint>(m_meshes.size() - 1);
+}
+
+Math::Matrix4D MeshPool::GetInstanceMatrix(uint mesh, const Math::Matrix4D& model) const
+{
+	const Math::PositionQuantization& quantization = m_meshes[mesh].quantization;
+	return Math::Matrix4D::Scale(Math::Matrix4D::Translate(model, quantization.offset), quantization.scale);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "InstanceBatcher.h"
+#include "Math/Matrix4D.h"
+#include "Math/Quantization.h"
+#include "Misc/Typedefs.h"
+#include <vector>
+
+namespace Assets
+{
+	class MeshContainer;
+}
+
+/*
+* Shared vertex pool: many mesh containers in one buffer behind one vertex array, so the
+* InstanceBatcher can draw all of them with a single glMultiDrawElementsIndirect per material.
+*
+* Each attribute has its own region sized for the whole pool, so a mesh is addressed by the
+* baseVertex and firstIndex of its BatchMesh alone:
+*
+*   positions  ushort[4] * vertexCapacity   binding 0, location POSITION_LOCATION
+*   normals    short[2]  * vertexCapacity   binding 1, location NORMAL_LOCATION
+*   texcoords  half[2]   * vertexCapacity   binding 2, location TEXCOORD_LOCATION (zeros if none)
+*   indices    uint      * indexCapacity    32-bit, relative to the mesh's first vertex
+*
+* The attributes are those of MeshBuffer, still quantized. The position quantization differs
+* per mesh, so it cannot be a uniform of the multi-draw: it goes into the instance transform
+* instead (GetInstanceMatrix), and the vertex shader uses the quantized position as is:
+*
+*   layout(location = 3) in vec4 instanceRow0;    // INSTANCE_LOCATION .. + 2, see InstanceTransform
+*   layout(location = 4) in vec4 instanceRow1;
+*   layout(location = 5) in vec4 instanceRow2;
+*   vec4 p = vec4(quantizedPosition, 1.0);
+*   vec3 world = vec3(dot(instanceRow0, p), dot(instanceRow1, p), dot(instanceRow2, p));
+*
+* The rows now scale each axis differently, so normals need their inverse transpose.
+*
+* Meshes are only appended; the pool frees them all at once when it is destroyed.
+*/
+class MeshPool
+{
+public:
+	static constexpr uint POSITION_LOCATION = 0;
+	static constexpr uint NORMAL_LOCATION = 1;
+	static constexpr uint TEXCOORD_LOCATION = 2;
+	// First of the three vec4 rows of the instance transform, read from RenderBackend::INSTANCE_BUFFER_BINDING
+	static constexpr uint INSTANCE_LOCATION = 3;
+	static constexpr uint INVALID_MESH = ~0u;
+
+	MeshPool(uint vertexCapacity, uint indexCapacity);
+	~MeshPool();
+
+	MeshPool(const MeshPool&) = delete;
+	MeshPool& operator=(const MeshPool&) = delete;
+
+	/// <summary>
+	/// Copies the container's sections into the pool. 16-bit indices are widened.
+	/// </summary>
+	/// <returns>Id of the mesh, or INVALID_MESH if the container is not open or the pool is full.</returns>
+	uint Add(const Assets::MeshContainer& container);
+
+	// Ready for InstanceBatcher::AddMesh
+	inline const BatchMesh& GetMesh(uint mesh) const { return m_meshes[mesh].batch; }
+	inline const Math::PositionQuantization& GetPositionQuantization(uint mesh) const { return m_meshes[mesh].quantization; }
+
+	// Model matrix followed by the mesh's dequantization, for InstanceBatcher::Build
+	Math::Matrix4D GetInstanceMatrix(uint mesh, const Math::Matrix4D& model) const;
+
+	inline uint GetVertexArray() const { return m_vertexArray; }
+	inline uint GetMeshCount() const { return static_cast<uint>(m_meshes.size()); }
+	inline uint GetVertexCount() const { return m_vertexCount; }
+	inline uint GetIndexCount() const { return m_indexCount; }
+
+private:
+	struct Entry
+	{
+		BatchMesh batch;
+		Math::PositionQuantization quantization;
+	};
+
+	uint m_vertexArray = 0;
+	uint m_buffer = 0;
+	uint m_vertexCapacity;
+	uint m_indexCapacity;
+	uint m_vertexCount = 0;
+	uint m_indexCount = 0;
+	std::vector<Entry> m_meshes;
+};
@@ -0,0 +1,74 @@
+#include "RenderBackend.h"
+#include "GLStateCache.h"
+#include "Middleware/GLEW/include/GL/glew.h"
+
+void GLRenderBackend::UseProgram(uint program)
+{
+	GLStateCache::UseProgram(program);
+}
+
+void GLRenderBackend::BindVertexArray(uint vertexArray)
+{
+	GLStateCache::BindVertexArray(vertexArray);
+}
+
+void GLRenderBackend::BindTexture(uint unit, uint texture)
+{
+	GLStateCache::BindTexture(unit, GL_TEXTURE_2D, texture);
+}
+
+void GLRenderBackend::SetMatrix(int location, const Math::Matrix4D& matrix)
+{
+	// GL_TRUE since Matrix4D is row-major
+	glUniformMatrix4fv(location, 1, GL_TRUE, &matrix.r0c0);
+}
+
+void GLRenderBackend::SetUniformBlock(uint binding, const void* data, uint size)
+{
+	const StreamBuffer::Allocation allocation = GetStream().AllocateUniform(size);
+	if (!allocation.data)
+		return;
+	std::memcpy(allocation.data, data, size);
+	// glBindBufferRange also sets the generic binding: keep the cache in step
+	GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, allocation.buffer);
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, allocation.buffer, allocation.offset, size);
+}
+
+void GLRenderBackend::DrawIndexed(uint indexCount, uint firstIndex, int baseVertex)
+{
+	glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT,
+		reinterpret_cast<void*>(static_cast<size_t>(firstIndex) * sizeof(uint)), baseVertex);
+}
+
+void GLRenderBackend::SetInstanceData(const void* data, uint size, uint stride)
+{
+	m_instanceData = GetStream().Write(data, size, 16);
+	m_instanceStride = stride;
+}
+
+void GLRenderBackend::MultiDrawIndirect(const DrawIndirectCommand* commands, uint count)
+{
+	const StreamBuffer::Allocation allocation = GetStream().Write(commands, count * sizeof(DrawIndirectCommand), 4);
+	if (!allocation.data || !m_instanceData.data)
+		return;
+
+	// Vertex buffer bindings belong to the vertex array, so attach the instances on every draw
+	glBindVertexBuffer(INSTANCE_BUFFER_BINDING, m_instanceData.buffer, m_instanceData.offset, m_instanceStride);
+	GLStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, allocation.buffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(static_cast<size_t>(allocation.offset)),
+		static_cast<GLsizei>(count), 0);
+}
+
+void GLRenderBackend::EndFrame()
+{
+	if (m_stream)
+		m_stream->EndFrame();
+	m_instanceData = {};
+}
+
+StreamBuffer& GLRenderBackend::GetStream()
+{
+	if (!m_stream)
+		m_stream.reset(new StreamBuffer(m_streamDevice, m_streamBytesPerFrame));
+	return *m_stream;
+}
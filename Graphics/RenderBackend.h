@@ -0,0 +1,137 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include "StreamBuffer.h"
+#include "Math/Matrix4D.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Layout of glMultiDrawElementsIndirect commands
+struct DrawIndirectCommand
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+/*
+* The GL calls the render queue issues, behind an interface so the queue (sorting,
+* redundant state filtering) runs and can be checked without a GL context.
+*/
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() = default;
+
+	virtual void UseProgram(uint program) = 0;
+	virtual void BindVertexArray(uint vertexArray) = 0;
+	virtual void BindTexture(uint unit, uint texture) = 0;
+	// Row-major, like every Matrix4D
+	virtual void SetMatrix(int location, const Math::Matrix4D& matrix) = 0;
+	// Makes size bytes of data the contents of the uniform block at the binding point
+	virtual void SetUniformBlock(uint binding, const void* data, uint size) = 0;
+	// Indexed triangles, 32-bit indices
+	virtual void DrawIndexed(uint indexCount, uint firstIndex, int baseVertex) = 0;
+
+	/// <summary>
+	/// Per-instance vertex data for the following indirect draws: vertex buffer binding
+	/// INSTANCE_BUFFER_BINDING of the bound vertex array, advancing once per instance.
+	/// </summary>
+	virtual void SetInstanceData(const void* data, uint size, uint stride) = 0;
+	// One call drawing every command, with the current vertex array and instance data
+	virtual void MultiDrawIndirect(const DrawIndirectCommand* commands, uint count) = 0;
+
+	// Vertex arrays drawn with instance data read it from this vertex buffer binding (glVertexAttribBinding)
+	static constexpr uint INSTANCE_BUFFER_BINDING = 15;
+};
+
+// Forwards to OpenGL. Needs a current context.
+class GLRenderBackend : public RenderBackend
+{
+public:
+	/// <param name="streamBytesPerFrame">Room for one frame's uniform blocks, instance data and indirect commands, see StreamBuffer.</param>
+	explicit GLRenderBackend(uint streamBytesPerFrame = 16 * 1024 * 1024) : m_streamBytesPerFrame(streamBytesPerFrame) {}
+
+	GLRenderBackend(const GLRenderBackend&) = delete;
+	GLRenderBackend& operator=(const GLRenderBackend&) = delete;
+
+	void UseProgram(uint program) override;
+	void BindVertexArray(uint vertexArray) override;
+	void BindTexture(uint unit, uint texture) override;
+	void SetMatrix(int location, const Math::Matrix4D& matrix) override;
+	void SetUniformBlock(uint binding, const void* data, uint size) override;
+	void DrawIndexed(uint indexCount, uint firstIndex, int baseVertex) override;
+	void SetInstanceData(const void* data, uint size, uint stride) override;
+	void MultiDrawIndirect(const DrawIndirectCommand* commands, uint count) override;
+
+	// Call once per frame after its draws: fences the frame's streamed data
+	void EndFrame();
+
+private:
+	StreamBuffer& GetStream();
+
+	GLStreamBufferDevice m_streamDevice;
+	// Created on first use, when a context surely exists
+	std::unique_ptr<StreamBuffer> m_stream;
+	uint m_streamBytesPerFrame;
+	StreamBuffer::Allocation m_instanceData = {};
+	uint m_instanceStride = 0;
+};
+
+/*
+* Records the calls instead of issuing them: for headless tools and for checking
+* what a frame would send to the driver (order, state changes, draws).
+*/
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+	enum class CommandType { UseProgram, BindVertexArray, BindTexture, SetMatrix, SetUniformBlock, DrawIndexed, SetInstanceData, MultiDrawIndirect };
+
+	struct Command
+	{
+		CommandType type;
+		// UseProgram: program; BindVertexArray: vertex array; BindTexture: unit, texture;
+		// SetMatrix: location; SetUniformBlock: binding, size, first 4 bytes of data; DrawIndexed: index count, first index, base vertex;
+		// SetInstanceData: size, stride; MultiDrawIndirect: command count, total instance count
+		uint arguments[3];
+	};
+
+	inline void UseProgram(uint program) override { Record(CommandType::UseProgram, program); }
+	inline void BindVertexArray(uint vertexArray) override { Record(CommandType::BindVertexArray, vertexArray); }
+	inline void BindTexture(uint unit, uint texture) override { Record(CommandType::BindTexture, unit, texture); }
+	inline void SetMatrix(int location, const Math::Matrix4D&) override { Record(CommandType::SetMatrix, static_cast<uint>(location)); }
+	inline void SetUniformBlock(uint binding, const void* data, uint size) override
+	{
+		uint head = 0;
+		std::memcpy(&head, data, size < sizeof(head) ? size : sizeof(head));
+		Record(CommandType::SetUniformBlock, binding, size, head);
+	}
+	inline void DrawIndexed(uint indexCount, uint firstIndex, int baseVertex) override { Record(CommandType::DrawIndexed, indexCount, firstIndex, static_cast<uint>(baseVertex)); }
+
+	inline void SetInstanceData(const void*, uint size, uint stride) override { Record(CommandType::SetInstanceData, size, stride); }
+	inline void MultiDrawIndirect(const DrawIndirectCommand* commands, uint count) override
+	{
+		uint instances = 0;
+		for (uint i = 0; i < count; i++)
+			instances += commands[i].instanceCount;
+		Record(CommandType::MultiDrawIndirect, count, instances);
+	}
+
+	inline const std::vector<Command>& GetCommands() const { return m_commands; }
+	inline void Clear() { m_commands.clear(); }
+
+	inline uint Count(CommandType type) const
+	{
+		uint count = 0;
+		for (const Command& command : m_commands)
+			count += command.type == type ? 1 : 0;
+		return count;
+	}
+
+private:
+	inline void Record(CommandType type, uint a, uint b = 0, uint c = 0) { m_commands.push_back({ type, { a, b, c } }); }
+
+	std::vector<Command> m_commands;
+};
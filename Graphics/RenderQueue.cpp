@@ -0,0 +1,206 @@
+#include "RenderQueue.h"
+#include "Core/Profiler.h"
+#include <utility>
+
+void RenderQueue::Reset()
+{
+	m_packets.clear();
+	m_transforms.clear();
+	m_uniformData.clear();
+	m_order.clear();
+}
+
+uint RenderQueue::AddTransform(const Math::Matrix4D& transform)
+{
+	m_transforms.push_back(transform);
+	return static_cast<uint>(m_transforms.size() - 1);
+}
+
+uint RenderQueue::AddUniformBlock(const void* data, uint size)
+{
+	const size_t offset = m_uniformData.size();
+	m_uniformData.resize(offset + size);
+	std::memcpy(m_uniformData.data() + offset, data, size);
+	return static_cast<uint>(offset);
+}
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	m_order.push_back(static_cast<uint>(m_packets.size()));
+	m_packets.push_back(packet);
+}
+
+void RenderQueue::Reserve(uint packets, uint transforms, uint uniformBytes)
+{
+	m_packets.reserve(packets);
+	m_order.reserve(packets);
+	m_transforms.reserve(transforms);
+	m_uniformData.reserve(uniformBytes);
+}
+
+RenderQueue::AppendBlock RenderQueue::Append(uint packets, uint transforms, uint uniformBytes)
+{
+	const uint firstPacket = static_cast<uint>(m_packets.size());
+	const uint firstTransform = static_cast<uint>(m_transforms.size());
+	const uint firstUniformByte = static_cast<uint>(m_uniformData.size());
+	m_packets.resize(firstPacket + packets);
+	m_transforms.resize(firstTransform + transforms);
+	m_uniformData.resize(firstUniformByte + uniformBytes);
+	m_order.resize(firstPacket + packets);
+	for (uint i = firstPacket; i < firstPacket + packets; ++i)
+		m_order[i] = i;
+
+	AppendBlock block;
+	block.packets = m_packets.data() + firstPacket;
+	block.transforms = m_transforms.data() + firstTransform;
+	block.firstTransform = firstTransform;
+	block.uniformData = m_uniformData.data() + firstUniformByte;
+	block.firstUniformByte = firstUniformByte;
+	return block;
+}
+
+void RenderQueue::Sort()
+{
+	const size_t count = m_packets.size();
+	if (count < 2)
+		return;
+
+	m_sortEntries.resize(count);
+	m_sortScratch.resize(count);
+
+	// Histograms of all eight key bytes in a single read of the keys
+	uint histograms[8][256] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint64 key = m_packets[i].sortKey;
+		m_sortEntries[i] = { key, static_cast<uint>(i) };
+		for (uint byte = 0; byte < 8; ++byte)
+			++histograms[byte][(key >> (byte * 8)) & 0xFF];
+	}
+
+	SortEntry* source = m_sortEntries.data();
+	SortEntry* destination = m_sortScratch.data();
+	for (uint byte = 0; byte < 8; ++byte)
+	{
+		uint* histogram = histograms[byte];
+		const uint shift = byte * 8;
+
+		// Every key has the same value in this byte (e.g. unused pass bits): the pass would not move anything
+		if (histogram[(source[0].key >> shift) & 0xFF] == count)
+			continue;
+
+		uint offset = 0;
+		for (uint bucket = 0; bucket < 256; ++bucket)
+		{
+			const uint bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+		std::swap(source, destination);
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		m_order[i] = source[i].packet;
+}
+
+RenderQueueStats RenderQueue::Execute(RenderBackend& backend) const
+{
+	static Core::Profiler::Counter& drawsCounter = Core::Profiler::GetCounter("Graphics/RenderQueue/Draws");
+	static Core::Profiler::Counter& stateChangesCounter = Core::Profiler::GetCounter("Graphics/RenderQueue/StateChanges");
+	static Core::Profiler::Counter& stateChangesSkippedCounter = Core::Profiler::GetCounter("Graphics/RenderQueue/StateChangesSkipped");
+
+	RenderQueueStats stats;
+
+	// 0 is a valid "nothing bound" state in GL, so start from a value no object has
+	const uint UNKNOWN = 0xFFFFFFFF;
+	uint currentProgram = UNKNOWN;
+	uint currentVertexArray = UNKNOWN;
+	uint currentTextures[DrawPacket::MAX_TEXTURES];
+	for (uint& texture : currentTextures)
+		texture = UNKNOWN;
+	uint currentTransform = DrawPacket::NO_TRANSFORM;
+	int currentLocation = -1;
+	uint currentUniformBlock = DrawPacket::NO_UNIFORM_BLOCK;
+	uint currentUniformBinding = 0;
+
+	for (uint index : m_order)
+	{
+		const DrawPacket& packet = m_packets[index];
+
+		// Uniforms belong to the program, so a program change invalidates the uploaded matrix
+		if (packet.program != currentProgram)
+		{
+			backend.UseProgram(packet.program);
+			currentProgram = packet.program;
+			currentTransform = DrawPacket::NO_TRANSFORM;
+			++stats.programChanges;
+		}
+		else
+			++stats.programChangesSkipped;
+
+		if (packet.vertexArray != currentVertexArray)
+		{
+			backend.BindVertexArray(packet.vertexArray);
+			currentVertexArray = packet.vertexArray;
+			++stats.vertexArrayChanges;
+		}
+		else
+			++stats.vertexArrayChangesSkipped;
+
+		for (uint unit = 0; unit < DrawPacket::MAX_TEXTURES; ++unit)
+		{
+			const uint texture = packet.textures[unit];
+			if (texture == 0)
+				continue;
+			if (texture != currentTextures[unit])
+			{
+				backend.BindTexture(unit, texture);
+				currentTextures[unit] = texture;
+				++stats.textureBinds;
+			}
+			else
+				++stats.textureBindsSkipped;
+		}
+
+		if (packet.modelLocation >= 0 && packet.transform != DrawPacket::NO_TRANSFORM)
+		{
+			if (packet.transform != currentTransform || packet.modelLocation != currentLocation)
+			{
+				backend.SetMatrix(packet.modelLocation, m_transforms[packet.transform]);
+				currentTransform = packet.transform;
+				currentLocation = packet.modelLocation;
+				++stats.matrixUploads;
+			}
+			else
+				++stats.matrixUploadsSkipped;
+		}
+
+		// Blocks are bound to the context, not the program; draws sharing one upload it once
+		if (packet.uniformBlock != DrawPacket::NO_UNIFORM_BLOCK)
+		{
+			if (packet.uniformBlock != currentUniformBlock || packet.uniformBinding != currentUniformBinding)
+			{
+				backend.SetUniformBlock(packet.uniformBinding, &m_uniformData[packet.uniformBlock], packet.uniformBlockSize);
+				currentUniformBlock = packet.uniformBlock;
+				currentUniformBinding = packet.uniformBinding;
+				++stats.uniformBlockUploads;
+			}
+			else
+				++stats.uniformBlockUploadsSkipped;
+		}
+
+		backend.DrawIndexed(packet.indexCount, packet.firstIndex, packet.baseVertex);
+		++stats.draws;
+	}
+
+	Core::Profiler::Set(drawsCounter, stats.draws);
+	Core::Profiler::Set(stateChangesCounter, stats.programChanges + stats.vertexArrayChanges + stats.textureBinds + stats.matrixUploads
+		+ stats.uniformBlockUploads);
+	Core::Profiler::Set(stateChangesSkippedCounter, stats.programChangesSkipped + stats.vertexArrayChangesSkipped
+		+ stats.textureBindsSkipped + stats.matrixUploadsSkipped + stats.uniformBlockUploadsSkipped);
+	return stats;
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include "RenderBackend.h"
+#include "Misc/Typedefs.h"
+#include "Math/Matrix4D.h"
+#include <cstring>
+#include <vector>
+
+/*
+* 64-bit sort keys: draws sorted by key run in the cheapest order.
+*
+* Opaque:      pass:4 | program:10 | material:12 | texture:14 | depth:24 (front to back)
+* Translucent: pass:4 | depth:24 (back to front) | program:10 | material:12 | texture:14
+*
+* The pass (e.g. shadow, opaque, translucent, UI) comes first so passes never interleave.
+* Opaque draws are grouped by the most expensive state first, and depth only breaks ties;
+* translucent draws must blend in order, so depth wins over state. Fields are truncated to
+* their width: ids beyond it only sort less well, the packets still carry the real state.
+*/
+struct RenderSortKey
+{
+	static constexpr uint PASS_BITS = 4;
+	static constexpr uint PROGRAM_BITS = 10;
+	static constexpr uint MATERIAL_BITS = 12;
+	static constexpr uint TEXTURE_BITS = 14;
+	static constexpr uint DEPTH_BITS = 24;
+
+	/// <summary>
+	/// Quantizes a view depth (positive distance from the camera) for the key. Positive floats sort
+	/// like their bit patterns, so the top bits give a logarithmic spread with no depth range to pick.
+	/// </summary>
+	static inline uint QuantizeDepth(float viewDepth)
+	{
+		if (!(viewDepth > 0.0f))
+			return 0;
+		uint bits;
+		std::memcpy(&bits, &viewDepth, sizeof(bits));
+		return bits >> (32 - DEPTH_BITS);
+	}
+
+	static inline uint64 Opaque(uint pass, uint program, uint material, uint texture, float viewDepth)
+	{
+		return Field(pass, PASS_BITS, 60) | Field(program, PROGRAM_BITS, 50) | Field(material, MATERIAL_BITS, 38)
+			| Field(texture, TEXTURE_BITS, 24) | Field(QuantizeDepth(viewDepth), DEPTH_BITS, 0);
+	}
+
+	static inline uint64 Translucent(uint pass, uint program, uint material, uint texture, float viewDepth)
+	{
+		const uint farToNear = ((1u << DEPTH_BITS) - 1) - QuantizeDepth(viewDepth);
+		return Field(pass, PASS_BITS, 60) | Field(farToNear, DEPTH_BITS, 36) | Field(program, PROGRAM_BITS, 26)
+			| Field(material, MATERIAL_BITS, 14) | Field(texture, TEXTURE_BITS, 0);
+	}
+
+private:
+	static inline uint64 Field(uint value, uint bits, uint shift)
+	{
+		return static_cast<uint64>(value & ((1u << bits) - 1)) << shift;
+	}
+};
+
+// One draw: the state it needs and what to draw. GL object ids, 0 meaning none.
+struct DrawPacket
+{
+	static constexpr uint MAX_TEXTURES = 4;
+	static constexpr uint NO_TRANSFORM = 0xFFFFFFFF;
+	static constexpr uint NO_UNIFORM_BLOCK = 0xFFFFFFFF;
+
+	uint64 sortKey = 0;
+	uint program = 0;
+	uint vertexArray = 0;
+	uint textures[MAX_TEXTURES] = {};	// Bound to units 0..MAX_TEXTURES-1; 0 leaves the unit as it is
+	uint indexCount = 0;
+	uint firstIndex = 0;
+	int baseVertex = 0;
+	int modelLocation = -1;				// Uniform location receiving the transform
+	uint transform = NO_TRANSFORM;		// RenderQueue::AddTransform index
+	uint uniformBlock = NO_UNIFORM_BLOCK;	// RenderQueue::AddUniformBlock offset
+	uint uniformBlockSize = 0;
+	uint uniformBinding = 0;			// Binding point of the uniform block
+};
+
+// What Execute sent and what it skipped as redundant
+struct RenderQueueStats
+{
+	uint draws = 0;
+	uint programChanges = 0;
+	uint programChangesSkipped = 0;
+	uint vertexArrayChanges = 0;
+	uint vertexArrayChangesSkipped = 0;
+	uint textureBinds = 0;
+	uint textureBindsSkipped = 0;
+	uint matrixUploads = 0;
+	uint matrixUploadsSkipped = 0;
+	uint uniformBlockUploads = 0;
+	uint uniformBlockUploadsSkipped = 0;
+};
+
+/*
+* Per-frame list of draw packets. Game code submits in any order; Sort orders the
+* packets by key (LSD radix sort, passes over bytes all keys share are skipped) and
+* Execute replays them through a backend, dropping program, vertex array, texture,
+* matrix and uniform block changes that would not change anything.
+*
+* Usage per frame: Reset, AddTransform / AddUniformBlock / Submit (or CommandListSet::MergeInto),
+* Sort, Execute.
+*/
+class RenderQueue
+{
+public:
+	// Drops the previous frame's packets, keeping the memory
+	void Reset();
+
+	// Stores a model matrix for the packets of this frame. Returns the index for DrawPacket::transform.
+	uint AddTransform(const Math::Matrix4D& transform);
+
+	/// <summary>
+	/// Copies per-draw uniform data (a std140 block) into the queue.
+	/// </summary>
+	/// <returns>The offset for DrawPacket::uniformBlock; size goes to uniformBlockSize.</returns>
+	uint AddUniformBlock(const void* data, uint size);
+
+	void Submit(const DrawPacket& packet);
+
+	// Makes room for a frame's worth of data up front
+	void Reserve(uint packets, uint transforms, uint uniformBytes);
+
+	// Storage handed out by Append, see there
+	struct AppendBlock
+	{
+		DrawPacket* packets;
+		Math::Matrix4D* transforms;
+		uint firstTransform;
+		uchar* uniformData;
+		uint firstUniformByte;
+	};
+
+	/// <summary>
+	/// Grows the queue by the given amounts in one go and returns where the new items go,
+	/// so they can be filled in place, from several threads. The packets count as submitted
+	/// after the existing ones; their transform and uniformBlock fields must be offset by
+	/// firstTransform and firstUniformByte. Pointers are valid until the queue grows again.
+	/// </summary>
+	AppendBlock Append(uint packets, uint transforms, uint uniformBytes);
+
+	// Orders the packets by sort key. Stable: equal keys keep their submission order.
+	void Sort();
+
+	/// <summary>
+	/// Issues the packets in sorted order (submission order if Sort was not called). Publishes the
+	/// stats to the profiler under Graphics/RenderQueue. Leaves the queue untouched, so a
+	/// finished queue can be handed to another thread and executed there.
+	/// </summary>
+	/// <returns>What was sent and what was skipped as redundant.</returns>
+	RenderQueueStats Execute(RenderBackend& backend) const;
+
+	inline uint GetPacketCount() const { return static_cast<uint>(m_packets.size()); }
+	inline uint GetTransformCount() const { return static_cast<uint>(m_transforms.size()); }
+	inline uint GetUniformBytes() const { return static_cast<uint>(m_uniformData.size()); }
+	inline const DrawPacket& GetSortedPacket(uint i) const { return m_packets[m_order[i]]; }
+
+private:
+	struct SortEntry
+	{
+		uint64 key;
+		uint packet;
+	};
+
+	std::vector<DrawPacket> m_packets;
+	std::vector<Math::Matrix4D> m_transforms;
+	std::vector<uchar> m_uniformData;
+	std::vector<uint> m_order;
+	std::vector<SortEntry> m_sortEntries;
+	std::vector<SortEntry> m_sortScratch;
+};
@@ -0,0 +1,147 @@
+#include "RenderThread.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include <chrono>
+#include <iostream>
+
+template<typename Condition>
+long long RenderThread::WaitUntil(Condition condition) const
+{
+	if (condition())
+		return 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	const uint SPINS = 64, YIELDS = 256;
+	uint attempt = 0;
+	for (; attempt < SPINS + YIELDS && !condition(); attempt++)
+	{
+		if (attempt >= SPINS)
+			std::this_thread::yield();
+	}
+
+	if (attempt == SPINS + YIELDS)
+	{
+		// Counted before the condition is checked under the lock: either Wake sees the sleeper,
+		// or the condition sees the change Wake announces
+		m_sleepers.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wake.wait(lock, condition);
+		m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RenderThread::Wake() const
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_sleepers.load(std::memory_order_relaxed) == 0)
+		return;
+	// Taking the mutex orders the wake after a sleeper's check of the condition
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+	}
+	m_wake.notify_all();
+}
+
+RenderThread::RenderThread(size_t arenaBytes) : m_packets{ { arenaBytes }, { arenaBytes } }
+{
+}
+
+RenderThread::~RenderThread()
+{
+	Stop();
+}
+
+void RenderThread::Start(Function onStart, RenderFunction render, Function onStop)
+{
+	if (IsRunning())
+	{
+		std::cout << "ERROR::RENDERTHREAD::ALREADY_RUNNING" << std::endl;
+		return;
+	}
+	m_stopping.store(false, std::memory_order_relaxed);
+	m_thread = std::thread(&RenderThread::Run, this, std::move(onStart), std::move(render), std::move(onStop));
+}
+
+void RenderThread::Stop()
+{
+	if (!IsRunning())
+		return;
+	m_stopping.store(true, std::memory_order_release);
+	Wake();
+	m_thread.join();
+}
+
+FramePacket& RenderThread::BeginFrame()
+{
+	static Core::Profiler::Counter& waitCounter = Core::Profiler::GetCounter("Graphics/RenderThread/MainWaitMicroseconds");
+
+	const uint64 frame = m_submitted.load(std::memory_order_relaxed);
+	const uint maxFramesInFlight = m_maxFramesInFlight;
+	// Acquire: the render thread's reads of the packet happen before we overwrite it
+	Core::Profiler::Add(waitCounter, WaitUntil([this, frame, maxFramesInFlight]
+	{
+		return frame - m_rendered.load(std::memory_order_acquire) < maxFramesInFlight;
+	}));
+
+	FramePacket& packet = m_packets[frame % PACKET_COUNT];
+	packet.frameIndex = frame;
+	packet.queue.Reset();
+	packet.arena.Reset();
+	m_building = true;
+	return packet;
+}
+
+void RenderThread::EndFrame()
+{
+	if (!m_building)
+	{
+		std::cout << "ERROR::RENDERTHREAD::END_FRAME_WITHOUT_BEGIN_FRAME" << std::endl;
+		return;
+	}
+	m_building = false;
+	// Release: the packet contents become visible to the render thread with the new count
+	m_submitted.fetch_add(1, std::memory_order_release);
+	Wake();
+}
+
+void RenderThread::SetMaxFramesInFlight(uint frames)
+{
+	m_maxFramesInFlight = frames < 1 ? 1 : (frames > PACKET_COUNT ? PACKET_COUNT : frames);
+}
+
+void RenderThread::WaitIdle() const
+{
+	WaitUntil([this] { return m_rendered.load(std::memory_order_acquire) == m_submitted.load(std::memory_order_relaxed); });
+}
+
+void RenderThread::Run(Function onStart, RenderFunction render, Function onStop)
+{
+	static Core::Profiler::Counter& waitCounter = Core::Profiler::GetCounter("Graphics/RenderThread/RenderWaitMicroseconds");
+	static Core::Profiler::Counter& framesCounter = Core::Profiler::GetCounter("Graphics/RenderThread/Frames");
+
+	Core::JobSystem::RegisterThread();
+	if (onStart)
+		onStart();
+
+	for (;;)
+	{
+		const uint64 frame = m_rendered.load(std::memory_order_relaxed);
+		Core::Profiler::Add(waitCounter, WaitUntil([this, frame]
+		{
+			return m_submitted.load(std::memory_order_acquire) > frame || m_stopping.load(std::memory_order_acquire);
+		}));
+		// Frames submitted before Stop are still drawn
+		if (m_submitted.load(std::memory_order_acquire) == frame)
+			break;
+
+		render(m_packets[frame % PACKET_COUNT]);
+		m_rendered.store(frame + 1, std::memory_order_release);
+		Wake();
+		Core::Profiler::Add(framesCounter, 1);
+	}
+
+	if (onStop)
+		onStop();
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include "RenderQueue.h"
+#include "Math/Matrix4D.h"
+#include "Math/Vector3D.h"
+#include "Memory/LinearArena.h"
+#include "Misc/Typedefs.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/*
+* Everything the render thread needs to draw one frame. Built by the main thread, then
+* handed over and only read until the render thread is done with it: the render side
+* never looks at live game objects.
+*/
+struct FramePacket
+{
+	FramePacket(size_t arenaBytes) : arena(arenaBytes) {}
+
+	uint64 frameIndex = 0;
+	float deltaTime = 0.0f;
+
+	Math::Matrix4D view;
+	Math::Matrix4D projection;
+	Math::Matrix4D viewProjection;
+	Math::Vector3D cameraLocation;
+
+	// The visible draws, with their transforms
+	RenderQueue queue;
+
+	// Any other per-frame data (visible lists, uniform blocks). Reset with the packet.
+	Memory::LinearArena arena;
+
+	template<typename T>
+	inline T* Allocate(size_t count) { return arena.AllocateArray<T>(count); }
+};
+
+/*
+* Runs the GL side of the engine on its own thread, one frame behind the main thread.
+*
+* Two frame packets alternate: while the render thread draws frame N from one, the main
+* thread builds frame N + 1 into the other, so simulation and submission overlap instead
+* of adding up. The handoff is two atomic frame counters, no locks: BeginFrame waits
+* until the packet it reuses has been drawn, the render thread waits for the next
+* packet to be published. Waits spin briefly, yield for a while, then sleep on a condition
+* variable, so a stalled main thread (loading, menus) does not keep a core busy; the side
+* that moves a counter only takes the mutex when the other one is asleep.
+*
+* The GL context must be made current on the render thread (in the start function) and
+* all GL calls, GLStateCache included, must come from there. The render thread registers with
+* the job system (JobSystem::RegisterThread), so jobs it waits on or runs in a ParallelFor get
+* their own per-thread data rather than the main thread's.
+*/
+class RenderThread
+{
+public:
+	using Function = std::function<void()>;
+	using RenderFunction = std::function<void(const FramePacket&)>;
+
+	/// <param name="arenaBytes">Capacity of the arena of each of the two packets.</param>
+	explicit RenderThread(size_t arenaBytes = 1024 * 1024);
+	// Stops the thread if still running
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	/// <summary>
+	/// Starts the render thread.
+	/// </summary>
+	/// <param name="onStart">Runs first on the render thread, e.g. glfwMakeContextCurrent and GL setup. May be empty.</param>
+	/// <param name="render">Draws one packet, including the buffer swap.</param>
+	/// <param name="onStop">Runs last on the render thread, e.g. releasing GL objects. May be empty.</param>
+	void Start(Function onStart, RenderFunction render, Function onStop);
+
+	// Renders the frames already submitted, then joins the thread
+	void Stop();
+
+	/// <summary>
+	/// Main thread: returns the packet to fill for the next frame, reset and with its frame index set.
+	/// Blocks while the render thread is still drawing from it (two frames ago).
+	/// </summary>
+	FramePacket& BeginFrame();
+
+	// Main thread: publishes the packet returned by BeginFrame. It must not be touched afterwards.
+	void EndFrame();
+
+	/// <summary>
+	/// Frame pacing: 2 (default) lets the main thread build a frame while the previous one
+	/// renders; 1 makes BeginFrame wait until every submitted frame is drawn, trading
+	/// throughput for one frame less of input latency.
+	/// </summary>
+	void SetMaxFramesInFlight(uint frames);
+
+	// Main thread: blocks until every submitted frame has been drawn
+	void WaitIdle() const;
+
+	inline uint64 GetSubmittedFrames() const { return m_submitted.load(std::memory_order_acquire); }
+	inline uint64 GetRenderedFrames() const { return m_rendered.load(std::memory_order_acquire); }
+	inline bool IsRunning() const { return m_thread.joinable(); }
+
+private:
+	static constexpr uint PACKET_COUNT = 2;
+
+	void Run(Function onStart, RenderFunction render, Function onStop);
+
+	// Returns the microseconds waited
+	template<typename Condition>
+	long long WaitUntil(Condition condition) const;
+	// Call after changing a counter or m_stopping: wakes the sleeping waits
+	void Wake() const;
+
+	FramePacket m_packets[PACKET_COUNT];
+	std::thread m_thread;
+
+	// Written by the main thread only
+	std::atomic<uint64> m_submitted{ 0 };
+	// Written by the render thread only
+	std::atomic<uint64> m_rendered{ 0 };
+	std::atomic<bool> m_stopping{ false };
+	uint m_maxFramesInFlight = PACKET_COUNT;
+	bool m_building = false;
+
+	// Waits that ran out of spins sleep here
+	mutable std::mutex m_wakeMutex;
+	mutable std::condition_variable m_wake;
+	mutable std::atomic<uint> m_sleepers{ 0 };
+};
@@ -1,7 +1,9 @@
 #include "Shader.h"
+#include "GLStateCache.h"
 #include <fstream>
 #include <iostream>
 #include "Math/Matrix4D.h"
+#include "Memory/ScopedStack.h"
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
 {
@@ -78,14 +80,30 @@ Shader::~Shader()
 	glDeleteProgram(ID);
 }
 
+Shader::Shader(Shader&& other) noexcept : ID(other.ID)
+{
+	other.ID = 0;
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+	if (this != &other)
+	{
+		glDeleteProgram(ID);
+		ID = other.ID;
+		other.ID = 0;
+	}
+	return *this;
+}
+
 void Shader::Use() const
 {
-	glUseProgram(ID);
+	GLStateCache::UseProgram(ID);
 }
 
-void Shader::SetBool(const std::string& name, bool value) const
+void Shader::SetBool(const char* name, bool value) const
 {
-	int location = glGetUniformLocation(ID, name.c_str());
+	int location = glGetUniformLocation(ID, name);
 	if (location == -1)
 	{
 		std::cout << "Error: uniform location not found: "<< name << std::endl;
@@ -94,9 +112,9 @@ void Shader::SetBool(const std::string& name, bool value) const
 	glUniform1i(location, (int)value);
 }
 
-void Shader::SetInt(const std::string& name, int value) const
+void Shader::SetInt(const char* name, int value) const
 {
-	int location = glGetUniformLocation(ID, name.c_str());
+	int location = glGetUniformLocation(ID, name);
 	if (location == -1)
 	{
 		std::cout << "Error: uniform location not found: " << name << std::endl;
@@ -105,9 +123,9 @@ void Shader::SetInt(const std::string& name, int value) const
 	glUniform1i(location, value);
 }
 
-void Shader::SetFloat(const std::string& name, float value) const
+void Shader::SetFloat(const char* name, float value) const
 {
-	int location = glGetUniformLocation(ID, name.c_str());
+	int location = glGetUniformLocation(ID, name);
 	if (location == -1)
 	{
 		std::cout << "Error: uniform location not found: " << name << std::endl;
@@ -116,9 +134,9 @@ void Shader::SetFloat(const std::string& name, float value) const
 	glUniform1f(location, value);
 }
 
-void Shader::SetVec3(const std::string& name, float r, float g, float b) const
+void Shader::SetVec3(const char* name, float r, float g, float b) const
 {
-	int location = glGetUniformLocation(ID, name.c_str());
+	int location = glGetUniformLocation(ID, name);
 	if (location == -1)
 	{
 		std::cout << "Error: uniform location not found: " << name << std::endl;
@@ -127,14 +145,14 @@ void Shader::SetVec3(const std::string& name, float r, float g, float b) const
 	glUniform3f(location, r, g, b);
 }
 
-void Shader::SetVec3(const std::string& name, const Math::Vector3D& vec3) const
+void Shader::SetVec3(const char* name, const Math::Vector3D& vec3) const
 {
 	SetVec3(name, vec3.x, vec3.y, vec3.z);
 }
 
-void Shader::SetVec4(const std::string& name, float r, float g, float b, float a) const
+void Shader::SetVec4(const char* name, float r, float g, float b, float a) const
 {
-	int location = glGetUniformLocation(ID, name.c_str());
+	int location = glGetUniformLocation(ID, name);
 	if (location == -1)
 	{
 		std::cout << "Error: uniform location not found: " << name << std::endl;
@@ -143,14 +161,14 @@ void Shader::SetVec4(const std::string& name, float r, float g, float b, float a
 	glUniform4f(location, r, g, b, a);
 }
 
-void Shader::SetVec4(const std::string& name, const Math::Vector4D& vec4) const
+void Shader::SetVec4(const char* name, const Math::Vector4D& vec4) const
 {
 	SetVec4(name, vec4.x, vec4.y, vec4.z, vec4.w);
 }
 
-void Shader::SetMat4(const std::string& name, const Math::Matrix4D& mat) const
+void Shader::SetMat4(const char* name, const Math::Matrix4D& mat) const
 {
-	int location = glGetUniformLocation(ID, name.c_str());
+	int location = glGetUniformLocation(ID, name);
 	if (location == -1)
 	{
 		std::cout << "Error: uniform location not found: " << name << std::endl;
@@ -168,7 +186,13 @@ bool Shader::CheckStatus(uint program, PFNGLGETSHADERIVPROC getProgramivFunc, ui
 	{
 		int infoLength;
 		getProgramivFunc(program, GL_INFO_LOG_LENGTH, &infoLength);
-		char* buffer = new char[infoLength];
+		Memory::ScopedStack stack;
+		char* buffer = stack.AllocateArray<char>(infoLength);
+		if (buffer == nullptr)
+		{
+			std::cout << " ERROR ON COMPILATION: (info log too long to display)" << std::endl;
+			return false;
+		}
 		int bufferSize;
 
 		infoLogGetterFunc(program, infoLength, &bufferSize, buffer);
@@ -176,7 +200,6 @@ bool Shader::CheckStatus(uint program, PFNGLGETSHADERIVPROC getProgramivFunc, ui
 		// Log error
 		std::cout << " ERROR ON COMPILATION: " << buffer << std::endl;
 
-		delete[] buffer;
 		return false; // Failure
 	}
 	return true; // Success
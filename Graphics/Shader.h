@@ -1,39 +1,48 @@
 #pragma once
 #include <Misc/Typedefs.h>
 #include <Middleware/GLEW/include/GL/glew.h>
+#include <Math/MathFwd.h>
 #include <sstream>
 
 
-namespace Math
-{
-	struct Vector3D;
-	struct Vector4D;
-	struct Matrix4D;
-}
-
-
 class Shader
 {
 public:
 	// The program ID
-	uint ID;
+	uint ID = 0;
 
 	// Constructor reads and builds the shader
 	Shader(const char* vertexPath, const char* fragmentPath);
 	~Shader();
 
+	// The program is owned by a single Shader: it can be moved (e.g. inside a HandlePool) but not copied
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+	Shader(Shader&& other) noexcept;
+	Shader& operator=(Shader&& other) noexcept;
+
 	// Use/activate the shader
 	void Use() const;
 
 	// Utility uniform functions
-	void SetBool(const std::string& name, bool value) const;
-	void SetInt(const std::string& name, int value) const;
-	void SetFloat(const std::string& name, float value) const;
-	void SetVec3(const std::string& name, float r, float g, float b) const;
-	void SetVec3(const std::string& name, const Math::Vector3D& vec3) const;
-	void SetVec4(const std::string& name, float r, float g, float b, float a) const;
-	void SetVec4(const std::string& name, const Math::Vector4D& vec4) const;
-	void SetMat4(const std::string& name, const Math::Matrix4D& mat) const;
+	// (taking const char* so string literals don't build a std::string per call)
+	void SetBool(const char* name, bool value) const;
+	void SetInt(const char* name, int value) const;
+	void SetFloat(const char* name, float value) const;
+	void SetVec3(const char* name, float r, float g, float b) const;
+	void SetVec3(const char* name, const Math::Vector3D& vec3) const;
+	void SetVec4(const char* name, float r, float g, float b, float a) const;
+	void SetVec4(const char* name, const Math::Vector4D& vec4) const;
+	void SetMat4(const char* name, const Math::Matrix4D& mat) const;
+
+	inline void SetBool(const std::string& name, bool value) const { SetBool(name.c_str(), value); }
+	inline void SetInt(const std::string& name, int value) const { SetInt(name.c_str(), value); }
+	inline void SetFloat(const std::string& name, float value) const { SetFloat(name.c_str(), value); }
+	inline void SetVec3(const std::string& name, float r, float g, float b) const { SetVec3(name.c_str(), r, g, b); }
+	inline void SetVec3(const std::string& name, const Math::Vector3D& vec3) const { SetVec3(name.c_str(), vec3); }
+	inline void SetVec4(const std::string& name, float r, float g, float b, float a) const { SetVec4(name.c_str(), r, g, b, a); }
+	inline void SetVec4(const std::string& name, const Math::Vector4D& vec4) const { SetVec4(name.c_str(), vec4); }
+	inline void SetMat4(const std::string& name, const Math::Matrix4D& mat) const { SetMat4(name.c_str(), mat); }
 
 private:
 
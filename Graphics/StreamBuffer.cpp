@@ -0,0 +1,216 @@
+#include "StreamBuffer.h"
+#include "GLStateCache.h"
+#include "Core/Profiler.h"
+#include "Middleware/GLEW/include/GL/glew.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+uint GLStreamBufferDevice::CreateMappedBuffer(size_t size, void** mapped)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	uint buffer = 0;
+	glGenBuffers(1, &buffer);
+	// The copy target is not used for drawing, so binding to it disturbs nothing
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), nullptr, flags);
+	*mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(size), flags);
+	if (!*mapped)
+	{
+		std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED: " << size << " bytes" << std::endl;
+		DestroyMappedBuffer(buffer);
+		return 0;
+	}
+	return buffer;
+}
+
+void GLStreamBufferDevice::DestroyMappedBuffer(uint buffer)
+{
+	GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	glDeleteBuffers(1, &buffer);
+	GLStateCache::OnBufferDeleted(buffer);
+}
+
+StreamBufferDevice::Fence GLStreamBufferDevice::InsertFence()
+{
+	return reinterpret_cast<Fence>(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+bool GLStreamBufferDevice::WaitFence(Fence fence, uint64 timeoutNanoseconds)
+{
+	// Flushing makes sure the fence reaches the GPU, or a wait on it could never return
+	const GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNanoseconds);
+	if (result == GL_WAIT_FAILED)
+	{
+		std::cout << "ERROR::STREAM_BUFFER::FENCE_WAIT_FAILED" << std::endl;
+		return true;
+	}
+	return result != GL_TIMEOUT_EXPIRED;
+}
+
+void GLStreamBufferDevice::DeleteFence(Fence fence)
+{
+	glDeleteSync(reinterpret_cast<GLsync>(fence));
+}
+
+uint GLStreamBufferDevice::GetUniformOffsetAlignment()
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return static_cast<uint>(alignment);
+}
+
+uint GLStreamBufferDevice::GetStorageOffsetAlignment()
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return static_cast<uint>(alignment);
+}
+
+uint SimulatedStreamBufferDevice::CreateMappedBuffer(size_t size, void** mapped)
+{
+	Buffer buffer;
+	buffer.id = m_nextBuffer++;
+	buffer.memory.reset(new uchar[size]);
+	*mapped = buffer.memory.get();
+	m_buffers.push_back(std::move(buffer));
+	return m_buffers.back().id;
+}
+
+void SimulatedStreamBufferDevice::DestroyMappedBuffer(uint buffer)
+{
+	for (size_t i = 0; i < m_buffers.size(); i++)
+	{
+		if (m_buffers[i].id == buffer)
+		{
+			m_buffers.erase(m_buffers.begin() + i);
+			return;
+		}
+	}
+}
+
+StreamBufferDevice::Fence SimulatedStreamBufferDevice::InsertFence()
+{
+	return ++m_lastFence;
+}
+
+bool SimulatedStreamBufferDevice::WaitFence(Fence fence, uint64 timeoutNanoseconds)
+{
+	if (fence <= m_completedFence)
+		return true;
+	if (timeoutNanoseconds == 0)
+		return false;
+	m_completedFence = fence;
+	m_stalls++;
+	return true;
+}
+
+void SimulatedStreamBufferDevice::DeleteFence(Fence)
+{
+}
+
+void SimulatedStreamBufferDevice::CompleteGpuWork(uint fences)
+{
+	m_completedFence = m_completedFence + fences < m_lastFence ? m_completedFence + fences : m_lastFence;
+}
+
+StreamBuffer::StreamBuffer(StreamBufferDevice& device, uint regionSize, uint regionCount) :
+	m_device(device),
+	m_regionSize(regionSize),
+	m_regionCount(regionCount < 1 ? 1 : regionCount),
+	m_uniformAlignment(device.GetUniformOffsetAlignment()),
+	m_storageAlignment(device.GetStorageOffsetAlignment()),
+	m_fences(m_regionCount, 0)
+{
+	// Every region starts on a bindable offset, so frames after the first lose nothing to alignment
+	const uint regionAlignment = m_uniformAlignment > m_storageAlignment ? m_uniformAlignment : m_storageAlignment;
+	if (regionAlignment > 1)
+		m_regionSize = (m_regionSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+	void* mapped = nullptr;
+	m_buffer = m_device.CreateMappedBuffer(static_cast<size_t>(m_regionSize) * m_regionCount, &mapped);
+	m_mapped = static_cast<uchar*>(mapped);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (StreamBufferDevice::Fence fence : m_fences)
+		if (fence != 0)
+			m_device.DeleteFence(fence);
+	if (m_buffer != 0)
+		m_device.DestroyMappedBuffer(m_buffer);
+}
+
+void StreamBuffer::AcquireRegion()
+{
+	static Core::Profiler::Counter& waitsCounter = Core::Profiler::GetCounter("Graphics/StreamBuffer/FenceWaits");
+	static Core::Profiler::Counter& waitTimeCounter = Core::Profiler::GetCounter("Graphics/StreamBuffer/FenceWaitMicroseconds");
+
+	m_regionAcquired = true;
+	StreamBufferDevice::Fence& fence = m_fences[m_region];
+	if (fence == 0)
+		return;
+
+	// Usually signaled long ago: only time the waits that actually block
+	if (!m_device.WaitFence(fence, 0))
+	{
+		const uint64 WAIT_SLICE_NANOSECONDS = 1000000;
+		const auto start = std::chrono::steady_clock::now();
+		while (!m_device.WaitFence(fence, WAIT_SLICE_NANOSECONDS))
+		{
+		}
+		Core::Profiler::Add(waitsCounter, 1);
+		Core::Profiler::Add(waitTimeCounter, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+	m_device.DeleteFence(fence);
+	fence = 0;
+}
+
+StreamBuffer::Allocation StreamBuffer::Allocate(uint size, uint alignment)
+{
+	if (!m_regionAcquired)
+		AcquireRegion();
+
+	// Aligned as an offset into the buffer, which is what binding checks, not into the region
+	const uint regionStart = m_region * m_regionSize;
+	const uint aligned = ((regionStart + m_offset + alignment - 1) & ~(alignment - 1)) - regionStart;
+	if (m_mapped == nullptr || aligned > m_regionSize || size > m_regionSize - aligned)
+	{
+		// Once per frame: an undersized buffer fails every allocation after the first
+		if (!m_overflowReported)
+		{
+			std::cout << "ERROR::STREAM_BUFFER::REGION_FULL: requested " << size << " bytes, "
+				<< m_regionSize - (m_offset < m_regionSize ? m_offset : m_regionSize) << " of " << m_regionSize << " left" << std::endl;
+			m_overflowReported = true;
+		}
+		return { nullptr, m_buffer, 0 };
+	}
+
+	m_offset = aligned + size;
+	const uint offset = regionStart + aligned;
+	return { m_mapped + offset, m_buffer, offset };
+}
+
+StreamBuffer::Allocation StreamBuffer::Write(const void* data, uint size, uint alignment)
+{
+	const Allocation allocation = Allocate(size, alignment);
+	if (allocation.data)
+		std::memcpy(allocation.data, data, size);
+	return allocation;
+}
+
+void StreamBuffer::EndFrame()
+{
+	static Core::Profiler::Counter& usedCounter = Core::Profiler::GetCounter("Graphics/StreamBuffer/PeakFrameBytes");
+
+	Core::Profiler::Max(usedCounter, m_offset);
+	// A frame that allocated nothing leaves its region free, no fence needed
+	if (m_regionAcquired && m_offset > 0)
+		m_fences[m_region] = m_device.InsertFence();
+	m_region = (m_region + 1) % m_regionCount;
+	m_offset = 0;
+	m_regionAcquired = false;
+	m_overflowReported = false;
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+* What StreamBuffer needs from the driver: persistently mapped buffers and fences.
+* Behind an interface so the allocation and fencing logic runs without a GL context.
+*/
+class StreamBufferDevice
+{
+public:
+	using Fence = uint64;
+
+	virtual ~StreamBufferDevice() = default;
+
+	/// <summary>
+	/// Creates a buffer of size bytes, mapped for writing for its whole lifetime.
+	/// </summary>
+	/// <param name="mapped">Receives the CPU address of the buffer.</param>
+	/// <returns>The buffer id, 0 on failure.</returns>
+	virtual uint CreateMappedBuffer(size_t size, void** mapped) = 0;
+	virtual void DestroyMappedBuffer(uint buffer) = 0;
+
+	// Signaled once the GPU has executed every command issued before it
+	virtual Fence InsertFence() = 0;
+	// Waits at most timeoutNanoseconds (0: just polls). True if the fence is signaled.
+	virtual bool WaitFence(Fence fence, uint64 timeoutNanoseconds) = 0;
+	virtual void DeleteFence(Fence fence) = 0;
+
+	// Required alignment of buffer offsets bound as uniform buffers (glBindBufferRange)
+	virtual uint GetUniformOffsetAlignment() = 0;
+	// Required alignment of buffer offsets bound as shader storage buffers
+	virtual uint GetStorageOffsetAlignment() = 0;
+};
+
+/*
+* glBufferStorage with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT, glFenceSync and
+* glClientWaitSync. Needs a current GL 4.4 (or ARB_buffer_storage) context.
+*/
+class GLStreamBufferDevice : public StreamBufferDevice
+{
+public:
+	uint CreateMappedBuffer(size_t size, void** mapped) override;
+	void DestroyMappedBuffer(uint buffer) override;
+	Fence InsertFence() override;
+	bool WaitFence(Fence fence, uint64 timeoutNanoseconds) override;
+	void DeleteFence(Fence fence) override;
+	uint GetUniformOffsetAlignment() override;
+	uint GetStorageOffsetAlignment() override;
+};
+
+/*
+* Stands in for the driver in tools and tests: buffers are plain memory and fences signal
+* when CompleteGpuWork is called, simulating a GPU running behind the CPU. A wait with a
+* timeout on a pending fence completes the GPU work up to that fence, as a real wait would
+* eventually, and counts it as a stall.
+*/
+class SimulatedStreamBufferDevice : public StreamBufferDevice
+{
+public:
+	explicit SimulatedStreamBufferDevice(uint uniformAlignment = 256, uint storageAlignment = 16) :
+		m_uniformAlignment(uniformAlignment), m_storageAlignment(storageAlignment) {}
+
+	uint CreateMappedBuffer(size_t size, void** mapped) override;
+	void DestroyMappedBuffer(uint buffer) override;
+	Fence InsertFence() override;
+	bool WaitFence(Fence fence, uint64 timeoutNanoseconds) override;
+	void DeleteFence(Fence fence) override;
+	inline uint GetUniformOffsetAlignment() override { return m_uniformAlignment; }
+	inline uint GetStorageOffsetAlignment() override { return m_storageAlignment; }
+
+	// Signals the oldest fences: the GPU finished that many submissions
+	void CompleteGpuWork(uint fences = 1);
+
+	inline uint GetPendingFenceCount() const { return static_cast<uint>(m_lastFence - m_completedFence); }
+	// Waits that had to block on the GPU
+	inline uint GetStallCount() const { return m_stalls; }
+	inline uint GetLiveBufferCount() const { return static_cast<uint>(m_buffers.size()); }
+
+private:
+	struct Buffer
+	{
+		uint id;
+		std::unique_ptr<uchar[]> memory;
+	};
+
+	std::vector<Buffer> m_buffers;
+	uint m_nextBuffer = 1;
+	// Fences are numbered from 1 and signal in order
+	Fence m_lastFence = 0;
+	Fence m_completedFence = 0;
+	uint m_stalls = 0;
+	uint m_uniformAlignment;
+	uint m_storageAlignment;
+};
+
+/*
+* Streams per-frame data (vertices, uniform and storage blocks) through one persistently
+* mapped buffer split into regions, one per frame in flight. The CPU writes a frame's data
+* into one region while the GPU reads the previous frames' from the others; a fence per
+* region keeps a region from being overwritten before the GPU is done with it.
+*
+* Allocation is a bump of an offset, aligned as needed: write the data to the returned
+* pointer and bind the buffer at the returned offset. Not thread safe: allocate from the
+* thread issuing the GL calls.
+*/
+class StreamBuffer
+{
+public:
+	// What an allocation is bound with. data is null if the region is full.
+	struct Allocation
+	{
+		void* data;
+		uint buffer;
+		uint offset;
+	};
+
+	/// <summary>
+	/// Creates and maps the buffer.
+	/// </summary>
+	/// <param name="regionSize">Bytes available per frame. Rounded up to the uniform and storage offset alignments.</param>
+	/// <param name="regionCount">Frames in flight; 3 lets the CPU run two frames ahead of the GPU without waiting.</param>
+	StreamBuffer(StreamBufferDevice& device, uint regionSize, uint regionCount = 3);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	/// <summary>
+	/// Sub-allocates size bytes of the current frame's region. The first allocation of a frame
+	/// waits (if needed) until the GPU is done with the region's previous contents.
+	/// </summary>
+	/// <param name="alignment">Power of two.</param>
+	Allocation Allocate(uint size, uint alignment = 16);
+
+	// Allocate with the alignment glBindBufferRange requires for uniform / shader storage buffers
+	inline Allocation AllocateUniform(uint size) { return Allocate(size, m_uniformAlignment); }
+	inline Allocation AllocateStorage(uint size) { return Allocate(size, m_storageAlignment); }
+
+	// Allocates and copies in one go
+	Allocation Write(const void* data, uint size, uint alignment = 16);
+
+	/// <summary>
+	/// Call after the frame's draws using the buffer have been issued: fences the region and
+	/// moves on to the next one.
+	/// </summary>
+	void EndFrame();
+
+	inline uint GetBuffer() const { return m_buffer; }
+	inline uint GetRegionSize() const { return m_regionSize; }
+	inline uint GetRegionCount() const { return m_regionCount; }
+	inline uint GetCurrentRegion() const { return m_region; }
+	// Bytes allocated in the current region so far
+	inline uint GetUsed() const { return m_offset; }
+
+private:
+	void AcquireRegion();
+
+	StreamBufferDevice& m_device;
+	uint m_buffer = 0;
+	uchar* m_mapped = nullptr;
+	uint m_regionSize;
+	uint m_regionCount;
+	uint m_uniformAlignment;
+	uint m_storageAlignment;
+
+	uint m_region = 0;
+	uint m_offset = 0;
+	bool m_regionAcquired = false;
+	bool m_overflowReported = false;
+	// Fence of the last frame written into each region, 0 if none
+	std::vector<StreamBufferDevice::Fence> m_fences;
+};
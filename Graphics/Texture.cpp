@@ -0,0 +1,135 @@
+#include "Texture.h"
+#include "GLStateCache.h"
+#include "Assets/TextureContainer.h"
+#include <Middleware/GLEW/include/GL/glew.h>
+#include <iostream>
+
+Texture::Texture(const char* imagePath, const TextureSettings& settings)
+{
+	// A stale cache (other settings, edited source) is rebuilt
+	uint64 sourceKey = 0;
+	if (settings.cachePath != nullptr)
+	{
+		sourceKey = Assets::TextureImporter::GetSourceKey(imagePath, settings);
+		Assets::TextureContainer container;
+		if (sourceKey != 0 && container.Open(settings.cachePath) && container.GetSourceKey() == sourceKey)
+		{
+			Upload(container);
+			return;
+		}
+	}
+
+	Assets::TextureData data;
+	if (!Assets::TextureImporter::Import(imagePath, settings, data))
+		return;
+
+	if (settings.cachePath != nullptr)
+		Assets::TextureContainer::Write(settings.cachePath, data, sourceKey);
+	Upload(data);
+}
+
+Texture::Texture(const Assets::TextureData& data)
+{
+	Upload(data);
+}
+
+Texture::Texture(const Assets::TextureContainer& container)
+{
+	Upload(container);
+}
+
+Texture::~Texture()
+{
+	glDeleteTextures(1, &ID);
+	GLStateCache::OnTextureDeleted(ID);
+}
+
+Texture::Texture(Texture&& other) noexcept : ID(other.ID)
+{
+	other.ID = 0;
+}
+
+Texture& Texture::operator=(Texture&& other) noexcept
+{
+	if (this != &other)
+	{
+		glDeleteTextures(1, &ID);
+		GLStateCache::OnTextureDeleted(ID);
+		ID = other.ID;
+		other.ID = 0;
+	}
+	return *this;
+}
+
+void Texture::Bind(uint unit) const
+{
+	GLStateCache::BindTexture(unit, GL_TEXTURE_2D, ID);
+}
+
+uint Texture::GetGLInternalFormat(Assets::TextureFormat format, bool sRGB)
+{
+	switch (format)
+	{
+	case Assets::TextureFormat::BC1: return sRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case Assets::TextureFormat::BC3: return sRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case Assets::TextureFormat::BC5: return GL_COMPRESSED_RG_RGTC2; // Two channel data is never sRGB
+	case Assets::TextureFormat::BC7: return sRGB ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default: return sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	}
+}
+
+void Texture::Upload(const Assets::TextureContainer& container)
+{
+	if (!container.IsOpen())
+	{
+		std::cout << "ERROR::TEXTURE::CONTAINER_NOT_OPEN" << std::endl;
+		return;
+	}
+
+	std::vector<Assets::TextureLevelView> levels(container.GetMipCount());
+	for (uint i = 0; i < container.GetMipCount(); i++)
+		levels[i] = container.GetMip(i);
+	Upload(container.GetFormat(), container.IsSRGB(), levels.data(), container.GetMipCount());
+}
+
+void Texture::Upload(const Assets::TextureData& data)
+{
+	std::vector<Assets::TextureLevelView> levels;
+	levels.reserve(data.mips.size());
+	for (const Assets::MipLevel& mip : data.mips)
+		levels.push_back(Assets::MakeLevelView(mip));
+	Upload(data.format, data.sRGB, levels.data(), static_cast<uint>(levels.size()));
+}
+
+void Texture::Upload(Assets::TextureFormat format, bool sRGB, const Assets::TextureLevelView* levels, uint levelCount)
+{
+	if (levelCount == 0)
+	{
+		std::cout << "ERROR::TEXTURE::NO_LEVELS_TO_UPLOAD" << std::endl;
+		return;
+	}
+
+	const uint internalFormat = GetGLInternalFormat(format, sRGB);
+
+	glGenTextures(1, &ID);
+	GLStateCache::BindTexture(0, GL_TEXTURE_2D, ID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(levelCount) - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	for (uint level = 0; level < levelCount; level++)
+	{
+		const Assets::TextureLevelView& mip = levels[level];
+		if (Assets::IsBlockCompressed(format))
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<int>(level), internalFormat, mip.width, mip.height, 0,
+				static_cast<int>(mip.size), mip.data);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, static_cast<int>(level), internalFormat, mip.width, mip.height, 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, mip.data);
+		}
+	}
+}
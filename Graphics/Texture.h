@@ -0,0 +1,48 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include "Assets/TextureData.h"
+#include "Assets/TextureImporter.h"
+
+namespace Assets
+{
+	class TextureContainer;
+}
+
+struct TextureSettings : Assets::TextureImportSettings
+{
+	// When set, the processed texture is mapped from this container (.etex) instead of
+	// running the decode, mip and compression pipeline on every load. Written on first load,
+	// rewritten when the settings or the source (size, modification time) change.
+	const char* cachePath = nullptr;
+};
+
+class Texture
+{
+public:
+	// The texture object ID
+	uint ID = 0;
+
+	// Loads an image through stb_image (or its cached container), builds its mip chain on the CPU and uploads it
+	Texture(const char* imagePath, const TextureSettings& settings = TextureSettings());
+	// Uploads an already processed texture
+	explicit Texture(const Assets::TextureData& data);
+	// Uploads straight from the mapped container memory
+	explicit Texture(const Assets::TextureContainer& container);
+	~Texture();
+
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+	Texture(Texture&& other) noexcept;
+	Texture& operator=(Texture&& other) noexcept;
+
+	// Binds the texture to the given texture unit
+	void Bind(uint unit = 0) const;
+
+	// OpenGL internal format matching the texture format and color space
+	static uint GetGLInternalFormat(Assets::TextureFormat format, bool sRGB);
+
+private:
+	void Upload(Assets::TextureFormat format, bool sRGB, const Assets::TextureLevelView* levels, uint levelCount);
+	void Upload(const Assets::TextureData& data);
+	void Upload(const Assets::TextureContainer& container);
+};
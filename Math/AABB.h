@@ -0,0 +1,167 @@
+#pragma once
+#include "Vector3D.h"
+#include "Matrix4D.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+
+namespace Math
+{
+	/*
+	* Axis aligned bounding box. An empty box has min > max so that merging
+	* anything into it yields that thing.
+	*/
+	struct AABB
+	{
+		Vector3D min = Vector3D(FLT_MAX);
+		Vector3D max = Vector3D(-FLT_MAX);
+
+		AABB() = default;
+		AABB(const Vector3D& min, const Vector3D& max) : min(min), max(max) {}
+
+		inline bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+		inline Vector3D GetCenter() const { return 0.5f * (min + max); }
+		inline Vector3D GetExtents() const { return 0.5f * (max - min); }
+
+		// Half of the surface area, which is all the SAH needs
+		inline float GetHalfArea() const
+		{
+			const Vector3D size = max - min;
+			return size.x * size.y + size.y * size.z + size.z * size.x;
+		}
+
+		inline void Expand(const Vector3D& point)
+		{
+			min = Vector3D(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+			max = Vector3D(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+		}
+
+		inline void Expand(const AABB& box)
+		{
+			min = Vector3D(std::min(min.x, box.min.x), std::min(min.y, box.min.y), std::min(min.z, box.min.z));
+			max = Vector3D(std::max(max.x, box.max.x), std::max(max.y, box.max.y), std::max(max.z, box.max.z));
+		}
+
+		inline static AABB Merge(const AABB& a, const AABB& b)
+		{
+			AABB result = a;
+			result.Expand(b);
+			return result;
+		}
+
+		// Bounds of count boxes, empty if count is 0
+		inline static AABB Merge(const AABB* boxes, size_t count);
+
+		// Bounds of count points, empty if count is 0
+		inline static AABB FromPoints(const Vector3D* points, size_t count);
+
+		/// <summary>
+		/// Bounds of this box after an affine transform (Arvo): the center is transformed and the
+		/// extents go through the absolute upper 3x3, instead of transforming and merging 8 corners.
+		/// Exact, not just conservative, for the transformed box. An empty box stays empty.
+		/// </summary>
+		inline AABB Transformed(const Matrix4D& transform) const;
+
+		inline bool Contains(const Vector3D& point) const
+		{
+			return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z;
+		}
+
+		inline bool Contains(const AABB& box) const
+		{
+			return box.min.x >= min.x && box.max.x <= max.x && box.min.y >= min.y && box.max.y <= max.y && box.min.z >= min.z && box.max.z <= max.z;
+		}
+
+		inline bool Overlaps(const AABB& box) const
+		{
+			return min.x <= box.max.x && max.x >= box.min.x && min.y <= box.max.y && max.y >= box.min.y && min.z <= box.max.z && max.z >= box.min.z;
+		}
+
+		inline Vector3D ClosestPoint(const Vector3D& point) const
+		{
+			return Vector3D(
+				std::min(std::max(point.x, min.x), max.x),
+				std::min(std::max(point.y, min.y), max.y),
+				std::min(std::max(point.z, min.z), max.z));
+		}
+
+		// 0 if the point is inside
+		inline float DistanceSquared(const Vector3D& point) const
+		{
+			const Vector3D delta = ClosestPoint(point) - point;
+			return Vector3D::DotProduct(delta, delta);
+		}
+	};
+
+	AABB AABB::Merge(const AABB* boxes, size_t count)
+	{
+		static_assert(sizeof(AABB) == 6 * sizeof(float), "Merge reads boxes as packed floats");
+		AABB result;
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		// min and max as (x, y, z, x') registers: the fourth lane reads the next float and is discarded
+		__m128 min = _mm_set1_ps(FLT_MAX), max = _mm_set1_ps(-FLT_MAX);
+		for (; i + 1 < count; i++)
+		{
+			min = _mm_min_ps(min, _mm_loadu_ps(&boxes[i].min.x));
+			max = _mm_max_ps(max, _mm_loadu_ps(&boxes[i].max.x));
+		}
+		float minValues[4], maxValues[4];
+		_mm_storeu_ps(minValues, min);
+		_mm_storeu_ps(maxValues, max);
+		result = AABB(Vector3D(minValues[0], minValues[1], minValues[2]), Vector3D(maxValues[0], maxValues[1], maxValues[2]));
+#endif
+		for (; i < count; i++)
+			result.Expand(boxes[i]);
+		return result;
+	}
+
+	AABB AABB::FromPoints(const Vector3D* points, size_t count)
+	{
+		AABB result;
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		// Four points are three registers; lane k of register j holds component (4j + k) % 3,
+		// so the running min / max of each register folds into x, y and z at the end
+		__m128 min0 = _mm_set1_ps(FLT_MAX), min1 = min0, min2 = min0;
+		__m128 max0 = _mm_set1_ps(-FLT_MAX), max1 = max0, max2 = max0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* source = &points[i].x;
+			const __m128 a = _mm_loadu_ps(source), b = _mm_loadu_ps(source + 4), c = _mm_loadu_ps(source + 8);
+			min0 = _mm_min_ps(min0, a); max0 = _mm_max_ps(max0, a);
+			min1 = _mm_min_ps(min1, b); max1 = _mm_max_ps(max1, b);
+			min2 = _mm_min_ps(min2, c); max2 = _mm_max_ps(max2, c);
+		}
+		float mins[12], maxs[12];
+		_mm_storeu_ps(mins, min0); _mm_storeu_ps(mins + 4, min1); _mm_storeu_ps(mins + 8, min2);
+		_mm_storeu_ps(maxs, max0); _mm_storeu_ps(maxs + 4, max1); _mm_storeu_ps(maxs + 8, max2);
+		for (int k = 0; k < 12; k += 3)
+		{
+			result.min = Vector3D(std::min(result.min.x, mins[k]), std::min(result.min.y, mins[k + 1]), std::min(result.min.z, mins[k + 2]));
+			result.max = Vector3D(std::max(result.max.x, maxs[k]), std::max(result.max.y, maxs[k + 1]), std::max(result.max.z, maxs[k + 2]));
+		}
+#endif
+		for (; i < count; i++)
+			result.Expand(points[i]);
+		return result;
+	}
+
+	AABB AABB::Transformed(const Matrix4D& m) const
+	{
+		if (IsEmpty())
+			return AABB();
+		const Vector3D c = GetCenter();
+		const Vector3D e = GetExtents();
+		const Vector3D center(
+			m.r0c0 * c.x + m.r0c1 * c.y + m.r0c2 * c.z + m.r0c3,
+			m.r1c0 * c.x + m.r1c1 * c.y + m.r1c2 * c.z + m.r1c3,
+			m.r2c0 * c.x + m.r2c1 * c.y + m.r2c2 * c.z + m.r2c3);
+		const Vector3D extents(
+			fabsf(m.r0c0) * e.x + fabsf(m.r0c1) * e.y + fabsf(m.r0c2) * e.z,
+			fabsf(m.r1c0) * e.x + fabsf(m.r1c1) * e.y + fabsf(m.r1c2) * e.z,
+			fabsf(m.r2c0) * e.x + fabsf(m.r2c1) * e.y + fabsf(m.r2c2) * e.z);
+		return AABB(center - extents, center + extents);
+	}
+}
@@ -0,0 +1,245 @@
+#pragma once
+#include "Intersection.h"
+#include "Simd.h"
+#include "Memory/AlignedAllocator.h"
+#include "Misc/Typedefs.h"
+#include <cstddef>
+
+namespace Math
+{
+	/*
+	* Bounding volumes stored as one array per component, for testing thousands of them
+	* against one frustum, box or ray. The batch kernels below run 4 volumes per SSE
+	* iteration and write the indices that pass, compacted, without branching per volume.
+	* Output arrays need room for Size() indices.
+	*/
+	struct SphereSoA
+	{
+		Memory::CacheAlignedVector<float> centerX, centerY, centerZ, radius;
+
+		inline size_t Size() const { return radius.size(); }
+		inline void Clear() { centerX.clear(); centerY.clear(); centerZ.clear(); radius.clear(); }
+
+		inline void Add(const Sphere& sphere)
+		{
+			centerX.push_back(sphere.center.x);
+			centerY.push_back(sphere.center.y);
+			centerZ.push_back(sphere.center.z);
+			radius.push_back(sphere.radius);
+		}
+
+		inline Sphere Get(size_t i) const { return Sphere(Vector3D(centerX[i], centerY[i], centerZ[i]), radius[i]); }
+	};
+
+	struct AABBSoA
+	{
+		Memory::CacheAlignedVector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+		inline size_t Size() const { return minX.size(); }
+		inline void Clear() { minX.clear(); minY.clear(); minZ.clear(); maxX.clear(); maxY.clear(); maxZ.clear(); }
+
+		inline void Add(const AABB& box)
+		{
+			minX.push_back(box.min.x); minY.push_back(box.min.y); minZ.push_back(box.min.z);
+			maxX.push_back(box.max.x); maxY.push_back(box.max.y); maxZ.push_back(box.max.z);
+		}
+
+		inline AABB Get(size_t i) const { return AABB(Vector3D(minX[i], minY[i], minZ[i]), Vector3D(maxX[i], maxY[i], maxZ[i])); }
+	};
+
+	namespace BoundsSoAKernels
+	{
+		// Appends first + lane for every set bit of mask
+		inline size_t Compact(int mask, uint first, uint* indices, size_t count)
+		{
+			for (uint lane = 0; lane < 4; lane++)
+			{
+				indices[count] = first + lane;
+				count += (mask >> lane) & 1;
+			}
+			return count;
+		}
+	}
+
+	/// <summary>
+	/// Frustum culling of many spheres.
+	/// </summary>
+	/// <param name="visible">Receives the indices of the spheres intersecting the frustum, in order.</param>
+	/// <returns>The number of visible spheres.</returns>
+	inline size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, uint* visible)
+	{
+		const size_t size = spheres.Size();
+		size_t count = 0, i = 0;
+#if MATH_SIMD_SSE2
+		for (; i + 4 <= size; i += 4)
+		{
+			const __m128 x = _mm_load_ps(&spheres.centerX[i]), y = _mm_load_ps(&spheres.centerY[i]), z = _mm_load_ps(&spheres.centerZ[i]);
+			const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(&spheres.radius[i]));
+			__m128 outside = _mm_setzero_ps();
+			for (const Plane& plane : frustum.planes)
+			{
+				const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.normal.x)), _mm_mul_ps(y, _mm_set1_ps(plane.normal.y))),
+					_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.normal.z)), _mm_set1_ps(plane.distance)));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+			}
+			count = BoundsSoAKernels::Compact(~_mm_movemask_ps(outside) & 0xF, static_cast<uint>(i), visible, count);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			visible[count] = static_cast<uint>(i);
+			count += Intersects(frustum, spheres.Get(i)) ? 1 : 0;
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// Frustum culling of many boxes, conservative like Frustum::Intersects.
+	/// </summary>
+	/// <param name="visible">Receives the indices of the boxes intersecting the frustum, in order.</param>
+	/// <returns>The number of visible boxes.</returns>
+	inline size_t CullAABBs(const Frustum& frustum, const AABBSoA& boxes, uint* visible)
+	{
+		const size_t size = boxes.Size();
+		size_t count = 0, i = 0;
+#if MATH_SIMD_SSE2
+		for (; i + 4 <= size; i += 4)
+		{
+			// Per plane, the box corner furthest along the normal decides: pick min or max per axis by the normal's sign
+			const __m128 minX = _mm_load_ps(&boxes.minX[i]), minY = _mm_load_ps(&boxes.minY[i]), minZ = _mm_load_ps(&boxes.minZ[i]);
+			const __m128 maxX = _mm_load_ps(&boxes.maxX[i]), maxY = _mm_load_ps(&boxes.maxY[i]), maxZ = _mm_load_ps(&boxes.maxZ[i]);
+			__m128 outside = _mm_setzero_ps();
+			for (const Plane& plane : frustum.planes)
+			{
+				const __m128 x = plane.normal.x >= 0.0f ? maxX : minX;
+				const __m128 y = plane.normal.y >= 0.0f ? maxY : minY;
+				const __m128 z = plane.normal.z >= 0.0f ? maxZ : minZ;
+				const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.normal.x)), _mm_mul_ps(y, _mm_set1_ps(plane.normal.y))),
+					_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.normal.z)), _mm_set1_ps(plane.distance)));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+			}
+			count = BoundsSoAKernels::Compact(~_mm_movemask_ps(outside) & 0xF, static_cast<uint>(i), visible, count);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			visible[count] = static_cast<uint>(i);
+			count += frustum.Intersects(boxes.Get(i)) ? 1 : 0;
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// Boxes overlapping a query box (broad phase, area queries).
+	/// </summary>
+	/// <param name="overlapping">Receives the indices of the overlapping boxes, in order.</param>
+	/// <returns>The number of overlapping boxes.</returns>
+	inline size_t OverlapAABBs(const AABB& box, const AABBSoA& boxes, uint* overlapping)
+	{
+		const size_t size = boxes.Size();
+		size_t count = 0, i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 queryMinX = _mm_set1_ps(box.min.x), queryMinY = _mm_set1_ps(box.min.y), queryMinZ = _mm_set1_ps(box.min.z);
+		const __m128 queryMaxX = _mm_set1_ps(box.max.x), queryMaxY = _mm_set1_ps(box.max.y), queryMaxZ = _mm_set1_ps(box.max.z);
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(&boxes.minX[i]), queryMaxX), _mm_cmpge_ps(_mm_load_ps(&boxes.maxX[i]), queryMinX));
+			overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(&boxes.minY[i]), queryMaxY), _mm_cmpge_ps(_mm_load_ps(&boxes.maxY[i]), queryMinY)));
+			overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(&boxes.minZ[i]), queryMaxZ), _mm_cmpge_ps(_mm_load_ps(&boxes.maxZ[i]), queryMinZ)));
+			count = BoundsSoAKernels::Compact(_mm_movemask_ps(overlap), static_cast<uint>(i), overlapping, count);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			overlapping[count] = static_cast<uint>(i);
+			count += box.Overlaps(boxes.Get(i)) ? 1 : 0;
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// Spheres overlapping a query sphere.
+	/// </summary>
+	/// <param name="overlapping">Receives the indices of the overlapping spheres, in order.</param>
+	/// <returns>The number of overlapping spheres.</returns>
+	inline size_t OverlapSpheres(const Sphere& sphere, const SphereSoA& spheres, uint* overlapping)
+	{
+		const size_t size = spheres.Size();
+		size_t count = 0, i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 queryX = _mm_set1_ps(sphere.center.x), queryY = _mm_set1_ps(sphere.center.y), queryZ = _mm_set1_ps(sphere.center.z);
+		const __m128 queryRadius = _mm_set1_ps(sphere.radius);
+		for (; i + 4 <= size; i += 4)
+		{
+			const __m128 dx = _mm_sub_ps(_mm_load_ps(&spheres.centerX[i]), queryX);
+			const __m128 dy = _mm_sub_ps(_mm_load_ps(&spheres.centerY[i]), queryY);
+			const __m128 dz = _mm_sub_ps(_mm_load_ps(&spheres.centerZ[i]), queryZ);
+			const __m128 radius = _mm_add_ps(_mm_load_ps(&spheres.radius[i]), queryRadius);
+			const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			count = BoundsSoAKernels::Compact(_mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_mul_ps(radius, radius))), static_cast<uint>(i), overlapping, count);
+		}
+#endif
+		for (; i < size; i++)
+		{
+			overlapping[count] = static_cast<uint>(i);
+			count += Intersects(sphere, spheres.Get(i)) ? 1 : 0;
+		}
+		return count;
+	}
+
+	/// <summary>
+	/// Closest box hit by a ray.
+	/// </summary>
+	/// <param name="index">Index of the closest box hit.</param>
+	/// <param name="distance">Entry distance of that box (0 if the origin is inside it).</param>
+	/// <returns>True if a box is hit within [0, maxDistance].</returns>
+	inline bool RaycastAABBs(const Ray& ray, const AABBSoA& boxes, float maxDistance, size_t& index, float& distance)
+	{
+		const Vector3D inverseDirection = ray.GetInverseDirection();
+		const size_t size = boxes.Size();
+		bool hit = false;
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 originX = _mm_set1_ps(ray.origin.x), originY = _mm_set1_ps(ray.origin.y), originZ = _mm_set1_ps(ray.origin.z);
+		const __m128 inverseX = _mm_set1_ps(inverseDirection.x), inverseY = _mm_set1_ps(inverseDirection.y), inverseZ = _mm_set1_ps(inverseDirection.z);
+		for (; i + 4 <= size; i += 4)
+		{
+			const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.minX[i]), originX), inverseX);
+			const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.maxX[i]), originX), inverseX);
+			const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.minY[i]), originY), inverseY);
+			const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.maxY[i]), originY), inverseY);
+			const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.minZ[i]), originZ), inverseZ);
+			const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.maxZ[i]), originZ), inverseZ);
+			const __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), _mm_setzero_ps()));
+			// Shrinking maxDistance to the closest hit so far rejects everything behind it
+			const __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_set1_ps(maxDistance)));
+			int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+			if (mask == 0)
+				continue;
+			float distances[4];
+			_mm_storeu_ps(distances, tNear);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (((mask >> lane) & 1) != 0 && distances[lane] <= maxDistance)
+				{
+					maxDistance = distances[lane];
+					index = i + lane;
+					hit = true;
+				}
+			}
+		}
+#endif
+		for (; i < size; i++)
+		{
+			float boxDistance;
+			if (IntersectRayAABB(ray, inverseDirection, boxes.Get(i), maxDistance, boxDistance))
+			{
+				maxDistance = boxDistance;
+				index = i;
+				hit = true;
+			}
+		}
+		distance = maxDistance;
+		return hit;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Plane.h"
+#include "AABB.h"
+#include "Matrix4D.h"
+
+namespace Math
+{
+	/*
+	* Six inward facing planes. Built from a (row-major, column vector) view-projection
+	* matrix with OpenGL clip space, -w <= x, y <= w and -w (or 0) <= z <= w.
+	* A plane at infinity (infinite far projections) never rejects anything.
+	*/
+	struct Frustum
+	{
+		enum PlaneIndex { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+		Plane planes[PLANE_COUNT];
+
+		/// <summary>
+		/// Extracts the planes of a view-projection matrix.
+		/// </summary>
+		/// <param name="clipDepth">Depth range the projection was built for.</param>
+		/// <param name="reversedZ">True if the near plane maps to depth 1 (PerspectiveReversedZ and friends).</param>
+		inline static Frustum FromMatrix(const Matrix4D& viewProjection, ClipDepth clipDepth = ClipDepth::NegativeOneToOne, bool reversedZ = false);
+
+		inline bool Contains(const Vector3D& point) const
+		{
+			for (const Plane& plane : planes)
+			{
+				if (plane.SignedDistance(point) < 0.0f)
+					return false;
+			}
+			return true;
+		}
+
+		// Conservative: may report boxes near the frustum corners as visible
+		inline bool Intersects(const AABB& box) const
+		{
+			const Vector3D center = box.GetCenter();
+			const Vector3D extents = box.GetExtents();
+			for (const Plane& plane : planes)
+			{
+				const float radius = extents.x * fabsf(plane.normal.x) + extents.y * fabsf(plane.normal.y) + extents.z * fabsf(plane.normal.z);
+				if (plane.SignedDistance(center) < -radius)
+					return false;
+			}
+			return true;
+		}
+	};
+
+	Frustum Frustum::FromMatrix(const Matrix4D& m, ClipDepth clipDepth, bool reversedZ)
+	{
+		// Gribb/Hartmann: each plane is the last row plus or minus another row
+		const Vector4D r0(m.r0c0, m.r0c1, m.r0c2, m.r0c3);
+		const Vector4D r1(m.r1c0, m.r1c1, m.r1c2, m.r1c3);
+		const Vector4D r2(m.r2c0, m.r2c1, m.r2c2, m.r2c3);
+		const Vector4D r3(m.r3c0, m.r3c1, m.r3c2, m.r3c3);
+		const auto makePlane = [](const Vector4D& a, const Vector4D& b, float sign)
+		{
+			const Plane plane(Vector3D(a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z), a.w + sign * b.w);
+			// The far plane of an infinite projection degenerates to 0 = w, which is always in front
+			if (plane.normal.Magnitude() < 1e-6f)
+				return Plane(Vector3D(0.0f), 1.0f);
+			return plane.Normalized();
+		};
+
+		Frustum frustum;
+		frustum.planes[LEFT] = makePlane(r3, r0, 1.0f);
+		frustum.planes[RIGHT] = makePlane(r3, r0, -1.0f);
+		frustum.planes[BOTTOM] = makePlane(r3, r1, 1.0f);
+		frustum.planes[TOP] = makePlane(r3, r1, -1.0f);
+
+		// z >= -w (or z >= 0) and z <= w, swapped between near and far by reversed-Z
+		const Plane lowDepth = clipDepth == ClipDepth::ZeroToOne ? makePlane(r2, r3, 0.0f) : makePlane(r3, r2, 1.0f);
+		const Plane highDepth = makePlane(r3, r2, -1.0f);
+		frustum.planes[NEAR_PLANE] = reversedZ ? highDepth : lowDepth;
+		frustum.planes[FAR_PLANE] = reversedZ ? lowDepth : highDepth;
+		return frustum;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <cstring>
+
+namespace Math
+{
+	/*
+	* IEEE 754 binary16, for storage (GL_HALF_FLOAT vertex attributes, textures).
+	* 11 bits of precision and a range of +-65504: enough for normals, UVs and colors,
+	* half the memory and bandwidth of float. Arithmetic is done after converting to float.
+	*/
+	struct Half
+	{
+		ushort bits;
+
+		Half() = default;
+		explicit Half(float value) : bits(FromFloat(value)) {}
+		explicit operator float() const { return ToFloat(bits); }
+
+		// Rounds to nearest even, overflows to infinity and keeps NaNs
+		inline static ushort FromFloat(float value);
+		inline static float ToFloat(ushort bits);
+	};
+
+	ushort Half::FromFloat(float value)
+	{
+		uint f;
+		std::memcpy(&f, &value, sizeof(f));
+		const uint sign = (f >> 16) & 0x8000u;
+		f &= 0x7FFFFFFFu;
+
+		// NaN and infinity
+		if (f >= 0x7F800000u)
+			return static_cast<ushort>(sign | 0x7C00u | (f > 0x7F800000u ? 0x0200u : 0u));
+		// Too large, rounds to infinity
+		if (f >= 0x477FF000u)
+			return static_cast<ushort>(sign | 0x7C00u);
+		// Subnormal half (or zero): shift the mantissa with its implicit bit into place
+		if (f < 0x38800000u)
+		{
+			if (f < 0x33000000u)
+				return static_cast<ushort>(sign);
+			const uint exponent = f >> 23;
+			const uint mantissa = (f & 0x007FFFFFu) | 0x00800000u;
+			const uint shift = 126u - exponent;
+			const uint rounded = (mantissa + (1u << (shift - 1)) - 1u + ((mantissa >> shift) & 1u)) >> shift;
+			return static_cast<ushort>(sign | rounded);
+		}
+		// Normal: rebias the exponent and round the 13 dropped bits
+		const uint rounded = f + 0xC8000FFFu + ((f >> 13) & 1u);
+		return static_cast<ushort>(sign | (rounded >> 13));
+	}
+
+	float Half::ToFloat(ushort bits)
+	{
+		const uint sign = static_cast<uint>(bits & 0x8000u) << 16;
+		uint exponent = (bits >> 10) & 0x1Fu;
+		uint mantissa = bits & 0x03FFu;
+
+		uint f;
+		if (exponent == 0x1Fu)
+			f = sign | 0x7F800000u | (mantissa << 13);
+		else if (exponent != 0)
+			f = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+		else if (mantissa == 0)
+			f = sign;
+		else
+		{
+			// Subnormal half: normalize it
+			exponent = 113;
+			while ((mantissa & 0x0400u) == 0)
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			f = sign | (exponent << 23) | ((mantissa & 0x03FFu) << 13);
+		}
+
+		float value;
+		std::memcpy(&value, &f, sizeof(value));
+		return value;
+	}
+}
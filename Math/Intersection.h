@@ -0,0 +1,243 @@
+#pragma once
+#include "AABB.h"
+#include "Frustum.h"
+#include "OBB.h"
+#include "Plane.h"
+#include "Ray.h"
+#include "Sphere.h"
+
+namespace Math
+{
+	/*
+	* Overlap (Intersects), containment (Contains) and ray tests between every pair of
+	* primitives. Boundaries count as touching. Tests combine per axis / per plane results
+	* with & and | instead of early outs, so they compile to straight line code.
+	* Frustum tests are conservative like Frustum::Intersects.
+	*/
+
+	enum class PlaneSide { Front, Back, Straddling };
+
+	namespace IntersectionKernels
+	{
+		// Projection radius of a box onto a direction
+		inline float ProjectedRadius(const AABB& box, const Vector3D& direction)
+		{
+			const Vector3D extents = box.GetExtents();
+			return extents.x * fabsf(direction.x) + extents.y * fabsf(direction.y) + extents.z * fabsf(direction.z);
+		}
+
+		inline float ProjectedRadius(const OBB& box, const Vector3D& direction)
+		{
+			return box.extents.x * fabsf(Vector3D::DotProduct(direction, box.GetAxis(0)))
+				+ box.extents.y * fabsf(Vector3D::DotProduct(direction, box.GetAxis(1)))
+				+ box.extents.z * fabsf(Vector3D::DotProduct(direction, box.GetAxis(2)));
+		}
+
+		inline PlaneSide Classify(float distance, float radius)
+		{
+			return distance > radius ? PlaneSide::Front : (distance < -radius ? PlaneSide::Back : PlaneSide::Straddling);
+		}
+	}
+
+	// ---- Plane ----
+
+	inline PlaneSide Classify(const Plane& plane, const Vector3D& point) { return IntersectionKernels::Classify(plane.SignedDistance(point), 0.0f); }
+	inline PlaneSide Classify(const Plane& plane, const Sphere& sphere) { return IntersectionKernels::Classify(plane.SignedDistance(sphere.center), sphere.radius); }
+	inline PlaneSide Classify(const Plane& plane, const AABB& box) { return IntersectionKernels::Classify(plane.SignedDistance(box.GetCenter()), IntersectionKernels::ProjectedRadius(box, plane.normal)); }
+	inline PlaneSide Classify(const Plane& plane, const OBB& box) { return IntersectionKernels::Classify(plane.SignedDistance(box.center), IntersectionKernels::ProjectedRadius(box, plane.normal)); }
+
+	template<typename T>
+	inline bool Intersects(const Plane& plane, const T& shape) { return Classify(plane, shape) == PlaneSide::Straddling; }
+
+	// ---- Overlap ----
+
+	inline bool Intersects(const AABB& a, const AABB& b) { return a.Overlaps(b); }
+
+	inline bool Intersects(const Sphere& a, const Sphere& b)
+	{
+		const Vector3D delta = b.center - a.center;
+		const float radius = a.radius + b.radius;
+		return Vector3D::DotProduct(delta, delta) <= radius * radius;
+	}
+
+	inline bool Intersects(const AABB& box, const Sphere& sphere) { return box.DistanceSquared(sphere.center) <= sphere.radius * sphere.radius; }
+	inline bool Intersects(const Sphere& sphere, const AABB& box) { return Intersects(box, sphere); }
+
+	inline bool Intersects(const OBB& box, const Sphere& sphere) { return box.DistanceSquared(sphere.center) <= sphere.radius * sphere.radius; }
+	inline bool Intersects(const Sphere& sphere, const OBB& box) { return Intersects(box, sphere); }
+
+	/// <summary>
+	/// Separating axis test over the 15 candidate axes (3 + 3 face normals, 9 edge cross products).
+	/// </summary>
+	inline bool Intersects(const OBB& a, const OBB& b)
+	{
+		// b's axes in a's frame, and the offset between the centers in a's frame
+		const Matrix3D rotation = a.axes.Transposed() * b.axes;
+		const Vector3D t = a.ToLocal(b.center);
+
+		// Parallel edges give near zero cross products; the epsilon keeps rounding from separating them
+		const float epsilon = 1e-6f;
+		Matrix3D absolute;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+				absolute(i, j) = fabsf(rotation(i, j)) + epsilon;
+		}
+
+		const Vector3D& ea = a.extents;
+		const Vector3D& eb = b.extents;
+		bool separated = false;
+		for (int i = 0; i < 3; i++)
+		{
+			// a's face normals
+			separated |= fabsf(t[i]) > ea[i] + eb.x * absolute(i, 0) + eb.y * absolute(i, 1) + eb.z * absolute(i, 2);
+			// b's face normals
+			separated |= fabsf(t.x * rotation(0, i) + t.y * rotation(1, i) + t.z * rotation(2, i))
+				> ea.x * absolute(0, i) + ea.y * absolute(1, i) + ea.z * absolute(2, i) + eb[i];
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+			for (int j = 0; j < 3; j++)
+			{
+				// a's axis i cross b's axis j
+				const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+				const float radiusA = ea[i1] * absolute(i2, j) + ea[i2] * absolute(i1, j);
+				const float radiusB = eb[j1] * absolute(i, j2) + eb[j2] * absolute(i, j1);
+				separated |= fabsf(t[i2] * rotation(i1, j) - t[i1] * rotation(i2, j)) > radiusA + radiusB;
+			}
+		}
+		return !separated;
+	}
+
+	inline bool Intersects(const AABB& a, const OBB& b) { return Intersects(OBB(a.GetCenter(), Matrix3D::Identity(), a.GetExtents()), b); }
+	inline bool Intersects(const OBB& a, const AABB& b) { return Intersects(b, a); }
+
+	inline bool Intersects(const Frustum& frustum, const Vector3D& point) { return frustum.Contains(point); }
+	inline bool Intersects(const Frustum& frustum, const AABB& box) { return frustum.Intersects(box); }
+
+	inline bool Intersects(const Frustum& frustum, const Sphere& sphere)
+	{
+		bool outside = false;
+		for (const Plane& plane : frustum.planes)
+			outside |= plane.SignedDistance(sphere.center) < -sphere.radius;
+		return !outside;
+	}
+
+	inline bool Intersects(const Frustum& frustum, const OBB& box)
+	{
+		bool outside = false;
+		for (const Plane& plane : frustum.planes)
+			outside |= plane.SignedDistance(box.center) < -IntersectionKernels::ProjectedRadius(box, plane.normal);
+		return !outside;
+	}
+
+	// ---- Containment: inner lies entirely within outer ----
+
+	inline bool Contains(const AABB& outer, const Vector3D& point) { return outer.Contains(point); }
+	inline bool Contains(const AABB& outer, const AABB& inner) { return outer.Contains(inner); }
+	inline bool Contains(const AABB& outer, const Sphere& inner) { return outer.Contains(inner.GetAABB()); }
+	inline bool Contains(const AABB& outer, const OBB& inner) { return outer.Contains(inner.GetAABB()); }
+
+	inline bool Contains(const Sphere& outer, const Vector3D& point) { return outer.Contains(point); }
+
+	inline bool Contains(const Sphere& outer, const Sphere& inner)
+	{
+		const float room = outer.radius - inner.radius;
+		const Vector3D delta = inner.center - outer.center;
+		return (room >= 0.0f) & (Vector3D::DotProduct(delta, delta) <= room * room);
+	}
+
+	// The farthest corner from the center is inside
+	inline bool Contains(const Sphere& outer, const AABB& inner)
+	{
+		const Vector3D delta = inner.GetCenter() - outer.center;
+		const Vector3D farthest = Vector3D(fabsf(delta.x), fabsf(delta.y), fabsf(delta.z)) + inner.GetExtents();
+		return Vector3D::DotProduct(farthest, farthest) <= outer.radius * outer.radius;
+	}
+
+	inline bool Contains(const Sphere& outer, const OBB& inner)
+	{
+		const Vector3D local = inner.ToLocal(outer.center);
+		const Vector3D farthest = Vector3D(fabsf(local.x), fabsf(local.y), fabsf(local.z)) + inner.extents;
+		return Vector3D::DotProduct(farthest, farthest) <= outer.radius * outer.radius;
+	}
+
+	inline bool Contains(const OBB& outer, const Vector3D& point) { return outer.Contains(point); }
+
+	inline bool Contains(const OBB& outer, const Sphere& inner)
+	{
+		const Vector3D local = outer.ToLocal(inner.center);
+		return (fabsf(local.x) + inner.radius <= outer.extents.x) & (fabsf(local.y) + inner.radius <= outer.extents.y) & (fabsf(local.z) + inner.radius <= outer.extents.z);
+	}
+
+	// inner's half widths along outer's axes fit around its center
+	inline bool Contains(const OBB& outer, const OBB& inner)
+	{
+		const Vector3D local = outer.ToLocal(inner.center);
+		bool inside = true;
+		for (int i = 0; i < 3; i++)
+			inside &= fabsf(local[i]) + IntersectionKernels::ProjectedRadius(inner, outer.GetAxis(i)) <= outer.extents[i];
+		return inside;
+	}
+
+	inline bool Contains(const OBB& outer, const AABB& inner) { return Contains(outer, OBB(inner.GetCenter(), Matrix3D::Identity(), inner.GetExtents())); }
+
+	inline bool Contains(const Frustum& frustum, const Vector3D& point) { return frustum.Contains(point); }
+
+	inline bool Contains(const Frustum& frustum, const Sphere& sphere)
+	{
+		bool inside = true;
+		for (const Plane& plane : frustum.planes)
+			inside &= plane.SignedDistance(sphere.center) >= sphere.radius;
+		return inside;
+	}
+
+	inline bool Contains(const Frustum& frustum, const AABB& box)
+	{
+		const Vector3D center = box.GetCenter();
+		bool inside = true;
+		for (const Plane& plane : frustum.planes)
+			inside &= plane.SignedDistance(center) >= IntersectionKernels::ProjectedRadius(box, plane.normal);
+		return inside;
+	}
+
+	inline bool Contains(const Frustum& frustum, const OBB& box)
+	{
+		bool inside = true;
+		for (const Plane& plane : frustum.planes)
+			inside &= plane.SignedDistance(box.center) >= IntersectionKernels::ProjectedRadius(box, plane.normal);
+		return inside;
+	}
+
+	// ---- Rays (IntersectRayAABB is in Ray.h). distance is 0 when the origin is inside. ----
+
+	inline bool IntersectRaySphere(const Ray& ray, const Sphere& sphere, float maxDistance, float& distance)
+	{
+		const Vector3D offset = ray.origin - sphere.center;
+		const float b = Vector3D::DotProduct(offset, ray.direction);
+		const float c = Vector3D::DotProduct(offset, offset) - sphere.radius * sphere.radius;
+		const float discriminant = b * b - c;
+		// Origin outside and pointing away gives b > 0 and a negative far root as well
+		distance = std::max(-b - sqrtf(std::max(discriminant, 0.0f)), 0.0f);
+		return (discriminant >= 0.0f) & ((c <= 0.0f) | (b <= 0.0f)) & (distance <= maxDistance);
+	}
+
+	inline bool IntersectRayOBB(const Ray& ray, const OBB& box, float maxDistance, float& distance)
+	{
+		// Slab test in the box's frame; rotation keeps distances along the ray
+		const Ray local(box.ToLocal(ray.origin), Vector3D(
+			box.axes.r0c0 * ray.direction.x + box.axes.r1c0 * ray.direction.y + box.axes.r2c0 * ray.direction.z,
+			box.axes.r0c1 * ray.direction.x + box.axes.r1c1 * ray.direction.y + box.axes.r2c1 * ray.direction.z,
+			box.axes.r0c2 * ray.direction.x + box.axes.r1c2 * ray.direction.y + box.axes.r2c2 * ray.direction.z));
+		return IntersectRayAABB(local, local.GetInverseDirection(), AABB(-box.extents, box.extents), maxDistance, distance);
+	}
+
+	// Either side of the plane counts
+	inline bool IntersectRayPlane(const Ray& ray, const Plane& plane, float maxDistance, float& distance)
+	{
+		distance = -plane.SignedDistance(ray.origin) / Vector3D::DotProduct(plane.normal, ray.direction);
+		// Parallel rays give an infinite or NaN distance, both rejected
+		return (distance >= 0.0f) & (distance <= maxDistance);
+	}
+}
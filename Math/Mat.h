@@ -0,0 +1,83 @@
+#pragma once
+#include "Vector2D.h"
+#include "Vector3D.h"
+#include "Vector4D.h"
+
+namespace Math
+{
+	/*
+	* Generic R x C matrix, row-major, multiplying column vectors (M * v), like Matrix4D.
+	* Matrix3D and Matrix4D (float) are specialized by hand in their own headers;
+	* this covers the other element types, e.g. Matrix4Double for planet scale transforms.
+	*/
+	template<typename T, int R, int C>
+	struct Mat
+	{
+		using ValueType = T;
+
+		Vec<T, C> rows[R];
+
+		Mat()
+		{
+			for (int row = 0; row < R; row++)
+				rows[row] = Vec<T, C>(T(0));
+		}
+
+		template<typename U>
+		explicit Mat(const Mat<U, R, C>& other)
+		{
+			for (int row = 0; row < R; row++)
+			{
+				for (int column = 0; column < C; column++)
+					(*this)(row, column) = static_cast<T>(other(row, column));
+			}
+		}
+
+		inline static Mat Identity()
+		{
+			static_assert(R == C, "Identity needs a square matrix");
+			Mat result;
+			for (int i = 0; i < R; i++)
+				result(i, i) = T(1);
+			return result;
+		}
+
+		inline T& operator()(int row, int column) { return rows[row][column]; }
+		inline const T& operator()(int row, int column) const { return rows[row][column]; }
+
+		inline Mat<T, C, R> Transposed() const
+		{
+			Mat<T, C, R> result;
+			for (int row = 0; row < R; row++)
+			{
+				for (int column = 0; column < C; column++)
+					result(column, row) = (*this)(row, column);
+			}
+			return result;
+		}
+	};
+
+	template<typename T, int R, int N, int C>
+	inline Mat<T, R, C> operator*(const Mat<T, R, N>& left, const Mat<T, N, C>& right)
+	{
+		// Row i of the result is the rows of right weighted by row i of left
+		Mat<T, R, C> result;
+		for (int row = 0; row < R; row++)
+		{
+			Vec<T, C> sum = right.rows[0] * left(row, 0);
+			for (int k = 1; k < N; k++)
+				sum += right.rows[k] * left(row, k);
+			result.rows[row] = sum;
+		}
+		return result;
+	}
+
+	template<typename T, int R, int C>
+	inline Vec<T, R> operator*(const Mat<T, R, C>& matrix, const Vec<T, C>& vec)
+	{
+		Vec<T, R> result;
+		for (int row = 0; row < R; row++)
+			result[row] = Dot(matrix.rows[row], vec);
+		return result;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+namespace Math
+{
+	/*
+	* Vectors and matrices are one template family: Vec<T, N> and Mat<T, R, C>.
+	* Sizes 2, 3 and 4 are specialized so components keep their names (x, y, z, w),
+	* Matrix3D / Matrix4D are the hand tuned float specializations (row-major,
+	* column vectors). Include this header instead of forward declaring the aliases.
+	*/
+	template<typename T, int N>
+	struct Vec;
+
+	template<typename T, int R, int C>
+	struct Mat;
+
+	struct Half;
+
+	using Vector2D = Vec<float, 2>;
+	using Vector3D = Vec<float, 3>;
+	using Vector4D = Vec<float, 4>;
+
+	using Vector2Double = Vec<double, 2>;
+	using Vector3Double = Vec<double, 3>;
+	using Vector4Double = Vec<double, 4>;
+
+	// Grid cells, texel and tile coordinates
+	using Vector2Int = Vec<int, 2>;
+	using Vector3Int = Vec<int, 3>;
+	using Vector4Int = Vec<int, 4>;
+
+	// Storage only (vertex attributes): convert to float to do math
+	using Vector2Half = Vec<Half, 2>;
+	using Vector3Half = Vec<Half, 3>;
+	using Vector4Half = Vec<Half, 4>;
+
+	using Matrix3D = Mat<float, 3, 3>;
+	using Matrix4D = Mat<float, 4, 4>;
+
+	using Matrix3Double = Mat<double, 3, 3>;
+	using Matrix4Double = Mat<double, 4, 4>;
+}
@@ -1,28 +1,37 @@
 #pragma once
-#include "Vector3D.h"
+#include "Mat.h"
+#include "Matrix4D.h"
+#include "Simd.h"
+#include "Trigonometry.h"
 #include <cmath>
+#include <cstddef>
 
 
 namespace Math
 {
 	/*
+	* ROW-MAJOR, multiplying column vectors like Matrix4D.
+	* Rotations, normal matrices (see NormalMatrix) and inertia tensors.
 	* It is advised to first do scaling operations,
 	then rotations and lastly translations when
 	combining matrices otherwise they may
 	(negatively) affect each other.
 	*/
-	struct Matrix3D
+	template<>
+	struct Mat<float, 3, 3>
 	{
+		using ValueType = float;
+
 		float r0c0, r0c1, r0c2;
 		float r1c0, r1c1, r1c2;
 		float r2c0, r2c1, r2c2;
 
-		Matrix3D() : r0c0(0.0f), r0c1(0.0f), r0c2(0.0f),
+		Mat() : r0c0(0.0f), r0c1(0.0f), r0c2(0.0f),
 			r1c0(0.0f), r1c1(0.0f), r1c2(0.0f),
 			r2c0(0.0f), r2c1(0.0f), r2c2(0.0f) {
 		}
 
-		Matrix3D(float _r0c0, float _r0c1, float _r0c2,
+		Mat(float _r0c0, float _r0c1, float _r0c2,
 			float _r1c0, float _r1c1, float _r1c2,
 			float _r2c0, float _r2c1, float _r2c2)
 			: r0c0(_r0c0), r0c1(_r0c1), r0c2(_r0c2),
@@ -31,7 +40,60 @@ namespace Math
 		{
 		}
 
-		static Matrix3D Identity();
+		// Upper left 3x3 (rotation and scale) of a transform
+		inline explicit Mat(const Matrix4D& matrix)
+			: r0c0(matrix.r0c0), r0c1(matrix.r0c1), r0c2(matrix.r0c2),
+			r1c0(matrix.r1c0), r1c1(matrix.r1c1), r1c2(matrix.r1c2),
+			r2c0(matrix.r2c0), r2c1(matrix.r2c1), r2c2(matrix.r2c2)
+		{
+		}
+
+		inline static Matrix3D Identity();
+
+		// Scale matrix, or the principal inertia tensor of a body in its local frame
+		inline static Matrix3D Diagonal(const Vector3D& diagonal);
+
+		// a * b^T
+		inline static Matrix3D OuterProduct(const Vector3D& a, const Vector3D& b);
+
+		// Skew(a) * b == Cross(a, b)
+		inline static Matrix3D Skew(const Vector3D& a);
+
+		/// <summary>
+		/// Matrix for transforming normals by model: the inverse transpose of its upper 3x3,
+		/// so non-uniform scale keeps normals perpendicular to the surface.
+		/// </summary>
+		inline static Matrix3D NormalMatrix(const Matrix4D& model);
+
+		inline float& operator()(int row, int column) { return (&r0c0)[row * 3 + column]; }
+		inline const float& operator()(int row, int column) const { return (&r0c0)[row * 3 + column]; }
+
+		inline Vector3D GetRow(int row) const { return Vector3D((*this)(row, 0), (*this)(row, 1), (*this)(row, 2)); }
+		inline Vector3D GetColumn(int column) const { return Vector3D((*this)(0, column), (*this)(1, column), (*this)(2, column)); }
+
+		// Embeds this matrix in an affine transform without translation
+		inline Matrix4D ToMatrix4D() const;
+
+		inline Matrix3D Transposed() const;
+		inline float Determinant() const;
+
+		/// <summary>
+		/// General 3x3 inverse (adjugate over determinant). For a pure rotation, Transposed is exact and cheaper.
+		/// </summary>
+		/// <returns>The inverse, or a zero matrix if this matrix is singular.</returns>
+		inline Matrix3D Inverse() const;
+
+		/// <summary>
+		/// Removes the scale and skew accumulated by repeated products (Gram-Schmidt on the
+		/// columns, the basis axes): the result is a proper rotation.
+		/// </summary>
+		inline Matrix3D Orthonormalized() const;
+
+		/// <summary>
+		/// Expresses a tensor given in a body's local frame (e.g. its inertia tensor) in the frame
+		/// rotation maps to: rotation * this * rotation^T.
+		/// </summary>
+		inline Matrix3D RotatedTensor(const Matrix3D& rotation) const;
 
 		/// <summary>
 		/// Creates a 3D rotation matrix representing a rotation around the X-axis by the specified angle.
@@ -65,21 +127,139 @@ namespace Math
 		inline static Matrix3D rotate(float angle);
 
 
-		inline Matrix3D operator*(const Matrix3D& other);
+		inline Matrix3D operator*(const Matrix3D& other) const;
+		inline Matrix3D operator+(const Matrix3D& other) const;
+		inline Matrix3D operator-(const Matrix3D& other) const;
+		inline Matrix3D operator*(float scalar) const;
 	};
 
-	Matrix3D Matrix3D::Identity()
+	inline Matrix3D Matrix3D::Identity()
 	{
 		Matrix3D result =
 		{
 			1.0f,0.0f,0.0f,
 			0.0f,1.0f,0.0f,
-			1.0f,0.0f,0.0f
+			0.0f,0.0f,1.0f
 		};
 		return result;
 	}
 
-	inline Matrix3D Matrix3D::operator*(const Matrix3D& other)
+	inline Matrix3D Matrix3D::Diagonal(const Vector3D& diagonal)
+	{
+		Matrix3D result;
+		result.r0c0 = diagonal.x;
+		result.r1c1 = diagonal.y;
+		result.r2c2 = diagonal.z;
+		return result;
+	}
+
+	inline Matrix3D Matrix3D::OuterProduct(const Vector3D& a, const Vector3D& b)
+	{
+		return Matrix3D(
+			a.x * b.x, a.x * b.y, a.x * b.z,
+			a.y * b.x, a.y * b.y, a.y * b.z,
+			a.z * b.x, a.z * b.y, a.z * b.z);
+	}
+
+	inline Matrix3D Matrix3D::Skew(const Vector3D& a)
+	{
+		return Matrix3D(
+			0.0f, -a.z, a.y,
+			a.z, 0.0f, -a.x,
+			-a.y, a.x, 0.0f);
+	}
+
+	inline Matrix3D Matrix3D::NormalMatrix(const Matrix4D& model)
+	{
+		// inverse(M)^T = cofactor(M) / det(M)
+		const Matrix3D m(model);
+		const Matrix3D cofactors(
+			m.r1c1 * m.r2c2 - m.r1c2 * m.r2c1, m.r1c2 * m.r2c0 - m.r1c0 * m.r2c2, m.r1c0 * m.r2c1 - m.r1c1 * m.r2c0,
+			m.r0c2 * m.r2c1 - m.r0c1 * m.r2c2, m.r0c0 * m.r2c2 - m.r0c2 * m.r2c0, m.r0c1 * m.r2c0 - m.r0c0 * m.r2c1,
+			m.r0c1 * m.r1c2 - m.r0c2 * m.r1c1, m.r0c2 * m.r1c0 - m.r0c0 * m.r1c2, m.r0c0 * m.r1c1 - m.r0c1 * m.r1c0);
+		const float determinant = m.r0c0 * cofactors.r0c0 + m.r0c1 * cofactors.r0c1 + m.r0c2 * cofactors.r0c2;
+		if (determinant == 0.0f)
+			return Matrix3D();
+		return cofactors * (1.0f / determinant);
+	}
+
+	inline Matrix4D Matrix3D::ToMatrix4D() const
+	{
+		return Matrix4D(
+			r0c0, r0c1, r0c2, 0.0f,
+			r1c0, r1c1, r1c2, 0.0f,
+			r2c0, r2c1, r2c2, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline Matrix3D Matrix3D::Transposed() const
+	{
+		return Matrix3D(
+			r0c0, r1c0, r2c0,
+			r0c1, r1c1, r2c1,
+			r0c2, r1c2, r2c2);
+	}
+
+	inline float Matrix3D::Determinant() const
+	{
+		return r0c0 * (r1c1 * r2c2 - r1c2 * r2c1) - r0c1 * (r1c0 * r2c2 - r1c2 * r2c0) + r0c2 * (r1c0 * r2c1 - r1c1 * r2c0);
+	}
+
+	inline Matrix3D Matrix3D::Inverse() const
+	{
+		// The inverse is the transposed cofactor matrix over the determinant
+		const Matrix3D adjugate(
+			r1c1 * r2c2 - r1c2 * r2c1, r0c2 * r2c1 - r0c1 * r2c2, r0c1 * r1c2 - r0c2 * r1c1,
+			r1c2 * r2c0 - r1c0 * r2c2, r0c0 * r2c2 - r0c2 * r2c0, r0c2 * r1c0 - r0c0 * r1c2,
+			r1c0 * r2c1 - r1c1 * r2c0, r0c1 * r2c0 - r0c0 * r2c1, r0c0 * r1c1 - r0c1 * r1c0);
+		const float determinant = r0c0 * adjugate.r0c0 + r0c1 * adjugate.r1c0 + r0c2 * adjugate.r2c0;
+		if (determinant == 0.0f)
+			return Matrix3D();
+		return adjugate * (1.0f / determinant);
+	}
+
+	inline Matrix3D Matrix3D::Orthonormalized() const
+	{
+		const Vector3D x = GetColumn(0).Normalized();
+		const Vector3D y = (GetColumn(1) - x * Vector3D::DotProduct(x, GetColumn(1))).Normalized();
+		// Right handed by construction, whatever the third column drifted to
+		const Vector3D z = Vector3D::CrossProduct(x, y);
+		return Matrix3D(
+			x.x, y.x, z.x,
+			x.y, y.y, z.y,
+			x.z, y.z, z.z);
+	}
+
+	inline Matrix3D Matrix3D::RotatedTensor(const Matrix3D& rotation) const
+	{
+		return rotation * *this * rotation.Transposed();
+	}
+
+	inline Matrix3D Matrix3D::operator+(const Matrix3D& other) const
+	{
+		return Matrix3D(
+			r0c0 + other.r0c0, r0c1 + other.r0c1, r0c2 + other.r0c2,
+			r1c0 + other.r1c0, r1c1 + other.r1c1, r1c2 + other.r1c2,
+			r2c0 + other.r2c0, r2c1 + other.r2c1, r2c2 + other.r2c2);
+	}
+
+	inline Matrix3D Matrix3D::operator-(const Matrix3D& other) const
+	{
+		return Matrix3D(
+			r0c0 - other.r0c0, r0c1 - other.r0c1, r0c2 - other.r0c2,
+			r1c0 - other.r1c0, r1c1 - other.r1c1, r1c2 - other.r1c2,
+			r2c0 - other.r2c0, r2c1 - other.r2c1, r2c2 - other.r2c2);
+	}
+
+	inline Matrix3D Matrix3D::operator*(float scalar) const
+	{
+		return Matrix3D(
+			r0c0 * scalar, r0c1 * scalar, r0c2 * scalar,
+			r1c0 * scalar, r1c1 * scalar, r1c2 * scalar,
+			r2c0 * scalar, r2c1 * scalar, r2c2 * scalar);
+	}
+
+	inline Matrix3D Matrix3D::operator*(const Matrix3D& other) const
 	{
 		Matrix3D result;
 
@@ -111,42 +291,113 @@ namespace Math
 		);
 	}
 
+	/// <summary>
+	/// out[i] = matrix * in[i] for count vectors, e.g. normals by a NormalMatrix.
+	/// in and out may be the same array but must not otherwise overlap.
+	/// </summary>
+	inline void TransformVectors(const Matrix3D& matrix, const Vector3D* in, Vector3D* out, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		// Four vectors are 12 floats, three registers, and the results land in the same three registers:
+		// output register k is sum_j (matrix column j, lanes rotated to match) * (input component j broadcast to match).
+		// Shuffling only the inputs costs 12 shuffles per 4 vectors, against 17 for a round trip through x/y/z lanes.
+		const __m128 x0 = _mm_setr_ps(matrix.r0c0, matrix.r1c0, matrix.r2c0, matrix.r0c0);
+		const __m128 y0 = _mm_setr_ps(matrix.r0c1, matrix.r1c1, matrix.r2c1, matrix.r0c1);
+		const __m128 z0 = _mm_setr_ps(matrix.r0c2, matrix.r1c2, matrix.r2c2, matrix.r0c2);
+		const __m128 x1 = _mm_setr_ps(matrix.r1c0, matrix.r2c0, matrix.r0c0, matrix.r1c0);
+		const __m128 y1 = _mm_setr_ps(matrix.r1c1, matrix.r2c1, matrix.r0c1, matrix.r1c1);
+		const __m128 z1 = _mm_setr_ps(matrix.r1c2, matrix.r2c2, matrix.r0c2, matrix.r1c2);
+		const __m128 x2 = _mm_setr_ps(matrix.r2c0, matrix.r0c0, matrix.r1c0, matrix.r2c0);
+		const __m128 y2 = _mm_setr_ps(matrix.r2c1, matrix.r0c1, matrix.r1c1, matrix.r2c1);
+		const __m128 z2 = _mm_setr_ps(matrix.r2c2, matrix.r0c2, matrix.r1c2, matrix.r2c2);
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* source = &in[i].x;
+			const __m128 a = _mm_loadu_ps(source);		// x0 y0 z0 x1
+			const __m128 b = _mm_loadu_ps(source + 4);	// y1 z1 x2 y2
+			const __m128 c = _mm_loadu_ps(source + 8);	// z2 x3 y3 z3
+
+			const __m128 ay = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+			const __m128 az = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+			const __m128 resultA = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(x0, _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 0, 0))),
+				_mm_mul_ps(y0, _mm_shuffle_ps(ay, ay, _MM_SHUFFLE(2, 0, 0, 0)))),
+				_mm_mul_ps(z0, _mm_shuffle_ps(az, az, _MM_SHUFFLE(2, 0, 0, 0))));
+
+			const __m128 resultB = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(x1, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 2, 3, 3))),
+				_mm_mul_ps(y1, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 0, 0)))),
+				_mm_mul_ps(z1, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 0, 1, 1))));
+
+			const __m128 cx = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+			const __m128 cy = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+			const __m128 resultC = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(x2, _mm_shuffle_ps(cx, cx, _MM_SHUFFLE(2, 2, 2, 0))),
+				_mm_mul_ps(y2, _mm_shuffle_ps(cy, cy, _MM_SHUFFLE(2, 2, 2, 0)))),
+				_mm_mul_ps(z2, _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 0))));
+
+			float* destination = &out[i].x;
+			_mm_storeu_ps(destination, resultA);
+			_mm_storeu_ps(destination + 4, resultB);
+			_mm_storeu_ps(destination + 8, resultC);
+		}
+#endif
+		for (; i < count; i++)
+			out[i] = matrix * in[i];
+	}
+
 	inline Matrix3D Matrix3D::rotateX(float angle)
 	{
+		float s, c;
+		SinCos(angle, s, c);
 		Matrix3D result =
 		{
-			1.0f,	0.0f,		0.0f,
-			0.0f,	cos(angle),	-sin(angle),
-			0.0f,	sin(angle),	cos(angle)
+			1.0f,	0.0f,	0.0f,
+			0.0f,	c,		-s,
+			0.0f,	s,		c
 		};
 		return result;
 	}
 
 	inline Matrix3D Matrix3D::rotateY(float angle)
 	{
+		float s, c;
+		SinCos(angle, s, c);
 		Matrix3D result =
 		{
-			cos(angle),	 0.0f,	sin(angle),
-			0.0f,		 1.0f,	0.0f,
-			-sin(angle), 0.0f,	cos(angle)
+			c,		0.0f,	s,
+			0.0f,	1.0f,	0.0f,
+			-s,		0.0f,	c
 		};
 		return result;
 	}
 
 	inline Matrix3D Matrix3D::rotateZ(float angle)
 	{
+		float s, c;
+		SinCos(angle, s, c);
 		Matrix3D result =
 		{
-			cos(angle),	-sin(angle),	0.0f,
-			sin(angle), cos(angle),		0.0f,
-			0.0f,		0.0f,			1.0f
+			c,		-s,		0.0f,
+			s,		c,		0.0f,
+			0.0f,	0.0f,	1.0f
 		};
 		return result;
 	}
 
 	inline Matrix3D Matrix3D::rotate(float angle)
 	{
-		Matrix3D result = rotateX(angle) * rotateY(angle) * rotateZ(angle);
+		// rotateX(angle) * rotateY(angle) * rotateZ(angle) expanded: one SinCos, no products
+		float s, c;
+		SinCos(angle, s, c);
+		const float cs = c * s;
+		Matrix3D result =
+		{
+			c * c,				-cs,			s,
+			s * s * c + cs,		c * c - s * s * s,	-cs,
+			s * s - c * cs,		s * cs + cs,		c * c
+		};
 		return result;
 	}
 
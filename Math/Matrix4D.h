@@ -1,11 +1,20 @@
 #pragma once
-#include "Vector4D.h"
-#include "Vector3D.h"
+#include "Mat.h"
+#include "Simd.h"
+#include "Trigonometry.h"
 
 namespace Math
 {
 	constexpr float DEG2RAD = 3.14159265f / 180.0f;
 
+	/*
+	* Depth range of normalized device coordinates after the perspective divide.
+	* ZeroToOne matches glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE) (GL 4.5 / ARB_clip_control)
+	* and is the one that gives reversed-Z its precision: with [-1, 1] the remap to
+	* window depth adds 0.5 and throws away the low exponents near zero.
+	*/
+	enum class ClipDepth { NegativeOneToOne, ZeroToOne };
+
 	/*
 	* ROW-MAJOR
 	* It is advised to first do scaling operations,
@@ -13,22 +22,32 @@ namespace Math
 	combining matrices otherwise they may
 	(negatively) affect each other.
 	*/
-	struct Matrix4D
+	template<>
+	struct Mat<float, 4, 4>
 	{
+		using ValueType = float;
+
 		float r0c0, r0c1, r0c2, r0c3;
 		float r1c0, r1c1, r1c2, r1c3;
 		float r2c0, r2c1, r2c2, r2c3;
 		float r3c0, r3c1, r3c2, r3c3;
 
-		inline Matrix4D();
-		inline explicit Matrix4D(
+		inline Mat();
+		inline explicit Mat(
 			float _r0c0, float _r0c1, float _r0c2, float _r0c3,
 			float _r1c0, float _r1c1, float _r1c2, float _r1c3,
 			float _r2c0, float _r2c1, float _r2c2, float _r2c3,
 			float _r3c0, float _r3c1, float _r3c2, float _r3c3);
+		// From another element type, e.g. a Matrix4Double
+		template<typename U>
+		inline explicit Mat(const Mat<U, 4, 4>& other);
+
 		// glm::mat4(1.0f);
 		inline static Matrix4D Identity();
 
+		inline float& operator()(int row, int column) { return (&r0c0)[row * 4 + column]; }
+		inline const float& operator()(int row, int column) const { return (&r0c0)[row * 4 + column]; }
+
 		/// <summary>
 		/// Returns a new 4x4 matrix representing the original matrix translated by the given 3D vector.
 		/// </summary>
@@ -63,8 +82,27 @@ namespace Math
 		/// in front of the near plane will not be drawn</param>
 		/// <param name="far">The far plane of the perspective frustum. All the objects
 		/// behind the far plane will not be drawn</param>
+		/// <param name="clipDepth">NDC depth range, near maps to the low end.</param>
 		/// <returns>A perspective projection matrix</returns>
-		inline static Matrix4D Perspective(const float& FOV, const float& aspectRatio, const float& near, const float& far);
+		inline static Matrix4D Perspective(const float& FOV, const float& aspectRatio, const float& near, const float& far,
+			ClipDepth clipDepth = ClipDepth::NegativeOneToOne);
+
+		/// <summary>
+		/// Perspective projection mapping the near plane to depth 1 and the far plane to the low end.
+		/// Float depth keeps most of its precision close to 0, which is where reversed-Z puts
+		/// the distant geometry. Render with glDepthFunc(GL_GREATER) and clear depth to 0.
+		/// </summary>
+		/// <param name="FOV">The vertical field of view in radians.</param>
+		/// <param name="clipDepth">Use ZeroToOne with glClipControl, NegativeOneToOne gains no precision.</param>
+		inline static Matrix4D PerspectiveReversedZ(float FOV, float aspectRatio, float nearPlane, float farPlane,
+			ClipDepth clipDepth = ClipDepth::ZeroToOne);
+
+		/// <summary>
+		/// PerspectiveReversedZ with the far plane at infinity: nothing is clipped by distance
+		/// and depth tends to the low end as the distance grows.
+		/// </summary>
+		inline static Matrix4D PerspectiveInfiniteReversedZ(float FOV, float aspectRatio, float nearPlane,
+			ClipDepth clipDepth = ClipDepth::ZeroToOne);
 
 		/// <summary>
 		/// Creates a view transformation matrix representing a way that the user
@@ -79,18 +117,24 @@ namespace Math
 		inline static Matrix4D LookAt(const Vector3D& position, const Vector3D& target, const Vector3D& up = Vector3D(0.0f, 1.0f, 0.0f));
 
 
+		/// <summary>
+		/// General 4x4 inverse (cofactor expansion).
+		/// </summary>
+		/// <returns>The inverse, or a zero matrix if this matrix is singular.</returns>
+		inline Matrix4D Inverse() const;
+
 		inline Vector4D operator*(const Vector4D& vec4) const;
 		inline Matrix4D operator*(const Matrix4D& otherMat) const;
 	};
 
-	Matrix4D::Matrix4D() : r0c0(0.0f), r0c1(0.0f), r0c2(0.0f), r0c3(0.0f),
+	Matrix4D::Mat() : r0c0(0.0f), r0c1(0.0f), r0c2(0.0f), r0c3(0.0f),
 		r1c0(0.0f), r1c1(0.0f), r1c2(0.0f), r1c3(0.0f),
 		r2c0(0.0f), r2c1(0.0f), r2c2(0.0f), r2c3(0.0f),
 		r3c0(0.0f), r3c1(0.0f), r3c2(0.0f), r3c3(0.0f)
 	{
 	}
 
-	Matrix4D::Matrix4D(float _r0c0, float _r0c1, float _r0c2, float _r0c3,
+	Matrix4D::Mat(float _r0c0, float _r0c1, float _r0c2, float _r0c3,
 		float _r1c0, float _r1c1, float _r1c2, float _r1c3,
 		float _r2c0, float _r2c1, float _r2c2, float _r2c3,
 		float _r3c0, float _r3c1, float _r3c2, float _r3c3)
@@ -101,6 +145,16 @@ namespace Math
 	{
 	}
 
+	template<typename U>
+	Matrix4D::Mat(const Mat<U, 4, 4>& other)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				(*this)(row, column) = static_cast<float>(other(row, column));
+		}
+	}
+
 	inline Matrix4D Matrix4D::Identity()
 	{
 		return Matrix4D(
@@ -130,8 +184,8 @@ namespace Math
 		axis = axis.Normalized();
 
 		Matrix4D result;
-		const float c = cos(angle);
-		const float s = sin(angle);
+		float s, c;
+		SinCos(angle, s, c);
 		const float oneMinusC = 1.0f - c;
 
 		result.r0c0 = axis.x * axis.x + (1.0f - axis.x * axis.x) * c;
@@ -160,14 +214,64 @@ namespace Math
 		return mat * result;
 	}
 
-	Matrix4D Matrix4D::Perspective(const float& FOV, const float& aspectRatio, const float& near, const float& far)
+	Matrix4D Matrix4D::Perspective(const float& FOV, const float& aspectRatio, const float& near, const float& far, ClipDepth clipDepth)
 	{
 		Matrix4D result;
 
 		result.r0c0 = 1.0f / (aspectRatio * tan(FOV / 2.0f));
 		result.r1c1 = 1.0f / tan(FOV / 2.0f);
-		result.r2c2 = -((far + near) / (far - near));
-		result.r2c3 = -(2.0f * far * near) / (far - near);
+		if (clipDepth == ClipDepth::ZeroToOne)
+		{
+			result.r2c2 = far / (near - far);
+			result.r2c3 = far * near / (near - far);
+		}
+		else
+		{
+			result.r2c2 = -((far + near) / (far - near));
+			result.r2c3 = -(2.0f * far * near) / (far - near);
+		}
+		result.r3c2 = -1.0f;
+		return result;
+	}
+
+	Matrix4D Matrix4D::PerspectiveReversedZ(float FOV, float aspectRatio, float nearPlane, float farPlane, ClipDepth clipDepth)
+	{
+		Matrix4D result;
+
+		result.r1c1 = 1.0f / tan(FOV / 2.0f);
+		result.r0c0 = result.r1c1 / aspectRatio;
+		if (clipDepth == ClipDepth::ZeroToOne)
+		{
+			result.r2c2 = nearPlane / (farPlane - nearPlane);
+			result.r2c3 = farPlane * nearPlane / (farPlane - nearPlane);
+		}
+		else
+		{
+			// The [-1, 1] mapping with the planes swapped
+			result.r2c2 = (farPlane + nearPlane) / (farPlane - nearPlane);
+			result.r2c3 = 2.0f * farPlane * nearPlane / (farPlane - nearPlane);
+		}
+		result.r3c2 = -1.0f;
+		return result;
+	}
+
+	Matrix4D Matrix4D::PerspectiveInfiniteReversedZ(float FOV, float aspectRatio, float nearPlane, ClipDepth clipDepth)
+	{
+		// Limit of PerspectiveReversedZ as farPlane goes to infinity
+		Matrix4D result;
+
+		result.r1c1 = 1.0f / tan(FOV / 2.0f);
+		result.r0c0 = result.r1c1 / aspectRatio;
+		if (clipDepth == ClipDepth::ZeroToOne)
+		{
+			result.r2c2 = 0.0f;
+			result.r2c3 = nearPlane;
+		}
+		else
+		{
+			result.r2c2 = 1.0f;
+			result.r2c3 = 2.0f * nearPlane;
+		}
 		result.r3c2 = -1.0f;
 		return result;
 	}
@@ -207,6 +311,40 @@ namespace Math
 		return rotationMatrix * translationMatrix;
 	}
 
+	Matrix4D Matrix4D::Inverse() const
+	{
+		// The cofactor formulas are layout agnostic: inverting the transpose gives the transposed inverse
+		const float* m = &r0c0;
+		Matrix4D result;
+		float* inv = &result.r0c0;
+
+		inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+		const float determinant = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+		if (determinant == 0.0f)
+			return Matrix4D();
+
+		const float inverseDeterminant = 1.0f / determinant;
+		for (int i = 0; i < 16; i++)
+			inv[i] *= inverseDeterminant;
+		return result;
+	}
+
 	Vector4D Matrix4D::operator*(const Vector4D& vec4) const
 	{
 		Vector4D result{};
@@ -222,6 +360,24 @@ namespace Math
 	{
 		Matrix4D result;
 
+#if MATH_SIMD_SSE2
+		// Row i of the result is the rows of 'other' weighted by row i of this matrix
+		const float* a = &r0c0;
+		const __m128 b0 = _mm_loadu_ps(&other.r0c0);
+		const __m128 b1 = _mm_loadu_ps(&other.r1c0);
+		const __m128 b2 = _mm_loadu_ps(&other.r2c0);
+		const __m128 b3 = _mm_loadu_ps(&other.r3c0);
+		float* out = &result.r0c0;
+		for (int row = 0; row < 4; row++)
+		{
+			const float* r = a + row * 4;
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(r[0]), b0);
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(r[1]), b1));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(r[2]), b2));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(r[3]), b3));
+			_mm_storeu_ps(out + row * 4, sum);
+		}
+#else
 		result.r0c0 = r0c0 * other.r0c0 + r0c1 * other.r1c0 + r0c2 * other.r2c0 + r0c3 * other.r3c0;
 		result.r0c1 = r0c0 * other.r0c1 + r0c1 * other.r1c1 + r0c2 * other.r2c1 + r0c3 * other.r3c1;
 		result.r0c2 = r0c0 * other.r0c2 + r0c1 * other.r1c2 + r0c2 * other.r2c2 + r0c3 * other.r3c2;
@@ -241,6 +397,7 @@ namespace Math
 		result.r3c1 = r3c0 * other.r0c1 + r3c1 * other.r1c1 + r3c2 * other.r2c1 + r3c3 * other.r3c1;
 		result.r3c2 = r3c0 * other.r0c2 + r3c1 * other.r1c2 + r3c2 * other.r2c2 + r3c3 * other.r3c2;
 		result.r3c3 = r3c0 * other.r0c3 + r3c1 * other.r1c3 + r3c2 * other.r2c3 + r3c3 * other.r3c3;
+#endif
 
 		return result;
 	}
@@ -0,0 +1,108 @@
+#pragma once
+#include "AABB.h"
+#include "Matrix3D.h"
+
+namespace Math
+{
+	/*
+	* Oriented bounding box: a box of half sizes extents around center, along the
+	* unit axes stored as the columns of axes (a rotation, local to world).
+	*/
+	struct OBB
+	{
+		Vector3D center = Vector3D(0.0f);
+		Matrix3D axes = Matrix3D::Identity();
+		Vector3D extents = Vector3D(0.0f);
+
+		OBB() = default;
+		OBB(const Vector3D& center, const Matrix3D& axes, const Vector3D& extents) : center(center), axes(axes), extents(extents) {}
+
+		/// <summary>
+		/// The box placed by an affine transform, with the transform's scale moved into the extents.
+		/// Exact for rotation, translation and (non-uniform) scale. The transform must not skew.
+		/// </summary>
+		inline static OBB FromAABB(const AABB& box, const Matrix4D& transform);
+
+		inline Vector3D GetAxis(int axis) const { return axes.GetColumn(axis); }
+
+		// Point in the box's frame, where the box spans [-extents, extents]
+		inline Vector3D ToLocal(const Vector3D& point) const
+		{
+			const Vector3D delta = point - center;
+			return Vector3D(
+				axes.r0c0 * delta.x + axes.r1c0 * delta.y + axes.r2c0 * delta.z,
+				axes.r0c1 * delta.x + axes.r1c1 * delta.y + axes.r2c1 * delta.z,
+				axes.r0c2 * delta.x + axes.r1c2 * delta.y + axes.r2c2 * delta.z);
+		}
+
+		inline Vector3D ToWorld(const Vector3D& local) const { return center + axes * local; }
+
+		// Same as AABB::Transformed on the box this was made from
+		inline AABB GetAABB() const
+		{
+			const Vector3D radius(
+				fabsf(axes.r0c0) * extents.x + fabsf(axes.r0c1) * extents.y + fabsf(axes.r0c2) * extents.z,
+				fabsf(axes.r1c0) * extents.x + fabsf(axes.r1c1) * extents.y + fabsf(axes.r1c2) * extents.z,
+				fabsf(axes.r2c0) * extents.x + fabsf(axes.r2c1) * extents.y + fabsf(axes.r2c2) * extents.z);
+			return AABB(center - radius, center + radius);
+		}
+
+		// Corner i has the signs of bits 0, 1 and 2 on the x, y and z extents
+		inline Vector3D GetCorner(int i) const
+		{
+			return ToWorld(Vector3D((i & 1) ? extents.x : -extents.x, (i & 2) ? extents.y : -extents.y, (i & 4) ? extents.z : -extents.z));
+		}
+
+		inline bool Contains(const Vector3D& point) const
+		{
+			const Vector3D local = ToLocal(point);
+			return (fabsf(local.x) <= extents.x) & (fabsf(local.y) <= extents.y) & (fabsf(local.z) <= extents.z);
+		}
+
+		inline Vector3D ClosestPoint(const Vector3D& point) const
+		{
+			const Vector3D local = ToLocal(point);
+			return ToWorld(Vector3D(
+				std::min(std::max(local.x, -extents.x), extents.x),
+				std::min(std::max(local.y, -extents.y), extents.y),
+				std::min(std::max(local.z, -extents.z), extents.z)));
+		}
+
+		// 0 if the point is inside
+		inline float DistanceSquared(const Vector3D& point) const
+		{
+			const Vector3D local = ToLocal(point);
+			const Vector3D outside(
+				std::max(fabsf(local.x) - extents.x, 0.0f),
+				std::max(fabsf(local.y) - extents.y, 0.0f),
+				std::max(fabsf(local.z) - extents.z, 0.0f));
+			return Vector3D::DotProduct(outside, outside);
+		}
+	};
+
+	OBB OBB::FromAABB(const AABB& box, const Matrix4D& m)
+	{
+		Vector3D axis[3] = {
+			Vector3D(m.r0c0, m.r1c0, m.r2c0),
+			Vector3D(m.r0c1, m.r1c1, m.r2c1),
+			Vector3D(m.r0c2, m.r1c2, m.r2c2) };
+		Vector3D scale;
+		for (int i = 0; i < 3; i++)
+		{
+			scale[i] = axis[i].Magnitude();
+			// A flattened axis keeps a valid direction and gets zero extent
+			axis[i] = scale[i] > 0.0f ? axis[i] / scale[i] : Vector3D(i == 0 ? 1.0f : 0.0f, i == 1 ? 1.0f : 0.0f, i == 2 ? 1.0f : 0.0f);
+		}
+
+		const Vector3D c = box.GetCenter();
+		const Vector3D center(
+			m.r0c0 * c.x + m.r0c1 * c.y + m.r0c2 * c.z + m.r0c3,
+			m.r1c0 * c.x + m.r1c1 * c.y + m.r1c2 * c.z + m.r1c3,
+			m.r2c0 * c.x + m.r2c1 * c.y + m.r2c2 * c.z + m.r2c3);
+		const Matrix3D axes(
+			axis[0].x, axis[1].x, axis[2].x,
+			axis[0].y, axis[1].y, axis[2].y,
+			axis[0].z, axis[1].z, axis[2].z);
+		return OBB(center, axes, box.GetExtents() * scale);
+	}
+}
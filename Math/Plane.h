@@ -0,0 +1,32 @@
+#pragma once
+#include "Vector3D.h"
+
+namespace Math
+{
+	// Points p with Dot(normal, p) + distance == 0
+	struct Plane
+	{
+		Vector3D normal = Vector3D(0.0f, 1.0f, 0.0f);
+		float distance = 0.0f;
+
+		Plane() = default;
+		Plane(const Vector3D& normal, float distance) : normal(normal), distance(distance) {}
+
+		inline static Plane FromPointNormal(const Vector3D& point, const Vector3D& normal)
+		{
+			return Plane(normal, -Vector3D::DotProduct(normal, point));
+		}
+
+		// Positive on the side the normal points to. In world units if the normal is unit length.
+		inline float SignedDistance(const Vector3D& point) const
+		{
+			return Vector3D::DotProduct(normal, point) + distance;
+		}
+
+		inline Plane Normalized() const
+		{
+			const float inverseLength = 1.0f / normal.Magnitude();
+			return Plane(normal * inverseLength, distance * inverseLength);
+		}
+	};
+}
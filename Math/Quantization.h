@@ -0,0 +1,119 @@
+#pragma once
+#include "AABB.h"
+#include "Half.h"
+#include "Vector2D.h"
+#include "Vector3D.h"
+#include "Misc/Typedefs.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Math
+{
+	/*
+	* Compact vertex attribute encodings and their decoders. Each decoder matches what the GPU does
+	* with the same bits as a normalized attribute (GL_UNSIGNED_SHORT / GL_SHORT with normalized = true),
+	* so CPU side decoding (picking, collision) sees exactly what the shaders see.
+	*/
+
+	// [0, 1] to 16 bits, rounded to nearest. Out of range values are clamped.
+	inline ushort QuantizeUnorm16(float value)
+	{
+		return static_cast<ushort>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+	}
+
+	inline float DequantizeUnorm16(ushort value)
+	{
+		return value * (1.0f / 65535.0f);
+	}
+
+	// [-1, 1] to 16 bits, rounded to nearest. Out of range values are clamped.
+	inline short QuantizeSnorm16(float value)
+	{
+		return static_cast<short>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+	}
+
+	// -32768 and -32767 both decode to -1, as in GL
+	inline float DequantizeSnorm16(short value)
+	{
+		return std::max(value * (1.0f / 32767.0f), -1.0f);
+	}
+
+	/*
+	* Positions as 16 bits per axis relative to the mesh bounds: dequantized = q * scale + offset.
+	* The error is half a step (plus float rounding), extent / 131070 per axis: 15 microns on a 2 m object.
+	*/
+	struct PositionQuantization
+	{
+		Vector3D scale;
+		Vector3D offset;
+
+		PositionQuantization() = default;
+		explicit PositionQuantization(const AABB& bounds) : scale((bounds.max - bounds.min) * (1.0f / 65535.0f)), offset(bounds.min) {}
+
+		// Positions outside of the bounds are clamped to them
+		inline void Quantize(const Vector3D& position, ushort* quantized) const
+		{
+			for (int axis = 0; axis < 3; axis++)
+				quantized[axis] = scale[axis] > 0.0f ? QuantizeUnorm16((position[axis] - offset[axis]) / (scale[axis] * 65535.0f)) : 0;
+		}
+
+		inline Vector3D Dequantize(const ushort* quantized) const
+		{
+			return Vector3D(quantized[0] * scale.x + offset.x, quantized[1] * scale.y + offset.y, quantized[2] * scale.z + offset.z);
+		}
+	};
+
+	/*
+	* Octahedral unit vectors: the sphere is projected onto an octahedron which is unfolded into the
+	* [-1, 1] square, two values instead of three. With 16 bits per value the angular error stays
+	* below 0.004 degrees, far finer than 8 bits per axis in the same 4 bytes.
+	*/
+	inline Vector2D EncodeOctahedral(const Vector3D& unit)
+	{
+		const float sum = std::fabs(unit.x) + std::fabs(unit.y) + std::fabs(unit.z);
+		if (sum == 0.0f)
+			return Vector2D(0.0f, 0.0f);
+		Vector2D square(unit.x / sum, unit.y / sum);
+		// The lower hemisphere folds over the diagonals
+		if (unit.z < 0.0f)
+		{
+			square = Vector2D((1.0f - std::fabs(square.y)) * (square.x >= 0.0f ? 1.0f : -1.0f),
+				(1.0f - std::fabs(square.x)) * (square.y >= 0.0f ? 1.0f : -1.0f));
+		}
+		return square;
+	}
+
+	// Returns a unit vector (up to float rounding) for any point of the [-1, 1] square
+	inline Vector3D DecodeOctahedral(const Vector2D& square)
+	{
+		Vector3D unit(square.x, square.y, 1.0f - std::fabs(square.x) - std::fabs(square.y));
+		const float fold = std::max(-unit.z, 0.0f);
+		unit.x += unit.x >= 0.0f ? -fold : fold;
+		unit.y += unit.y >= 0.0f ? -fold : fold;
+		return unit.Normalized();
+	}
+
+	inline void EncodeOctahedralSnorm16(const Vector3D& unit, short* encoded)
+	{
+		const Vector2D square = EncodeOctahedral(unit);
+		encoded[0] = QuantizeSnorm16(square.x);
+		encoded[1] = QuantizeSnorm16(square.y);
+	}
+
+	inline Vector3D DecodeOctahedralSnorm16(const short* encoded)
+	{
+		return DecodeOctahedral(Vector2D(DequantizeSnorm16(encoded[0]), DequantizeSnorm16(encoded[1])));
+	}
+
+	// Texture coordinates as two halfs (GL_HALF_FLOAT): exact to 1/2048 up to 1.0, tiling values stay usable
+	inline void EncodeHalf2(const Vector2D& value, ushort* encoded)
+	{
+		encoded[0] = Half::FromFloat(value.x);
+		encoded[1] = Half::FromFloat(value.y);
+	}
+
+	inline Vector2D DecodeHalf2(const ushort* encoded)
+	{
+		return Vector2D(Half::ToFloat(encoded[0]), Half::ToFloat(encoded[1]));
+	}
+}
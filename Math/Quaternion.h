@@ -0,0 +1,158 @@
+#pragma once
+#include "Vector3D.h"
+#include "Matrix3D.h"
+#include "Matrix4D.h"
+
+namespace Math
+{
+	/*
+	* Unit quaternion representing a rotation.
+	* (x, y, z) is the vector part and w the scalar part.
+	*/
+	struct Quaternion
+	{
+		float x, y, z, w;
+
+		Quaternion() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+		explicit Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+		inline static Quaternion Identity() { return Quaternion(); }
+
+		/// <summary>
+		/// Creates a rotation of angle radians around axis.
+		/// </summary>
+		/// <param name="axis">Axis to rotate around. (Should be a unit vector)</param>
+		/// <param name="angle">The magnitude of rotation IN RADIANS</param>
+		inline static Quaternion FromAxisAngle(const Vector3D& axis, float angle);
+
+		/// <summary>
+		/// Creates a rotation from Euler angles in radians, applied roll (Z) first, then pitch (X), then yaw (Y).
+		/// </summary>
+		inline static Quaternion FromEuler(float pitch, float yaw, float roll);
+
+		/// <summary>
+		/// Rotation represented by a rotation matrix (Orthonormalized first if it has drifted).
+		/// </summary>
+		inline static Quaternion FromMatrix3D(const Matrix3D& rotation);
+
+		inline float Magnitude() const { return sqrtf(x * x + y * y + z * z + w * w); }
+		inline Quaternion Normalized() const;
+		// Inverse rotation (for unit quaternions)
+		inline Quaternion Conjugate() const { return Quaternion(-x, -y, -z, w); }
+
+		// Rotates a vector
+		inline Vector3D Rotate(const Vector3D& vec) const;
+
+		// Rotation matrix (row-major, as every Matrix4D)
+		inline Matrix4D ToMatrix4D() const;
+		inline Matrix3D ToMatrix3D() const;
+
+		// Combined rotation: first 'other', then this
+		inline Quaternion operator*(const Quaternion& other) const;
+	};
+
+	inline Quaternion Quaternion::FromAxisAngle(const Vector3D& axis, float angle)
+	{
+		float s, c;
+		SinCos(angle * 0.5f, s, c);
+		return Quaternion(axis.x * s, axis.y * s, axis.z * s, c);
+	}
+
+	inline Quaternion Quaternion::FromEuler(float pitch, float yaw, float roll)
+	{
+		return FromAxisAngle(Vector3D(0.0f, 1.0f, 0.0f), yaw)
+			* FromAxisAngle(Vector3D(1.0f, 0.0f, 0.0f), pitch)
+			* FromAxisAngle(Vector3D(0.0f, 0.0f, 1.0f), roll);
+	}
+
+	inline Quaternion Quaternion::FromMatrix3D(const Matrix3D& m)
+	{
+		// Divide by the largest of 4w^2, 4x^2, 4y^2, 4z^2 to stay accurate near 180 degree rotations
+		const float trace = m.r0c0 + m.r1c1 + m.r2c2;
+		if (trace > 0.0f)
+		{
+			const float s = 2.0f * sqrtf(trace + 1.0f);
+			return Quaternion((m.r2c1 - m.r1c2) / s, (m.r0c2 - m.r2c0) / s, (m.r1c0 - m.r0c1) / s, 0.25f * s);
+		}
+		if (m.r0c0 > m.r1c1 && m.r0c0 > m.r2c2)
+		{
+			const float s = 2.0f * sqrtf(1.0f + m.r0c0 - m.r1c1 - m.r2c2);
+			return Quaternion(0.25f * s, (m.r0c1 + m.r1c0) / s, (m.r0c2 + m.r2c0) / s, (m.r2c1 - m.r1c2) / s);
+		}
+		if (m.r1c1 > m.r2c2)
+		{
+			const float s = 2.0f * sqrtf(1.0f + m.r1c1 - m.r0c0 - m.r2c2);
+			return Quaternion((m.r0c1 + m.r1c0) / s, 0.25f * s, (m.r1c2 + m.r2c1) / s, (m.r0c2 - m.r2c0) / s);
+		}
+		const float s = 2.0f * sqrtf(1.0f + m.r2c2 - m.r0c0 - m.r1c1);
+		return Quaternion((m.r0c2 + m.r2c0) / s, (m.r1c2 + m.r2c1) / s, 0.25f * s, (m.r1c0 - m.r0c1) / s);
+	}
+
+	inline Quaternion Quaternion::Normalized() const
+	{
+		const float magnitude = Magnitude();
+		if (magnitude == 0.0f)
+			return Identity();
+		return Quaternion(x / magnitude, y / magnitude, z / magnitude, w / magnitude);
+	}
+
+	inline Vector3D Quaternion::Rotate(const Vector3D& vec) const
+	{
+		// v' = v + 2w(q x v) + 2(q x (q x v))
+		const Vector3D q(x, y, z);
+		const Vector3D t = 2.0f * Vector3D::CrossProduct(q, vec);
+		return vec + w * t + Vector3D::CrossProduct(q, t);
+	}
+
+	inline Matrix4D Quaternion::ToMatrix4D() const
+	{
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+		return Matrix4D(
+			1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy), 0.0f,
+			2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx), 0.0f,
+			2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy), 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+
+	inline Matrix3D Quaternion::ToMatrix3D() const
+	{
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+		return Matrix3D(
+			1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy),
+			2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx),
+			2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy)
+		);
+	}
+
+	inline Quaternion Quaternion::operator*(const Quaternion& o) const
+	{
+		return Quaternion(
+			w * o.x + x * o.w + y * o.z - z * o.y,
+			w * o.y - x * o.z + y * o.w + z * o.x,
+			w * o.z + x * o.y - y * o.x + z * o.w,
+			w * o.w - x * o.x - y * o.y - z * o.z
+		);
+	}
+
+	/// <summary>
+	/// Builds translation * rotation * scale in one go, without the three matrix products
+	/// Translate/Rotate/Scale would need.
+	/// </summary>
+	inline Matrix4D MakeTRS(const Vector3D& translation, const Quaternion& rotation, const Vector3D& scale)
+	{
+		const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+		const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+		const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+		return Matrix4D(
+			(1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy - wz) * scale.y, 2.0f * (xz + wy) * scale.z, translation.x,
+			2.0f * (xy + wz) * scale.x, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz - wx) * scale.z, translation.y,
+			2.0f * (xz - wy) * scale.x, 2.0f * (yz + wx) * scale.y, (1.0f - 2.0f * (xx + yy)) * scale.z, translation.z,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "AABB.h"
+
+namespace Math
+{
+	struct Ray
+	{
+		Vector3D origin;
+		Vector3D direction; // Unit length, distances along the ray are then in world units
+
+		Ray() = default;
+		Ray(const Vector3D& origin, const Vector3D& direction) : origin(origin), direction(direction) {}
+
+		inline Vector3D GetPoint(float distance) const { return origin + direction * distance; }
+
+		// Per component reciprocal of the direction, precompute it when testing many boxes
+		inline Vector3D GetInverseDirection() const
+		{
+			return Vector3D(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		}
+	};
+
+	/// <summary>
+	/// Slab test between a ray and a box.
+	/// </summary>
+	/// <param name="inverseDirection">ray.GetInverseDirection()</param>
+	/// <param name="maxDistance">Hits further than this are ignored.</param>
+	/// <param name="distance">Entry distance (0 if the origin is inside the box).</param>
+	/// <returns>True if the ray hits the box within [0, maxDistance].</returns>
+	inline bool IntersectRayAABB(const Ray& ray, const Vector3D& inverseDirection, const AABB& box, float maxDistance, float& distance)
+	{
+		const float tx0 = (box.min.x - ray.origin.x) * inverseDirection.x, tx1 = (box.max.x - ray.origin.x) * inverseDirection.x;
+		const float ty0 = (box.min.y - ray.origin.y) * inverseDirection.y, ty1 = (box.max.y - ray.origin.y) * inverseDirection.y;
+		const float tz0 = (box.min.z - ray.origin.z) * inverseDirection.z, tz1 = (box.max.z - ray.origin.z) * inverseDirection.z;
+		const float tNear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+		const float tFar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), maxDistance));
+		distance = tNear;
+		return tNear <= tFar;
+	}
+}
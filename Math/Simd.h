@@ -0,0 +1,10 @@
+#pragma once
+
+// SSE2 is the baseline on every x64 target (and on Win32 with /arch:SSE2, the default).
+// Code paths using intrinsics must keep a scalar fallback under #else.
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define MATH_SIMD_SSE2 0
+#endif
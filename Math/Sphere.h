@@ -0,0 +1,155 @@
+#pragma once
+#include "AABB.h"
+#include <cstddef>
+
+namespace Math
+{
+	/*
+	* Bounding sphere. A negative radius marks an empty sphere, so that merging
+	* anything into it yields that thing.
+	*/
+	struct Sphere
+	{
+		Vector3D center = Vector3D(0.0f);
+		float radius = -1.0f;
+
+		Sphere() = default;
+		Sphere(const Vector3D& center, float radius) : center(center), radius(radius) {}
+
+		// Circumscribes the box
+		inline static Sphere FromAABB(const AABB& box)
+		{
+			return box.IsEmpty() ? Sphere() : Sphere(box.GetCenter(), box.GetExtents().Magnitude());
+		}
+
+		/// <summary>
+		/// Ritter's bounding sphere: two passes, at most about 5% larger than the minimal one.
+		/// </summary>
+		inline static Sphere FromPoints(const Vector3D* points, size_t count);
+
+		inline bool IsEmpty() const { return radius < 0.0f; }
+
+		inline AABB GetAABB() const { return IsEmpty() ? AABB() : AABB(center - Vector3D(radius), center + Vector3D(radius)); }
+
+		inline void Expand(const Vector3D& point);
+		inline void Expand(const Sphere& sphere);
+
+		inline static Sphere Merge(const Sphere& a, const Sphere& b)
+		{
+			Sphere result = a;
+			result.Expand(b);
+			return result;
+		}
+
+		/// <summary>
+		/// Bounds of this sphere after an affine transform: the radius grows with the largest axis scale.
+		/// </summary>
+		inline Sphere Transformed(const Matrix4D& transform) const;
+
+		inline bool Contains(const Vector3D& point) const
+		{
+			const Vector3D delta = point - center;
+			return Vector3D::DotProduct(delta, delta) <= radius * radius;
+		}
+
+		inline Vector3D ClosestPoint(const Vector3D& point) const
+		{
+			const Vector3D delta = point - center;
+			const float distanceSquared = Vector3D::DotProduct(delta, delta);
+			return distanceSquared <= radius * radius ? point : center + delta * (radius / sqrtf(distanceSquared));
+		}
+	};
+
+	Sphere Sphere::FromPoints(const Vector3D* points, size_t count)
+	{
+		if (count == 0)
+			return Sphere();
+
+		// Start from the extreme points along x, y or z that are furthest apart
+		size_t minIndex[3] = { 0, 0, 0 }, maxIndex[3] = { 0, 0, 0 };
+		for (size_t i = 1; i < count; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (points[i][axis] < points[minIndex[axis]][axis])
+					minIndex[axis] = i;
+				if (points[i][axis] > points[maxIndex[axis]][axis])
+					maxIndex[axis] = i;
+			}
+		}
+		int widest = 0;
+		float widestDistance = -1.0f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const Vector3D span = points[maxIndex[axis]] - points[minIndex[axis]];
+			const float distance = Vector3D::DotProduct(span, span);
+			if (distance > widestDistance)
+			{
+				widestDistance = distance;
+				widest = axis;
+			}
+		}
+
+		const Vector3D& a = points[minIndex[widest]];
+		const Vector3D& b = points[maxIndex[widest]];
+		Sphere result(0.5f * (a + b), 0.5f * sqrtf(widestDistance));
+		for (size_t i = 0; i < count; i++)
+			result.Expand(points[i]);
+		return result;
+	}
+
+	void Sphere::Expand(const Vector3D& point)
+	{
+		if (IsEmpty())
+		{
+			*this = Sphere(point, 0.0f);
+			return;
+		}
+		const Vector3D delta = point - center;
+		const float distanceSquared = Vector3D::DotProduct(delta, delta);
+		if (distanceSquared <= radius * radius)
+			return;
+		// Grow just enough to touch the point, keeping the opposite side of the sphere fixed
+		const float distance = sqrtf(distanceSquared);
+		const float newRadius = 0.5f * (radius + distance);
+		center += delta * ((newRadius - radius) / distance);
+		radius = newRadius;
+	}
+
+	void Sphere::Expand(const Sphere& sphere)
+	{
+		if (sphere.IsEmpty())
+			return;
+		if (IsEmpty())
+		{
+			*this = sphere;
+			return;
+		}
+		const Vector3D delta = sphere.center - center;
+		const float distance = delta.Magnitude();
+		if (distance + sphere.radius <= radius)
+			return;
+		if (distance + radius <= sphere.radius)
+		{
+			*this = sphere;
+			return;
+		}
+		const float newRadius = 0.5f * (distance + radius + sphere.radius);
+		center += delta * ((newRadius - radius) / distance);
+		radius = newRadius;
+	}
+
+	Sphere Sphere::Transformed(const Matrix4D& m) const
+	{
+		if (IsEmpty())
+			return Sphere();
+		const Vector3D transformedCenter(
+			m.r0c0 * center.x + m.r0c1 * center.y + m.r0c2 * center.z + m.r0c3,
+			m.r1c0 * center.x + m.r1c1 * center.y + m.r1c2 * center.z + m.r1c3,
+			m.r2c0 * center.x + m.r2c1 * center.y + m.r2c2 * center.z + m.r2c3);
+		const float scaleX = m.r0c0 * m.r0c0 + m.r1c0 * m.r1c0 + m.r2c0 * m.r2c0;
+		const float scaleY = m.r0c1 * m.r0c1 + m.r1c1 * m.r1c1 + m.r2c1 * m.r2c1;
+		const float scaleZ = m.r0c2 * m.r0c2 + m.r1c2 * m.r1c2 + m.r2c2 * m.r2c2;
+		return Sphere(transformedCenter, radius * sqrtf(std::max(std::max(scaleX, scaleY), scaleZ)));
+	}
+}
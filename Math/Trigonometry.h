@@ -0,0 +1,348 @@
+#pragma once
+#include "Simd.h"
+#include <cmath>
+#include <cstddef>
+
+// Define MATH_FAST_TRIG as 1 to make the fast tier the default of every function below
+#ifndef MATH_FAST_TRIG
+#define MATH_FAST_TRIG 0
+#endif
+
+namespace Math
+{
+	/*
+	* Minimax polynomial sin/cos/atan2/acos, scalar and over arrays (4 lanes with SSE2).
+	*
+	* Precise: within a few float ulps of the std functions (max abs error 1e-7 for
+	* sin/cos, 3e-7 for atan2, 4e-7 for acos).
+	* Fast: shorter polynomials, max abs error ~1e-5 for sin/cos and ~1e-4 for atan2/acos,
+	* fine for animation and procedural motion.
+	*
+	* Angles are reduced by multiples of pi/2 in float, which stays accurate up to
+	* |angle| = TRIG_REDUCTION_LIMIT; larger angles fall back to the std functions.
+	*/
+	enum class TrigAccuracy { Fast, Precise };
+
+	constexpr TrigAccuracy DEFAULT_TRIG_ACCURACY = MATH_FAST_TRIG ? TrigAccuracy::Fast : TrigAccuracy::Precise;
+	constexpr float TRIG_REDUCTION_LIMIT = 8192.0f;
+
+	namespace TrigKernels
+	{
+		constexpr float PI = 3.14159265358979f;
+		constexpr float HALF_PI = 1.57079632679490f;
+		constexpr float QUARTER_PI = 0.78539816339745f;
+		constexpr float TWO_OVER_PI = 0.63661977236758f;
+		constexpr float TAN_PI_OVER_8 = 0.41421356237310f;
+		// pi/2 split so quadrant * PIO2_1 and quadrant * PIO2_2 are exact (Cody-Waite)
+		constexpr float PIO2_1 = 1.5703125f;
+		constexpr float PIO2_2 = 4.837512969970703125e-4f;
+		constexpr float PIO2_3 = 7.54978995489188216e-8f;
+
+		// sin(r) and cos(r) for |r| <= pi/4
+		template<TrigAccuracy A>
+		inline float SinPolynomial(float r, float r2)
+		{
+			if (A == TrigAccuracy::Fast)
+				return r * (0.99999838540f + r2 * (-0.16661749354f + r2 * 0.00813651196f));
+			return r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+		}
+
+		template<TrigAccuracy A>
+		inline float CosPolynomial(float r2)
+		{
+			if (A == TrigAccuracy::Fast)
+				return 0.99999003496f + r2 * (-0.49970814036f + r2 * 0.04039853597f);
+			return 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+		}
+
+		// atan(a) for 0 <= a <= 1
+		template<TrigAccuracy A>
+		inline float AtanUnit(float a)
+		{
+			if (A == TrigAccuracy::Fast)
+			{
+				const float z = a * a;
+				return a * (0.99921381257f + z * (-0.32117496931f + z * (0.14626446359f + z * -0.03898651416f)));
+			}
+			// Above tan(pi/8), use atan(a) = pi/4 + atan((a - 1) / (a + 1))
+			float offset = 0.0f;
+			if (a > TAN_PI_OVER_8)
+			{
+				a = (a - 1.0f) / (a + 1.0f);
+				offset = QUARTER_PI;
+			}
+			const float z = a * a;
+			return offset + a + a * z * (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f);
+		}
+
+		// acos(x) / sqrt(1 - x) for 0 <= x <= 1 (Abramowitz and Stegun 4.4.45 / 4.4.46)
+		template<TrigAccuracy A>
+		inline float AcosPolynomial(float x)
+		{
+			if (A == TrigAccuracy::Fast)
+				return 1.5707288f + x * (-0.2121144f + x * (0.0742610f + x * -0.0187293f));
+			return 1.5707963050f + x * (-0.2145988016f + x * (0.0889789874f + x * (-0.0501743046f
+				+ x * (0.0308918810f + x * (-0.0170881256f + x * (0.0066700901f + x * -0.0012624911f))))));
+		}
+
+#if MATH_SIMD_SSE2
+		inline __m128 Polynomial(__m128 x, float c0, float c1) { return _mm_add_ps(_mm_set1_ps(c0), _mm_mul_ps(x, _mm_set1_ps(c1))); }
+		inline __m128 Horner(__m128 x, __m128 tail, float c) { return _mm_add_ps(_mm_set1_ps(c), _mm_mul_ps(x, tail)); }
+
+		inline __m128 Select(__m128 mask, __m128 whenTrue, __m128 whenFalse)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, whenTrue), _mm_andnot_ps(mask, whenFalse));
+		}
+
+		inline __m128 Abs(__m128 x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+
+		// False if a lane needs the std fallback
+		template<TrigAccuracy A>
+		inline bool SinCos4(__m128 x, __m128& sine, __m128& cosine)
+		{
+			if (_mm_movemask_ps(_mm_cmpnle_ps(Abs(x), _mm_set1_ps(TRIG_REDUCTION_LIMIT))) != 0)
+				return false;
+
+			const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+			const __m128 q = _mm_cvtepi32_ps(quadrant);
+			__m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(PIO2_1)));
+			r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(PIO2_2)));
+			r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(PIO2_3)));
+			const __m128 r2 = _mm_mul_ps(r, r);
+
+			__m128 s, c;
+			if (A == TrigAccuracy::Fast)
+			{
+				s = _mm_mul_ps(r, Horner(r2, Polynomial(r2, -0.16661749354f, 0.00813651196f), 0.99999838540f));
+				c = Horner(r2, Polynomial(r2, -0.49970814036f, 0.04039853597f), 0.99999003496f);
+			}
+			else
+			{
+				s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), Horner(r2, Polynomial(r2, 8.3321608736e-3f, -1.9515295891e-4f), -1.6666654611e-1f)));
+				const __m128 tail = Horner(r2, Polynomial(r2, -1.388731625493765e-3f, 2.443315711809948e-5f), 4.166664568298827e-2f);
+				c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), tail));
+			}
+
+			// Odd quadrants swap sin and cos, the sign bits come from bit 1 of q and q + 1
+			const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+			const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+			const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+			sine = _mm_xor_ps(Select(swap, c, s), sinSign);
+			cosine = _mm_xor_ps(Select(swap, s, c), cosSign);
+			return true;
+		}
+
+		template<TrigAccuracy A>
+		inline __m128 Atan2_4(__m128 y, __m128 x)
+		{
+			const __m128 absY = Abs(y), absX = Abs(x);
+			const __m128 steep = _mm_cmpgt_ps(absY, absX);
+			const __m128 largest = _mm_max_ps(absX, absY);
+			// 0 / 0 yields 0 like std::atan2(0, 0)
+			const __m128 ratio = _mm_and_ps(_mm_div_ps(_mm_min_ps(absX, absY), largest), _mm_cmpgt_ps(largest, _mm_setzero_ps()));
+
+			__m128 angle;
+			if (A == TrigAccuracy::Fast)
+			{
+				const __m128 z = _mm_mul_ps(ratio, ratio);
+				angle = _mm_mul_ps(ratio, Horner(z, Horner(z, Polynomial(z, 0.14626446359f, -0.03898651416f), -0.32117496931f), 0.99921381257f));
+			}
+			else
+			{
+				const __m128 reduce = _mm_cmpgt_ps(ratio, _mm_set1_ps(TAN_PI_OVER_8));
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 a = Select(reduce, _mm_div_ps(_mm_sub_ps(ratio, one), _mm_add_ps(ratio, one)), ratio);
+				const __m128 z = _mm_mul_ps(a, a);
+				const __m128 tail = Horner(z, Horner(z, Polynomial(z, -1.38776856032e-1f, 8.05374449538e-2f), 1.99777106478e-1f), -3.33329491539e-1f);
+				angle = _mm_add_ps(_mm_and_ps(reduce, _mm_set1_ps(QUARTER_PI)), _mm_add_ps(a, _mm_mul_ps(_mm_mul_ps(a, z), tail)));
+			}
+
+			angle = Select(steep, _mm_sub_ps(_mm_set1_ps(HALF_PI), angle), angle);
+			angle = Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), angle), angle);
+			return _mm_or_ps(angle, _mm_and_ps(y, _mm_set1_ps(-0.0f)));
+		}
+
+		template<TrigAccuracy A>
+		inline __m128 Acos4(__m128 x)
+		{
+			const __m128 one = _mm_set1_ps(1.0f);
+			x = _mm_max_ps(_mm_min_ps(x, one), _mm_set1_ps(-1.0f));
+			const __m128 a = Abs(x);
+			__m128 p;
+			if (A == TrigAccuracy::Fast)
+				p = Horner(a, Horner(a, Polynomial(a, 0.0742610f, -0.0187293f), -0.2121144f), 1.5707288f);
+			else
+			{
+				__m128 tail = Polynomial(a, 0.0066700901f, -0.0012624911f);
+				tail = Horner(a, tail, -0.0170881256f);
+				tail = Horner(a, tail, 0.0308918810f);
+				tail = Horner(a, tail, -0.0501743046f);
+				tail = Horner(a, tail, 0.0889789874f);
+				tail = Horner(a, tail, -0.2145988016f);
+				p = Horner(a, tail, 1.5707963050f);
+			}
+			const __m128 result = _mm_mul_ps(p, _mm_sqrt_ps(_mm_sub_ps(one, a)));
+			return Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), result), result);
+		}
+#endif
+	}
+
+	/// <summary>
+	/// Sine and cosine of the same angle in one pass: a single range reduction
+	/// feeding both polynomials.
+	/// </summary>
+	/// <param name="angle">In radians.</param>
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline void SinCos(float angle, float& sine, float& cosine)
+	{
+		using namespace TrigKernels;
+		if (!(std::fabs(angle) <= TRIG_REDUCTION_LIMIT))
+		{
+			sine = std::sin(angle);
+			cosine = std::cos(angle);
+			return;
+		}
+
+		const float scaled = angle * TWO_OVER_PI;
+#if MATH_SIMD_SSE2
+		const int quadrant = _mm_cvtss_si32(_mm_set_ss(scaled));
+#else
+		const int quadrant = static_cast<int>(scaled + (scaled < 0.0f ? -0.5f : 0.5f));
+#endif
+		const float q = static_cast<float>(quadrant);
+		const float r = ((angle - q * PIO2_1) - q * PIO2_2) - q * PIO2_3;
+		const float r2 = r * r;
+
+		// Branch free quadrant fix up: the quadrant is unpredictable for arrays of angles
+		const float s = SinPolynomial<A>(r, r2);
+		const float c = CosPolynomial<A>(r2);
+		const bool swap = (quadrant & 1) != 0;
+		const float sineSign = static_cast<float>(1 - (quadrant & 2));
+		const float cosineSign = static_cast<float>(1 - ((quadrant + 1) & 2));
+		sine = (swap ? c : s) * sineSign;
+		cosine = (swap ? s : c) * cosineSign;
+	}
+
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline float Sin(float angle)
+	{
+		float sine, cosine;
+		SinCos<A>(angle, sine, cosine);
+		return sine;
+	}
+
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline float Cos(float angle)
+	{
+		float sine, cosine;
+		SinCos<A>(angle, sine, cosine);
+		return cosine;
+	}
+
+	// Angle of (x, y) in [-pi, pi], 0 for the origin
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline float Atan2(float y, float x)
+	{
+		using namespace TrigKernels;
+		const float absY = std::fabs(y), absX = std::fabs(x);
+		const float largest = absX > absY ? absX : absY;
+		const float ratio = largest > 0.0f ? (absX < absY ? absX : absY) / largest : 0.0f;
+
+		float angle = AtanUnit<A>(ratio);
+		if (absY > absX)
+			angle = HALF_PI - angle;
+		if (x < 0.0f)
+			angle = PI - angle;
+		return std::signbit(y) ? -angle : angle;
+	}
+
+	// x is clamped to [-1, 1]
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline float Acos(float x)
+	{
+		using namespace TrigKernels;
+		x = x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x);
+		const float a = std::fabs(x);
+		const float result = AcosPolynomial<A>(a) * std::sqrt(1.0f - a);
+		return x < 0.0f ? PI - result : result;
+	}
+
+	/// <summary>
+	/// SinCos over arrays, four angles per iteration with SSE2.
+	/// Any of the outputs may be nullptr; they must not overlap the input.
+	/// </summary>
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline void SinCos(const float* angles, float* sines, float* cosines, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 s, c;
+			if (TrigKernels::SinCos4<A>(_mm_loadu_ps(angles + i), s, c))
+			{
+				if (sines)
+					_mm_storeu_ps(sines + i, s);
+				if (cosines)
+					_mm_storeu_ps(cosines + i, c);
+				continue;
+			}
+			for (size_t lane = i; lane < i + 4; lane++)
+			{
+				float sine, cosine;
+				SinCos<A>(angles[lane], sine, cosine);
+				if (sines)
+					sines[lane] = sine;
+				if (cosines)
+					cosines[lane] = cosine;
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			float sine, cosine;
+			SinCos<A>(angles[i], sine, cosine);
+			if (sines)
+				sines[i] = sine;
+			if (cosines)
+				cosines[i] = cosine;
+		}
+	}
+
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline void Sin(const float* angles, float* sines, size_t count)
+	{
+		SinCos<A>(angles, sines, nullptr, count);
+	}
+
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline void Cos(const float* angles, float* cosines, size_t count)
+	{
+		SinCos<A>(angles, nullptr, cosines, count);
+	}
+
+	// angles[i] = Atan2(y[i], x[i])
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline void Atan2(const float* y, const float* x, float* angles, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(angles + i, TrigKernels::Atan2_4<A>(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+#endif
+		for (; i < count; i++)
+			angles[i] = Atan2<A>(y[i], x[i]);
+	}
+
+	template<TrigAccuracy A = DEFAULT_TRIG_ACCURACY>
+	inline void Acos(const float* x, float* angles, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(angles + i, TrigKernels::Acos4<A>(_mm_loadu_ps(x + i)));
+#endif
+		for (; i < count; i++)
+			angles[i] = Acos<A>(x[i]);
+	}
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include "MathFwd.h"
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <utility>
+
+namespace Math
+{
+	/*
+	* Kernels shared by every Vec<T, N>. Element-wise operations expand over an index
+	* sequence, so Vec<float, 3> + Vec<float, 3> compiles to the same three additions
+	* as the former hand written Vector3D. Hot float4 / double4 operations have SSE
+	* overloads in Vector4D.h, which take precedence over these templates.
+	*
+	* Scalars are taken as typename Vec<T, N>::ValueType so "vector * 2" still converts
+	* the int instead of failing template deduction.
+	*/
+	namespace VecKernels
+	{
+		template<typename T, int N, typename F, size_t... I>
+		inline Vec<T, N> Map(const Vec<T, N>& a, const Vec<T, N>& b, F f, std::index_sequence<I...>)
+		{
+			return Vec<T, N>(f(a[I], b[I])...);
+		}
+
+		template<typename T, int N, typename F, size_t... I>
+		inline Vec<T, N> Map(const Vec<T, N>& a, F f, std::index_sequence<I...>)
+		{
+			return Vec<T, N>(f(a[I])...);
+		}
+
+		template<typename U, typename T, int N, size_t... I>
+		inline Vec<U, N> Convert(const Vec<T, N>& a, std::index_sequence<I...>)
+		{
+			return Vec<U, N>(static_cast<U>(a[I])...);
+		}
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> operator+(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		return VecKernels::Map(a, b, [](T x, T y) { return static_cast<T>(x + y); }, std::make_index_sequence<N>());
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> operator-(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		return VecKernels::Map(a, b, [](T x, T y) { return static_cast<T>(x - y); }, std::make_index_sequence<N>());
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> operator-(const Vec<T, N>& a)
+	{
+		return VecKernels::Map(a, [](T x) { return static_cast<T>(-x); }, std::make_index_sequence<N>());
+	}
+
+	// Component-wise
+	template<typename T, int N>
+	inline Vec<T, N> operator*(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		return VecKernels::Map(a, b, [](T x, T y) { return static_cast<T>(x * y); }, std::make_index_sequence<N>());
+	}
+
+	// Component-wise
+	template<typename T, int N>
+	inline Vec<T, N> operator/(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		return VecKernels::Map(a, b, [](T x, T y) { return static_cast<T>(x / y); }, std::make_index_sequence<N>());
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> operator*(const Vec<T, N>& a, typename Vec<T, N>::ValueType scalar)
+	{
+		return VecKernels::Map(a, [scalar](T x) { return static_cast<T>(x * scalar); }, std::make_index_sequence<N>());
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> operator*(typename Vec<T, N>::ValueType scalar, const Vec<T, N>& a)
+	{
+		return a * scalar;
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> operator/(const Vec<T, N>& a, typename Vec<T, N>::ValueType scalar)
+	{
+		return VecKernels::Map(a, [scalar](T x) { return static_cast<T>(x / scalar); }, std::make_index_sequence<N>());
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N>& operator+=(Vec<T, N>& a, const Vec<T, N>& b) { return a = a + b; }
+
+	template<typename T, int N>
+	inline Vec<T, N>& operator-=(Vec<T, N>& a, const Vec<T, N>& b) { return a = a - b; }
+
+	template<typename T, int N>
+	inline Vec<T, N>& operator*=(Vec<T, N>& a, typename Vec<T, N>::ValueType scalar) { return a = a * scalar; }
+
+	template<typename T, int N>
+	inline Vec<T, N>& operator/=(Vec<T, N>& a, typename Vec<T, N>::ValueType scalar) { return a = a / scalar; }
+
+	template<typename T, int N>
+	inline bool operator==(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			if (a[i] != b[i])
+				return false;
+		}
+		return true;
+	}
+
+	template<typename T, int N>
+	inline bool operator!=(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		return !(a == b);
+	}
+
+	template<typename T, int N>
+	inline T Dot(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		T sum = a[0] * b[0];
+		for (int i = 1; i < N; i++)
+			sum += a[i] * b[i];
+		return sum;
+	}
+
+	template<typename T, int N>
+	inline T Length(const Vec<T, N>& a)
+	{
+		return std::sqrt(Dot(a, a));
+	}
+
+	// Returns the zero vector (and complains) for zero length input
+	template<typename T, int N>
+	inline Vec<T, N> Normalize(const Vec<T, N>& a)
+	{
+		const T length = Length(a);
+		if (length == T(0))
+		{
+			std::cout << "Vector has magnitude zero" << std::endl;
+			return Vec<T, N>(T(0));
+		}
+		return a / length;
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> Min(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		return VecKernels::Map(a, b, [](T x, T y) { return y < x ? y : x; }, std::make_index_sequence<N>());
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> Max(const Vec<T, N>& a, const Vec<T, N>& b)
+	{
+		return VecKernels::Map(a, b, [](T x, T y) { return x < y ? y : x; }, std::make_index_sequence<N>());
+	}
+
+	template<typename T, int N>
+	inline Vec<T, N> Lerp(const Vec<T, N>& a, const Vec<T, N>& b, typename Vec<T, N>::ValueType t)
+	{
+		return a + (b - a) * t;
+	}
+
+	// Element type conversion, e.g. VectorCast<Half>(normal) to pack a vertex
+	template<typename U, typename T, int N>
+	inline Vec<U, N> VectorCast(const Vec<T, N>& a)
+	{
+		return VecKernels::Convert<U>(a, std::make_index_sequence<N>());
+	}
+
+	template<typename T>
+	inline Vec<T, 3> Cross(const Vec<T, 3>& left, const Vec<T, 3>& right)
+	{
+		return Vec<T, 3>(
+			left.y * right.z - right.y * left.z,
+			left.z * right.x - right.z * left.x,
+			left.x * right.y - right.x * left.y
+		);
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Vec.h"
+
+namespace Math
+{
+	// 2 components: texture coordinates, screen positions, grid cells (Vector2Int)
+	template<typename T>
+	struct Vec<T, 2>
+	{
+		using ValueType = T;
+
+		union { T x, u; };
+		union { T y, v; };
+
+		Vec() : x(T(0)), y(T(0)) {}
+		explicit Vec(T val) : x(val), y(val) {}
+		explicit Vec(T x, T y) : x(x), y(y) {}
+
+		template<typename U>
+		explicit Vec(const Vec<U, 2>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)) {}
+
+		inline T& operator[](int i) { return (&x)[i]; }
+		inline const T& operator[](int i) const { return (&x)[i]; }
+
+		inline T Magnitude() const { return Length(*this); }
+		inline Vec Normalized() const { return Normalize(*this); }
+	};
+}
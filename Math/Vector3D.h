@@ -1,23 +1,33 @@
 ﻿#pragma once
-#include <iostream>
+#include "Vec.h"
 
 namespace Math
 {
-	struct Vector3D
+	// Also Vector3Double, Vector3Int and Vector3Half (see MathFwd.h)
+	template<typename T>
+	struct Vec<T, 3>
 	{
-		union { float x, r; };
-		union { float y, g; };
-		union { float z, b; };
+		using ValueType = T;
 
-		Vector3D() :x(0.0f), y(0.0f), z(0.0f) {}
-		Vector3D(float val) : x(val), y(val), z(val) {}
-		explicit Vector3D(float x, float y, float z) :x(x), y(y), z(z) {}
+		union { T x, r; };
+		union { T y, g; };
+		union { T z, b; };
 
-		inline float Magnitude() const;
-		inline Vector3D Normalized() const;
+		Vec() :x(T(0)), y(T(0)), z(T(0)) {}
+		Vec(T val) : x(val), y(val), z(val) {}
+		explicit Vec(T x, T y, T z) :x(x), y(y), z(z) {}
 
-		inline static Vector3D CrossProduct(const Vector3D& left, const Vector3D& right);
-		inline static float DotProduct(const Vector3D& left, const Vector3D& right);
+		template<typename U>
+		explicit Vec(const Vec<U, 3>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)), z(static_cast<T>(other.z)) {}
+
+		inline T& operator[](int i) { return (&x)[i]; }
+		inline const T& operator[](int i) const { return (&x)[i]; }
+
+		inline T Magnitude() const;
+		inline Vec Normalized() const;
+
+		inline static Vec CrossProduct(const Vec& left, const Vec& right);
+		inline static T DotProduct(const Vec& left, const Vec& right);
 
 		/// <summary>
 		/// Calculates the angle in radians between two 3D vectors.
@@ -25,99 +35,39 @@ namespace Math
 		/// <param name="left">The first 3D vector.</param>
 		/// <param name="right">The second 3D vector.</param>
 		/// <returns>The angle in radians between the two vectors.</returns>
-		inline static float Angle(const Vector3D& left, const Vector3D& right);
-
-		//Vector3D& operator=(const Vector3D& source);
-		Vector3D& operator+=(const Vector3D& v2);
-		Vector3D& operator-=(const Vector3D& v2);
+		inline static T Angle(const Vec& left, const Vec& right);
 	};
 
-	inline float Vector3D::Magnitude() const
+	template<typename T>
+	T Vec<T, 3>::Magnitude() const
 	{
-		return sqrtf(x * x + y * y + z * z);
+		return Length(*this);
 	}
 
-	Vector3D Vector3D::Normalized() const
+	template<typename T>
+	Vec<T, 3> Vec<T, 3>::Normalized() const
 	{
-		float magnitude = Magnitude();
-		if (magnitude == 0.0f)
-		{
-			std::cout << "Vector has magnitude zero" << std::endl;
-			return Vector3D(0.0f, 0.0f, 0.0f);
-		}
-		return Vector3D(x / magnitude, y / magnitude, z / magnitude);
+		return Normalize(*this);
 	}
 
-	Vector3D Vector3D::CrossProduct(const Vector3D& left, const Vector3D& right)
+	template<typename T>
+	Vec<T, 3> Vec<T, 3>::CrossProduct(const Vec& left, const Vec& right)
 	{
-		return Vector3D(
-			left.y * right.z - right.y * left.z,
-			left.z * right.x - right.z * left.x,
-			left.x * right.y - right.x * left.y
-		);
+		return Cross(left, right);
 	}
 
-	inline float Vector3D::DotProduct(const Vector3D& left, const Vector3D& right)
+	template<typename T>
+	T Vec<T, 3>::DotProduct(const Vec& left, const Vec& right)
 	{
-		// NOTE: not tested yet
-		return left.x * right.x + left.y * right.y + left.z * right.z;
+		return Dot(left, right);
 	}
 
-	float Vector3D::Angle(const Vector3D& left, const Vector3D& right)
+	template<typename T>
+	T Vec<T, 3>::Angle(const Vec& left, const Vec& right)
 	{
 		// NOTE: not tested yet
-		const float dotP = DotProduct(left, right);
-
-		return acos(dotP / (left.Magnitude() * right.Magnitude()));
-	}
-
-	/*
-	// Vector assignment
-	inline Vector3D& Vector3D::operator=(const Vector3D& source)
-	{
-		x = source.x;
-		y = source.y;
-		z = source.z;
-		return *this;
-	}
-	*/
-
-
-	// Vector addition
-	inline Vector3D operator +(const Vector3D& v1, const Vector3D& v2)
-	{
-		return Vector3D(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);
-	}
-
-	// Vector addition-assignation
-	inline Vector3D& Vector3D::operator +=(const Vector3D& v2)
-	{
-		*this = *this + v2;
-		return *this;
-	}
-
-	// Vector subtraction
-	// a − b = el camino desde el final de b hasta el final de a
-	inline Vector3D operator-(const Vector3D& v1, const Vector3D& v2)
-	{
-		return Vector3D(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z);
-	}
+		const T dotP = DotProduct(left, right);
 
-	// Vector subtraction-assignation
-	inline Vector3D& Vector3D::operator -=(const Vector3D& v2)
-	{
-		*this = *this - v2;
-		return *this;
-	}
-
-	// Scaling a vector
-	inline Vector3D operator*(float scalar, const Vector3D& vec)
-	{
-		return Vector3D(vec.x * scalar, vec.y * scalar, vec.z * scalar);
-	}
-	// Scaling a vector
-	inline Vector3D operator*(const Vector3D& vec, float scalar)
-	{
-		return scalar * vec;
+		return std::acos(dotP / (left.Magnitude() * right.Magnitude()));
 	}
-}
\ No newline at end of file
+}
@@ -1,16 +1,105 @@
 #pragma once
+#include "Vec.h"
+#include "Simd.h"
 
 namespace Math
 {
-	struct Vector4D
-	{
-		union { float x, r; };
-		union { float y, g; };
-		union { float z, b; };
-		union { float w, a; };
-		
-		Vector4D() = default;
-		Vector4D(float x, float y, float z, float w) :x(x), y(y), z(z), w(w) {};
-		
+	// Also Vector4Double, Vector4Int and Vector4Half (see MathFwd.h)
+	template<typename T>
+	struct Vec<T, 4>
+	{
+		using ValueType = T;
+
+		union { T x, r; };
+		union { T y, g; };
+		union { T z, b; };
+		union { T w, a; };
+
+		Vec() = default;
+		explicit Vec(T val) : x(val), y(val), z(val), w(val) {}
+		Vec(T x, T y, T z, T w) :x(x), y(y), z(z), w(w) {};
+
+		template<typename U>
+		explicit Vec(const Vec<U, 4>& other) :
+			x(static_cast<T>(other.x)), y(static_cast<T>(other.y)), z(static_cast<T>(other.z)), w(static_cast<T>(other.w)) {}
+
+		inline T& operator[](int i) { return (&x)[i]; }
+		inline const T& operator[](int i) const { return (&x)[i]; }
+
+		inline T Magnitude() const { return Length(*this); }
+		inline Vec Normalized() const { return Normalize(*this); }
 	};
-}
\ No newline at end of file
+
+#if MATH_SIMD_SSE2
+	// float4 and double4 in SSE registers. Unaligned loads: vectors live in plain arrays and vertex data.
+	inline Vector4D operator+(const Vector4D& a, const Vector4D& b)
+	{
+		Vector4D result;
+		_mm_storeu_ps(&result.x, _mm_add_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x)));
+		return result;
+	}
+
+	inline Vector4D operator-(const Vector4D& a, const Vector4D& b)
+	{
+		Vector4D result;
+		_mm_storeu_ps(&result.x, _mm_sub_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x)));
+		return result;
+	}
+
+	inline Vector4D operator*(const Vector4D& a, const Vector4D& b)
+	{
+		Vector4D result;
+		_mm_storeu_ps(&result.x, _mm_mul_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x)));
+		return result;
+	}
+
+	inline Vector4D operator*(const Vector4D& a, float scalar)
+	{
+		Vector4D result;
+		_mm_storeu_ps(&result.x, _mm_mul_ps(_mm_loadu_ps(&a.x), _mm_set1_ps(scalar)));
+		return result;
+	}
+
+	inline Vector4D operator*(float scalar, const Vector4D& a)
+	{
+		return a * scalar;
+	}
+
+	inline float Dot(const Vector4D& a, const Vector4D& b)
+	{
+		const __m128 product = _mm_mul_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x));
+		const __m128 pairs = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+	}
+
+	inline Vector4Double operator+(const Vector4Double& a, const Vector4Double& b)
+	{
+		Vector4Double result;
+		_mm_storeu_pd(&result.x, _mm_add_pd(_mm_loadu_pd(&a.x), _mm_loadu_pd(&b.x)));
+		_mm_storeu_pd(&result.z, _mm_add_pd(_mm_loadu_pd(&a.z), _mm_loadu_pd(&b.z)));
+		return result;
+	}
+
+	inline Vector4Double operator-(const Vector4Double& a, const Vector4Double& b)
+	{
+		Vector4Double result;
+		_mm_storeu_pd(&result.x, _mm_sub_pd(_mm_loadu_pd(&a.x), _mm_loadu_pd(&b.x)));
+		_mm_storeu_pd(&result.z, _mm_sub_pd(_mm_loadu_pd(&a.z), _mm_loadu_pd(&b.z)));
+		return result;
+	}
+
+	inline Vector4Double operator*(const Vector4Double& a, double scalar)
+	{
+		const __m128d s = _mm_set1_pd(scalar);
+		Vector4Double result;
+		_mm_storeu_pd(&result.x, _mm_mul_pd(_mm_loadu_pd(&a.x), s));
+		_mm_storeu_pd(&result.z, _mm_mul_pd(_mm_loadu_pd(&a.z), s));
+		return result;
+	}
+
+	inline Vector4Double operator*(double scalar, const Vector4Double& a)
+	{
+		return a * scalar;
+	}
+#endif
+}
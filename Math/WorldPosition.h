@@ -0,0 +1,68 @@
+#pragma once
+#include "Vector3D.h"
+
+namespace Math
+{
+	/*
+	* Double precision point for planet scale worlds. Stays on the CPU: subtract a nearby
+	* reference (the floating origin, the camera) to get a float offset for matrices,
+	* culling and the GPU. Doubles keep sub-millimetre precision out to ~1e10 units,
+	* floats only to ~1e4.
+	*/
+	struct WorldPosition
+	{
+		double x, y, z;
+
+		WorldPosition() : x(0.0), y(0.0), z(0.0) {}
+		explicit WorldPosition(double x, double y, double z) : x(x), y(y), z(z) {}
+		explicit WorldPosition(const Vector3D& position) : x(position.x), y(position.y), z(position.z) {}
+
+		// Float offset from origin to this point, exact up to the float rounding of the result
+		inline Vector3D RelativeTo(const WorldPosition& origin) const
+		{
+			return Vector3D(static_cast<float>(x - origin.x), static_cast<float>(y - origin.y), static_cast<float>(z - origin.z));
+		}
+
+		inline double DistanceSquared(const WorldPosition& other) const
+		{
+			const double dx = x - other.x, dy = y - other.y, dz = z - other.z;
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+		inline WorldPosition& operator+=(const Vector3D& offset)
+		{
+			x += offset.x;
+			y += offset.y;
+			z += offset.z;
+			return *this;
+		}
+
+		inline WorldPosition& operator-=(const Vector3D& offset)
+		{
+			x -= offset.x;
+			y -= offset.y;
+			z -= offset.z;
+			return *this;
+		}
+	};
+
+	inline WorldPosition operator+(WorldPosition position, const Vector3D& offset)
+	{
+		return position += offset;
+	}
+
+	inline WorldPosition operator-(WorldPosition position, const Vector3D& offset)
+	{
+		return position -= offset;
+	}
+
+	inline bool operator==(const WorldPosition& left, const WorldPosition& right)
+	{
+		return left.x == right.x && left.y == right.y && left.z == right.z;
+	}
+
+	inline bool operator!=(const WorldPosition& left, const WorldPosition& right)
+	{
+		return !(left == right);
+	}
+}
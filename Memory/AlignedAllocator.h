@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace Memory
+{
+	/*
+	* std allocator that aligns storage to Alignment bytes (e.g. a cache line),
+	* independent of the language standard's support for over-aligned new.
+	* Over-allocates and keeps the original pointer just before the aligned block.
+	*/
+	template<typename T, size_t Alignment>
+	class AlignedAllocator
+	{
+		static_assert((Alignment & (Alignment - 1)) == 0 && Alignment >= alignof(void*), "Alignment must be a power of two");
+
+	public:
+		using value_type = T;
+
+		template<typename U>
+		struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+		AlignedAllocator() = default;
+
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(size_t count)
+		{
+			char* raw = static_cast<char*>(::operator new(count * sizeof(T) + Alignment + sizeof(void*)));
+			char* aligned = reinterpret_cast<char*>((reinterpret_cast<size_t>(raw) + sizeof(void*) + Alignment - 1) & ~(Alignment - 1));
+			reinterpret_cast<void**>(aligned)[-1] = raw;
+			return reinterpret_cast<T*>(aligned);
+		}
+
+		void deallocate(T* memory, size_t)
+		{
+			::operator delete(reinterpret_cast<void**>(memory)[-1]);
+		}
+	};
+
+	template<typename T, typename U, size_t Alignment>
+	inline bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return true; }
+
+	template<typename T, typename U, size_t Alignment>
+	inline bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return false; }
+
+	constexpr size_t CACHE_LINE_SIZE = 64;
+
+	template<typename T>
+	using CacheAlignedVector = std::vector<T, AlignedAllocator<T, CACHE_LINE_SIZE>>;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "FrameAllocator.h"
+#include <vector>
+
+namespace Memory
+{
+	/*
+	* std allocator adapter over a LinearArena, so standard containers can
+	* live in frame or scratch memory. deallocate() is a no-op: the memory
+	* comes back when the arena is reset or rewound.
+	*/
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		// Defaults to the calling thread's frame arena
+		ArenaAllocator() : m_arena(&FrameAllocator::GetThreadArena()) {}
+		explicit ArenaAllocator(LinearArena& arena) : m_arena(&arena) {}
+
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.GetArena()) {}
+
+		T* allocate(size_t count)
+		{
+			T* memory = m_arena->template AllocateArray<T>(count);
+			if (memory == nullptr)
+				throw std::bad_alloc();
+			return memory;
+		}
+
+		void deallocate(T*, size_t) {}
+
+		inline LinearArena* GetArena() const { return m_arena; }
+
+	private:
+		LinearArena* m_arena;
+	};
+
+	template<typename T, typename U>
+	inline bool operator==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right)
+	{
+		return left.GetArena() == right.GetArena();
+	}
+
+	template<typename T, typename U>
+	inline bool operator!=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right)
+	{
+		return !(left == right);
+	}
+
+	// Vector whose storage is released with the frame. Do not keep it past the next BeginFrame().
+	template<typename T>
+	using FrameVector = std::vector<T, ArenaAllocator<T>>;
+}
@@ -0,0 +1,156 @@
+#include "FrameAllocator.h"
+#include "Core/Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Memory
+{
+	namespace
+	{
+		constexpr size_t DEFAULT_FRAME_ARENA_SIZE = 4 * 1024 * 1024;
+		constexpr size_t SCRATCH_ARENA_SIZE = 256 * 1024;
+
+		struct ThreadArenas
+		{
+			std::unique_ptr<LinearArena> frames[2];
+			bool owned = true;						// False once its thread has exited
+			unsigned long long releasedFrame = 0;	// Frame index when its thread exited
+		};
+
+		struct FrameRegistry
+		{
+			std::mutex mutex;
+			// Owned here rather than by the threads so BeginFrame can reset them all
+			std::vector<std::unique_ptr<ThreadArenas>> threads;
+			size_t bytesPerThread = DEFAULT_FRAME_ARENA_SIZE;
+			std::atomic<unsigned long long> frameIndex{ 0 };
+		};
+
+		FrameRegistry& GetRegistry()
+		{
+			static FrameRegistry registry;
+			return registry;
+		}
+
+		void ReleaseThread(ThreadArenas& arenas)
+		{
+			FrameRegistry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			arenas.owned = false;
+			arenas.releasedFrame = registry.frameIndex.load(std::memory_order_relaxed);
+		}
+
+		// Hands the arenas back when the thread exits, so short-lived threads do not leak them
+		struct ThreadArenasOwner
+		{
+			ThreadArenas* arenas = nullptr;
+
+			~ThreadArenasOwner()
+			{
+				if (arenas != nullptr)
+					ReleaseThread(*arenas);
+			}
+		};
+
+		// Plain pointer for the allocation fast path, the owner is only touched on registration
+		thread_local ThreadArenas* t_arenas = nullptr;
+		thread_local ThreadArenasOwner t_arenasOwner;
+
+		ThreadArenas& RegisterThread()
+		{
+			FrameRegistry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			// Arenas of an exited thread are taken over as they are: what it allocated stays valid
+			// for as long as it would have, the new thread allocates after it
+			ThreadArenas* arenas = nullptr;
+			for (const std::unique_ptr<ThreadArenas>& thread : registry.threads)
+			{
+				if (!thread->owned)
+				{
+					arenas = thread.get();
+					arenas->owned = true;
+					break;
+				}
+			}
+			if (arenas == nullptr)
+			{
+				registry.threads.emplace_back(new ThreadArenas());
+				arenas = registry.threads.back().get();
+				arenas->frames[0].reset(new LinearArena(registry.bytesPerThread));
+				arenas->frames[1].reset(new LinearArena(registry.bytesPerThread));
+			}
+			t_arenas = arenas;
+			t_arenasOwner.arenas = arenas;
+			return *arenas;
+		}
+	}
+
+	void FrameAllocator::Initialize(size_t bytesPerThread)
+	{
+		FrameRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.bytesPerThread = bytesPerThread;
+	}
+
+	void FrameAllocator::BeginFrame()
+	{
+		static Core::Profiler::Counter& usedCounter = Core::Profiler::GetCounter("Memory/FrameArena/LastFrameBytes");
+		static Core::Profiler::Counter& peakCounter = Core::Profiler::GetCounter("Memory/FrameArena/PeakBytes");
+		static Core::Profiler::Counter& totalCounter = Core::Profiler::GetCounter("Memory/FrameArena/TotalBytes");
+		static Core::Profiler::Counter& allocationsCounter = Core::Profiler::GetCounter("Memory/FrameArena/Allocations");
+		static Core::Profiler::Counter& failedCounter = Core::Profiler::GetCounter("Memory/FrameArena/FailedAllocations");
+
+		FrameRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		const unsigned long long finished = registry.frameIndex.load(std::memory_order_relaxed);
+		size_t used = 0, total = 0, allocations = 0, failed = 0;
+		for (const std::unique_ptr<ThreadArenas>& thread : registry.threads)
+		{
+			used += thread->frames[finished & 1]->GetUsed();
+			for (const std::unique_ptr<LinearArena>& arena : thread->frames)
+			{
+				total += arena->GetStats().totalAllocated;
+				allocations += arena->GetStats().allocationCount;
+				failed += arena->GetStats().failedCount;
+			}
+		}
+		Core::Profiler::Set(usedCounter, static_cast<long long>(used));
+		Core::Profiler::Max(peakCounter, static_cast<long long>(used));
+		Core::Profiler::Set(totalCounter, static_cast<long long>(total));
+		Core::Profiler::Set(allocationsCounter, static_cast<long long>(allocations));
+		Core::Profiler::Set(failedCounter, static_cast<long long>(failed));
+
+		// The finished frame stays alive, the one before it is recycled
+		const unsigned long long next = finished + 1;
+		for (const std::unique_ptr<ThreadArenas>& thread : registry.threads)
+			thread->frames[next & 1]->Reset();
+
+		// Arenas of threads that exited two frames ago hold nothing alive anymore
+		registry.threads.erase(std::remove_if(registry.threads.begin(), registry.threads.end(),
+			[next](const std::unique_ptr<ThreadArenas>& thread) { return !thread->owned && next >= thread->releasedFrame + 2; }),
+			registry.threads.end());
+		registry.frameIndex.store(next, std::memory_order_release);
+	}
+
+	LinearArena& FrameAllocator::GetThreadArena()
+	{
+		ThreadArenas& arenas = t_arenas ? *t_arenas : RegisterThread();
+		return *arenas.frames[GetRegistry().frameIndex.load(std::memory_order_acquire) & 1];
+	}
+
+	unsigned long long FrameAllocator::GetFrameIndex()
+	{
+		return GetRegistry().frameIndex.load(std::memory_order_acquire);
+	}
+
+	LinearArena& GetScratchArena()
+	{
+		thread_local LinearArena scratch(SCRATCH_ARENA_SIZE);
+		return scratch;
+	}
+}
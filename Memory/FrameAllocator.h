@@ -0,0 +1,53 @@
+#pragma once
+#include "LinearArena.h"
+
+namespace Memory
+{
+	/*
+	* Per-thread, double-buffered frame memory.
+	*
+	* Every thread allocates from its own arena, so allocations never lock.
+	* Each thread owns two arenas: one for the frame being built and one for the
+	* previous frame, which stays valid while the GPU (or render thread) consumes it.
+	* BeginFrame() flips the buffers and resets the one about to be reused.
+	* When a thread exits, its arenas go to the next new thread, or are freed two frames later.
+	*/
+	class FrameAllocator
+	{
+	public:
+		/// <summary>
+		/// Sets the capacity of each per-thread arena. Must be called before the first allocation.
+		/// </summary>
+		static void Initialize(size_t bytesPerThread);
+
+		/// <summary>
+		/// Starts a new frame: memory from two frames ago is released.
+		/// Call from the main thread while no other thread allocates frame memory.
+		/// Also publishes the usage stats to the profiler.
+		/// </summary>
+		static void BeginFrame();
+
+		static inline void* Allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT)
+		{
+			return GetThreadArena().Allocate(size, alignment);
+		}
+
+		template<typename T>
+		static inline T* AllocateArray(size_t count)
+		{
+			return GetThreadArena().AllocateArray<T>(count);
+		}
+
+		// The calling thread's arena for the current frame.
+		static LinearArena& GetThreadArena();
+
+		// Number of frames started so far.
+		static unsigned long long GetFrameIndex();
+	};
+
+	/// <summary>
+	/// Per-thread arena for short scoped temporaries (see ScopedStack).
+	/// Independent from the frame arenas, never reset automatically.
+	/// </summary>
+	LinearArena& GetScratchArena();
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <utility>
+#include <vector>
+
+namespace Memory
+{
+	/*
+	* Generational handle: a slot index plus the generation the slot had when
+	* the object was created. Destroying an object bumps the slot generation,
+	* so any handle still pointing at it is detected as stale with one compare.
+	* The type parameter only keeps handles of different pools apart.
+	*/
+	template<typename T>
+	struct Handle
+	{
+		uint index = 0;
+		uint generation = 0; // 0 is never used by a live object: a default handle is always invalid
+
+		inline bool IsNull() const { return generation == 0; }
+		inline bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const Handle& other) const { return !(*this == other); }
+	};
+
+	/*
+	* Owns objects of type T in one dense array and hands out generational handles.
+	* Create/Destroy/Get are O(1). Destroy moves the last object into the hole,
+	* so the live objects are always contiguous and can be iterated linearly
+	* (begin/end); T must therefore be movable. Pointers returned by Get are
+	* invalidated by Create and Destroy, keep the handle instead.
+	*/
+	template<typename T>
+	class HandlePool
+	{
+	public:
+		explicit HandlePool(uint reserve = 0)
+		{
+			m_objects.reserve(reserve);
+			m_owners.reserve(reserve);
+			m_slots.reserve(reserve);
+		}
+
+		template<typename... Args>
+		Handle<T> Create(Args&&... args)
+		{
+			uint slotIndex;
+			if (m_freeSlot != INVALID_INDEX)
+			{
+				slotIndex = m_freeSlot;
+				m_freeSlot = m_slots[slotIndex].denseIndex;
+			}
+			else
+			{
+				slotIndex = static_cast<uint>(m_slots.size());
+				m_slots.push_back({ INVALID_INDEX, 1 });
+			}
+
+			Slot& slot = m_slots[slotIndex];
+			slot.denseIndex = static_cast<uint>(m_objects.size());
+			m_objects.emplace_back(std::forward<Args>(args)...);
+			m_owners.push_back(slotIndex);
+			return { slotIndex, slot.generation };
+		}
+
+		// Destroys the object. Returns false (and does nothing) for stale or null handles.
+		bool Destroy(Handle<T> handle)
+		{
+			if (!IsValid(handle))
+				return false;
+
+			Slot& slot = m_slots[handle.index];
+			const uint denseIndex = slot.denseIndex;
+			const uint lastIndex = static_cast<uint>(m_objects.size()) - 1;
+			if (denseIndex != lastIndex)
+			{
+				m_objects[denseIndex] = std::move(m_objects[lastIndex]);
+				m_owners[denseIndex] = m_owners[lastIndex];
+				m_slots[m_owners[denseIndex]].denseIndex = denseIndex;
+			}
+			m_objects.pop_back();
+			m_owners.pop_back();
+
+			// Skip 0 on wrap around so a recycled slot never matches a null handle
+			slot.generation = slot.generation + 1 != 0 ? slot.generation + 1 : 1;
+			slot.denseIndex = m_freeSlot;
+			m_freeSlot = handle.index;
+			return true;
+		}
+
+		inline bool IsValid(Handle<T> handle) const
+		{
+			return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation;
+		}
+
+		// Returns nullptr for stale or null handles.
+		inline T* Get(Handle<T> handle)
+		{
+			return IsValid(handle) ? &m_objects[m_slots[handle.index].denseIndex] : nullptr;
+		}
+
+		inline const T* Get(Handle<T> handle) const
+		{
+			return IsValid(handle) ? &m_objects[m_slots[handle.index].denseIndex] : nullptr;
+		}
+
+		// Handle of the object at a dense position (0 .. GetSize() - 1), e.g. while iterating.
+		inline Handle<T> GetHandle(uint denseIndex) const
+		{
+			const uint slotIndex = m_owners[denseIndex];
+			return { slotIndex, m_slots[slotIndex].generation };
+		}
+
+		inline uint GetSize() const { return static_cast<uint>(m_objects.size()); }
+
+		inline T* begin() { return m_objects.data(); }
+		inline T* end() { return m_objects.data() + m_objects.size(); }
+		inline const T* begin() const { return m_objects.data(); }
+		inline const T* end() const { return m_objects.data() + m_objects.size(); }
+
+		// Destroys every object, invalidating all outstanding handles.
+		void Clear()
+		{
+			while (!m_objects.empty())
+				Destroy(GetHandle(static_cast<uint>(m_objects.size()) - 1));
+		}
+
+	private:
+		static constexpr uint INVALID_INDEX = 0xFFFFFFFF;
+
+		struct Slot
+		{
+			uint denseIndex;	// Position in m_objects, or next free slot while unused
+			uint generation;
+		};
+
+		std::vector<T> m_objects;		// Dense, live objects only
+		std::vector<uint> m_owners;		// Slot of every dense object
+		std::vector<Slot> m_slots;
+		uint m_freeSlot = INVALID_INDEX;
+	};
+}
@@ -0,0 +1,26 @@
+#include "LinearArena.h"
+#include <iostream>
+
+namespace Memory
+{
+	LinearArena::LinearArena(size_t capacity) :
+		m_base(static_cast<char*>(::operator new(capacity))), m_capacity(capacity)
+	{
+	}
+
+	LinearArena::~LinearArena()
+	{
+		::operator delete(m_base);
+	}
+
+	void* LinearArena::OnOverflow(size_t size)
+	{
+		// Only report the first failure, an undersized arena fails every frame
+		if (m_stats.failedCount++ == 0)
+		{
+			std::cout << "ERROR::LINEAR_ARENA::OUT_OF_MEMORY: requested " << size << " bytes, "
+				<< m_capacity - m_offset << " of " << m_capacity << " left" << std::endl;
+		}
+		return nullptr;
+	}
+}
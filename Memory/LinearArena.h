@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+namespace Memory
+{
+	constexpr size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+	struct ArenaStats
+	{
+		size_t used = 0;			// Bytes in use right now
+		size_t peak = 0;			// Largest 'used' since creation
+		size_t totalAllocated = 0;	// Bytes handed out since creation
+		size_t allocationCount = 0;
+		size_t failedCount = 0;		// Allocations that did not fit
+	};
+
+	/*
+	* Bump allocator over one fixed block. Allocating is a pointer increment,
+	* individual frees do not exist: everything is released at once with
+	* Reset() or back to a marker with Rewind(). Not thread safe.
+	*/
+	class LinearArena
+	{
+	public:
+		explicit LinearArena(size_t capacity);
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		/// <summary>
+		/// Returns size bytes aligned to alignment (a power of two), or nullptr if the arena is full.
+		/// </summary>
+		inline void* Allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT)
+		{
+			const size_t address = reinterpret_cast<size_t>(m_base) + m_offset;
+			const size_t aligned = (address + alignment - 1) & ~(alignment - 1);
+			const size_t newOffset = aligned - reinterpret_cast<size_t>(m_base) + size;
+			if (newOffset > m_capacity)
+				return OnOverflow(size);
+
+			m_offset = newOffset;
+			m_stats.used = newOffset;
+			m_stats.peak = newOffset > m_stats.peak ? newOffset : m_stats.peak;
+			m_stats.totalAllocated += size;
+			m_stats.allocationCount++;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		// Uninitialized storage for count objects of type T.
+		template<typename T>
+		inline T* AllocateArray(size_t count)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		// Constructs a T in the arena. Its destructor is never called.
+		template<typename T, typename... Args>
+		inline T* New(Args&&... args)
+		{
+			void* memory = Allocate(sizeof(T), alignof(T));
+			return memory ? new (memory) T(static_cast<Args&&>(args)...) : nullptr;
+		}
+
+		// Releases every allocation.
+		inline void Reset() { Rewind(0); }
+
+		// Position to Rewind() back to, releasing everything allocated after it.
+		inline size_t GetMarker() const { return m_offset; }
+		inline void Rewind(size_t marker)
+		{
+			m_offset = marker < m_offset ? marker : m_offset;
+			m_stats.used = m_offset;
+		}
+
+		inline bool Owns(const void* pointer) const
+		{
+			return pointer >= m_base && pointer < m_base + m_capacity;
+		}
+
+		inline size_t GetCapacity() const { return m_capacity; }
+		inline size_t GetUsed() const { return m_offset; }
+		inline const ArenaStats& GetStats() const { return m_stats; }
+
+	private:
+		char* m_base;
+		size_t m_capacity;
+		size_t m_offset = 0;
+		ArenaStats m_stats;
+
+		void* OnOverflow(size_t size);
+	};
+}
@@ -0,0 +1,41 @@
+#include "PoolAllocator.h"
+
+namespace Memory
+{
+	namespace
+	{
+		inline size_t RoundUp(size_t value, size_t multiple)
+		{
+			return (value + multiple - 1) / multiple * multiple;
+		}
+	}
+
+	PoolAllocator::PoolAllocator(size_t blockSize, size_t blocksPerPage, size_t alignment) :
+		m_blocksPerPage(blocksPerPage > 0 ? blocksPerPage : 1),
+		m_alignment(alignment < alignof(FreeBlock) ? alignof(FreeBlock) : alignment)
+	{
+		m_blockSize = RoundUp(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize, m_alignment);
+	}
+
+	PoolAllocator::~PoolAllocator()
+	{
+		for (void* page : m_pages)
+			::operator delete(page);
+	}
+
+	void PoolAllocator::AddPage()
+	{
+		// Over-allocate by the alignment so the first block can be aligned
+		char* page = static_cast<char*>(::operator new(m_blockSize * m_blocksPerPage + m_alignment));
+		m_pages.push_back(page);
+
+		char* first = reinterpret_cast<char*>(RoundUp(reinterpret_cast<size_t>(page), m_alignment));
+		// Link in reverse so blocks are handed out in address order
+		for (size_t i = m_blocksPerPage; i-- > 0;)
+		{
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(first + i * m_blockSize);
+			block->next = m_freeList;
+			m_freeList = block;
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "LinearArena.h"
+#include <vector>
+
+namespace Memory
+{
+	/*
+	* Fixed-size block allocator. Blocks are carved out of large pages so they
+	* stay close in memory, and free blocks form an intrusive linked list:
+	* Allocate and Free are O(1) and never touch the system allocator once
+	* a page exists. Not thread safe.
+	*/
+	class PoolAllocator
+	{
+	public:
+		/// <summary>
+		/// Creates an empty pool. Pages are allocated on demand.
+		/// </summary>
+		/// <param name="blockSize">Size of every block. Rounded up to hold a pointer and to the alignment.</param>
+		/// <param name="blocksPerPage">Blocks allocated at once when the pool runs out.</param>
+		/// <param name="alignment">Alignment of every block (power of two).</param>
+		PoolAllocator(size_t blockSize, size_t blocksPerPage = 256, size_t alignment = DEFAULT_ALIGNMENT);
+		~PoolAllocator();
+
+		PoolAllocator(const PoolAllocator&) = delete;
+		PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+		inline void* Allocate()
+		{
+			if (m_freeList == nullptr)
+				AddPage();
+			FreeBlock* block = m_freeList;
+			m_freeList = block->next;
+			m_liveCount++;
+			return block;
+		}
+
+		// Returns a block obtained from Allocate() to the pool.
+		inline void Free(void* pointer)
+		{
+			if (pointer == nullptr)
+				return;
+			FreeBlock* block = static_cast<FreeBlock*>(pointer);
+			block->next = m_freeList;
+			m_freeList = block;
+			m_liveCount--;
+		}
+
+		inline size_t GetBlockSize() const { return m_blockSize; }
+		inline size_t GetLiveCount() const { return m_liveCount; }
+		inline size_t GetCapacity() const { return m_pages.size() * m_blocksPerPage; }
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		size_t m_blockSize;
+		size_t m_blocksPerPage;
+		size_t m_alignment;
+		size_t m_liveCount = 0;
+		FreeBlock* m_freeList = nullptr;
+		std::vector<void*> m_pages;
+
+		void AddPage();
+	};
+
+	/*
+	* Typed front-end of PoolAllocator: objects keep a stable address for their whole life.
+	*/
+	template<typename T>
+	class ObjectPool
+	{
+	public:
+		explicit ObjectPool(size_t objectsPerPage = 256) : m_pool(sizeof(T), objectsPerPage, alignof(T)) {}
+
+		template<typename... Args>
+		inline T* New(Args&&... args)
+		{
+			return new (m_pool.Allocate()) T(static_cast<Args&&>(args)...);
+		}
+
+		inline void Delete(T* object)
+		{
+			if (object == nullptr)
+				return;
+			object->~T();
+			m_pool.Free(object);
+		}
+
+		inline size_t GetLiveCount() const { return m_pool.GetLiveCount(); }
+
+	private:
+		PoolAllocator m_pool;
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "FrameAllocator.h"
+
+namespace Memory
+{
+	/*
+	* Stack style allocations on top of an arena: everything allocated through
+	* the ScopedStack is released when it goes out of scope. Scopes must nest
+	* (LIFO), which is always the case for local variables.
+	*/
+	class ScopedStack
+	{
+	public:
+		// Defaults to the calling thread's scratch arena
+		explicit ScopedStack(LinearArena& arena = GetScratchArena()) :
+			m_arena(arena), m_marker(arena.GetMarker())
+		{
+		}
+
+		~ScopedStack()
+		{
+			m_arena.Rewind(m_marker);
+		}
+
+		ScopedStack(const ScopedStack&) = delete;
+		ScopedStack& operator=(const ScopedStack&) = delete;
+
+		inline void* Allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT)
+		{
+			return m_arena.Allocate(size, alignment);
+		}
+
+		template<typename T>
+		inline T* AllocateArray(size_t count)
+		{
+			return m_arena.AllocateArray<T>(count);
+		}
+
+		inline LinearArena& GetArena() { return m_arena; }
+
+	private:
+		LinearArena& m_arena;
+		size_t m_marker;
+	};
+}
@@ -7,4 +7,5 @@ constexpr int DIMENSION_3 = 3;
 
 typedef unsigned int uint;
 typedef unsigned short ushort;
-typedef unsigned char uchar;
\ No newline at end of file
+typedef unsigned char uchar;
+typedef unsigned long long uint64;
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "Archetype.h"
+#include <cstring>
+
+namespace Scene
+{
+	namespace
+	{
+		inline size_t AlignUp(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	Archetype::Archetype(const ComponentMask& mask, Memory::PoolAllocator& chunkPool) :
+		m_mask(mask), m_chunkPool(chunkPool)
+	{
+		size_t bytesPerEntity = sizeof(Entity);
+		for (uint id = 0; id < MAX_COMPONENT_TYPES; id++)
+		{
+			m_offsets[id] = INVALID_OFFSET;
+			m_sizes[id] = 0;
+			if (mask.test(id))
+			{
+				m_componentIds.push_back(id);
+				m_sizes[id] = static_cast<uint>(ComponentRegistry::GetInfo(id).size);
+				bytesPerEntity += m_sizes[id];
+			}
+		}
+
+		// Start from the ideal capacity and shrink until the aligned arrays fit in a chunk
+		for (size_t capacity = CHUNK_SIZE / bytesPerEntity; capacity > 0; capacity--)
+		{
+			if (LayoutChunk(capacity) <= CHUNK_SIZE)
+			{
+				m_capacity = static_cast<uint>(capacity);
+				break;
+			}
+		}
+
+		// Not even one entity fits: every entity gets a chunk of its own, outside of the pool
+		if (m_capacity == 0)
+		{
+			m_capacity = 1;
+			m_oversizedChunkBytes = LayoutChunk(1);
+		}
+	}
+
+	Archetype::~Archetype()
+	{
+		for (Chunk& chunk : m_chunks)
+			FreeChunk(chunk.memory);
+	}
+
+	size_t Archetype::LayoutChunk(size_t capacity)
+	{
+		size_t offset = sizeof(Entity) * capacity;
+		for (uint id : m_componentIds)
+		{
+			offset = AlignUp(offset, ComponentRegistry::GetInfo(id).alignment);
+			m_offsets[id] = static_cast<uint>(offset);
+			offset += m_sizes[id] * capacity;
+		}
+		return offset;
+	}
+
+	uchar* Archetype::AllocateChunk()
+	{
+		if (m_oversizedChunkBytes != 0)
+			return OversizedChunkAllocator().allocate(m_oversizedChunkBytes);
+		return static_cast<uchar*>(m_chunkPool.Allocate());
+	}
+
+	void Archetype::FreeChunk(uchar* memory)
+	{
+		if (m_oversizedChunkBytes != 0)
+			OversizedChunkAllocator().deallocate(memory, m_oversizedChunkBytes);
+		else
+			m_chunkPool.Free(memory);
+	}
+
+	void Archetype::AddRow(Entity entity, uint& chunk, uint& row)
+	{
+		if (m_chunks.empty() || m_chunks.back().count == m_capacity)
+			m_chunks.push_back({ AllocateChunk(), 0 });
+
+		chunk = GetChunkCount() - 1;
+		row = m_chunks.back().count++;
+		GetEntities(chunk)[row] = entity;
+	}
+
+	Entity Archetype::RemoveRow(uint chunk, uint row)
+	{
+		const uint lastChunk = GetChunkCount() - 1;
+		const uint lastRow = m_chunks[lastChunk].count - 1;
+
+		Entity moved;
+		if (chunk != lastChunk || row != lastRow)
+		{
+			moved = GetEntities(lastChunk)[lastRow];
+			GetEntities(chunk)[row] = moved;
+			for (uint id : m_componentIds)
+				memcpy(GetComponent(chunk, row, id), GetComponent(lastChunk, lastRow, id), m_sizes[id]);
+		}
+
+		if (--m_chunks[lastChunk].count == 0)
+		{
+			FreeChunk(m_chunks[lastChunk].memory);
+			m_chunks.pop_back();
+		}
+		return moved;
+	}
+
+	void Archetype::CopySharedComponents(const Archetype& source, uint sourceChunk, uint sourceRow, uint chunk, uint row)
+	{
+		for (uint id : m_componentIds)
+		{
+			if (source.m_mask.test(id))
+				memcpy(GetComponent(chunk, row, id), source.GetComponent(sourceChunk, sourceRow, id), m_sizes[id]);
+		}
+	}
+}
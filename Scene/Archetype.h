@@ -0,0 +1,96 @@
+#pragma once
+#include "Entity.h"
+#include "Memory/AlignedAllocator.h"
+#include "Memory/PoolAllocator.h"
+#include <vector>
+
+namespace Scene
+{
+	constexpr size_t CHUNK_SIZE = 16 * 1024;
+	constexpr size_t CHUNK_ALIGNMENT = 64;
+
+	/*
+	* Fixed-size block holding up to 'capacity' entities of one archetype in SoA
+	* layout: the entity ids first, then one contiguous array per component.
+	* Entities larger than CHUNK_SIZE get a chunk of their own, sized to fit.
+	*/
+	struct Chunk
+	{
+		uchar* memory;
+		uint count;
+	};
+
+	/*
+	* Storage for all entities sharing the same set of components.
+	* Rows are kept dense: every chunk is full except the last one.
+	*/
+	class Archetype
+	{
+	public:
+		Archetype(const ComponentMask& mask, Memory::PoolAllocator& chunkPool);
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		inline const ComponentMask& GetMask() const { return m_mask; }
+		inline uint GetChunkCapacity() const { return m_capacity; }
+		inline uint GetChunkCount() const { return static_cast<uint>(m_chunks.size()); }
+		inline const Chunk& GetChunk(uint index) const { return m_chunks[index]; }
+		inline uint GetEntityCount() const
+		{
+			return m_chunks.empty() ? 0 : (GetChunkCount() - 1) * m_capacity + m_chunks.back().count;
+		}
+
+		inline Entity* GetEntities(uint chunk) const
+		{
+			return reinterpret_cast<Entity*>(m_chunks[chunk].memory);
+		}
+
+		// Start of the component array in a chunk, nullptr if the archetype lacks the component.
+		inline void* GetComponentArray(uint chunk, uint componentId) const
+		{
+			const uint offset = m_offsets[componentId];
+			return offset != INVALID_OFFSET ? m_chunks[chunk].memory + offset : nullptr;
+		}
+
+		inline void* GetComponent(uint chunk, uint row, uint componentId) const
+		{
+			return m_chunks[chunk].memory + m_offsets[componentId] + static_cast<size_t>(row) * m_sizes[componentId];
+		}
+
+		/// <summary>
+		/// Appends a row for the entity. Component data is left uninitialized.
+		/// </summary>
+		/// <param name="chunk">Receives the chunk of the new row.</param>
+		/// <param name="row">Receives the row inside the chunk.</param>
+		void AddRow(Entity entity, uint& chunk, uint& row);
+
+		/// <summary>
+		/// Removes a row by moving the last row of the archetype into it.
+		/// </summary>
+		/// <returns>The entity that was moved into (chunk, row), or a null entity if none was.</returns>
+		Entity RemoveRow(uint chunk, uint row);
+
+		// Copies the components both archetypes share from a row of 'source' into a row of this archetype.
+		void CopySharedComponents(const Archetype& source, uint sourceChunk, uint sourceRow, uint chunk, uint row);
+
+	private:
+		static constexpr uint INVALID_OFFSET = 0xFFFFFFFF;
+		using OversizedChunkAllocator = Memory::AlignedAllocator<uchar, CHUNK_ALIGNMENT>;
+
+		// Sets the component offsets for a chunk of the given capacity. Returns the bytes used.
+		size_t LayoutChunk(size_t capacity);
+		uchar* AllocateChunk();
+		void FreeChunk(uchar* memory);
+
+		ComponentMask m_mask;
+		std::vector<uint> m_componentIds;
+		uint m_offsets[MAX_COMPONENT_TYPES];	// Per component id, byte offset of its array inside a chunk
+		uint m_sizes[MAX_COMPONENT_TYPES];		// Per component id, size of one element
+		uint m_capacity = 0;
+		size_t m_oversizedChunkBytes = 0;		// Size of each chunk when they do not fit the pool, 0 otherwise
+		std::vector<Chunk> m_chunks;
+		Memory::PoolAllocator& m_chunkPool;
+	};
+}
@@ -0,0 +1,675 @@
+#include "Bvh.h"
+#include "Core/JobSystem.h"
+#include <algorithm>
+#include <atomic>
+
+namespace Scene
+{
+	namespace
+	{
+		constexpr uint BIN_COUNT = 16;
+		// Binned builds split groups this small at the object median
+		constexpr uint SMALL_SPLIT_COUNT = 32;
+		// Subtrees with more primitives than this are built in their own job
+		constexpr uint PARALLEL_BUILD_THRESHOLD = 4096;
+
+		inline float GetAxis(const Math::Vector3D& vector, uint axis)
+		{
+			return axis == 0 ? vector.x : axis == 1 ? vector.y : vector.z;
+		}
+	}
+
+	struct Bvh::BuildContext
+	{
+		BvhBuildMode mode;
+		std::atomic<uint> nodeCount{ 1 };
+		Core::JobCounter jobs;
+	};
+
+	Bvh::Bvh()
+	{
+		m_nodes.resize(1);
+		InitializeNode(m_nodes[ROOT], INVALID_INDEX, 0);
+	}
+
+	uint Bvh::CreateProxy(const Math::AABB& bounds, uint userData)
+	{
+		uint proxy;
+		if (m_freeProxy != INVALID_PROXY)
+		{
+			proxy = m_freeProxy;
+			m_freeProxy = m_proxies[proxy].node;
+		}
+		else
+		{
+			proxy = static_cast<uint>(m_proxies.size());
+			m_proxies.emplace_back();
+		}
+		m_proxies[proxy] = { bounds, userData, INVALID_INDEX, 0 };
+		m_liveProxies++;
+
+		// Descend towards the child whose box grows the least, growing the boxes on the way
+		uint node = ROOT;
+		for (;;)
+		{
+			BvhNode& current = m_nodes[node];
+			if (current.count < 4)
+			{
+				current.count++;
+				SetSlot(node, current.count - 1, LEAF_BIT | proxy, bounds);
+				return proxy;
+			}
+
+			uint bestSlot = 0;
+			float bestGrowth = FLT_MAX;
+			float bestArea = FLT_MAX;
+			for (uint slot = 0; slot < 4; slot++)
+			{
+				const Math::AABB slotBounds = GetSlotBounds(current, slot);
+				const float area = slotBounds.GetHalfArea();
+				const float growth = Math::AABB::Merge(slotBounds, bounds).GetHalfArea() - area;
+				if (growth < bestGrowth || (growth == bestGrowth && area < bestArea))
+				{
+					bestSlot = slot;
+					bestGrowth = growth;
+					bestArea = area;
+				}
+			}
+
+			const uint child = current.children[bestSlot];
+			const Math::AABB merged = Math::AABB::Merge(GetSlotBounds(current, bestSlot), bounds);
+			if (!(child & LEAF_BIT))
+			{
+				SetSlot(node, bestSlot, child, merged);
+				node = child;
+				continue;
+			}
+
+			// Replace the leaf with a node holding it and the new proxy
+			const uint split = AllocateNode(node, bestSlot);
+			const uint existing = child & ~LEAF_BIT;
+			m_nodes[split].count = 2;
+			SetSlot(split, 0, child, m_proxies[existing].bounds);
+			SetSlot(split, 1, LEAF_BIT | proxy, bounds);
+			SetSlot(node, bestSlot, split, merged);
+			return proxy;
+		}
+	}
+
+	void Bvh::DestroyProxy(uint proxy)
+	{
+		// Stale or already destroyed ids are ignored
+		if (!IsValidProxy(proxy))
+			return;
+
+		Proxy& removed = m_proxies[proxy];
+		RemoveSlot(removed.node, removed.slot);
+		removed.node = m_freeProxy;
+		removed.slot = INVALID_INDEX;
+		m_freeProxy = proxy;
+		m_liveProxies--;
+	}
+
+	void Bvh::MoveProxy(uint proxy, const Math::AABB& bounds)
+	{
+		// A destroyed proxy's node is a free list link and its slot is INVALID_INDEX
+		if (!IsValidProxy(proxy))
+			return;
+
+		Proxy& moved = m_proxies[proxy];
+		moved.bounds = bounds;
+		BvhNode& node = m_nodes[moved.node];
+		node.minX[moved.slot] = bounds.min.x;
+		node.minY[moved.slot] = bounds.min.y;
+		node.minZ[moved.slot] = bounds.min.z;
+		node.maxX[moved.slot] = bounds.max.x;
+		node.maxY[moved.slot] = bounds.max.y;
+		node.maxZ[moved.slot] = bounds.max.z;
+	}
+
+	const Math::AABB& Bvh::GetProxyBounds(uint proxy) const
+	{
+		static const Math::AABB EMPTY;
+		return IsValidProxy(proxy) ? m_proxies[proxy].bounds : EMPTY;
+	}
+
+	void Bvh::ShiftOrigin(const Math::Vector3D& shift)
+	{
+		for (BvhNode& node : m_nodes)
+		{
+			for (uint slot = 0; slot < node.count; slot++)
+			{
+				node.minX[slot] -= shift.x;
+				node.minY[slot] -= shift.y;
+				node.minZ[slot] -= shift.z;
+				node.maxX[slot] -= shift.x;
+				node.maxY[slot] -= shift.y;
+				node.maxZ[slot] -= shift.z;
+			}
+		}
+		for (Proxy& proxy : m_proxies)
+		{
+			if (proxy.slot == INVALID_INDEX)
+				continue;
+			proxy.bounds.min -= shift;
+			proxy.bounds.max -= shift;
+		}
+	}
+
+	void Bvh::Refit()
+	{
+		// Inner nodes in breadth first order, so every node comes after its parent
+		m_refitOrder.clear();
+		m_refitOrder.push_back(ROOT);
+		for (size_t i = 0; i < m_refitOrder.size(); i++)
+		{
+			const BvhNode& current = m_nodes[m_refitOrder[i]];
+			for (uint slot = 0; slot < current.count; slot++)
+			{
+				if (!(current.children[slot] & LEAF_BIT))
+					m_refitOrder.push_back(current.children[slot]);
+			}
+		}
+
+		// Walking it backwards visits children first: each node's box is final when it is pushed to its parent
+		for (size_t i = m_refitOrder.size(); i-- > 1;)
+		{
+			const BvhNode& current = m_nodes[m_refitOrder[i]];
+			Math::AABB bounds;
+			for (uint slot = 0; slot < current.count; slot++)
+			{
+				const uint child = current.children[slot];
+				bounds.Expand(child & LEAF_BIT ? m_proxies[child & ~LEAF_BIT].bounds : GetSlotBounds(current, slot));
+			}
+
+			BvhNode& parent = m_nodes[current.parent];
+			parent.minX[current.parentSlot] = bounds.min.x;
+			parent.minY[current.parentSlot] = bounds.min.y;
+			parent.minZ[current.parentSlot] = bounds.min.z;
+			parent.maxX[current.parentSlot] = bounds.max.x;
+			parent.maxY[current.parentSlot] = bounds.max.y;
+			parent.maxZ[current.parentSlot] = bounds.max.z;
+		}
+	}
+
+	void Bvh::Build(BvhBuildMode mode)
+	{
+		// Copy the proxies into a compact array the build partitions in place,
+		// so every pass over a subtree reads contiguous memory
+		std::vector<BuildPrimitive> primitives;
+		primitives.reserve(m_liveProxies);
+		for (uint proxy = 0; proxy < m_proxies.size(); proxy++)
+		{
+			if (m_proxies[proxy].slot != INVALID_INDEX)
+				primitives.push_back({ m_proxies[proxy].bounds, m_proxies[proxy].bounds.GetCenter(), proxy });
+		}
+
+		// A 4-wide tree with single-proxy leaves has fewer inner nodes than proxies
+		m_nodes.clear();
+		m_nodes.resize(primitives.size() > 1 ? primitives.size() : 1);
+		m_freeNode = INVALID_INDEX;
+		m_freeNodeCount = 0;
+		InitializeNode(m_nodes[ROOT], INVALID_INDEX, 0);
+
+		BuildContext context;
+		context.mode = mode;
+		if (!primitives.empty())
+		{
+			BuildNode(ROOT, primitives.data(), static_cast<uint>(primitives.size()), context);
+			Core::JobSystem::Wait(context.jobs);
+		}
+		m_nodes.resize(context.nodeCount.load());
+	}
+
+	void Bvh::BuildNode(uint node, BuildPrimitive* primitives, uint count, BuildContext& context)
+	{
+		struct Group
+		{
+			BuildPrimitive* primitives;
+			uint count;
+			Math::AABB bounds;
+			Math::AABB centroidBounds;
+		};
+
+		const auto makeGroup = [](BuildPrimitive* groupPrimitives, uint groupCount)
+		{
+			Group group = { groupPrimitives, groupCount, Math::AABB(), Math::AABB() };
+			for (uint i = 0; i < groupCount; i++)
+			{
+				group.bounds.Expand(groupPrimitives[i].bounds);
+				group.centroidBounds.Expand(groupPrimitives[i].centroid);
+			}
+			return group;
+		};
+
+		Group groups[4];
+		uint groupCount = 0;
+		if (count <= 4)
+		{
+			// Few enough to become leaves of this node directly
+			for (; groupCount < count; groupCount++)
+				groups[groupCount] = makeGroup(primitives + groupCount, 1);
+		}
+		else
+			groups[groupCount++] = makeGroup(primitives, count);
+
+		// Split the largest group until there are four, so each node gets as many children as possible
+		while (groupCount < 4)
+		{
+			uint largest = INVALID_INDEX;
+			for (uint i = 0; i < groupCount; i++)
+			{
+				if (groups[i].count > 1 && (largest == INVALID_INDEX || groups[i].bounds.GetHalfArea() > groups[largest].bounds.GetHalfArea()))
+					largest = i;
+			}
+			if (largest == INVALID_INDEX)
+				break;
+
+			const Group group = groups[largest];
+			const uint leftCount = context.mode == BvhBuildMode::Binned ? SplitBinned(group.primitives, group.count, group.centroidBounds)
+				: SplitSweep(group.primitives, group.count, group.centroidBounds);
+
+			groups[largest] = makeGroup(group.primitives, leftCount);
+			groups[groupCount++] = makeGroup(group.primitives + leftCount, group.count - leftCount);
+		}
+
+		m_nodes[node].count = groupCount;
+		for (uint slot = 0; slot < groupCount; slot++)
+		{
+			const Group& group = groups[slot];
+			if (group.count == 1)
+			{
+				SetSlot(node, slot, LEAF_BIT | group.primitives[0].proxy, group.bounds);
+				continue;
+			}
+
+			const uint child = context.nodeCount.fetch_add(1, std::memory_order_relaxed);
+			InitializeNode(m_nodes[child], node, slot);
+			SetSlot(node, slot, child, group.bounds);
+			if (group.count >= PARALLEL_BUILD_THRESHOLD)
+			{
+				BuildPrimitive* groupPrimitives = group.primitives;
+				const uint groupSize = group.count;
+				Core::JobSystem::Execute(context.jobs, [this, child, groupPrimitives, groupSize, &context]
+				{
+					BuildNode(child, groupPrimitives, groupSize, context);
+				});
+			}
+			else
+				BuildNode(child, group.primitives, group.count, context);
+		}
+	}
+
+	uint Bvh::SplitBinned(BuildPrimitive* primitives, uint count, const Math::AABB& centroidBounds)
+	{
+		if (count <= SMALL_SPLIT_COUNT)
+		{
+			// Object median along the widest axis, binning this few primitives costs more than it gains
+			const Math::Vector3D extent = centroidBounds.max - centroidBounds.min;
+			const uint axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+			std::nth_element(primitives, primitives + count / 2, primitives + count, [axis](const BuildPrimitive& left, const BuildPrimitive& right)
+			{
+				return GetAxis(left.centroid, axis) < GetAxis(right.centroid, axis);
+			});
+			return count / 2;
+		}
+
+		struct Bin
+		{
+			uint count = 0;
+			Math::AABB bounds;
+		};
+
+		// One pass bins the primitives along all three axes at once
+		Bin bins[3][BIN_COUNT];
+		float scales[3] = {};
+		float offsets[3] = {};
+		for (uint axis = 0; axis < 3; axis++)
+		{
+			const float extent = GetAxis(centroidBounds.max, axis) - GetAxis(centroidBounds.min, axis);
+			scales[axis] = extent > 0.0f ? BIN_COUNT / extent : 0.0f;
+			offsets[axis] = GetAxis(centroidBounds.min, axis) * scales[axis];
+		}
+		// Must round exactly like the SIMD binning below, so the partition agrees with the bins
+		const auto getBin = [&](const BuildPrimitive& primitive, uint axis)
+		{
+			const float bin = GetAxis(primitive.centroid, axis) * scales[axis] - offsets[axis];
+			return static_cast<uint>(std::min(std::max(bin, 0.0f), static_cast<float>(BIN_COUNT - 1)));
+		};
+
+#if MATH_SIMD_SSE2
+		{
+			__m128 binMin[3][BIN_COUNT];
+			__m128 binMax[3][BIN_COUNT];
+			for (uint axis = 0; axis < 3; axis++)
+			{
+				for (uint bin = 0; bin < BIN_COUNT; bin++)
+				{
+					binMin[axis][bin] = _mm_set1_ps(FLT_MAX);
+					binMax[axis][bin] = _mm_set1_ps(-FLT_MAX);
+				}
+			}
+
+			const __m128 scale = _mm_setr_ps(scales[0], scales[1], scales[2], 0.0f);
+			const __m128 offset = _mm_setr_ps(offsets[0], offsets[1], offsets[2], 0.0f);
+			const __m128 lastBin = _mm_set1_ps(static_cast<float>(BIN_COUNT - 1));
+			for (uint i = 0; i < count; i++)
+			{
+				// The fourth lane of each load belongs to the next member and is never used
+				const BuildPrimitive& primitive = primitives[i];
+				const __m128 boundsMin = _mm_loadu_ps(&primitive.bounds.min.x);
+				const __m128 boundsMax = _mm_loadu_ps(&primitive.bounds.max.x);
+				const __m128 bin = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&primitive.centroid.x), scale), offset);
+				alignas(16) int binIndices[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(binIndices), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(bin, _mm_setzero_ps()), lastBin)));
+
+				for (uint axis = 0; axis < 3; axis++)
+				{
+					const int index = binIndices[axis];
+					binMin[axis][index] = _mm_min_ps(binMin[axis][index], boundsMin);
+					binMax[axis][index] = _mm_max_ps(binMax[axis][index], boundsMax);
+					bins[axis][index].count++;
+				}
+			}
+
+			for (uint axis = 0; axis < 3; axis++)
+			{
+				for (uint bin = 0; bin < BIN_COUNT; bin++)
+				{
+					alignas(16) float minimum[4], maximum[4];
+					_mm_store_ps(minimum, binMin[axis][bin]);
+					_mm_store_ps(maximum, binMax[axis][bin]);
+					bins[axis][bin].bounds = Math::AABB(Math::Vector3D(minimum[0], minimum[1], minimum[2]), Math::Vector3D(maximum[0], maximum[1], maximum[2]));
+				}
+			}
+		}
+#else
+		for (uint i = 0; i < count; i++)
+		{
+			for (uint axis = 0; axis < 3; axis++)
+			{
+				Bin& bin = bins[axis][getBin(primitives[i], axis)];
+				bin.count++;
+				bin.bounds.Expand(primitives[i].bounds);
+			}
+		}
+#endif
+
+		float bestCost = FLT_MAX;
+		uint bestAxis = INVALID_INDEX;
+		uint bestSplit = 0;
+		for (uint axis = 0; axis < 3; axis++)
+		{
+			if (scales[axis] == 0.0f)
+				continue;
+
+			// Right-to-left sweep for the right side areas, then left-to-right for the costs
+			float rightAreas[BIN_COUNT];
+			Math::AABB accumulated;
+			for (uint bin = BIN_COUNT - 1; bin > 0; bin--)
+			{
+				accumulated.Expand(bins[axis][bin].bounds);
+				rightAreas[bin] = accumulated.GetHalfArea();
+			}
+
+			accumulated = Math::AABB();
+			uint leftCount = 0;
+			for (uint split = 1; split < BIN_COUNT; split++)
+			{
+				accumulated.Expand(bins[axis][split - 1].bounds);
+				leftCount += bins[axis][split - 1].count;
+				if (leftCount == 0 || leftCount == count)
+					continue;
+				const float cost = accumulated.GetHalfArea() * leftCount + rightAreas[split] * (count - leftCount);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		// Coincident centroids cannot be separated, split them evenly
+		if (bestAxis == INVALID_INDEX)
+			return count / 2;
+
+		BuildPrimitive* middle = std::partition(primitives, primitives + count, [&](const BuildPrimitive& primitive)
+		{
+			return getBin(primitive, bestAxis) < bestSplit;
+		});
+		return static_cast<uint>(middle - primitives);
+	}
+
+	uint Bvh::SplitSweep(BuildPrimitive* primitives, uint count, const Math::AABB& centroidBounds)
+	{
+		float smallAreas[SMALL_SPLIT_COUNT];
+		std::vector<float> largeAreas(count > SMALL_SPLIT_COUNT ? count : 0);
+		float* rightAreas = count > SMALL_SPLIT_COUNT ? largeAreas.data() : smallAreas;
+		float bestCost = FLT_MAX;
+		uint bestAxis = INVALID_INDEX;
+		uint bestSplit = 0;
+		uint sortedAxis = INVALID_INDEX;
+		const auto sortAlong = [primitives, count](uint axis)
+		{
+			std::sort(primitives, primitives + count, [axis](const BuildPrimitive& left, const BuildPrimitive& right)
+			{
+				return GetAxis(left.centroid, axis) < GetAxis(right.centroid, axis);
+			});
+		};
+
+		for (uint axis = 0; axis < 3; axis++)
+		{
+			if (GetAxis(centroidBounds.max, axis) <= GetAxis(centroidBounds.min, axis))
+				continue;
+			sortAlong(axis);
+			sortedAxis = axis;
+
+			Math::AABB accumulated;
+			for (uint i = count - 1; i > 0; i--)
+			{
+				accumulated.Expand(primitives[i].bounds);
+				rightAreas[i] = accumulated.GetHalfArea();
+			}
+
+			accumulated = Math::AABB();
+			for (uint split = 1; split < count; split++)
+			{
+				accumulated.Expand(primitives[split - 1].bounds);
+				const float cost = accumulated.GetHalfArea() * split + rightAreas[split] * (count - split);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		if (bestAxis == INVALID_INDEX)
+			return count / 2;
+		if (bestAxis != sortedAxis)
+			sortAlong(bestAxis);
+		return bestSplit;
+	}
+
+	bool Bvh::Raycast(const Math::Ray& ray, float maxDistance, BvhRayHit& hit) const
+	{
+		const Math::Vector3D inverseDirection = ray.GetInverseDirection();
+		return RaycastProxies(ray, maxDistance, [this, &inverseDirection](uint proxy, const Math::Ray& proxyRay, float proxyMaxDistance, float& distance)
+		{
+			return Math::IntersectRayAABB(proxyRay, inverseDirection, m_proxies[proxy].bounds, proxyMaxDistance, distance);
+		}, hit);
+	}
+
+	bool Bvh::FindNearest(const Math::Vector3D& point, float maxDistance, uint& userData, float& distance) const
+	{
+		float closest = maxDistance * maxDistance;
+		uint closestProxy = INVALID_PROXY;
+
+		TraversalStack stack;
+		stack.Push(ROOT, 0.0f);
+		while (!stack.IsEmpty())
+		{
+			const StackEntry entry = stack.Pop();
+			if (entry.distance > closest)
+				continue;
+
+			const BvhNode& node = m_nodes[entry.child];
+			float distances[4];
+			int mask = DistanceSquared4(node, point, distances);
+
+			// Visit the closest child first, it shrinks the search radius the most
+			uint order[4];
+			uint orderCount = 0;
+			for (; mask != 0; mask &= mask - 1)
+			{
+				const uint slot = mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3;
+				if (distances[slot] > closest)
+					continue;
+				uint position = orderCount++;
+				for (; position > 0 && distances[order[position - 1]] < distances[slot]; position--)
+					order[position] = order[position - 1];
+				order[position] = slot;
+			}
+
+			for (uint i = 0; i < orderCount; i++)
+			{
+				const uint slot = order[i];
+				const uint child = node.children[slot];
+				if (!(child & LEAF_BIT))
+					stack.Push(child, distances[slot]);
+				else if (distances[slot] <= closest)
+				{
+					closest = distances[slot];
+					closestProxy = child & ~LEAF_BIT;
+				}
+			}
+		}
+
+		if (closestProxy == INVALID_PROXY)
+			return false;
+		userData = m_proxies[closestProxy].userData;
+		distance = sqrtf(closest);
+		return true;
+	}
+
+	Math::AABB Bvh::GetBounds() const
+	{
+		return GetNodeBounds(m_nodes[ROOT]);
+	}
+
+	uint Bvh::AllocateNode(uint parent, uint parentSlot)
+	{
+		uint node;
+		if (m_freeNode != INVALID_INDEX)
+		{
+			node = m_freeNode;
+			m_freeNode = m_nodes[node].nextFree;
+			m_freeNodeCount--;
+		}
+		else
+		{
+			node = static_cast<uint>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+		InitializeNode(m_nodes[node], parent, parentSlot);
+		return node;
+	}
+
+	void Bvh::FreeNode(uint node)
+	{
+		InitializeNode(m_nodes[node], INVALID_INDEX, 0);
+		m_nodes[node].nextFree = m_freeNode;
+		m_freeNode = node;
+		m_freeNodeCount++;
+	}
+
+	void Bvh::SetSlot(uint node, uint slot, uint child, const Math::AABB& bounds)
+	{
+		BvhNode& current = m_nodes[node];
+		current.minX[slot] = bounds.min.x;
+		current.minY[slot] = bounds.min.y;
+		current.minZ[slot] = bounds.min.z;
+		current.maxX[slot] = bounds.max.x;
+		current.maxY[slot] = bounds.max.y;
+		current.maxZ[slot] = bounds.max.z;
+		current.children[slot] = child;
+
+		if (child & LEAF_BIT)
+		{
+			Proxy& proxy = m_proxies[child & ~LEAF_BIT];
+			proxy.node = node;
+			proxy.slot = slot;
+		}
+		else
+		{
+			m_nodes[child].parent = node;
+			m_nodes[child].parentSlot = slot;
+		}
+	}
+
+	void Bvh::ClearSlot(BvhNode& node, uint slot)
+	{
+		node.minX[slot] = node.minY[slot] = node.minZ[slot] = FLT_MAX;
+		node.maxX[slot] = node.maxY[slot] = node.maxZ[slot] = -FLT_MAX;
+		node.children[slot] = INVALID_INDEX;
+	}
+
+	void Bvh::InitializeNode(BvhNode& node, uint parent, uint parentSlot)
+	{
+		for (uint slot = 0; slot < 4; slot++)
+			ClearSlot(node, slot);
+		node.parent = parent;
+		node.parentSlot = parentSlot;
+		node.count = 0;
+		node.nextFree = INVALID_INDEX;
+	}
+
+	Math::AABB Bvh::GetSlotBounds(const BvhNode& node, uint slot)
+	{
+		return Math::AABB(Math::Vector3D(node.minX[slot], node.minY[slot], node.minZ[slot]), Math::Vector3D(node.maxX[slot], node.maxY[slot], node.maxZ[slot]));
+	}
+
+	Math::AABB Bvh::GetNodeBounds(const BvhNode& node)
+	{
+		Math::AABB bounds;
+		for (uint slot = 0; slot < node.count; slot++)
+			bounds.Expand(GetSlotBounds(node, slot));
+		return bounds;
+	}
+
+	void Bvh::RemoveSlot(uint node, uint slot)
+	{
+		BvhNode& current = m_nodes[node];
+		const uint last = current.count - 1;
+		if (slot != last)
+			SetSlot(node, slot, current.children[last], GetSlotBounds(current, last));
+		ClearSlot(current, last);
+		current.count--;
+
+		if (node != ROOT && current.count <= 1)
+		{
+			// Empty or single-child nodes are folded into their parent
+			const uint parent = current.parent;
+			const uint parentSlot = current.parentSlot;
+			if (current.count == 0)
+			{
+				FreeNode(node);
+				RemoveSlot(parent, parentSlot);
+				return;
+			}
+			SetSlot(parent, parentSlot, current.children[0], GetSlotBounds(current, 0));
+			FreeNode(node);
+			node = parent;
+		}
+
+		// Tighten the ancestors' boxes
+		while (node != ROOT)
+		{
+			const BvhNode& updated = m_nodes[node];
+			SetSlot(updated.parent, updated.parentSlot, node, GetNodeBounds(updated));
+			node = updated.parent;
+		}
+	}
+}
@@ -0,0 +1,396 @@
+#pragma once
+#include "Math/AABB.h"
+#include "Math/Ray.h"
+#include "Math/Frustum.h"
+#include "Math/Simd.h"
+#include "Memory/AlignedAllocator.h"
+#include "Misc/Typedefs.h"
+#include <vector>
+
+namespace Scene
+{
+	enum class BvhBuildMode
+	{
+		Binned,		// Binned SAH, fast enough to rebuild large scenes at load time
+		Sweep		// Full sweep SAH over sorted centroids, slower but tighter trees
+	};
+
+	struct BvhRayHit
+	{
+		uint proxy;
+		uint userData;
+		float distance;
+	};
+
+	/*
+	* 4-wide bounding volume hierarchy over proxies (an AABB plus user data).
+	*
+	* Each node stores the boxes of its four children as SoA so one SSE test checks all
+	* of them, and is exactly two cache lines. Proxies can be inserted and removed
+	* incrementally; moved proxies only need a Refit. Build rebuilds the whole tree
+	* with the SAH (in parallel on the job system) when quality has degraded.
+	* Queries are read-only and may run concurrently.
+	*/
+	class Bvh
+	{
+	public:
+		static constexpr uint INVALID_PROXY = 0xFFFFFFFF;
+
+		Bvh();
+
+		// Inserts a proxy into the tree. The id is reused after DestroyProxy.
+		uint CreateProxy(const Math::AABB& bounds, uint userData);
+		// Ignores ids that are not live
+		void DestroyProxy(uint proxy);
+
+		// Updates the proxy's box. Call Refit once all moved proxies are updated and before querying. Ignores ids that are not live.
+		void MoveProxy(uint proxy, const Math::AABB& bounds);
+
+		// Recomputes every node box bottom-up after MoveProxy. Keeps the topology.
+		void Refit();
+
+		// Rebuilds the tree from all current proxies.
+		void Build(BvhBuildMode mode = BvhBuildMode::Binned);
+
+		// Translates every box by -shift when the floating origin recenters. Keeps the topology.
+		void ShiftOrigin(const Math::Vector3D& shift);
+
+		inline bool IsValidProxy(uint proxy) const { return proxy < m_proxies.size() && m_proxies[proxy].slot != INVALID_INDEX; }
+		// An empty box for ids that are not live
+		const Math::AABB& GetProxyBounds(uint proxy) const;
+		// INVALID_PROXY for ids that are not live
+		inline uint GetProxyUserData(uint proxy) const { return IsValidProxy(proxy) ? m_proxies[proxy].userData : INVALID_PROXY; }
+		inline uint GetProxyCount() const { return m_liveProxies; }
+		inline uint GetNodeCount() const { return static_cast<uint>(m_nodes.size()) - m_freeNodeCount; }
+		Math::AABB GetBounds() const;
+
+		// Closest proxy box hit by the ray
+		bool Raycast(const Math::Ray& ray, float maxDistance, BvhRayHit& hit) const;
+
+		/// <summary>
+		/// Closest hit where each proxy box hit by the ray is refined by intersect, e.g. against a mesh.
+		/// </summary>
+		/// <param name="intersect">bool(uint userData, const Ray&amp;, float maxDistance, float&amp; distance)</param>
+		template<typename F>
+		bool Raycast(const Math::Ray& ray, float maxDistance, F&& intersect, BvhRayHit& hit) const;
+
+		// Calls f(userData) for every proxy whose box intersects the frustum (conservatively)
+		template<typename F>
+		void QueryFrustum(const Math::Frustum& frustum, F&& f) const;
+
+		// Calls f(userData) for every proxy whose box overlaps the box
+		template<typename F>
+		void QueryAABB(const Math::AABB& box, F&& f) const;
+
+		/// <summary>
+		/// Finds the proxy whose box is closest to point (0 if the point is inside it).
+		/// </summary>
+		/// <returns>False if nothing lies within maxDistance.</returns>
+		bool FindNearest(const Math::Vector3D& point, float maxDistance, uint& userData, float& distance) const;
+
+	private:
+		static constexpr uint INVALID_INDEX = 0xFFFFFFFF;
+		static constexpr uint LEAF_BIT = 0x80000000;
+		static constexpr uint ROOT = 0;
+
+		// 128 bytes: child boxes as SoA, then the links
+		struct BvhNode
+		{
+			float minX[4], minY[4], minZ[4];
+			float maxX[4], maxY[4], maxZ[4];
+			uint children[4];	// Node index, or LEAF_BIT | proxy
+			uint parent;
+			uint parentSlot;
+			uint count;			// Children occupy the first count slots
+			uint nextFree;
+		};
+
+		struct Proxy
+		{
+			Math::AABB bounds;
+			uint userData;
+			uint node;			// Next free proxy while unused
+			uint slot;			// INVALID_INDEX while unused
+		};
+
+		struct StackEntry
+		{
+			uint child;
+			float distance;
+		};
+
+		// Fixed size traversal stack that spills to the heap on pathological trees
+		class TraversalStack
+		{
+		public:
+			inline bool IsEmpty() const { return m_size == 0; }
+			inline void Push(uint child, float distance)
+			{
+				if (m_size < FIXED_SIZE)
+					m_fixed[m_size] = { child, distance };
+				else
+					m_overflow.push_back({ child, distance });
+				m_size++;
+			}
+			inline StackEntry Pop()
+			{
+				m_size--;
+				if (m_size < FIXED_SIZE)
+					return m_fixed[m_size];
+				const StackEntry entry = m_overflow.back();
+				m_overflow.pop_back();
+				return entry;
+			}
+
+		private:
+			static constexpr uint FIXED_SIZE = 128;
+			StackEntry m_fixed[FIXED_SIZE];
+			std::vector<StackEntry> m_overflow;
+			uint m_size = 0;
+		};
+
+		Memory::CacheAlignedVector<BvhNode> m_nodes;
+		uint m_freeNode = INVALID_INDEX;
+		uint m_freeNodeCount = 0;
+		std::vector<Proxy> m_proxies;
+		uint m_freeProxy = INVALID_INDEX;
+		uint m_liveProxies = 0;
+		std::vector<uint> m_refitOrder;	// Scratch of Refit, kept to avoid reallocating every frame
+
+		uint AllocateNode(uint parent, uint parentSlot);
+		void FreeNode(uint node);
+		// Stores child in the slot and points the child (node or proxy) back at it
+		void SetSlot(uint node, uint slot, uint child, const Math::AABB& bounds);
+		static void ClearSlot(BvhNode& node, uint slot);
+		static void InitializeNode(BvhNode& node, uint parent, uint parentSlot);
+		static Math::AABB GetSlotBounds(const BvhNode& node, uint slot);
+		static Math::AABB GetNodeBounds(const BvhNode& node);
+		void RemoveSlot(uint node, uint slot);
+		struct BuildPrimitive
+		{
+			Math::AABB bounds;
+			Math::Vector3D centroid;
+			uint proxy;
+		};
+
+		struct BuildContext;
+		void BuildNode(uint node, BuildPrimitive* primitives, uint count, BuildContext& context);
+		// Both reorder the primitives and return how many go to the left side, always in [1, count - 1]
+		static uint SplitBinned(BuildPrimitive* primitives, uint count, const Math::AABB& centroidBounds);
+		static uint SplitSweep(BuildPrimitive* primitives, uint count, const Math::AABB& centroidBounds);
+
+		// Traversal shared by both Raycast overloads, intersect receives the proxy id
+		template<typename F>
+		bool RaycastProxies(const Math::Ray& ray, float maxDistance, const F& intersect, BvhRayHit& hit) const;
+
+		/// <summary>
+		/// Slab test of the ray against the four child boxes.
+		/// </summary>
+		/// <returns>Bit i set if child i is hit closer than maxDistance, entry distance in distances[i].</returns>
+		static inline int IntersectRay4(const BvhNode& node, const Math::Ray& ray, const Math::Vector3D& inverseDirection, float maxDistance, float distances[4]);
+		static inline int IntersectFrustum4(const BvhNode& node, const Math::Frustum& frustum);
+		static inline int Overlap4(const BvhNode& node, const Math::AABB& box);
+		static inline int DistanceSquared4(const BvhNode& node, const Math::Vector3D& point, float distances[4]);
+
+		static inline int GetOccupiedMask(const BvhNode& node) { return (1 << node.count) - 1; }
+	};
+
+	int Bvh::IntersectRay4(const BvhNode& node, const Math::Ray& ray, const Math::Vector3D& inverseDirection, float maxDistance, float distances[4])
+	{
+#if MATH_SIMD_SSE2
+		const __m128 originX = _mm_set1_ps(ray.origin.x), originY = _mm_set1_ps(ray.origin.y), originZ = _mm_set1_ps(ray.origin.z);
+		const __m128 inverseX = _mm_set1_ps(inverseDirection.x), inverseY = _mm_set1_ps(inverseDirection.y), inverseZ = _mm_set1_ps(inverseDirection.z);
+		const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), originX), inverseX);
+		const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxX), originX), inverseX);
+		const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), originY), inverseY);
+		const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxY), originY), inverseY);
+		const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), originZ), inverseZ);
+		const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxZ), originZ), inverseZ);
+		const __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), _mm_setzero_ps()));
+		const __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_set1_ps(maxDistance)));
+		_mm_storeu_ps(distances, tNear);
+		return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) & GetOccupiedMask(node);
+#else
+		int mask = 0;
+		for (uint i = 0; i < node.count; i++)
+		{
+			const Math::AABB box(Math::Vector3D(node.minX[i], node.minY[i], node.minZ[i]), Math::Vector3D(node.maxX[i], node.maxY[i], node.maxZ[i]));
+			if (Math::IntersectRayAABB(ray, inverseDirection, box, maxDistance, distances[i]))
+				mask |= 1 << i;
+		}
+		return mask;
+#endif
+	}
+
+	int Bvh::IntersectFrustum4(const BvhNode& node, const Math::Frustum& frustum)
+	{
+#if MATH_SIMD_SSE2
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 minX = _mm_loadu_ps(node.minX), minY = _mm_loadu_ps(node.minY), minZ = _mm_loadu_ps(node.minZ);
+		const __m128 maxX = _mm_loadu_ps(node.maxX), maxY = _mm_loadu_ps(node.maxY), maxZ = _mm_loadu_ps(node.maxZ);
+		const __m128 centerX = _mm_mul_ps(_mm_add_ps(minX, maxX), half), extentX = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+		const __m128 centerY = _mm_mul_ps(_mm_add_ps(minY, maxY), half), extentY = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+		const __m128 centerZ = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half), extentZ = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+		__m128 outside = _mm_setzero_ps();
+		for (const Math::Plane& plane : frustum.planes)
+		{
+			const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.normal.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.normal.y))),
+				_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.normal.z)), _mm_set1_ps(plane.distance)));
+			const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(fabsf(plane.normal.x))), _mm_mul_ps(extentY, _mm_set1_ps(fabsf(plane.normal.y)))),
+				_mm_mul_ps(extentZ, _mm_set1_ps(fabsf(plane.normal.z))));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+		return ~_mm_movemask_ps(outside) & GetOccupiedMask(node);
+#else
+		int mask = 0;
+		for (uint i = 0; i < node.count; i++)
+		{
+			if (frustum.Intersects(Math::AABB(Math::Vector3D(node.minX[i], node.minY[i], node.minZ[i]), Math::Vector3D(node.maxX[i], node.maxY[i], node.maxZ[i]))))
+				mask |= 1 << i;
+		}
+		return mask;
+#endif
+	}
+
+	int Bvh::Overlap4(const BvhNode& node, const Math::AABB& box)
+	{
+#if MATH_SIMD_SSE2
+		__m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minX), _mm_set1_ps(box.max.x)), _mm_cmpge_ps(_mm_loadu_ps(node.maxX), _mm_set1_ps(box.min.x)));
+		overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minY), _mm_set1_ps(box.max.y)), _mm_cmpge_ps(_mm_loadu_ps(node.maxY), _mm_set1_ps(box.min.y))));
+		overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minZ), _mm_set1_ps(box.max.z)), _mm_cmpge_ps(_mm_loadu_ps(node.maxZ), _mm_set1_ps(box.min.z))));
+		return _mm_movemask_ps(overlap) & GetOccupiedMask(node);
+#else
+		int mask = 0;
+		for (uint i = 0; i < node.count; i++)
+		{
+			if (box.Overlaps(Math::AABB(Math::Vector3D(node.minX[i], node.minY[i], node.minZ[i]), Math::Vector3D(node.maxX[i], node.maxY[i], node.maxZ[i]))))
+				mask |= 1 << i;
+		}
+		return mask;
+#endif
+	}
+
+	int Bvh::DistanceSquared4(const BvhNode& node, const Math::Vector3D& point, float distances[4])
+	{
+#if MATH_SIMD_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 pointX = _mm_set1_ps(point.x), pointY = _mm_set1_ps(point.y), pointZ = _mm_set1_ps(point.z);
+		// Distance outside the box along each axis, 0 when within the slab
+		const __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), pointX), zero), _mm_max_ps(_mm_sub_ps(pointX, _mm_loadu_ps(node.maxX)), zero));
+		const __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), pointY), zero), _mm_max_ps(_mm_sub_ps(pointY, _mm_loadu_ps(node.maxY)), zero));
+		const __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), pointZ), zero), _mm_max_ps(_mm_sub_ps(pointZ, _mm_loadu_ps(node.maxZ)), zero));
+		_mm_storeu_ps(distances, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+#else
+		for (uint i = 0; i < 4; i++)
+		{
+			if (i < node.count)
+				distances[i] = Math::AABB(Math::Vector3D(node.minX[i], node.minY[i], node.minZ[i]), Math::Vector3D(node.maxX[i], node.maxY[i], node.maxZ[i])).DistanceSquared(point);
+		}
+#endif
+		return GetOccupiedMask(node);
+	}
+
+	template<typename F>
+	bool Bvh::Raycast(const Math::Ray& ray, float maxDistance, F&& intersect, BvhRayHit& hit) const
+	{
+		return RaycastProxies(ray, maxDistance, [this, &intersect](uint proxy, const Math::Ray& proxyRay, float proxyMaxDistance, float& distance)
+		{
+			return intersect(m_proxies[proxy].userData, proxyRay, proxyMaxDistance, distance);
+		}, hit);
+	}
+
+	template<typename F>
+	bool Bvh::RaycastProxies(const Math::Ray& ray, float maxDistance, const F& intersect, BvhRayHit& hit) const
+	{
+		const Math::Vector3D inverseDirection = ray.GetInverseDirection();
+		float closest = maxDistance;
+		uint closestProxy = INVALID_PROXY;
+
+		TraversalStack stack;
+		stack.Push(ROOT, 0.0f);
+		while (!stack.IsEmpty())
+		{
+			const StackEntry entry = stack.Pop();
+			if (entry.distance > closest)
+				continue;
+
+			const BvhNode& node = m_nodes[entry.child];
+			float distances[4];
+			int mask = IntersectRay4(node, ray, inverseDirection, closest, distances);
+
+			// Push the far children first so the nearest one is visited next
+			uint order[4];
+			uint orderCount = 0;
+			for (; mask != 0; mask &= mask - 1)
+			{
+				const uint slot = mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3;
+				uint position = orderCount++;
+				for (; position > 0 && distances[order[position - 1]] < distances[slot]; position--)
+					order[position] = order[position - 1];
+				order[position] = slot;
+			}
+
+			for (uint i = 0; i < orderCount; i++)
+			{
+				const uint slot = order[i];
+				const uint child = node.children[slot];
+				if (child & LEAF_BIT)
+				{
+					const uint proxy = child & ~LEAF_BIT;
+					float distance;
+					if (intersect(proxy, ray, closest, distance) && distance <= closest)
+					{
+						closest = distance;
+						closestProxy = proxy;
+					}
+				}
+				else
+					stack.Push(child, distances[slot]);
+			}
+		}
+
+		if (closestProxy == INVALID_PROXY)
+			return false;
+		hit = { closestProxy, m_proxies[closestProxy].userData, closest };
+		return true;
+	}
+
+	template<typename F>
+	void Bvh::QueryFrustum(const Math::Frustum& frustum, F&& f) const
+	{
+		TraversalStack stack;
+		stack.Push(ROOT, 0.0f);
+		while (!stack.IsEmpty())
+		{
+			const BvhNode& node = m_nodes[stack.Pop().child];
+			for (int mask = IntersectFrustum4(node, frustum); mask != 0; mask &= mask - 1)
+			{
+				const uint child = node.children[mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3];
+				if (child & LEAF_BIT)
+					f(m_proxies[child & ~LEAF_BIT].userData);
+				else
+					stack.Push(child, 0.0f);
+			}
+		}
+	}
+
+	template<typename F>
+	void Bvh::QueryAABB(const Math::AABB& box, F&& f) const
+	{
+		TraversalStack stack;
+		stack.Push(ROOT, 0.0f);
+		while (!stack.IsEmpty())
+		{
+			const BvhNode& node = m_nodes[stack.Pop().child];
+			for (int mask = Overlap4(node, box); mask != 0; mask &= mask - 1)
+			{
+				const uint child = node.children[mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3];
+				if (child & LEAF_BIT)
+					f(m_proxies[child & ~LEAF_BIT].userData);
+				else
+					stack.Push(child, 0.0f);
+			}
+		}
+	}
+}
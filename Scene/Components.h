@@ -0,0 +1,40 @@
+#pragma once
+#include "Math/Vector3D.h"
+#include "Math/Matrix4D.h"
+#include "Math/Quaternion.h"
+#include "Math/WorldPosition.h"
+#include "Memory/HandlePool.h"
+
+class Shader;
+class Texture;
+
+namespace Scene
+{
+	// Local placement of an entity. Turned into a WorldMatrix by TransformSystem.
+	struct Transform
+	{
+		Math::Vector3D position = Math::Vector3D(0.0f);
+		Math::Quaternion rotation;
+		Math::Vector3D scale = Math::Vector3D(1.0f);
+	};
+
+	// Double precision placement for entities far from the origin. Transform.position is
+	// then an offset from the anchor, and WorldMatrix is relative to the floating origin.
+	struct WorldAnchor
+	{
+		Math::WorldPosition position;
+	};
+
+	struct WorldMatrix
+	{
+		Math::Matrix4D matrix = Math::Matrix4D::Identity();
+	};
+
+	// Something to draw: which mesh, with which shader and texture.
+	struct Renderable
+	{
+		uint mesh = 0;
+		Memory::Handle<Shader> shader;
+		Memory::Handle<Texture> texture;
+	};
+}
@@ -0,0 +1,48 @@
+#include "Entity.h"
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+namespace Scene
+{
+	namespace
+	{
+		struct Registry
+		{
+			std::mutex mutex;
+			ComponentInfo components[MAX_COMPONENT_TYPES];
+			uint count = 0;
+		};
+
+		Registry& GetRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+	}
+
+	uint ComponentRegistry::Register(size_t size, size_t alignment, const char* name)
+	{
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (registry.count == MAX_COMPONENT_TYPES)
+		{
+			std::cout << "ERROR::ECS::TOO_MANY_COMPONENT_TYPES: " << name << std::endl;
+			std::abort();
+		}
+		registry.components[registry.count] = { size, alignment, name };
+		return registry.count++;
+	}
+
+	const ComponentInfo& ComponentRegistry::GetInfo(uint componentId)
+	{
+		return GetRegistry().components[componentId];
+	}
+
+	uint ComponentRegistry::GetCount()
+	{
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		return registry.count;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Misc/Typedefs.h"
+#include <bitset>
+#include <cstddef>
+#include <type_traits>
+#include <typeinfo>
+
+namespace Scene
+{
+	constexpr uint MAX_COMPONENT_TYPES = 64;
+
+	// Set of component types, one bit per component id.
+	using ComponentMask = std::bitset<MAX_COMPONENT_TYPES>;
+
+	// Index into the world's entity records plus the generation of that record when the entity was created.
+	struct Entity
+	{
+		uint index = 0;
+		uint generation = 0; // 0 is never used by a live entity
+
+		inline bool IsNull() const { return generation == 0; }
+		inline bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const Entity& other) const { return !(*this == other); }
+	};
+
+	struct ComponentInfo
+	{
+		size_t size;
+		size_t alignment;
+		const char* name;
+	};
+
+	namespace ComponentRegistry
+	{
+		// Assigns the next component id. Use GetComponentId<T>() instead.
+		uint Register(size_t size, size_t alignment, const char* name);
+		const ComponentInfo& GetInfo(uint componentId);
+		uint GetCount();
+	}
+
+	template<typename T>
+	struct ComponentTypeId
+	{
+		static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+			"ECS components must be plain data (trivially copyable and destructible)");
+
+		static uint Get()
+		{
+			static const uint id = ComponentRegistry::Register(sizeof(T), alignof(T), typeid(T).name());
+			return id;
+		}
+	};
+
+	/// <summary>
+	/// Runtime id of a component type, assigned on first use. 'const T' names the same component as T.
+	/// Components are plain data: they are moved between chunks with memcpy and never destructed.
+	/// </summary>
+	template<typename T>
+	inline uint GetComponentId()
+	{
+		return ComponentTypeId<typename std::remove_const<T>::type>::Get();
+	}
+
+	template<typename... Ts>
+	inline ComponentMask MakeComponentMask()
+	{
+		ComponentMask mask;
+		const uint ids[] = { GetComponentId<Ts>()..., 0 };
+		for (size_t i = 0; i < sizeof...(Ts); i++)
+			mask.set(ids[i]);
+		return mask;
+	}
+}
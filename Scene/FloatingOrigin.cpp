@@ -0,0 +1,36 @@
+#include "FloatingOrigin.h"
+#include "Graphics/Camera.h"
+
+namespace Scene
+{
+	FloatingOrigin::FloatingOrigin(float recenterDistance) :
+		m_recenterDistance(recenterDistance)
+	{
+	}
+
+	void FloatingOrigin::AddShiftListener(ShiftListener listener)
+	{
+		m_listeners.push_back(std::move(listener));
+	}
+
+	bool FloatingOrigin::Update(Camera& camera)
+	{
+		const Math::Vector3D location = camera.GetLocation();
+		if (Math::Vector3D::DotProduct(location, location) <= m_recenterDistance * m_recenterDistance)
+			return false;
+
+		const Math::Vector3D shift = Recenter(ToWorld(location));
+		camera.SetLocation(location - shift);
+		return true;
+	}
+
+	Math::Vector3D FloatingOrigin::Recenter(const Math::WorldPosition& position)
+	{
+		const Math::WorldPosition snapped(std::round(position.x), std::round(position.y), std::round(position.z));
+		const Math::Vector3D shift = snapped.RelativeTo(m_origin);
+		m_origin += shift;
+		for (const ShiftListener& listener : m_listeners)
+			listener(shift);
+		return shift;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Math/WorldPosition.h"
+#include <functional>
+#include <vector>
+
+class Camera;
+
+namespace Scene
+{
+	/*
+	* Keeps float coordinates small by moving the world origin along with the camera.
+	*
+	* Everything in float (Camera location, Transforms, the SceneGraph, the Bvh) lives in
+	* the frame of this double precision origin. Once the camera strays further than the
+	* recenter distance, the origin jumps to it and every listener moves its float data
+	* by the opposite amount, so precision near the camera never degrades. Far away data
+	* that must not drift keeps a WorldPosition and is converted with ToLocal.
+	*/
+	class FloatingOrigin
+	{
+	public:
+		// Receives the jump of the origin; float positions must have it subtracted.
+		using ShiftListener = std::function<void(const Math::Vector3D& shift)>;
+
+		explicit FloatingOrigin(float recenterDistance = 4096.0f);
+
+		inline const Math::WorldPosition& GetOrigin() const { return m_origin; }
+
+		inline Math::Vector3D ToLocal(const Math::WorldPosition& position) const { return position.RelativeTo(m_origin); }
+		inline Math::WorldPosition ToWorld(const Math::Vector3D& local) const { return m_origin + local; }
+
+		// E.g. [&graph](const Math::Vector3D& shift) { graph.ShiftOrigin(shift); }
+		void AddShiftListener(ShiftListener listener);
+
+		/// <summary>
+		/// Recenters on the camera if it is beyond the recenter distance. Call once per frame,
+		/// before building matrices.
+		/// </summary>
+		/// <returns>True if the origin moved.</returns>
+		bool Update(Camera& camera);
+
+		/// <summary>
+		/// Moves the origin close to position (snapped to whole units so shifts are exact
+		/// in float) and notifies the listeners. Does not move the camera.
+		/// </summary>
+		/// <returns>The shift applied.</returns>
+		Math::Vector3D Recenter(const Math::WorldPosition& position);
+
+	private:
+		Math::WorldPosition m_origin;
+		float m_recenterDistance;
+		std::vector<ShiftListener> m_listeners;
+	};
+}
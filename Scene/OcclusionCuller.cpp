@@ -0,0 +1,407 @@
+#include "OcclusionCuller.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include "Math/Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Scene
+{
+	namespace
+	{
+		// Occluder instances transformed per job
+		constexpr uint OCCLUDERS_PER_JOB = 8;
+	}
+
+	OcclusionCuller::OcclusionCuller(uint width, uint height)
+		: m_width((std::max(width, 4u) + 3) & ~3u), m_height(std::max(height, 1u))
+	{
+		m_tilesX = (m_width + TILE_WIDTH - 1) / TILE_WIDTH;
+		m_tilesY = (m_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+		m_bins.resize(m_tilesX * m_tilesY);
+
+		// Level l covers 2^l x 2^l pixels of level 0 per texel, down to a single texel
+		uint levelWidth = m_width, levelHeight = m_height;
+		for (;;)
+		{
+			m_levels.push_back({ levelWidth, levelHeight, Memory::CacheAlignedVector<float>(levelWidth * levelHeight, 0.0f) });
+			if (levelWidth == 1 && levelHeight == 1)
+				break;
+			levelWidth = (levelWidth + 1) / 2;
+			levelHeight = (levelHeight + 1) / 2;
+		}
+	}
+
+	uint OcclusionCuller::AddOccluderMesh(const Math::Vector3D* positions, uint vertexCount, const uint* indices, uint indexCount)
+	{
+		OccluderMesh mesh;
+		mesh.firstVertex = static_cast<uint>(m_positions.size());
+		mesh.vertexCount = vertexCount;
+		mesh.firstIndex = static_cast<uint>(m_indices.size());
+		mesh.indexCount = indexCount - indexCount % 3;
+		m_positions.insert(m_positions.end(), positions, positions + vertexCount);
+		m_indices.insert(m_indices.end(), indices, indices + mesh.indexCount);
+		m_meshes.push_back(mesh);
+		return static_cast<uint>(m_meshes.size()) - 1;
+	}
+
+	void OcclusionCuller::BeginFrame(const Math::Matrix4D& viewProjection)
+	{
+		m_viewProjection = viewProjection;
+		m_occluders.clear();
+	}
+
+	void OcclusionCuller::AddOccluder(uint mesh, const Math::Matrix4D& model)
+	{
+		m_occluders.push_back({ mesh, m_viewProjection * model });
+	}
+
+	void OcclusionCuller::Rasterize()
+	{
+		static Core::Profiler::Counter& timeCounter = Core::Profiler::GetCounter("Scene/Occlusion/RasterizeMicroseconds");
+		static Core::Profiler::Counter& triangleCounter = Core::Profiler::GetCounter("Scene/Occlusion/Triangles");
+		Core::ScopedTimer timer(timeCounter);
+
+		// Transform and clip the occluders, each thread into its own list
+		const uint threadCount = Core::JobSystem::GetThreadIndexCount();
+		m_threadClipPositions.resize(threadCount);
+		m_threadTriangles.resize(threadCount);
+		for (std::vector<ScreenTriangle>& triangles : m_threadTriangles)
+			triangles.clear();
+		Core::JobSystem::ParallelFor(static_cast<uint>(m_occluders.size()), OCCLUDERS_PER_JOB, [this](uint begin, uint end)
+		{
+			const uint thread = Core::JobSystem::GetThreadIndex();
+			for (uint i = begin; i < end; i++)
+				TransformOccluder(m_occluders[i], m_threadClipPositions[thread], m_threadTriangles[thread]);
+		});
+		m_triangles.clear();
+		for (const std::vector<ScreenTriangle>& triangles : m_threadTriangles)
+			m_triangles.insert(m_triangles.end(), triangles.begin(), triangles.end());
+
+		// Bin by bounding rectangle. Order within a bin does not matter: depth is combined with max.
+		for (std::vector<uint>& bin : m_bins)
+			bin.clear();
+		for (uint i = 0; i < m_triangles.size(); i++)
+		{
+			const ScreenTriangle& triangle = m_triangles[i];
+			const float minX = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+			const float maxX = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+			const float minY = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+			const float maxY = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+			// Clamped before converting: vertices near the camera project very far out
+			const float lastX = static_cast<float>(m_width - 1), lastY = static_cast<float>(m_height - 1);
+			if (maxX < 0.0f || maxY < 0.0f || minX > lastX || minY > lastY)
+				continue;
+			const uint tileX0 = static_cast<uint>(std::max(minX, 0.0f)) / TILE_WIDTH;
+			const uint tileX1 = static_cast<uint>(std::min(maxX, lastX)) / TILE_WIDTH;
+			const uint tileY0 = static_cast<uint>(std::max(minY, 0.0f)) / TILE_HEIGHT;
+			const uint tileY1 = static_cast<uint>(std::min(maxY, lastY)) / TILE_HEIGHT;
+			for (uint tileY = tileY0; tileY <= tileY1; tileY++)
+			{
+				for (uint tileX = tileX0; tileX <= tileX1; tileX++)
+					m_bins[tileY * m_tilesX + tileX].push_back(i);
+			}
+		}
+
+		// Tiles own disjoint pixels, so they rasterize without synchronization
+		Core::JobSystem::ParallelFor(m_tilesX * m_tilesY, 1, [this](uint begin, uint end)
+		{
+			for (uint tile = begin; tile < end; tile++)
+				RasterizeTile(tile);
+		});
+
+		BuildPyramid();
+		Core::Profiler::Set(triangleCounter, static_cast<long long>(m_triangles.size()));
+	}
+
+	void OcclusionCuller::TransformOccluder(const Occluder& occluder, std::vector<Math::Vector4D>& clipPositions, std::vector<ScreenTriangle>& triangles) const
+	{
+		const OccluderMesh& mesh = m_meshes[occluder.mesh];
+		clipPositions.resize(mesh.vertexCount);
+		for (uint i = 0; i < mesh.vertexCount; i++)
+		{
+			const Math::Vector3D& position = m_positions[mesh.firstVertex + i];
+			clipPositions[i] = occluder.modelViewProjection * Math::Vector4D(position.x, position.y, position.z, 1.0f);
+		}
+
+		const uint* indices = m_indices.data() + mesh.firstIndex;
+		for (uint i = 0; i < mesh.indexCount; i += 3)
+		{
+			const Math::Vector4D clip[3] = { clipPositions[indices[i]], clipPositions[indices[i + 1]], clipPositions[indices[i + 2]] };
+			EmitTriangle(clip, triangles);
+		}
+	}
+
+	void OcclusionCuller::EmitTriangle(const Math::Vector4D clip[3], std::vector<ScreenTriangle>& triangles) const
+	{
+		// Off screen on one side of a frustum side plane: nothing to draw
+		const auto allOutside = [clip](float sign, int axis)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				if (sign * (&clip[i].x)[axis] <= clip[i].w)
+					return false;
+			}
+			return true;
+		};
+		if (allOutside(1.0f, 0) || allOutside(-1.0f, 0) || allOutside(1.0f, 1) || allOutside(-1.0f, 1))
+			return;
+
+		// Clip against w >= MIN_W (a triangle becomes at most a quad)
+		Math::Vector4D polygon[4];
+		int count = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			const Math::Vector4D& a = clip[i];
+			const Math::Vector4D& b = clip[(i + 1) % 3];
+			const bool aInside = a.w >= MIN_W;
+			const bool bInside = b.w >= MIN_W;
+			if (aInside)
+				polygon[count++] = a;
+			if (aInside != bInside)
+				polygon[count++] = a + (b - a) * ((MIN_W - a.w) / (b.w - a.w));
+		}
+		if (count < 3)
+			return;
+
+		float x[4], y[4], z[4];
+		for (int i = 0; i < count; i++)
+		{
+			const float inverseW = 1.0f / polygon[i].w;
+			x[i] = (polygon[i].x * inverseW * 0.5f + 0.5f) * m_width;
+			y[i] = (polygon[i].y * inverseW * 0.5f + 0.5f) * m_height;
+			z[i] = inverseW;
+		}
+		for (int i = 1; i + 1 < count; i++)
+		{
+			const float area = (x[i] - x[0]) * (y[i + 1] - y[0]) - (x[i + 1] - x[0]) * (y[i] - y[0]);
+			if (area == 0.0f)
+				continue;
+			triangles.push_back({ { x[0], x[i], x[i + 1] }, { y[0], y[i], y[i + 1] }, { z[0], z[i], z[i + 1] } });
+		}
+	}
+
+	void OcclusionCuller::RasterizeTile(uint tile)
+	{
+		const int tileX0 = static_cast<int>((tile % m_tilesX) * TILE_WIDTH);
+		const int tileY0 = static_cast<int>((tile / m_tilesX) * TILE_HEIGHT);
+		const int tileX1 = std::min(tileX0 + static_cast<int>(TILE_WIDTH), static_cast<int>(m_width));
+		const int tileY1 = std::min(tileY0 + static_cast<int>(TILE_HEIGHT), static_cast<int>(m_height));
+		float* depth = m_levels[0].depth.data();
+
+		for (int y = tileY0; y < tileY1; y++)
+			std::fill(depth + y * m_width + tileX0, depth + y * m_width + tileX1, 0.0f);
+
+		for (uint index : m_bins[tile])
+		{
+			const ScreenTriangle& triangle = m_triangles[index];
+			const float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+			// Occluders are drawn double sided: flip the edges of clockwise triangles
+			const float sign = area > 0.0f ? 1.0f : -1.0f;
+			const float inverseArea = 1.0f / fabsf(area);
+
+			// Edge k runs from vertex k to k + 1 and is positive inside; it weighs the opposite vertex k + 2
+			float edgeA[3], edgeB[3];
+			for (int k = 0; k < 3; k++)
+			{
+				const int next = (k + 1) % 3;
+				edgeA[k] = (triangle.y[k] - triangle.y[next]) * sign;
+				edgeB[k] = (triangle.x[next] - triangle.x[k]) * sign;
+			}
+			// 1/w as a plane over the screen, relative to vertex 0
+			const float depthA = (edgeA[0] * triangle.z[2] + edgeA[1] * triangle.z[0] + edgeA[2] * triangle.z[1]) * inverseArea;
+			const float depthB = (edgeB[0] * triangle.z[2] + edgeB[1] * triangle.z[0] + edgeB[2] * triangle.z[1]) * inverseArea;
+			const float maxDepth = std::max(std::max(triangle.z[0], triangle.z[1]), triangle.z[2]);
+
+			const float minX = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+			const float maxX = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+			const float minY = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+			const float maxY = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+			// Groups of 4 pixels start at multiples of 4; tiles and the buffer width are multiples of 4 too
+			const int startX = static_cast<int>(std::floor(std::min(std::max(minX, static_cast<float>(tileX0)), static_cast<float>(tileX1)))) & ~3;
+			const int endX = static_cast<int>(std::ceil(std::max(std::min(maxX, static_cast<float>(tileX1)), static_cast<float>(tileX0))));
+			const int startY = static_cast<int>(std::floor(std::min(std::max(minY, static_cast<float>(tileY0)), static_cast<float>(tileY1))));
+			const int endY = static_cast<int>(std::ceil(std::max(std::min(maxY, static_cast<float>(tileY1)), static_cast<float>(tileY0))));
+
+#if MATH_SIMD_SSE2
+			const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 a0 = _mm_set1_ps(edgeA[0]), a1 = _mm_set1_ps(edgeA[1]), a2 = _mm_set1_ps(edgeA[2]);
+			const __m128 vDepthA = _mm_set1_ps(depthA), vMaxDepth = _mm_set1_ps(maxDepth);
+			for (int y = startY; y < endY; y++)
+			{
+				// Edge functions are evaluated relative to a vertex of the edge: large screen coordinates
+				// from triangles near the camera would otherwise cancel out the precision
+				const float pixelY = y + 0.5f;
+				const __m128 row0 = _mm_set1_ps(edgeB[0] * (pixelY - triangle.y[0]));
+				const __m128 row1 = _mm_set1_ps(edgeB[1] * (pixelY - triangle.y[1]));
+				const __m128 row2 = _mm_set1_ps(edgeB[2] * (pixelY - triangle.y[2]));
+				const __m128 rowDepth = _mm_set1_ps(triangle.z[0] + depthB * (pixelY - triangle.y[0]));
+				float* row = depth + y * m_width;
+				for (int x = startX; x < endX; x += 4)
+				{
+					const __m128 pixelX = _mm_add_ps(_mm_set1_ps(x + 0.5f), laneOffsets);
+					const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, _mm_sub_ps(pixelX, _mm_set1_ps(triangle.x[0]))), row0);
+					const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, _mm_sub_ps(pixelX, _mm_set1_ps(triangle.x[1]))), row1);
+					const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, _mm_sub_ps(pixelX, _mm_set1_ps(triangle.x[2]))), row2);
+					const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+					if (_mm_movemask_ps(inside) == 0)
+						continue;
+					const __m128 pixelDepth = _mm_min_ps(_mm_add_ps(rowDepth, _mm_mul_ps(vDepthA, _mm_sub_ps(pixelX, _mm_set1_ps(triangle.x[0])))), vMaxDepth);
+					const __m128 current = _mm_load_ps(row + x);
+					const __m128 nearest = _mm_max_ps(current, pixelDepth);
+					_mm_store_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+				}
+			}
+#else
+			for (int y = startY; y < endY; y++)
+			{
+				const float pixelY = y + 0.5f;
+				float* row = depth + y * m_width;
+				for (int x = startX; x < endX; x++)
+				{
+					const float pixelX = x + 0.5f;
+					bool inside = true;
+					for (int k = 0; k < 3; k++)
+						inside &= edgeA[k] * (pixelX - triangle.x[k]) + edgeB[k] * (pixelY - triangle.y[k]) >= 0.0f;
+					if (inside)
+					{
+						// Row term first, as the SSE path adds it: both give the same bits
+						const float pixelDepth = std::min(triangle.z[0] + depthB * (pixelY - triangle.y[0]) + depthA * (pixelX - triangle.x[0]), maxDepth);
+						row[x] = std::max(row[x], pixelDepth);
+					}
+				}
+			}
+#endif
+		}
+	}
+
+	void OcclusionCuller::BuildPyramid()
+	{
+		// Farthest (smallest 1/w) of each 2x2 block; odd edges repeat their last texel
+		for (uint level = 1; level < m_levels.size(); level++)
+		{
+			const Level& source = m_levels[level - 1];
+			Level& destination = m_levels[level];
+			for (uint y = 0; y < destination.height; y++)
+			{
+				const float* row0 = source.depth.data() + std::min(2 * y, source.height - 1) * source.width;
+				const float* row1 = source.depth.data() + std::min(2 * y + 1, source.height - 1) * source.width;
+				float* out = destination.depth.data() + y * destination.width;
+				for (uint x = 0; x < destination.width; x++)
+				{
+					const uint x0 = std::min(2 * x, source.width - 1), x1 = std::min(2 * x + 1, source.width - 1);
+					out[x] = std::min(std::min(row0[x0], row0[x1]), std::min(row1[x0], row1[x1]));
+				}
+			}
+		}
+	}
+
+	bool OcclusionCuller::IsVisible(const Math::AABB& box) const
+	{
+		if (box.IsEmpty())
+			return false;
+
+		// w is affine in the position, so the nearest point of the box is one of its corners.
+		// Corners are the clip position of min plus any of the three edge vectors.
+		const Math::Matrix4D& m = m_viewProjection;
+		const Math::Vector3D size = box.max - box.min;
+		float minX, maxX, minY, maxY, nearest;
+#if MATH_SIMD_SSE2
+		// Corners 0-3 and 4-7 (the latter offset along z) in two registers per clip component
+		const __m128 selectX = _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f), selectY = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+		const auto corners = [&box, &size, selectX, selectY](float c0, float c1, float c2, float c3, __m128& low, __m128& high)
+		{
+			const float base = c0 * box.min.x + c1 * box.min.y + c2 * box.min.z + c3;
+			low = _mm_add_ps(_mm_set1_ps(base), _mm_add_ps(_mm_mul_ps(selectX, _mm_set1_ps(c0 * size.x)), _mm_mul_ps(selectY, _mm_set1_ps(c1 * size.y))));
+			high = _mm_add_ps(low, _mm_set1_ps(c2 * size.z));
+		};
+		__m128 xLow, xHigh, yLow, yHigh, wLow, wHigh;
+		corners(m.r0c0, m.r0c1, m.r0c2, m.r0c3, xLow, xHigh);
+		corners(m.r1c0, m.r1c1, m.r1c2, m.r1c3, yLow, yHigh);
+		corners(m.r3c0, m.r3c1, m.r3c2, m.r3c3, wLow, wHigh);
+		// Reaching behind the camera: the projected rectangle is unbounded
+		if (_mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(wLow, _mm_set1_ps(MIN_W)), _mm_cmplt_ps(wHigh, _mm_set1_ps(MIN_W)))) != 0)
+			return true;
+
+		const __m128 one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+		const __m128 inverseLow = _mm_div_ps(one, wLow), inverseHigh = _mm_div_ps(one, wHigh);
+		const __m128 scaleX = _mm_set1_ps(static_cast<float>(m_width)), scaleY = _mm_set1_ps(static_cast<float>(m_height));
+		const auto toScreen = [half](__m128 clip, __m128 inverseW, __m128 scale)
+		{
+			return _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip, inverseW), half), half), scale);
+		};
+		const __m128 screenXLow = toScreen(xLow, inverseLow, scaleX), screenXHigh = toScreen(xHigh, inverseHigh, scaleX);
+		const __m128 screenYLow = toScreen(yLow, inverseLow, scaleY), screenYHigh = toScreen(yHigh, inverseHigh, scaleY);
+		const auto horizontalMin = [](__m128 v)
+		{
+			v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtss_f32(_mm_min_ss(v, _mm_movehl_ps(v, v)));
+		};
+		const auto horizontalMax = [](__m128 v)
+		{
+			v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtss_f32(_mm_max_ss(v, _mm_movehl_ps(v, v)));
+		};
+		minX = horizontalMin(_mm_min_ps(screenXLow, screenXHigh));
+		maxX = horizontalMax(_mm_max_ps(screenXLow, screenXHigh));
+		minY = horizontalMin(_mm_min_ps(screenYLow, screenYHigh));
+		maxY = horizontalMax(_mm_max_ps(screenYLow, screenYHigh));
+		nearest = horizontalMax(_mm_max_ps(inverseLow, inverseHigh));
+#else
+		minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX, nearest = 0.0f;
+		for (int i = 0; i < 8; i++)
+		{
+			const Math::Vector4D corner((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z, 1.0f);
+			const Math::Vector4D clip = m * corner;
+			// Reaching behind the camera: the projected rectangle is unbounded
+			if (clip.w < MIN_W)
+				return true;
+			const float inverseW = 1.0f / clip.w;
+			const float x = (clip.x * inverseW * 0.5f + 0.5f) * m_width;
+			const float y = (clip.y * inverseW * 0.5f + 0.5f) * m_height;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			nearest = std::max(nearest, inverseW);
+		}
+#endif
+		if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height)
+			return false;
+
+		// Covered pixels of level 0, then the finest level where they span at most 4x4 texels:
+		// coarser levels reach further past the box and keep more hidden boxes visible
+		const uint x0 = static_cast<uint>(std::max(minX, 0.0f)), x1 = static_cast<uint>(std::min(maxX, static_cast<float>(m_width - 1)));
+		const uint y0 = static_cast<uint>(std::max(minY, 0.0f)), y1 = static_cast<uint>(std::min(maxY, static_cast<float>(m_height - 1)));
+		uint level = 0;
+		while (level + 1 < m_levels.size() && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3))
+			level++;
+
+		const Level& hiZ = m_levels[level];
+		float farthest = FLT_MAX;
+		for (uint y = y0 >> level; y <= (y1 >> level); y++)
+		{
+			for (uint x = x0 >> level; x <= (x1 >> level); x++)
+				farthest = std::min(farthest, hiZ.depth[y * hiZ.width + x]);
+		}
+		return nearest >= farthest;
+	}
+
+	uint OcclusionCuller::FilterVisible(const Math::AABB* boxes, uint count, uint* visible) const
+	{
+		static Core::Profiler::Counter& testedCounter = Core::Profiler::GetCounter("Scene/Occlusion/TestedBoxes");
+		static Core::Profiler::Counter& culledCounter = Core::Profiler::GetCounter("Scene/Occlusion/CulledBoxes");
+
+		uint visibleCount = 0;
+		for (uint i = 0; i < count; i++)
+		{
+			visible[visibleCount] = i;
+			visibleCount += IsVisible(boxes[i]) ? 1 : 0;
+		}
+		Core::Profiler::Add(testedCounter, count);
+		Core::Profiler::Add(culledCounter, count - visibleCount);
+		return visibleCount;
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "Math/AABB.h"
+#include "Math/Matrix4D.h"
+#include "Memory/AlignedAllocator.h"
+#include "Misc/Typedefs.h"
+#include <vector>
+
+namespace Scene
+{
+	/*
+	* Software occlusion culling for perspective views.
+	*
+	* Designated occluder meshes (a few large, closed, low-poly stand-ins for walls and
+	* floors) are rasterized each frame into a small depth buffer on the CPU: triangles are
+	* binned into screen tiles and the tiles are filled in parallel on the job system, four
+	* pixels per SSE instruction. A hierarchical-Z pyramid (each texel the farthest depth of
+	* the 2x2 texels below it) is then built, and object boxes are tested against the level
+	* where they cover at most 4x4 texels.
+	*
+	* Depth is stored as 1/w (view depth), which interpolates linearly in screen space and
+	* works for every projection depth convention (reversed-Z, infinite far) alike;
+	* 0 means nothing rasterized. Tests are conservative: a box is only culled if every
+	* texel it covers holds an occluder nearer than the box's nearest corner.
+	*
+	* Usage per frame: BeginFrame, AddOccluder for each occluder instance, Rasterize, then
+	* IsVisible / FilterVisible (read-only, may run concurrently).
+	*/
+	class OcclusionCuller
+	{
+	public:
+		static constexpr uint TILE_WIDTH = 64;
+		static constexpr uint TILE_HEIGHT = 32;
+
+		/// <summary>
+		/// Creates the depth buffer. Low resolutions are the point: 256 x 128 is enough to cull
+		/// anything but thin gaps.
+		/// </summary>
+		/// <param name="width">Width in pixels, rounded up to a multiple of 4.</param>
+		explicit OcclusionCuller(uint width = 256, uint height = 128);
+
+		/// <summary>
+		/// Registers an occluder mesh, in its local space. Should be closed and lie within the
+		/// object it stands for, or it will hide things that are actually visible.
+		/// </summary>
+		/// <param name="indices">Triangle list, three indices per triangle.</param>
+		/// <returns>Id to pass to AddOccluder.</returns>
+		uint AddOccluderMesh(const Math::Vector3D* positions, uint vertexCount, const uint* indices, uint indexCount);
+
+		// Forgets the occluders of the previous frame
+		void BeginFrame(const Math::Matrix4D& viewProjection);
+
+		// Queues an instance of a registered occluder mesh for this frame
+		void AddOccluder(uint mesh, const Math::Matrix4D& model);
+
+		// Rasterizes the queued occluders and builds the Hi-Z pyramid
+		void Rasterize();
+
+		// False only if the box is certainly hidden by the occluders (or entirely off screen)
+		bool IsVisible(const Math::AABB& box) const;
+
+		/// <summary>
+		/// Tests many boxes, e.g. the survivors of frustum culling.
+		/// </summary>
+		/// <param name="visible">Receives the indices of the visible boxes, in order. Needs room for count indices.</param>
+		/// <returns>The number of visible boxes.</returns>
+		uint FilterVisible(const Math::AABB* boxes, uint count, uint* visible) const;
+
+		inline uint GetWidth() const { return m_width; }
+		inline uint GetHeight() const { return m_height; }
+		inline uint GetLevelCount() const { return static_cast<uint>(m_levels.size()); }
+
+		// 1/w per texel, row 0 at the bottom of the screen. Level 0 is the rasterized buffer.
+		inline const float* GetLevel(uint level) const { return m_levels[level].depth.data(); }
+		inline uint GetLevelWidth(uint level) const { return m_levels[level].width; }
+		inline uint GetLevelHeight(uint level) const { return m_levels[level].height; }
+
+	private:
+		// Clip space w below this is clipped away (triangles) or considered visible (boxes)
+		static constexpr float MIN_W = 1e-4f;
+
+		struct OccluderMesh
+		{
+			uint firstVertex;
+			uint vertexCount;
+			uint firstIndex;
+			uint indexCount;
+		};
+
+		struct Occluder
+		{
+			uint mesh;
+			Math::Matrix4D modelViewProjection;
+		};
+
+		// Screen space pixels, z = 1/w
+		struct ScreenTriangle
+		{
+			float x[3], y[3], z[3];
+		};
+
+		struct Level
+		{
+			uint width, height;
+			Memory::CacheAlignedVector<float> depth;
+		};
+
+		void TransformOccluder(const Occluder& occluder, std::vector<Math::Vector4D>& clipPositions, std::vector<ScreenTriangle>& triangles) const;
+		void EmitTriangle(const Math::Vector4D clip[3], std::vector<ScreenTriangle>& triangles) const;
+		void RasterizeTile(uint tile);
+		void BuildPyramid();
+
+		uint m_width;
+		uint m_height;
+		uint m_tilesX;
+		uint m_tilesY;
+		Math::Matrix4D m_viewProjection;
+
+		std::vector<Math::Vector3D> m_positions;
+		std::vector<uint> m_indices;
+		std::vector<OccluderMesh> m_meshes;
+		std::vector<Occluder> m_occluders;
+
+		// Per thread scratch and output of the transform stage, indexed by JobSystem::GetThreadIndex
+		std::vector<std::vector<Math::Vector4D>> m_threadClipPositions;
+		std::vector<std::vector<ScreenTriangle>> m_threadTriangles;
+		std::vector<ScreenTriangle> m_triangles;
+		// Triangle indices overlapping each tile
+		std::vector<std::vector<uint>> m_bins;
+		std::vector<Level> m_levels;
+	};
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "Bvh.h"
+#include "Graphics/Camera.h"
+
+namespace Scene
+{
+	/// <summary>
+	/// Finds the object under the cursor by casting a camera ray through the BVH.
+	/// </summary>
+	/// <param name="cursorX">Cursor position in pixels from the left edge.</param>
+	/// <param name="cursorY">Cursor position in pixels from the top edge.</param>
+	/// <param name="hit">The closest proxy box hit.</param>
+	/// <returns>False if the cursor is over empty space.</returns>
+	inline bool PickObject(const Bvh& bvh, const Camera& camera, float cursorX, float cursorY, float viewportWidth, float viewportHeight,
+		BvhRayHit& hit, float maxDistance = FLT_MAX)
+	{
+		return bvh.Raycast(camera.ScreenPointToRay(cursorX, cursorY, viewportWidth, viewportHeight), maxDistance, hit);
+	}
+
+	// Same, refining each candidate box with intersect (see Bvh::Raycast)
+	template<typename F>
+	inline bool PickObject(const Bvh& bvh, const Camera& camera, float cursorX, float cursorY, float viewportWidth, float viewportHeight,
+		F&& intersect, BvhRayHit& hit, float maxDistance = FLT_MAX)
+	{
+		return bvh.Raycast(camera.ScreenPointToRay(cursorX, cursorY, viewportWidth, viewportHeight), maxDistance, intersect, hit);
+	}
+}
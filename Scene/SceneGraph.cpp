@@ -0,0 +1,234 @@
+#include "SceneGraph.h"
+#include "Core/JobSystem.h"
+#include <algorithm>
+#include <atomic>
+
+namespace Scene
+{
+	SceneGraph::SceneGraph(uint reserve)
+	{
+		m_parents.reserve(reserve);
+		m_locals.reserve(reserve);
+		m_worlds.reserve(reserve);
+		m_dirty.reserve(reserve);
+		m_denseToRecord.reserve(reserve);
+		m_records.reserve(reserve);
+	}
+
+	SceneNode SceneGraph::CreateNode(const Transform& local, SceneNode parent)
+	{
+		if (!parent.IsNull() && !IsValid(parent))
+			return SceneNode();
+
+		uint index;
+		if (m_freeRecord != INVALID_INDEX)
+		{
+			index = m_freeRecord;
+			m_freeRecord = m_records[index].dense;
+		}
+		else
+		{
+			index = static_cast<uint>(m_records.size());
+			m_records.push_back({ INVALID_INDEX, 1, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX });
+		}
+
+		// Appended for now, moved to its breadth first position by the next Update
+		NodeRecord& record = m_records[index];
+		record.dense = static_cast<uint>(m_parents.size());
+		m_parents.push_back(parent.IsNull() ? INVALID_INDEX : m_records[parent.index].dense);
+		m_locals.push_back(local);
+		m_worlds.push_back(Math::Matrix4D::Identity());
+		m_dirty.push_back(1);
+		m_denseToRecord.push_back(index);
+
+		LinkChild(index, parent.IsNull() ? INVALID_INDEX : parent.index);
+		m_liveCount++;
+		m_orderDirty = true;
+		return { index, record.generation };
+	}
+
+	void SceneGraph::DestroyNode(SceneNode node)
+	{
+		if (!IsValid(node))
+			return;
+
+		UnlinkChild(node.index);
+
+		std::vector<uint> stack(1, node.index);
+		while (!stack.empty())
+		{
+			const uint index = stack.back();
+			stack.pop_back();
+
+			NodeRecord& record = m_records[index];
+			for (uint child = record.firstChild; child != INVALID_INDEX; child = m_records[child].nextSibling)
+				stack.push_back(child);
+
+			m_denseToRecord[record.dense] = INVALID_INDEX;
+			record.generation = record.generation + 1 != 0 ? record.generation + 1 : 1;
+			record.parent = record.firstChild = record.nextSibling = record.previousSibling = INVALID_INDEX;
+			record.dense = m_freeRecord;
+			m_freeRecord = index;
+			m_liveCount--;
+		}
+		m_orderDirty = true;
+	}
+
+	bool SceneGraph::SetParent(SceneNode node, SceneNode parent)
+	{
+		if (!IsValid(node) || (!parent.IsNull() && !IsValid(parent)))
+			return false;
+
+		// Refuse to create a cycle
+		for (uint ancestor = parent.IsNull() ? INVALID_INDEX : parent.index; ancestor != INVALID_INDEX; ancestor = m_records[ancestor].parent)
+		{
+			if (ancestor == node.index)
+				return false;
+		}
+
+		UnlinkChild(node.index);
+		LinkChild(node.index, parent.IsNull() ? INVALID_INDEX : parent.index);
+		m_dirty[m_records[node.index].dense] = 1;
+		m_orderDirty = true;
+		return true;
+	}
+
+	SceneNode SceneGraph::GetParent(SceneNode node) const
+	{
+		if (!IsValid(node))
+			return SceneNode();
+		const uint parent = m_records[node.index].parent;
+		if (parent == INVALID_INDEX)
+			return SceneNode();
+		return { parent, m_records[parent].generation };
+	}
+
+	void SceneGraph::Update(uint nodesPerJob)
+	{
+		if (m_orderDirty)
+			RebuildOrder();
+
+		std::atomic<uint> updated{ 0 };
+		for (size_t level = 0; level + 1 < m_levelStarts.size(); level++)
+		{
+			const uint levelBegin = m_levelStarts[level];
+			const uint levelEnd = m_levelStarts[level + 1];
+
+			// Parents live in the previous depth, which is complete by now
+			Core::JobSystem::ParallelFor(levelEnd - levelBegin, nodesPerJob, [this, levelBegin, &updated](uint begin, uint end)
+			{
+				uint count = 0;
+				for (uint i = levelBegin + begin; i < levelBegin + end; i++)
+				{
+					const uint parent = m_parents[i];
+					if (parent != INVALID_INDEX && m_dirty[parent])
+						m_dirty[i] = 1;
+					if (!m_dirty[i])
+						continue;
+
+					const Transform& local = m_locals[i];
+					const Math::Matrix4D localMatrix = Math::MakeTRS(local.position, local.rotation, local.scale);
+					m_worlds[i] = parent == INVALID_INDEX ? localMatrix : m_worlds[parent] * localMatrix;
+					count++;
+				}
+				updated.fetch_add(count, std::memory_order_relaxed);
+			});
+		}
+
+		std::fill(m_dirty.begin(), m_dirty.end(), static_cast<uchar>(0));
+		m_updatedCount = updated.load();
+	}
+
+	void SceneGraph::ShiftOrigin(const Math::Vector3D& shift)
+	{
+		// Children are relative to their parent and follow on the next Update
+		for (size_t i = 0; i < m_parents.size(); i++)
+		{
+			if (m_parents[i] != INVALID_INDEX || m_denseToRecord[i] == INVALID_INDEX)
+				continue;
+			m_locals[i].position -= shift;
+			m_dirty[i] = 1;
+		}
+	}
+
+	void SceneGraph::LinkChild(uint record, uint parent)
+	{
+		NodeRecord& node = m_records[record];
+		node.parent = parent;
+		node.previousSibling = INVALID_INDEX;
+		node.nextSibling = INVALID_INDEX;
+		if (parent == INVALID_INDEX)
+			return;
+
+		NodeRecord& parentNode = m_records[parent];
+		node.nextSibling = parentNode.firstChild;
+		if (parentNode.firstChild != INVALID_INDEX)
+			m_records[parentNode.firstChild].previousSibling = record;
+		parentNode.firstChild = record;
+	}
+
+	void SceneGraph::UnlinkChild(uint record)
+	{
+		NodeRecord& node = m_records[record];
+		if (node.parent == INVALID_INDEX)
+			return;
+
+		if (node.previousSibling != INVALID_INDEX)
+			m_records[node.previousSibling].nextSibling = node.nextSibling;
+		else
+			m_records[node.parent].firstChild = node.nextSibling;
+		if (node.nextSibling != INVALID_INDEX)
+			m_records[node.nextSibling].previousSibling = node.previousSibling;
+
+		node.parent = node.previousSibling = node.nextSibling = INVALID_INDEX;
+	}
+
+	void SceneGraph::RebuildOrder()
+	{
+		// Breadth first walk from the roots, which keep their current relative order
+		std::vector<uint> order;
+		order.reserve(m_liveCount);
+		for (uint record : m_denseToRecord)
+		{
+			if (record != INVALID_INDEX && m_records[record].parent == INVALID_INDEX)
+				order.push_back(record);
+		}
+
+		m_levelStarts.clear();
+		m_levelStarts.push_back(0);
+		size_t levelBegin = 0;
+		while (levelBegin < order.size())
+		{
+			const size_t levelEnd = order.size();
+			for (size_t i = levelBegin; i < levelEnd; i++)
+			{
+				for (uint child = m_records[order[i]].firstChild; child != INVALID_INDEX; child = m_records[child].nextSibling)
+					order.push_back(child);
+			}
+			m_levelStarts.push_back(static_cast<uint>(order.size()));
+			levelBegin = levelEnd;
+		}
+
+		std::vector<uint> parents(order.size());
+		std::vector<Transform> locals(order.size());
+		std::vector<Math::Matrix4D> worlds(order.size());
+		std::vector<uchar> dirty(order.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			NodeRecord& record = m_records[order[i]];
+			locals[i] = m_locals[record.dense];
+			worlds[i] = m_worlds[record.dense];
+			dirty[i] = m_dirty[record.dense];
+			// The parent precedes the node in the new order, so its dense index is already remapped
+			parents[i] = record.parent == INVALID_INDEX ? INVALID_INDEX : m_records[record.parent].dense;
+			record.dense = static_cast<uint>(i);
+		}
+
+		m_parents.swap(parents);
+		m_locals.swap(locals);
+		m_worlds.swap(worlds);
+		m_dirty.swap(dirty);
+		m_denseToRecord.swap(order);
+		m_orderDirty = false;
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "Components.h"
+#include "Memory/HandlePool.h"
+#include <vector>
+
+namespace Scene
+{
+	class SceneGraph;
+	using SceneNode = Memory::Handle<SceneGraph>;
+
+	/*
+	* Parent/child transform hierarchy.
+	*
+	* Nodes are kept in flat arrays sorted breadth first, so every parent comes before
+	* its children and the nodes of one depth are contiguous. Update walks the arrays
+	* once per depth: a node is recomputed only if it or an ancestor changed since the
+	* last update, and each depth is split across the job system.
+	*
+	* Handles stay valid while the arrays are reordered. Structural changes (create,
+	* destroy, reparent) are batched and the order is rebuilt on the next Update.
+	*/
+	class SceneGraph
+	{
+	public:
+		explicit SceneGraph(uint reserve = 0);
+
+		/// <summary>
+		/// Adds a node under parent (or as a root if parent is null).
+		/// </summary>
+		/// <returns>A null handle if parent is stale.</returns>
+		SceneNode CreateNode(const Transform& local = Transform(), SceneNode parent = SceneNode());
+
+		// Destroys the node and its whole subtree.
+		void DestroyNode(SceneNode node);
+
+		// Moves the node (with its subtree) under parent, or makes it a root if parent is null.
+		// Returns false if either handle is stale or parent is inside the node's subtree.
+		bool SetParent(SceneNode node, SceneNode parent);
+
+		SceneNode GetParent(SceneNode node) const;
+
+		inline bool IsValid(SceneNode node) const
+		{
+			return !node.IsNull() && node.index < m_records.size() && m_records[node.index].generation == node.generation;
+		}
+
+		// Stale handles are accepted by the three accessors below: the getters return the identity, the setter does nothing
+		inline const Transform& GetLocalTransform(SceneNode node) const
+		{
+			static const Transform IDENTITY;
+			return IsValid(node) ? m_locals[m_records[node.index].dense] : IDENTITY;
+		}
+
+		// Marks the node (and so its subtree) for recomputation on the next Update
+		inline void SetLocalTransform(SceneNode node, const Transform& local)
+		{
+			if (!IsValid(node))
+				return;
+			const uint dense = m_records[node.index].dense;
+			m_locals[dense] = local;
+			m_dirty[dense] = 1;
+		}
+
+		// World matrix as of the last Update
+		inline const Math::Matrix4D& GetWorldMatrix(SceneNode node) const
+		{
+			static const Math::Matrix4D IDENTITY;
+			return IsValid(node) ? m_worlds[m_records[node.index].dense] : IDENTITY;
+		}
+
+		/// <summary>
+		/// Rebuilds the breadth first order if the hierarchy changed, then recomputes
+		/// the world matrix of every changed node and its descendants.
+		/// </summary>
+		/// <param name="nodesPerJob">Grain size of the parallel loop over each depth.</param>
+		void Update(uint nodesPerJob = 2048);
+
+		// Moves every root by -shift when the floating origin recenters (see FloatingOrigin).
+		void ShiftOrigin(const Math::Vector3D& shift);
+
+		inline uint GetNodeCount() const { return m_liveCount; }
+		inline uint GetDepthCount() const { return m_levelStarts.empty() ? 0 : static_cast<uint>(m_levelStarts.size()) - 1; }
+		// Nodes recomputed by the last Update
+		inline uint GetUpdatedCount() const { return m_updatedCount; }
+
+	private:
+		struct NodeRecord
+		{
+			uint dense;				// Index in the sorted arrays, next free record while unused
+			uint generation;
+			uint parent;			// Record index, INVALID_INDEX for roots
+			uint firstChild;
+			uint nextSibling;
+			uint previousSibling;
+		};
+
+		static constexpr uint INVALID_INDEX = 0xFFFFFFFF;
+
+		// Sorted breadth first, indexed by dense index
+		std::vector<uint> m_parents;			// Dense index of the parent, INVALID_INDEX for roots
+		std::vector<Transform> m_locals;
+		std::vector<Math::Matrix4D> m_worlds;
+		std::vector<uchar> m_dirty;
+		std::vector<uint> m_denseToRecord;		// INVALID_INDEX for destroyed nodes awaiting the rebuild
+		std::vector<uint> m_levelStarts;		// First dense index of each depth, plus the end
+
+		std::vector<NodeRecord> m_records;
+		uint m_freeRecord = INVALID_INDEX;
+		uint m_liveCount = 0;
+		uint m_updatedCount = 0;
+		bool m_orderDirty = false;
+
+		void LinkChild(uint record, uint parent);
+		void UnlinkChild(uint record);
+		void RebuildOrder();
+	};
+}
@@ -0,0 +1,41 @@
+#include "SystemScheduler.h"
+#include "Core/JobSystem.h"
+
+namespace Scene
+{
+	void SystemScheduler::AddSystem(const char* name, const ComponentMask& reads, const ComponentMask& writes, SystemFunction function)
+	{
+		m_systems.push_back({ name, reads, writes, std::move(function) });
+	}
+
+	void SystemScheduler::Run(World& world)
+	{
+		size_t batchStart = 0;
+		while (batchStart < m_systems.size())
+		{
+			// Grow the batch while the next system does not conflict with any system already in it
+			ComponentMask batchReads = m_systems[batchStart].reads;
+			ComponentMask batchWrites = m_systems[batchStart].writes;
+			size_t batchEnd = batchStart + 1;
+			for (; batchEnd < m_systems.size(); batchEnd++)
+			{
+				const System& system = m_systems[batchEnd];
+				if ((system.writes & (batchReads | batchWrites)).any() || (system.reads & batchWrites).any())
+					break;
+				batchReads |= system.reads;
+				batchWrites |= system.writes;
+			}
+
+			Core::JobCounter counter;
+			for (size_t i = batchStart + 1; i < batchEnd; i++)
+			{
+				SystemFunction& function = m_systems[i].function;
+				Core::JobSystem::Execute(counter, [&function, &world] { function(world); });
+			}
+			m_systems[batchStart].function(world);
+			Core::JobSystem::Wait(counter);
+
+			batchStart = batchEnd;
+		}
+	}
+}
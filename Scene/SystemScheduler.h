@@ -0,0 +1,42 @@
+#pragma once
+#include "Entity.h"
+#include <functional>
+#include <vector>
+
+namespace Scene
+{
+	class World;
+
+	/*
+	* Runs systems in registration order, executing consecutive systems in parallel
+	* when their component accesses do not conflict (no write/write or read/write
+	* overlap). Systems must not make structural changes to the world while it runs.
+	*/
+	class SystemScheduler
+	{
+	public:
+		using SystemFunction = std::function<void(World&)>;
+
+		/// <summary>
+		/// Registers a system.
+		/// </summary>
+		/// <param name="name">For debugging and profiling.</param>
+		/// <param name="reads">Components the system only reads (see MakeComponentMask).</param>
+		/// <param name="writes">Components the system modifies.</param>
+		/// <param name="function">Called once per Run with the world.</param>
+		void AddSystem(const char* name, const ComponentMask& reads, const ComponentMask& writes, SystemFunction function);
+
+		void Run(World& world);
+
+	private:
+		struct System
+		{
+			const char* name;
+			ComponentMask reads;
+			ComponentMask writes;
+			SystemFunction function;
+		};
+
+		std::vector<System> m_systems;
+	};
+}
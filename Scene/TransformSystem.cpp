@@ -0,0 +1,26 @@
+#include "TransformSystem.h"
+
+namespace Scene
+{
+	void TransformSystem::Update(const Math::WorldPosition& origin)
+	{
+		m_query.ParallelForEachChunk([](uint count, const Entity*, const Transform* transforms, WorldMatrix* worlds)
+		{
+			for (uint i = 0; i < count; i++)
+				worlds[i].matrix = Math::MakeTRS(transforms[i].position, transforms[i].rotation, transforms[i].scale);
+		});
+
+		// Anchored entities were matched above too, only their translation needs the anchor
+		m_anchoredQuery.ParallelForEachChunk([&origin](uint count, const Entity*, const Transform*, const WorldAnchor* anchors, WorldMatrix* worlds)
+		{
+			for (uint i = 0; i < count; i++)
+			{
+				const Math::Vector3D offset = anchors[i].position.RelativeTo(origin);
+				Math::Matrix4D& matrix = worlds[i].matrix;
+				matrix.r0c3 += offset.x;
+				matrix.r1c3 += offset.y;
+				matrix.r2c3 += offset.z;
+			}
+		});
+	}
+}
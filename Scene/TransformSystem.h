@@ -0,0 +1,27 @@
+#pragma once
+#include "World.h"
+#include "Components.h"
+
+namespace Scene
+{
+	/*
+	* Recomputes the WorldMatrix of every entity that also has a Transform.
+	* Chunks are processed in parallel on the job system.
+	*/
+	class TransformSystem
+	{
+	public:
+		explicit TransformSystem(World& world) : m_query(world), m_anchoredQuery(world) {}
+
+		/// <summary>
+		/// Recomputes the world matrices.
+		/// </summary>
+		/// <param name="origin">Floating origin: entities with a WorldAnchor are placed at
+		/// anchor - origin, computed in double before narrowing to float.</param>
+		void Update(const Math::WorldPosition& origin = Math::WorldPosition());
+
+	private:
+		Query<const Transform, WorldMatrix> m_query;
+		Query<const Transform, const WorldAnchor, WorldMatrix> m_anchoredQuery;
+	};
+}
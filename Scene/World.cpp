@@ -0,0 +1,94 @@
+#include "World.h"
+
+namespace Scene
+{
+	namespace
+	{
+		constexpr size_t CHUNKS_PER_PAGE = 64;
+	}
+
+	World::World() : m_chunkPool(CHUNK_SIZE, CHUNKS_PER_PAGE, CHUNK_ALIGNMENT)
+	{
+	}
+
+	World::~World()
+	{
+		// Archetypes return their chunks to the pool, destroy them first
+		m_archetypes.clear();
+	}
+
+	void World::DestroyEntity(Entity entity)
+	{
+		if (!IsAlive(entity))
+			return;
+
+		EntityRecord& record = m_records[entity.index];
+		const Entity moved = record.archetype->RemoveRow(record.chunk, record.row);
+		if (!moved.IsNull())
+		{
+			m_records[moved.index].chunk = record.chunk;
+			m_records[moved.index].row = record.row;
+		}
+
+		record.archetype = nullptr;
+		record.generation = record.generation + 1 != 0 ? record.generation + 1 : 1;
+		record.chunk = m_freeRecord;
+		m_freeRecord = entity.index;
+		m_liveCount--;
+	}
+
+	Archetype* World::GetOrCreateArchetype(const ComponentMask& mask)
+	{
+		auto found = m_archetypeByMask.find(mask);
+		if (found != m_archetypeByMask.end())
+			return found->second;
+
+		m_archetypes.emplace_back(new Archetype(mask, m_chunkPool));
+		Archetype* archetype = m_archetypes.back().get();
+		m_archetypeByMask.emplace(mask, archetype);
+		return archetype;
+	}
+
+	Entity World::CreateEntityInArchetype(const ComponentMask& mask)
+	{
+		uint index;
+		if (m_freeRecord != INVALID_INDEX)
+		{
+			index = m_freeRecord;
+			m_freeRecord = m_records[index].chunk;
+		}
+		else
+		{
+			index = static_cast<uint>(m_records.size());
+			m_records.push_back({ nullptr, 0, 0, 1 });
+		}
+
+		EntityRecord& record = m_records[index];
+		const Entity entity = { index, record.generation };
+		record.archetype = GetOrCreateArchetype(mask);
+		record.archetype->AddRow(entity, record.chunk, record.row);
+		m_liveCount++;
+		return entity;
+	}
+
+	void World::MoveEntity(Entity entity, Archetype* target)
+	{
+		EntityRecord& record = m_records[entity.index];
+		Archetype* source = record.archetype;
+
+		uint chunk, row;
+		target->AddRow(entity, chunk, row);
+		target->CopySharedComponents(*source, record.chunk, record.row, chunk, row);
+
+		const Entity moved = source->RemoveRow(record.chunk, record.row);
+		if (!moved.IsNull())
+		{
+			m_records[moved.index].chunk = record.chunk;
+			m_records[moved.index].row = record.row;
+		}
+
+		record.archetype = target;
+		record.chunk = chunk;
+		record.row = row;
+	}
+}
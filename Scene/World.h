@@ -0,0 +1,233 @@
+#pragma once
+#include "Archetype.h"
+#include "Core/JobSystem.h"
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Scene
+{
+	/*
+	* Archetype based entity-component storage.
+	*
+	* Entities with the same set of components share an Archetype whose chunks store
+	* every component in its own contiguous array. Adding or removing a component moves
+	* the entity to another archetype. Structural changes (create, destroy, add, remove)
+	* are not thread safe; iterating components through a Query from several threads is.
+	*/
+	class World
+	{
+	public:
+		World();
+		~World();
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		// Creates an entity with the given components.
+		template<typename... Ts>
+		Entity CreateEntity(const Ts&... components);
+
+		// Destroys the entity. Stale entities are ignored.
+		void DestroyEntity(Entity entity);
+
+		inline bool IsAlive(Entity entity) const
+		{
+			return entity.index < m_records.size() && m_records[entity.index].generation == entity.generation;
+		}
+
+		// Returns nullptr if the entity is stale or lacks the component.
+		template<typename T>
+		T* GetComponent(Entity entity) const;
+
+		template<typename T>
+		inline bool HasComponent(Entity entity) const
+		{
+			return IsAlive(entity) && m_records[entity.index].archetype->GetMask().test(GetComponentId<T>());
+		}
+
+		/// <summary>
+		/// Adds (or overwrites) a component, moving the entity to the matching archetype.
+		/// </summary>
+		/// <returns>The component, or nullptr if the entity is stale.</returns>
+		template<typename T>
+		T* AddComponent(Entity entity, const T& value = T());
+
+		// Returns false if the entity is stale or did not have the component.
+		template<typename T>
+		bool RemoveComponent(Entity entity);
+
+		inline uint GetEntityCount() const { return m_liveCount; }
+		inline uint GetArchetypeCount() const { return static_cast<uint>(m_archetypes.size()); }
+		inline Archetype& GetArchetype(uint index) const { return *m_archetypes[index]; }
+
+	private:
+		struct EntityRecord
+		{
+			Archetype* archetype;
+			uint chunk;			// Next free record while unused
+			uint row;
+			uint generation;
+		};
+
+		static constexpr uint INVALID_INDEX = 0xFFFFFFFF;
+
+		Memory::PoolAllocator m_chunkPool;
+		std::vector<std::unique_ptr<Archetype>> m_archetypes;
+		std::unordered_map<ComponentMask, Archetype*> m_archetypeByMask;
+		std::vector<EntityRecord> m_records;
+		uint m_freeRecord = INVALID_INDEX;
+		uint m_liveCount = 0;
+
+		Archetype* GetOrCreateArchetype(const ComponentMask& mask);
+		Entity CreateEntityInArchetype(const ComponentMask& mask);
+		// Moves the entity's row to another archetype, keeping the components both share
+		void MoveEntity(Entity entity, Archetype* target);
+	};
+
+	/*
+	* Iterates the chunks of every archetype containing all of Ts.
+	* Matching archetypes are cached and only re-scanned when the world creates new ones,
+	* so keep the query around (e.g. as a system member) instead of rebuilding it every frame.
+	* Use 'const T' for components that are only read.
+	*/
+	template<typename... Ts>
+	class Query
+	{
+	public:
+		explicit Query(World& world) : m_world(world), m_mask(MakeComponentMask<Ts...>()) {}
+
+		/// <summary>
+		/// Calls f(count, entities, Ts* arrays...) once per chunk. Loops over the arrays are
+		/// plain contiguous loops the compiler can vectorize.
+		/// </summary>
+		template<typename F>
+		void ForEachChunk(F&& f)
+		{
+			Refresh();
+			for (Archetype* archetype : m_archetypes)
+			{
+				for (uint chunk = 0; chunk < archetype->GetChunkCount(); chunk++)
+					InvokeChunk(f, *archetype, chunk);
+			}
+		}
+
+		// Calls f(Ts&...) once per entity.
+		template<typename F>
+		void ForEach(F&& f)
+		{
+			ForEachChunk([&f](uint count, const Entity*, Ts*... arrays)
+			{
+				for (uint i = 0; i < count; i++)
+					f(arrays[i]...);
+			});
+		}
+
+		/// <summary>
+		/// Same as ForEachChunk but chunks are spread across the job system.
+		/// f must only touch the arrays it is given.
+		/// </summary>
+		template<typename F>
+		void ParallelForEachChunk(F&& f, uint chunksPerJob = 4)
+		{
+			Refresh();
+			m_chunkList.clear();
+			for (Archetype* archetype : m_archetypes)
+			{
+				for (uint chunk = 0; chunk < archetype->GetChunkCount(); chunk++)
+					m_chunkList.emplace_back(archetype, chunk);
+			}
+
+			Core::JobSystem::ParallelFor(static_cast<uint>(m_chunkList.size()), chunksPerJob, [this, &f](uint begin, uint end)
+			{
+				for (uint i = begin; i < end; i++)
+					InvokeChunk(f, *m_chunkList[i].first, m_chunkList[i].second);
+			});
+		}
+
+		uint GetEntityCount()
+		{
+			Refresh();
+			uint count = 0;
+			for (Archetype* archetype : m_archetypes)
+				count += archetype->GetEntityCount();
+			return count;
+		}
+
+	private:
+		World& m_world;
+		ComponentMask m_mask;
+		std::vector<Archetype*> m_archetypes;
+		uint m_scannedArchetypes = 0;
+		std::vector<std::pair<Archetype*, uint>> m_chunkList;
+
+		void Refresh()
+		{
+			for (; m_scannedArchetypes < m_world.GetArchetypeCount(); m_scannedArchetypes++)
+			{
+				Archetype& archetype = m_world.GetArchetype(m_scannedArchetypes);
+				if ((archetype.GetMask() & m_mask) == m_mask)
+					m_archetypes.push_back(&archetype);
+			}
+		}
+
+		template<typename F>
+		inline void InvokeChunk(F& f, const Archetype& archetype, uint chunk)
+		{
+			f(archetype.GetChunk(chunk).count, archetype.GetEntities(chunk),
+				static_cast<Ts*>(archetype.GetComponentArray(chunk, GetComponentId<Ts>()))...);
+		}
+	};
+
+	template<typename... Ts>
+	Entity World::CreateEntity(const Ts&... components)
+	{
+		const Entity entity = CreateEntityInArchetype(MakeComponentMask<Ts...>());
+		const EntityRecord& record = m_records[entity.index];
+		// Expands to one placement copy per component
+		const int expand[] = { 0, (new (record.archetype->GetComponent(record.chunk, record.row, GetComponentId<Ts>())) Ts(components), 0)... };
+		(void)expand;
+		return entity;
+	}
+
+	template<typename T>
+	T* World::GetComponent(Entity entity) const
+	{
+		if (!IsAlive(entity))
+			return nullptr;
+		const EntityRecord& record = m_records[entity.index];
+		const uint id = GetComponentId<T>();
+		if (!record.archetype->GetMask().test(id))
+			return nullptr;
+		return static_cast<T*>(record.archetype->GetComponent(record.chunk, record.row, id));
+	}
+
+	template<typename T>
+	T* World::AddComponent(Entity entity, const T& value)
+	{
+		if (!IsAlive(entity))
+			return nullptr;
+		const uint id = GetComponentId<T>();
+		Archetype* current = m_records[entity.index].archetype;
+		if (!current->GetMask().test(id))
+		{
+			ComponentMask mask = current->GetMask();
+			mask.set(id);
+			MoveEntity(entity, GetOrCreateArchetype(mask));
+		}
+		const EntityRecord& record = m_records[entity.index];
+		return new (record.archetype->GetComponent(record.chunk, record.row, id)) T(value);
+	}
+
+	template<typename T>
+	bool World::RemoveComponent(Entity entity)
+	{
+		if (!HasComponent<T>(entity))
+			return false;
+		ComponentMask mask = m_records[entity.index].archetype->GetMask();
+		mask.reset(GetComponentId<T>());
+		MoveEntity(entity, GetOrCreateArchetype(mask));
+		return true;
+	}
+}